@@ -0,0 +1,100 @@
+#include "common/uniforms.wgsl"
+
+struct VertexInput {
+    @location(0) position: vec3f,
+    @location(1) uv: vec2f
+}
+
+struct VertexOutput {
+    @builtin(position) @invariant position: vec4f,
+    @location(0) uv: vec2f,
+    @location(1) worldPosition: vec3f,
+    @location(2) viewDepth: f32
+}
+
+// Untextured materials never sample, they take a flat color set per pipeline instead
+#ifdef TEXTURED
+@group(1) @binding(1) var objectTexture: texture_2d<f32>;
+@group(1) @binding(2) var objectSampler: sampler;
+#else
+override objectColorR: f32 = 1.0;
+override objectColorG: f32 = 1.0;
+override objectColorB: f32 = 1.0;
+#endif
+
+#ifdef CLUSTERED_LIGHTING
+#include "common/lights.wgsl"
+
+override ambientStrength: f32 = 0.1;
+
+@group(0) @binding(1) var<storage, read> lights: array<Light>;
+@group(0) @binding(2) var<storage, read> clusterLights: array<ClusterLights>;
+@group(0) @binding(3) var<storage, read> lightIndices: array<u32>;
+
+// Only the lights binned into this fragment's froxel are visited
+fn shadeClusteredLights(fragCoord: vec2f, worldPosition: vec3f, viewDepth: f32, normal: vec3f) -> vec3f {
+    let cluster = clusterLights[getClusterIndex(fragCoord, viewDepth)];
+    var result = vec3f(0.0);
+
+    for (var i = 0u; i < cluster.count; i++) {
+        let light = lights[lightIndices[cluster.offset + i]];
+
+        let toLight = light.positionRange.xyz - worldPosition;
+        let distance = length(toLight);
+        let direction = toLight / max(distance, 0.0001);
+
+        // Inverse square falloff windowed to reach zero at the range the lights were culled with
+        let range = light.positionRange.w;
+        let ratio = distance / range;
+        let window = saturate(1.0 - ratio * ratio * ratio * ratio);
+        let attenuation = window * window / (distance * distance + 1.0);
+
+        var spot = 1.0;
+        if (light.directionType.w == LIGHT_TYPE_SPOT) {
+            let cosTheta = dot(-direction, normalize(light.directionType.xyz));
+            spot = smoothstep(light.spotAngles.y, light.spotAngles.x, cosTheta);
+        }
+
+        result += light.colorIntensity.rgb * light.colorIntensity.w * max(dot(normal, direction), 0.0) * attenuation * spot;
+    }
+
+    return result;
+}
+
+// Meshes carry no normals yet, so the face normal comes from the position derivatives
+fn getFaceNormal(worldPosition: vec3f) -> vec3f {
+    let normal = normalize(cross(dpdx(worldPosition), dpdy(worldPosition)));
+    return faceForward(normal, worldPosition - sceneUniform.cameraPosition, normal);
+}
+#endif
+
+@vertex
+fn vertexMain(input: VertexInput) -> VertexOutput {
+    let worldPosition = objectUniform.modelTransform * vec4f(input.position, 1.0);
+
+    var output: VertexOutput;
+    output.position = sceneUniform.cameraTransform * objectUniform.modelTransform * vec4f(input.position, 1.0);
+    output.uv = input.uv;
+    output.worldPosition = worldPosition.xyz;
+    output.viewDepth = -(sceneUniform.viewTransform * worldPosition).z;
+
+    return output;
+}
+
+@fragment
+fn fragmentMain(input: VertexOutput) -> @location(0) vec4f {
+#ifdef TEXTURED
+    let baseColor = textureSample(objectTexture, objectSampler, input.uv);
+#else
+    let baseColor = vec4f(objectColorR, objectColorG, objectColorB, 1.0);
+#endif
+
+#ifdef CLUSTERED_LIGHTING
+    let normal = getFaceNormal(input.worldPosition);
+    let lighting = ambientStrength + shadeClusteredLights(input.position.xy, input.worldPosition, input.viewDepth, normal);
+
+    return vec4f(baseColor.rgb * lighting, baseColor.a);
+#else
+    return baseColor;
+#endif
+}
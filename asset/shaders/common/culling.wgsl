@@ -0,0 +1,9 @@
+// Layout matches OcclusionCuller::CullUniform
+struct CullUniform {
+    viewProjection: mat4x4f,
+    previousViewProjection: mat4x4f,
+    renderSize: vec2f,
+    previousRenderSize: vec2f,
+    objectCount: u32,
+    mipCount: u32
+}
@@ -0,0 +1,37 @@
+#include "common/uniforms.wgsl"
+
+const LIGHT_TYPE_POINT: f32 = 0.0;
+const LIGHT_TYPE_SPOT: f32 = 1.0;
+
+// Layout matches nugie::Light
+struct Light {
+    positionRange: vec4f,
+    colorIntensity: vec4f,
+    directionType: vec4f,
+    spotAngles: vec4f
+}
+
+// Where a cluster's light indices start in the index list and how many there are
+struct ClusterLights {
+    offset: u32,
+    count: u32
+}
+
+// Depth slices are spaced exponentially, so froxels stay roughly cubic from near to far
+fn getSliceDepth(slice: u32) -> f32 {
+    let slices = f32(sceneUniform.clusterCount.z);
+    return sceneUniform.nearPlane * pow(sceneUniform.farPlane / sceneUniform.nearPlane, f32(slice) / slices);
+}
+
+fn getClusterIndex(fragCoord: vec2f, viewDepth: f32) -> u32 {
+    let counts = sceneUniform.clusterCount;
+    let slices = f32(counts.z);
+
+    let sliceValue = log(viewDepth / sceneUniform.nearPlane) / log(sceneUniform.farPlane / sceneUniform.nearPlane) * slices;
+    let slice = u32(clamp(sliceValue, 0.0, slices - 1.0));
+
+    let tileValue = fragCoord / sceneUniform.screenSize * vec2f(counts.xy);
+    let tile = vec2u(clamp(tileValue, vec2f(0.0), vec2f(counts.xy) - 1.0));
+
+    return tile.x + tile.y * counts.x + slice * counts.x * counts.y;
+}
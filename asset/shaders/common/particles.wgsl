@@ -0,0 +1,33 @@
+// Layout matches ParticleSystem::ParticleParams
+struct ParticleParams {
+    viewProjection: mat4x4f,
+    cameraRightSize: vec4f,
+    cameraUp: vec4f,
+    emitterPositionRadius: vec4f,
+    emitterVelocityJitter: vec4f,
+    gravityDrag: vec4f,
+    startColor: vec4f,
+    endColor: vec4f,
+    deltaTime: f32,
+    lifetimeMin: f32,
+    lifetimeMax: f32,
+    emitRequest: u32,
+    maxParticles: u32,
+    parity: u32,
+    seed: u32
+}
+
+// Layout matches ParticleSystem::Particle, age and lifetime ride in the w components
+struct Particle {
+    positionAge: vec4f,
+    velocityLifetime: vec4f
+}
+
+// The alive list read this frame is the one the previous frame compacted into, the other one is written
+fn getInputListBase(params: ParticleParams) -> u32 {
+    return params.parity * params.maxParticles;
+}
+
+fn getOutputListBase(params: ParticleParams) -> u32 {
+    return (1u - params.parity) * params.maxParticles;
+}
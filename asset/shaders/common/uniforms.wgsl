@@ -0,0 +1,18 @@
+struct SceneUniform {
+    cameraTransform: mat4x4f,
+    viewTransform: mat4x4f,
+    inverseProjection: mat4x4f,
+    cameraPosition: vec3f,
+    lightCount: u32,
+    screenSize: vec2f,
+    nearPlane: f32,
+    farPlane: f32,
+    clusterCount: vec3u
+}
+
+struct ObjectUniform {
+    modelTransform: mat4x4f
+}
+
+@group(0) @binding(0) var<uniform> sceneUniform: SceneUniform;
+@group(1) @binding(0) var<uniform> objectUniform: ObjectUniform;
@@ -0,0 +1,7 @@
+#include "common/uniforms.wgsl"
+
+// Must transform positions exactly like the main pass, otherwise its Equal depth test drops pixels
+@vertex
+fn vertexMain(@location(0) position: vec3f) -> @builtin(position) @invariant vec4f {
+    return sceneUniform.cameraTransform * objectUniform.modelTransform * vec4f(position, 1.0);
+}
@@ -0,0 +1,47 @@
+#include "common/culling.wgsl"
+
+// Every texel of the pyramid holds the farthest depth of the region below it, so anything
+// nearer than that value over its whole footprint might be visible
+
+@group(0) @binding(0) var<uniform> cullUniform: CullUniform;
+
+#ifdef FROM_DEPTH
+@group(0) @binding(1) var sourceDepth: texture_depth_2d;
+#else
+@group(0) @binding(1) var sourceLevel: texture_2d<f32>;
+#endif
+
+@group(0) @binding(2) var destinationLevel: texture_storage_2d<r32float, write>;
+
+@compute @workgroup_size(8, 8)
+fn computeMain(@builtin(global_invocation_id) id: vec3u) {
+    let destinationSize = textureDimensions(destinationLevel);
+    if (id.x >= destinationSize.x || id.y >= destinationSize.y) {
+        return;
+    }
+
+#ifdef FROM_DEPTH
+    // Only the rendered corner of the depth texture is valid under dynamic resolution
+    let sourceSize = vec2u(cullUniform.renderSize);
+#else
+    let sourceSize = textureDimensions(sourceLevel);
+#endif
+
+    // Odd sources fold their last row or column into the last destination texel
+    let begin = min(id.xy * 2u, sourceSize - 1u);
+    var end = min(begin + 2u, sourceSize);
+    end = select(end, sourceSize, id.xy == destinationSize - 1u);
+
+    var farthest = 0.0;
+    for (var y = begin.y; y < end.y; y++) {
+        for (var x = begin.x; x < end.x; x++) {
+#ifdef FROM_DEPTH
+            farthest = max(farthest, textureLoad(sourceDepth, vec2u(x, y), 0));
+#else
+            farthest = max(farthest, textureLoad(sourceLevel, vec2u(x, y), 0).r);
+#endif
+        }
+    }
+
+    textureStore(destinationLevel, id.xy, vec4f(farthest, 0.0, 0.0, 0.0));
+}
@@ -0,0 +1,115 @@
+#include "common/lights.wgsl"
+
+@group(0) @binding(1) var<storage, read> lights: array<Light>;
+@group(0) @binding(2) var<storage, read_write> clusterLights: array<ClusterLights>;
+@group(0) @binding(3) var<storage, read_write> lightIndices: array<u32>;
+@group(0) @binding(4) var<storage, read_write> lightIndexCounter: atomic<u32>;
+
+const WORKGROUP_SIZE: u32 = 64u;
+const MAX_LIGHTS_PER_CLUSTER: u32 = 256u;
+
+var<workgroup> clusterLightCount: atomic<u32>;
+var<workgroup> clusterLightList: array<u32, MAX_LIGHTS_PER_CLUSTER>;
+var<workgroup> clusterOffset: u32;
+var<workgroup> clusterStoredCount: u32;
+
+// The view space ray through a point on the screen, scaled so that its depth is one
+fn getTileRay(ndc: vec2f) -> vec3f {
+    let point = sceneUniform.inverseProjection * vec4f(ndc, 0.5, 1.0);
+    let viewPoint = point.xyz / point.w;
+
+    return viewPoint / -viewPoint.z;
+}
+
+// Cone against sphere, from the cone axis distance and the angle of the closest point
+fn spotIntersectsSphere(position: vec3f, direction: vec3f, range: f32, cosAngle: f32, center: vec3f, radius: f32) -> bool {
+    let toCenter = center - position;
+    let lengthSquared = dot(toCenter, toCenter);
+    let projected = dot(toCenter, direction);
+    let sinAngle = sqrt(max(1.0 - cosAngle * cosAngle, 0.0));
+    let closestDistance = cosAngle * sqrt(max(lengthSquared - projected * projected, 0.0)) - projected * sinAngle;
+
+    return !(closestDistance > radius || projected > radius + range || projected < -radius);
+}
+
+// One workgroup per cluster, its invocations test the lights in strides and gather the hits in
+// workgroup memory, so the global index list only sees one atomic add per cluster
+@compute @workgroup_size(WORKGROUP_SIZE)
+fn computeMain(@builtin(workgroup_id) cluster: vec3u, @builtin(local_invocation_index) localIndex: u32) {
+    let counts = sceneUniform.clusterCount;
+    let clusterIndex = cluster.x + cluster.y * counts.x + cluster.z * counts.x * counts.y;
+
+    if (localIndex == 0u) {
+        atomicStore(&clusterLightCount, 0u);
+    }
+
+    workgroupBarrier();
+
+    // Tile rows go down the screen like fragment coordinates, NDC y goes up
+    let tileSize = 2.0 / vec2f(counts.xy);
+    let ndcMin = vec2f(-1.0 + f32(cluster.x) * tileSize.x, 1.0 - f32(cluster.y + 1u) * tileSize.y);
+    let ndcMax = ndcMin + tileSize;
+
+    let nearDepth = getSliceDepth(cluster.z);
+    let farDepth = getSliceDepth(cluster.z + 1u);
+
+    var boundsMin = vec3f(3.4e38);
+    var boundsMax = vec3f(-3.4e38);
+
+    for (var i = 0u; i < 4u; i++) {
+        let corner = vec2f(select(ndcMin.x, ndcMax.x, (i & 1u) != 0u), select(ndcMin.y, ndcMax.y, (i & 2u) != 0u));
+        let ray = getTileRay(corner);
+
+        boundsMin = min(boundsMin, min(ray * nearDepth, ray * farDepth));
+        boundsMax = max(boundsMax, max(ray * nearDepth, ray * farDepth));
+    }
+
+    let center = (boundsMin + boundsMax) * 0.5;
+    let radius = length(boundsMax - center);
+
+    for (var i = localIndex; i < sceneUniform.lightCount; i += WORKGROUP_SIZE) {
+        let light = lights[i];
+        let position = (sceneUniform.viewTransform * vec4f(light.positionRange.xyz, 1.0)).xyz;
+        let range = light.positionRange.w;
+
+        let closest = clamp(position, boundsMin, boundsMax);
+        let delta = closest - position;
+        var visible = dot(delta, delta) <= range * range;
+
+        if (visible && light.directionType.w == LIGHT_TYPE_SPOT) {
+            let direction = normalize((sceneUniform.viewTransform * vec4f(light.directionType.xyz, 0.0)).xyz);
+            visible = spotIntersectsSphere(position, direction, range, light.spotAngles.y, center, radius);
+        }
+
+        if (visible) {
+            let slot = atomicAdd(&clusterLightCount, 1u);
+            if (slot < MAX_LIGHTS_PER_CLUSTER) {
+                clusterLightList[slot] = i;
+            }
+        }
+    }
+
+    workgroupBarrier();
+
+    if (localIndex == 0u) {
+        let count = min(atomicLoad(&clusterLightCount), MAX_LIGHTS_PER_CLUSTER);
+        let offset = atomicAdd(&lightIndexCounter, count);
+        let capacity = arrayLength(&lightIndices);
+
+        // A full index list drops the cluster's lights rather than writing out of bounds
+        var stored = 0u;
+        if (offset < capacity) {
+            stored = min(count, capacity - offset);
+        }
+
+        clusterLights[clusterIndex] = ClusterLights(offset, stored);
+        clusterOffset = offset;
+        clusterStoredCount = stored;
+    }
+
+    workgroupBarrier();
+
+    for (var i = localIndex; i < clusterStoredCount; i += WORKGROUP_SIZE) {
+        lightIndices[clusterOffset + i] = clusterLightList[i];
+    }
+}
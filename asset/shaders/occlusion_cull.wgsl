@@ -0,0 +1,125 @@
+#include "common/culling.wgsl"
+
+// Layout matches OcclusionCuller::CullObject
+struct CullObject {
+    boundsMin: vec4f,
+    boundsMax: vec4f,
+    indexCount: u32,
+    firstIndex: u32,
+    baseVertex: i32,
+    padding: u32
+}
+
+struct DrawIndexedArgs {
+    indexCount: u32,
+    instanceCount: u32,
+    firstIndex: u32,
+    baseVertex: i32,
+    firstInstance: u32
+}
+
+struct CullCounters {
+    earlyVisible: atomic<u32>,
+    lateVisible: atomic<u32>
+}
+
+@group(0) @binding(0) var<uniform> cullUniform: CullUniform;
+@group(0) @binding(1) var<storage, read> objects: array<CullObject>;
+@group(0) @binding(2) var<storage, read_write> earlyArgs: array<DrawIndexedArgs>;
+@group(0) @binding(3) var<storage, read_write> lateArgs: array<DrawIndexedArgs>;
+@group(0) @binding(4) var<storage, read_write> counters: CullCounters;
+@group(0) @binding(5) var hizPyramid: texture_2d<f32>;
+
+// Frustum test of the box, then its nearest depth against the farthest depth of the pyramid
+// texels under its screen rectangle, at the level where that rectangle spans at most two texels
+fn isVisible(object: CullObject, viewProjection: mat4x4f, renderSize: vec2f) -> bool {
+    var rectMin = vec2f(3.4e38);
+    var rectMax = vec2f(-3.4e38);
+    var nearestDepth = 1.0;
+
+    for (var i = 0u; i < 8u; i++) {
+        let corner = vec3f(
+            select(object.boundsMin.x, object.boundsMax.x, (i & 1u) != 0u),
+            select(object.boundsMin.y, object.boundsMax.y, (i & 2u) != 0u),
+            select(object.boundsMin.z, object.boundsMax.z, (i & 4u) != 0u)
+        );
+
+        let clip = viewProjection * vec4f(corner, 1.0);
+
+        // Boxes crossing the near plane cannot be projected, they are always drawn
+        if (clip.w <= 0.0001) {
+            return true;
+        }
+
+        let ndc = clip.xyz / clip.w;
+        rectMin = min(rectMin, ndc.xy);
+        rectMax = max(rectMax, ndc.xy);
+        nearestDepth = min(nearestDepth, ndc.z);
+    }
+
+    if (any(rectMax < vec2f(-1.0)) || any(rectMin > vec2f(1.0)) || nearestDepth > 1.0) {
+        return false;
+    }
+
+    if (nearestDepth <= 0.0) {
+        return true;
+    }
+
+    // Screen rows go down, NDC y goes up
+    let uvMin = clamp(vec2f(rectMin.x, -rectMax.y) * 0.5 + 0.5, vec2f(0.0), vec2f(1.0));
+    let uvMax = clamp(vec2f(rectMax.x, -rectMin.y) * 0.5 + 0.5, vec2f(0.0), vec2f(1.0));
+
+    // The first pyramid level is half the render size
+    let baseSize = renderSize * 0.5;
+    let extent = (uvMax - uvMin) * baseSize;
+    let level = min(u32(ceil(log2(max(max(extent.x, extent.y), 1.0)))), cullUniform.mipCount - 1u);
+
+    let levelSize = textureDimensions(hizPyramid, level);
+    let levelScale = baseSize / f32(1u << level);
+    let texelMin = min(vec2u(uvMin * levelScale), levelSize - 1u);
+    let texelMax = min(vec2u(uvMax * levelScale), levelSize - 1u);
+
+    var farthest = 0.0;
+    for (var y = texelMin.y; y <= texelMax.y; y++) {
+        for (var x = texelMin.x; x <= texelMax.x; x++) {
+            farthest = max(farthest, textureLoad(hizPyramid, vec2u(x, y), level).r);
+        }
+    }
+
+    return nearestDepth <= farthest;
+}
+
+fn makeArgs(object: CullObject, visible: bool) -> DrawIndexedArgs {
+    return DrawIndexedArgs(object.indexCount, select(0u, 1u, visible), object.firstIndex, object.baseVertex, 0u);
+}
+
+@compute @workgroup_size(64)
+fn computeMain(@builtin(global_invocation_id) id: vec3u) {
+    let index = id.x;
+    if (index >= cullUniform.objectCount) {
+        return;
+    }
+
+    let object = objects[index];
+
+#ifdef LATE_PHASE
+    // Objects the early phase rejected get a second chance against this frame's depth
+    let drawnEarly = earlyArgs[index].instanceCount > 0u;
+    let visible = !drawnEarly && isVisible(object, cullUniform.viewProjection, cullUniform.renderSize);
+
+    lateArgs[index] = makeArgs(object, visible);
+
+    if (visible) {
+        atomicAdd(&counters.lateVisible, 1u);
+    }
+#else
+    // Tested where the pyramid was built, from last frame's camera, which is what was visible then
+    let visible = isVisible(object, cullUniform.previousViewProjection, cullUniform.previousRenderSize);
+
+    earlyArgs[index] = makeArgs(object, visible);
+
+    if (visible) {
+        atomicAdd(&counters.earlyVisible, 1u);
+    }
+#endif
+}
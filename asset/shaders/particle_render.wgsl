@@ -0,0 +1,46 @@
+#include "common/particles.wgsl"
+
+// Draws the alive particles the simulation compacted this frame, one instance per particle.
+// The quad is built from the camera axes here, so no vertex buffer is needed.
+
+@group(0) @binding(0) var<uniform> params: ParticleParams;
+@group(0) @binding(1) var<storage, read> particles: array<Particle>;
+@group(0) @binding(2) var<storage, read> aliveLists: array<u32>;
+
+struct VertexOutput {
+    @builtin(position) position: vec4f,
+    @location(0) corner: vec2f,
+    @location(1) color: vec4f
+}
+
+@vertex
+fn vertexMain(@builtin(vertex_index) vertexIndex: u32, @builtin(instance_index) instanceIndex: u32) -> VertexOutput {
+    var corners = array<vec2f, 6>(
+        vec2f(-1.0, -1.0), vec2f(1.0, -1.0), vec2f(1.0, 1.0),
+        vec2f(1.0, 1.0), vec2f(-1.0, 1.0), vec2f(-1.0, -1.0)
+    );
+
+    let corner = corners[vertexIndex];
+    let particle = particles[aliveLists[getOutputListBase(params) + instanceIndex]];
+
+    let size = params.cameraRightSize.w;
+    let offset = (params.cameraRightSize.xyz * corner.x + params.cameraUp.xyz * corner.y) * size;
+
+    var output: VertexOutput;
+    output.position = params.viewProjection * vec4f(particle.positionAge.xyz + offset, 1.0);
+    output.corner = corner;
+    output.color = mix(params.startColor, params.endColor, clamp(particle.positionAge.w / particle.velocityLifetime.w, 0.0, 1.0));
+
+    return output;
+}
+
+// Round soft sprites, blended additively so they need no sorting
+@fragment
+fn fragmentMain(input: VertexOutput) -> @location(0) vec4f {
+    let falloff = 1.0 - dot(input.corner, input.corner);
+    if (falloff <= 0.0) {
+        discard;
+    }
+
+    return vec4f(input.color.rgb, input.color.a * falloff);
+}
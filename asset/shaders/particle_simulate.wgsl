@@ -0,0 +1,107 @@
+#include "common/particles.wgsl"
+
+// One frame of the particle system, as four dispatches in a single pass:
+//   beginMain     clamps the emission to the free particles and sizes the simulate dispatch
+//   emitMain      takes particles off the dead list and appends them to the input alive list
+//   simulateMain  integrates every alive particle, compacting the survivors into the output list
+//   finishMain    writes the indirect draw of the output list
+// Counts never leave the GPU, the CPU only asks for a number of particles to emit.
+
+struct ParticleCounters {
+    dead: atomic<u32>,
+    alive: array<atomic<u32>, 2>,
+    emitted: atomic<u32>
+}
+
+@group(0) @binding(0) var<uniform> params: ParticleParams;
+@group(0) @binding(1) var<storage, read_write> particles: array<Particle>;
+@group(0) @binding(2) var<storage, read_write> deadList: array<u32>;
+@group(0) @binding(3) var<storage, read_write> aliveLists: array<u32>;
+@group(0) @binding(4) var<storage, read_write> counters: ParticleCounters;
+
+@group(1) @binding(0) var<storage, read_write> dispatchArgs: array<u32, 3>;
+@group(1) @binding(1) var<storage, read_write> drawArgs: array<u32, 4>;
+
+const WORKGROUP_SIZE: u32 = 64u;
+
+// PCG hash, good enough for spawn jitter and cheap enough to call per component
+fn hash(value: u32) -> u32 {
+    let state = value * 747796405u + 2891336453u;
+    let word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    return (word >> 22u) ^ word;
+}
+
+fn random(seed: ptr<function, u32>) -> f32 {
+    *seed = hash(*seed);
+    return f32(*seed) / 4294967295.0;
+}
+
+fn randomSigned3(seed: ptr<function, u32>) -> vec3f {
+    return vec3f(random(seed), random(seed), random(seed)) * 2.0 - 1.0;
+}
+
+@compute @workgroup_size(1)
+fn beginMain() {
+    let emitted = min(params.emitRequest, atomicLoad(&counters.dead));
+    let simulated = atomicLoad(&counters.alive[params.parity]) + emitted;
+
+    atomicStore(&counters.emitted, emitted);
+    atomicStore(&counters.alive[1u - params.parity], 0u);
+
+    dispatchArgs[0] = (simulated + WORKGROUP_SIZE - 1u) / WORKGROUP_SIZE;
+    dispatchArgs[1] = 1u;
+    dispatchArgs[2] = 1u;
+}
+
+@compute @workgroup_size(WORKGROUP_SIZE)
+fn emitMain(@builtin(global_invocation_id) id: vec3u) {
+    if (id.x >= atomicLoad(&counters.emitted)) {
+        return;
+    }
+
+    let index = deadList[atomicSub(&counters.dead, 1u) - 1u];
+    var seed = hash(id.x ^ params.seed);
+
+    let offset = randomSigned3(&seed) * params.emitterPositionRadius.w;
+    let jitter = randomSigned3(&seed) * params.emitterVelocityJitter.w;
+    let lifetime = mix(params.lifetimeMin, params.lifetimeMax, random(&seed));
+
+    particles[index].positionAge = vec4f(params.emitterPositionRadius.xyz + offset, 0.0);
+    particles[index].velocityLifetime = vec4f(params.emitterVelocityJitter.xyz + jitter, lifetime);
+
+    aliveLists[getInputListBase(params) + atomicAdd(&counters.alive[params.parity], 1u)] = index;
+}
+
+@compute @workgroup_size(WORKGROUP_SIZE)
+fn simulateMain(@builtin(global_invocation_id) id: vec3u) {
+    if (id.x >= atomicLoad(&counters.alive[params.parity])) {
+        return;
+    }
+
+    let index = aliveLists[getInputListBase(params) + id.x];
+    let particle = particles[index];
+
+    let age = particle.positionAge.w + params.deltaTime;
+    let lifetime = particle.velocityLifetime.w;
+
+    if (age >= lifetime) {
+        deadList[atomicAdd(&counters.dead, 1u)] = index;
+        return;
+    }
+
+    var velocity = particle.velocityLifetime.xyz + params.gravityDrag.xyz * params.deltaTime;
+    velocity *= max(1.0 - params.gravityDrag.w * params.deltaTime, 0.0);
+
+    particles[index].positionAge = vec4f(particle.positionAge.xyz + velocity * params.deltaTime, age);
+    particles[index].velocityLifetime = vec4f(velocity, lifetime);
+
+    aliveLists[getOutputListBase(params) + atomicAdd(&counters.alive[1u - params.parity], 1u)] = index;
+}
+
+@compute @workgroup_size(1)
+fn finishMain() {
+    drawArgs[0] = 6u;
+    drawArgs[1] = atomicLoad(&counters.alive[1u - params.parity]);
+    drawArgs[2] = 0u;
+    drawArgs[3] = 0u;
+}
@@ -0,0 +1,45 @@
+// Linear blend skinning of one mesh instance, one thread per vertex. The result is written as three
+// floats per vertex, the same layout as the position stream every scene pipeline reads.
+
+// Layout matches SkinningSystem::SkinParams
+struct SkinParams {
+    vertexCount: u32,
+    jointCount: u32,
+    padding0: u32,
+    padding1: u32
+}
+
+// Layout matches nugie::SkinVertex
+struct SkinVertex {
+    position: vec4f,
+    weights: vec4f,
+    joints: vec4u
+}
+
+@group(0) @binding(0) var<uniform> params: SkinParams;
+@group(0) @binding(1) var<storage, read> vertices: array<SkinVertex>;
+@group(0) @binding(2) var<storage, read> palette: array<mat4x4f>;
+@group(0) @binding(3) var<storage, read_write> positions: array<f32>;
+
+const WORKGROUP_SIZE: u32 = 64u;
+
+@compute @workgroup_size(WORKGROUP_SIZE)
+fn computeMain(@builtin(global_invocation_id) id: vec3u) {
+    if (id.x >= params.vertexCount) {
+        return;
+    }
+
+    let vertex = vertices[id.x];
+    let joints = min(vertex.joints, vec4u(params.jointCount - 1u));
+
+    let skin = palette[joints.x] * vertex.weights.x
+        + palette[joints.y] * vertex.weights.y
+        + palette[joints.z] * vertex.weights.z
+        + palette[joints.w] * vertex.weights.w;
+
+    let position = (skin * vec4f(vertex.position.xyz, 1.0)).xyz;
+
+    positions[id.x * 3u] = position.x;
+    positions[id.x * 3u + 1u] = position.y;
+    positions[id.x * 3u + 2u] = position.z;
+}
@@ -0,0 +1,72 @@
+// Stretches the scaled region of the internal scene target over the whole surface
+
+struct UpscaleUniform {
+    // Rendered size divided by the size of the internal target
+    uvScale: vec2f,
+    // One texel of the internal target, in uv units
+    texelSize: vec2f
+}
+
+struct VertexOutput {
+    @builtin(position) position: vec4f,
+    @location(0) uv: vec2f
+}
+
+@group(0) @binding(0) var<uniform> upscaleUniform: UpscaleUniform;
+@group(0) @binding(1) var sceneColor: texture_2d<f32>;
+@group(0) @binding(2) var sceneSampler: sampler;
+
+#ifdef EDGE_AWARE
+override edgeSharpness: f32 = 8.0;
+
+fn luma(color: vec3f) -> f32 {
+    return dot(color, vec3f(0.299, 0.587, 0.114));
+}
+#endif
+
+// A single triangle covering the screen, no vertex buffer needed
+@vertex
+fn vertexMain(@builtin(vertex_index) vertexIndex: u32) -> VertexOutput {
+    var output: VertexOutput;
+    let corner = vec2f(f32((vertexIndex << 1u) & 2u), f32(vertexIndex & 2u));
+
+    output.position = vec4f(corner * 2.0 - 1.0, 0.0, 1.0);
+    output.uv = vec2f(corner.x, 1.0 - corner.y);
+
+    return output;
+}
+
+fn sampleScene(uv: vec2f) -> vec4f {
+    // Keep the bilinear footprint inside the rendered region
+    let maxUv = upscaleUniform.uvScale - upscaleUniform.texelSize * 0.5;
+    return textureSampleLevel(sceneColor, sceneSampler, min(uv * upscaleUniform.uvScale, maxUv), 0.0);
+}
+
+@fragment
+fn fragmentMain(@location(0) uv: vec2f) -> @location(0) vec4f {
+    let center = sampleScene(uv);
+
+#ifdef EDGE_AWARE
+    // Neighbours whose luma differs from the bilinear estimate are across an edge and get little
+    // weight, so edges stay crisp while flat regions are smoothed
+    let texelStep = upscaleUniform.texelSize / upscaleUniform.uvScale;
+    let centerLuma = luma(center.rgb);
+
+    var sum = center;
+    var weightSum = 1.0;
+
+    var offsets = array<vec2f, 4>(vec2f(1.0, 0.0), vec2f(-1.0, 0.0), vec2f(0.0, 1.0), vec2f(0.0, -1.0));
+    for (var i = 0; i < 4; i++) {
+        let neighbour = sampleScene(uv + offsets[i] * texelStep * 0.5);
+        let difference = luma(neighbour.rgb) - centerLuma;
+        let weight = exp(-edgeSharpness * difference * difference * 16.0) * 0.5;
+
+        sum += neighbour * weight;
+        weightSum += weight;
+    }
+
+    return sum / weightSum;
+#else
+    return center;
+#endif
+}
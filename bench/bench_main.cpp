@@ -0,0 +1,106 @@
+#include "benchmarks.hpp"
+
+#include <string>
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+
+#ifndef NUGIE_GIT_COMMIT
+    #define NUGIE_GIT_COMMIT "unknown"
+#endif
+
+#ifndef NUGIE_BUILD_TYPE
+    #define NUGIE_BUILD_TYPE "unknown"
+#endif
+
+// Micro-benchmarks of the renderer's CPU side. Everything runs on a null device, so no GPU or window is needed,
+// except for the GPU benchmarks that only run when asked for. Exits with 1 when a benchmark's own check failed.
+//
+//   --filter=TEXT        only benchmarks whose name contains TEXT
+//   --repetitions=N      timed samples per benchmark (default 30)
+//   --min-sample-ms=MS   shortest time one sample may take (default 10)
+//   --json=PATH          writes the results for later comparison
+//   --compare=PATH       prints the change against results written by an earlier --json
+//   --gpu                adds the benchmarks that need a real adapter, such as particle throughput,
+//                        occlusion culling and the depth prepass
+//   --list               prints the benchmark names and exits
+
+std::string filter;
+std::string jsonPath;
+std::string comparePath;
+bool listOnly = false;
+bool gpuBenchmarks = false;
+nugie::BenchmarkSettings settings;
+
+void parseArguments(int argc, char** argv)
+{
+    for (int i = 1; i < argc; i++) {
+        std::string argument = argv[i];
+
+        if (argument.rfind("--filter=", 0) == 0)
+            filter = argument.substr(9);
+        else if (argument.rfind("--repetitions=", 0) == 0)
+            settings.repetitions = static_cast<uint32_t>(std::max(3, std::stoi(argument.substr(14))));
+        else if (argument.rfind("--min-sample-ms=", 0) == 0)
+            settings.minSampleSeconds = std::max(0.1, std::stod(argument.substr(16))) / 1000.0;
+        else if (argument.rfind("--json=", 0) == 0)
+            jsonPath = argument.substr(7);
+        else if (argument.rfind("--compare=", 0) == 0)
+            comparePath = argument.substr(10);
+        else if (argument == "--gpu")
+            gpuBenchmarks = true;
+        else if (argument == "--list")
+            listOnly = true;
+        else
+            std::cerr << "Unknown argument " << argument << std::endl;
+    }
+}
+
+int main (int argc, char** argv) {
+    parseArguments(argc, argv);
+
+    nugie::BenchmarkRunner runner;
+    nugie::registerBufferBenchmarks(runner);
+    nugie::registerUploadBenchmarks(runner);
+    nugie::registerCameraBenchmarks(runner);
+    nugie::registerMeshBenchmarks(runner);
+    nugie::registerJobBenchmarks(runner);
+    nugie::registerDrawQueueBenchmarks(runner);
+    nugie::registerParallelEncoderBenchmarks(runner);
+    nugie::registerFrameBenchmarks(runner);
+    nugie::registerParticleBenchmarks(runner, gpuBenchmarks);
+    nugie::registerCullingBenchmarks(runner, gpuBenchmarks);
+    nugie::registerPrepassBenchmarks(runner, gpuBenchmarks);
+
+    if (listOnly) {
+        runner.list();
+        return 0;
+    }
+
+    // Single-config generators leave the build type empty when none was asked for
+    std::string buildType = std::string(NUGIE_BUILD_TYPE).empty() ? "unspecified" : NUGIE_BUILD_TYPE;
+
+    std::cout << "Commit " << NUGIE_GIT_COMMIT << ", " << buildType << " build, " << settings.repetitions << " samples per benchmark" << std::endl;
+    if (buildType != "Release" && buildType != "RelWithDebInfo") {
+        std::cout << "Warning: not an optimized build, timings will not match the app" << std::endl;
+    }
+
+    std::cout << std::endl;
+    bool passed = runner.run(settings, filter);
+
+    try {
+        if (!jsonPath.empty()) {
+            runner.writeJson(jsonPath, NUGIE_GIT_COMMIT, buildType);
+            std::cout << "Results written to " << jsonPath << std::endl;
+        }
+
+        if (!comparePath.empty()) {
+            runner.compare(comparePath);
+        }
+    } catch (const std::exception &error) {
+        std::cerr << error.what() << std::endl;
+        return 1;
+    }
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,35 @@
+#ifndef NUGIE_BENCHMARKS_HPP
+#define NUGIE_BENCHMARKS_HPP
+
+#include "harness/benchmark.hpp"
+
+namespace nugie {
+    // Every subsystem adds its benchmarks to the runner, in the order they are listed and run
+
+    void registerBufferBenchmarks(BenchmarkRunner &runner);
+
+    void registerUploadBenchmarks(BenchmarkRunner &runner);
+
+    void registerCameraBenchmarks(BenchmarkRunner &runner);
+
+    void registerMeshBenchmarks(BenchmarkRunner &runner);
+
+    void registerJobBenchmarks(BenchmarkRunner &runner);
+
+    void registerDrawQueueBenchmarks(BenchmarkRunner &runner);
+
+    void registerParallelEncoderBenchmarks(BenchmarkRunner &runner);
+
+    void registerFrameBenchmarks(BenchmarkRunner &runner);
+
+    // Only registers anything when gpu is set, the benchmarks then open a headless device on a real adapter
+    void registerParticleBenchmarks(BenchmarkRunner &runner, bool gpu);
+
+    // Also only with gpu, the Hi-Z build and the occlusion cull dispatches timed on the GPU
+    void registerCullingBenchmarks(BenchmarkRunner &runner, bool gpu);
+
+    // Also only with gpu, the GPU time and overdraw of a dense scene with and without the depth prepass
+    void registerPrepassBenchmarks(BenchmarkRunner &runner, bool gpu);
+}
+
+#endif
@@ -0,0 +1,216 @@
+#include "../benchmarks.hpp"
+#include "../../src/device/device.hpp"
+#include "../../src/buffer/master/master_buffer.hpp"
+#include "../../src/buffer/child/child_buffer.hpp"
+#include "../../src/buffer/shadow/shadow_buffer.hpp"
+
+#include <random>
+#include <cstring>
+#include <algorithm>
+#include <glm/glm.hpp>
+
+namespace nugie {
+    namespace {
+        constexpr uint32_t CHILD_COUNT = 4096;
+        constexpr uint64_t CHILD_SIZE = 256;
+
+        constexpr uint32_t WRITE_COUNT = 1024;
+        constexpr uint64_t WRITE_SIZE = 64;
+
+        // An instance array of transforms where one moves per frame
+        constexpr uint32_t INSTANCE_COUNT = 16384;
+
+        MasterBuffer* createBenchmarkBuffer(Device *device, uint64_t size) {
+            wgpu::BufferDescriptor bufferDesc{};
+            bufferDesc.label = "Benchmark Master Buffer";
+            bufferDesc.size = size;
+            bufferDesc.usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::Vertex;
+            bufferDesc.mappedAtCreation = false;
+
+            return device->createMasterBuffer(bufferDesc);
+        }
+
+        void benchmarkCreateRelease(BenchmarkContext &context, bool shuffled) {
+            Device device{ DeviceBackend::Null, 1280, 720 };
+            MasterBuffer *masterBuffer = createBenchmarkBuffer(&device, CHILD_COUNT * CHILD_SIZE);
+
+            // Out of order releases make the free list merge ranges on both sides
+            std::vector<uint32_t> releaseOrder(CHILD_COUNT);
+            for (uint32_t i = 0; i < CHILD_COUNT; i++) {
+                releaseOrder[i] = i;
+            }
+
+            if (shuffled) {
+                std::shuffle(releaseOrder.begin(), releaseOrder.end(), std::mt19937{ 7 });
+            }
+
+            std::vector<ChildBuffer> childBuffers;
+            childBuffers.reserve(CHILD_COUNT);
+
+            context.setItemsPerIteration(CHILD_COUNT);
+            context.run([&]() {
+                for (uint32_t i = 0; i < CHILD_COUNT; i++) {
+                    childBuffers.push_back(masterBuffer->createChildBuffer(CHILD_SIZE));
+                }
+
+                for (uint32_t i : releaseOrder) {
+                    masterBuffer->releaseChildBuffer(childBuffers[i]);
+                }
+
+                childBuffers.clear();
+            });
+
+            delete masterBuffer;
+        }
+    }
+
+    void registerBufferBenchmarks(BenchmarkRunner &runner) {
+        runner.add("master_buffer/create_release/4096", [](BenchmarkContext &context) {
+            benchmarkCreateRelease(context, false);
+        });
+
+        runner.add("master_buffer/create_release_shuffled/4096", [](BenchmarkContext &context) {
+            benchmarkCreateRelease(context, true);
+        });
+
+        // Every other child stays alive, so each create searches a free list of 2048 one-child holes
+        runner.add("master_buffer/reuse_fragmented/2048", [](BenchmarkContext &context) {
+            Device device{ DeviceBackend::Null, 1280, 720 };
+            MasterBuffer *masterBuffer = createBenchmarkBuffer(&device, CHILD_COUNT * CHILD_SIZE);
+
+            std::vector<ChildBuffer> childBuffers;
+            for (uint32_t i = 0; i < CHILD_COUNT; i++) {
+                childBuffers.push_back(masterBuffer->createChildBuffer(CHILD_SIZE));
+            }
+
+            std::vector<ChildBuffer> holes;
+            for (uint32_t i = 0; i < CHILD_COUNT; i += 2) {
+                holes.push_back(childBuffers[i]);
+                masterBuffer->releaseChildBuffer(childBuffers[i]);
+            }
+
+            context.setItemsPerIteration(holes.size());
+            context.run([&]() {
+                for (auto &&hole : holes) {
+                    hole = masterBuffer->createChildBuffer(CHILD_SIZE);
+                }
+
+                for (auto &&hole : holes) {
+                    masterBuffer->releaseChildBuffer(hole);
+                }
+            });
+
+            delete masterBuffer;
+        });
+
+        // One queue write per child, as the per-object uniforms were written
+        runner.add("child_buffer/write_each/1024", [](BenchmarkContext &context) {
+            Device device{ DeviceBackend::Null, 1280, 720 };
+            MasterBuffer *masterBuffer = createBenchmarkBuffer(&device, WRITE_COUNT * WRITE_SIZE);
+
+            std::vector<ChildBuffer> childBuffers;
+            for (uint32_t i = 0; i < WRITE_COUNT; i++) {
+                childBuffers.push_back(masterBuffer->createChildBuffer(WRITE_SIZE));
+            }
+
+            std::vector<uint8_t> data(WRITE_SIZE, 0x5A);
+            auto writeAll = [&]() {
+                for (auto &&childBuffer : childBuffers) {
+                    childBuffer.write(data.data());
+                }
+            };
+
+            device.getCommandLog()->reset();
+            writeAll();
+            context.setCounter("queue_writes", static_cast<double>(device.getCommandLog()->getCount(LoggedCommand::WriteBuffer)));
+
+            context.setItemsPerIteration(WRITE_COUNT);
+            context.run(writeAll);
+
+            delete masterBuffer;
+        });
+
+        // The same children gathered into one staging copy and written with a single queue write
+        runner.add("child_buffer/write_batched/1024", [](BenchmarkContext &context) {
+            Device device{ DeviceBackend::Null, 1280, 720 };
+            MasterBuffer *masterBuffer = createBenchmarkBuffer(&device, WRITE_COUNT * WRITE_SIZE);
+
+            std::vector<ChildBuffer> childBuffers;
+            for (uint32_t i = 0; i < WRITE_COUNT; i++) {
+                childBuffers.push_back(masterBuffer->createChildBuffer(WRITE_SIZE));
+            }
+
+            std::vector<uint8_t> data(WRITE_SIZE, 0x5A);
+            std::vector<uint8_t> staging(WRITE_COUNT * WRITE_SIZE);
+
+            auto writeAll = [&]() {
+                for (auto &&childBuffer : childBuffers) {
+                    std::memcpy(staging.data() + childBuffer.getOffset(), data.data(), childBuffer.getSize());
+                }
+
+                masterBuffer->write(staging.data(), staging.size(), 0);
+            };
+
+            device.getCommandLog()->reset();
+            writeAll();
+            context.setCounter("queue_writes", static_cast<double>(device.getCommandLog()->getCount(LoggedCommand::WriteBuffer)));
+
+            context.setItemsPerIteration(WRITE_COUNT);
+            context.run(writeAll);
+
+            delete masterBuffer;
+        });
+
+        // The whole instance array goes up again because one transform moved
+        runner.add("child_buffer/write_full/16384", [](BenchmarkContext &context) {
+            Device device{ DeviceBackend::Null, 1280, 720 };
+            MasterBuffer *masterBuffer = createBenchmarkBuffer(&device, INSTANCE_COUNT * sizeof(glm::mat4));
+            ChildBuffer childBuffer = masterBuffer->createChildBuffer();
+
+            std::vector<glm::mat4> transforms(INSTANCE_COUNT, glm::mat4{1.0f});
+            uint32_t frame = 0;
+
+            auto update = [&]() {
+                transforms[frame++ % INSTANCE_COUNT][3].y += 1.0f;
+                childBuffer.write(transforms.data());
+            };
+
+            device.getCommandLog()->reset();
+            update();
+            context.setCounter("uploaded_bytes", static_cast<double>(device.getCommandLog()->getBytes(LoggedCommand::WriteBuffer)));
+
+            context.setItemsPerIteration(INSTANCE_COUNT);
+            context.run(update);
+
+            delete masterBuffer;
+        });
+
+        // The same frame through a shadow copy, which still compares the whole array but uploads one transform
+        runner.add("shadow_buffer/write_dirty/16384", [](BenchmarkContext &context) {
+            Device device{ DeviceBackend::Null, 1280, 720 };
+            MasterBuffer *masterBuffer = createBenchmarkBuffer(&device, INSTANCE_COUNT * sizeof(glm::mat4));
+            ShadowBuffer shadowBuffer{ masterBuffer->createChildBuffer() };
+
+            std::vector<glm::mat4> transforms(INSTANCE_COUNT, glm::mat4{1.0f});
+            uint32_t frame = 0;
+
+            auto update = [&]() {
+                transforms[frame++ % INSTANCE_COUNT][3].y += 1.0f;
+                shadowBuffer.write(transforms.data());
+                shadowBuffer.flush();
+            };
+
+            // The first flush uploads everything, steady state is what is measured
+            update();
+
+            device.getCommandLog()->reset();
+            update();
+            context.setCounter("uploaded_bytes", static_cast<double>(device.getCommandLog()->getBytes(LoggedCommand::WriteBuffer)));
+
+            context.setItemsPerIteration(INSTANCE_COUNT);
+            context.run(update);
+
+            delete masterBuffer;
+        });
+    }
+}
@@ -0,0 +1,27 @@
+#include "../benchmarks.hpp"
+#include "../../src/camera/camera.hpp"
+
+namespace nugie {
+    void registerCameraBenchmarks(BenchmarkRunner &runner) {
+        runner.add("camera/get_view_matrix", [](BenchmarkContext &context) {
+            Camera camera{ glm::vec3(0.0f, 0.0f, 3.0f) };
+
+            context.run([&]() {
+                glm::mat4 view = camera.getViewMatrix();
+                doNotOptimize(view);
+            });
+        });
+
+        // updateCameraVectors() is private, setPose() is the cheapest call that runs it
+        runner.add("camera/update_vectors", [](BenchmarkContext &context) {
+            Camera camera{ glm::vec3(0.0f, 0.0f, 3.0f) };
+            float yaw = 0.0f;
+
+            context.run([&]() {
+                yaw = yaw < 360.0f ? yaw + 0.25f : 0.0f;
+                camera.setPose(camera.position, yaw, 15.0f, ZOOM);
+                doNotOptimize(camera.front);
+            });
+        });
+    }
+}
@@ -0,0 +1,184 @@
+#include "../benchmarks.hpp"
+#include "../../src/device/device.hpp"
+#include "../../src/device/upload/upload_queue.hpp"
+#include "../../src/job/system/job_system.hpp"
+
+#include <atomic>
+#include <random>
+#include <cstring>
+#include <algorithm>
+#include <barrier>
+#include <thread>
+#include <string>
+#include <stdexcept>
+
+namespace nugie {
+    namespace {
+        const uint32_t THREAD_COUNTS[] = { 1, 2, 4, 8, 16 };
+
+        constexpr uint32_t PRODUCER_COUNT = 16;
+        constexpr uint32_t REQUESTS_PER_PRODUCER = 1024;
+        constexpr uint64_t REQUEST_SIZE = 64;
+
+        // Small enough that producers keep running into a full queue and staging, and their rings wrap
+        constexpr uint32_t STRESS_CAPACITY = 256;
+        constexpr uint64_t STRESS_STAGING_BYTES = 16 * 1024;
+        constexpr uint64_t STRESS_MAX_SIZE = 1024;
+
+        wgpu::Buffer createBenchmarkBuffer(Device &device, uint64_t size) {
+            wgpu::BufferDescriptor bufferDesc{};
+            bufferDesc.label = "Benchmark Upload Buffer";
+            bufferDesc.size = size;
+            bufferDesc.usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::Storage;
+            bufferDesc.mappedAtCreation = false;
+
+            return device.createBuffer(bufferDesc);
+        }
+    }
+
+    void registerUploadBenchmarks(BenchmarkRunner &runner) {
+        // Every producer writes its own region in order, so the drain joins each region into one queue write
+        for (uint32_t threadCount : THREAD_COUNTS) {
+            runner.addScaling("upload_queue/enqueue_drain", threadCount, [](BenchmarkContext &context, uint32_t threadCount) {
+                Device device{ DeviceBackend::Null, 1280, 720 };
+                JobSystem jobSystem{ threadCount };
+
+                uint64_t regionSize = REQUESTS_PER_PRODUCER * REQUEST_SIZE;
+                wgpu::Buffer buffer = createBenchmarkBuffer(device, regionSize * threadCount);
+
+                // A worker may run several producers' ranges when it steals, so each has room for all of them
+                UploadQueue uploadQueue{ &device, REQUESTS_PER_PRODUCER * PRODUCER_COUNT, regionSize * threadCount };
+
+                std::vector<uint8_t> data(REQUEST_SIZE, 0x5A);
+
+                auto frame = [&]() {
+                    jobSystem.parallelFor(threadCount, 1, [&](uint32_t begin, uint32_t end) {
+                        for (uint32_t producer = begin; producer < end; producer++) {
+                            for (uint32_t i = 0; i < REQUESTS_PER_PRODUCER; i++) {
+                                uploadQueue.enqueueBuffer(buffer, producer * regionSize + i * REQUEST_SIZE, data.data(), REQUEST_SIZE);
+                            }
+                        }
+                    });
+
+                    uploadQueue.drain();
+                };
+
+                device.getCommandLog()->reset();
+                frame();
+                context.setCounter("queue_writes", static_cast<double>(device.getCommandLog()->getCount(LoggedCommand::WriteBuffer)));
+                context.setCounter("rejected", static_cast<double>(uploadQueue.getStats().rejectedCount));
+
+                context.setItemsPerIteration(threadCount * REQUESTS_PER_PRODUCER);
+                context.run(frame);
+
+                device.releaseBuffer(buffer);
+            });
+        }
+
+        // 16 threads racing for a small queue while it is drained, with sizes that make the staging rings wrap.
+        // The producers live across iterations, as a loader's threads would. Every request carries bytes of its
+        // own and writes somewhere in its producer's region, overlapping earlier ones. Each producer applies its
+        // writes to an expected copy of its region, and after every iteration the null device's mirror of the
+        // buffer must match all of them, or the benchmark throws. Timings include the mirror's copies.
+        runner.add("upload_queue/stress/16", [](BenchmarkContext &context) {
+            Device device{ DeviceBackend::Null, 1280, 720 };
+            device.enableBufferMirror();
+
+            UploadQueue uploadQueue{ &device, STRESS_CAPACITY, STRESS_STAGING_BYTES };
+
+            uint64_t regionSize = REQUESTS_PER_PRODUCER * STRESS_MAX_SIZE;
+            wgpu::Buffer buffer = createBenchmarkBuffer(device, regionSize * PRODUCER_COUNT);
+
+            std::vector<std::vector<uint8_t>> expected(PRODUCER_COUNT, std::vector<uint8_t>(regionSize, 0));
+
+            std::barrier start{ PRODUCER_COUNT + 1 };
+            std::atomic<uint32_t> finished{0};
+            bool stop = false;
+
+            std::vector<std::thread> producers;
+            for (uint32_t producer = 0; producer < PRODUCER_COUNT; producer++) {
+                producers.emplace_back([&, producer]() {
+                    std::mt19937 random{ producer };
+                    std::vector<uint8_t> data(STRESS_MAX_SIZE);
+                    uint32_t serial = 0;
+
+                    while (true) {
+                        start.arrive_and_wait();
+                        if (stop) {
+                            return;
+                        }
+
+                        for (uint32_t i = 0; i < REQUESTS_PER_PRODUCER; i++) {
+                            uint64_t size = (random() % (STRESS_MAX_SIZE / 4) + 1) * 4;
+                            uint64_t offset = random() % (regionSize - size) / 4 * 4;
+
+                            // No two requests of any producer carry the same bytes
+                            uint32_t seed = (producer << 24) ^ (serial++ * 2654435761u);
+                            for (uint64_t j = 0; j < size; j++) {
+                                data[j] = static_cast<uint8_t>((seed + static_cast<uint32_t>(j)) * 0x9E3779B1u >> 24);
+                            }
+
+                            while (!uploadQueue.enqueueBuffer(buffer, producer * regionSize + offset, data.data(), size)) {
+                                std::this_thread::yield();
+                            }
+
+                            std::memcpy(expected[producer].data() + offset, data.data(), size);
+                        }
+
+                        finished.fetch_add(1, std::memory_order_release);
+                    }
+                });
+            }
+
+            auto stress = [&]() {
+                finished.store(0, std::memory_order_relaxed);
+                start.arrive_and_wait();
+
+                while (finished.load(std::memory_order_acquire) < PRODUCER_COUNT) {
+                    uploadQueue.drain();
+                }
+
+                // Whatever the producers published after the last drain, which takes at most a queue's worth at once
+                uploadQueue.drain();
+                while (uploadQueue.hasUploaded()) {
+                    uploadQueue.drain();
+                }
+
+                for (uint32_t producer = 0; producer < PRODUCER_COUNT; producer++) {
+                    std::vector<uint8_t> written = device.getBufferMirror()->read(buffer, producer * regionSize, regionSize);
+
+                    if (written != expected[producer]) {
+                        auto mismatch = std::mismatch(written.begin(), written.end(), expected[producer].begin());
+                        throw std::runtime_error("upload queue left byte " + std::to_string(mismatch.first - written.begin())
+                            + " of producer " + std::to_string(producer) + "'s region different from what it enqueued last");
+                    }
+                }
+            };
+
+            // The producers must be stopped whether or not a check failed
+            auto stopProducers = [&]() {
+                stop = true;
+                start.arrive_and_wait();
+
+                for (auto &&producer : producers) {
+                    producer.join();
+                }
+
+                device.releaseBuffer(buffer);
+            };
+
+            try {
+                stress();
+                context.setCounter("rejected_per_request", static_cast<double>(uploadQueue.getStats().rejectedCount) / (PRODUCER_COUNT * REQUESTS_PER_PRODUCER));
+
+                context.setItemsPerIteration(PRODUCER_COUNT * REQUESTS_PER_PRODUCER);
+                context.run(stress);
+            } catch (...) {
+                stopProducers();
+                throw;
+            }
+
+            stopProducers();
+        });
+    }
+}
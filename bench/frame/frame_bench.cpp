@@ -0,0 +1,275 @@
+#include "../benchmarks.hpp"
+#include "../harness/scene_fixture.hpp"
+#include "../../src/device/device.hpp"
+#include "../../src/buffer/master/master_buffer.hpp"
+#include "../../src/buffer/shadow/shadow_buffer.hpp"
+#include "../../src/frame/arena/frame_arena.hpp"
+#include "../../src/job/graph/task_graph.hpp"
+#include "../../src/memory/tracking/allocation_tracker.hpp"
+#include "../../src/render/queue/draw_queue.hpp"
+#include "../../src/render/bundle/parallel_encoder.hpp"
+#include "../../src/memory/arena/linear_arena.hpp"
+
+#include <string>
+#include <iostream>
+#include <stdexcept>
+#include <glm/glm.hpp>
+
+namespace nugie {
+    namespace {
+        constexpr uint32_t DRAW_COUNT = 20000;
+        constexpr uint32_t INSTANCE_COUNT = 4096;
+        constexpr uint32_t FRAMES_IN_FLIGHT = 2;
+        constexpr size_t FRAME_ARENA_SIZE = 4 * 1024 * 1024;
+
+        // Frames before the arenas, id tables and pools have grown to what the frame needs, as in the app
+        constexpr uint32_t WARM_UP_FRAMES = 16;
+        constexpr uint32_t CHECKED_FRAMES = 64;
+
+        // The command log check: every pipeline with every material, so sorting makes runs of equal state.
+        // Each bundle then gets exactly one pipeline and two whole materials.
+        constexpr uint32_t LOG_CHUNK_COUNT = 4;
+        constexpr uint32_t LOG_PIPELINE_COUNT = 2;
+        constexpr uint32_t LOG_MATERIAL_COUNT = 4;
+        constexpr uint32_t LOG_DRAWS_PER_STATE = 128;
+        constexpr uint32_t LOG_DRAW_COUNT = LOG_PIPELINE_COUNT * LOG_MATERIAL_COUNT * LOG_DRAWS_PER_STATE;
+        constexpr uint32_t LOG_INSTANCE_COUNT = 64;
+        constexpr size_t LOG_ARENA_SIZE = 1024 * 1024;
+
+        void expectLogged(CommandLog *commandLog, LoggedCommand command, uint64_t expected) {
+            if (commandLog->getCount(command) != expected) {
+                throw std::runtime_error(std::string("null device logged ") + std::to_string(commandLog->getCount(command)) + " "
+                    + CommandLog::getCommandName(command) + " in a frame, expected " + std::to_string(expected));
+            }
+        }
+    }
+
+    void registerFrameBenchmarks(BenchmarkRunner &runner) {
+        // The CPU side of a frame as the app runs it: a task graph that animates instance transforms into a
+        // shadow buffer, builds and sorts the draw queue in a frame arena and records it on every worker.
+        // In a build with NUGIE_TRACK_ALLOCATIONS it throws if a frame after the warm-up allocates on any thread.
+        runner.add("frame/steady_state", [](BenchmarkContext &context) {
+            Device device{ DeviceBackend::Null, 1280, 720 };
+            SceneFixture scene{ &device, 8, 256, 64 };
+            JobSystem jobSystem;
+
+            std::vector<DrawCommand> drawCommands = scene.createDraws(DRAW_COUNT, 1);
+            std::vector<DrawSortInfo> sortInfos = scene.createSortInfos(DRAW_COUNT, 2);
+
+            wgpu::BufferDescriptor bufferDesc{};
+            bufferDesc.label = "Benchmark Instance Buffer";
+            bufferDesc.size = INSTANCE_COUNT * sizeof(glm::mat4);
+            bufferDesc.usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::Storage;
+            bufferDesc.mappedAtCreation = false;
+
+            MasterBuffer *masterBuffer = device.createMasterBuffer(bufferDesc);
+            ShadowBuffer instanceBuffer{ masterBuffer->createChildBuffer() };
+            std::vector<glm::mat4> transforms(INSTANCE_COUNT, glm::mat4{1.0f});
+
+            FrameArena frameArena{ FRAMES_IN_FLIGHT, FRAME_ARENA_SIZE };
+            std::vector<DrawQueue> drawQueues;
+            for (uint32_t i = 0; i < FRAMES_IN_FLIGHT; i++) {
+                drawQueues.emplace_back(frameArena.getArena(i));
+            }
+
+            ParallelEncoder encoder{ &device, &jobSystem, wgpu::TextureFormat::BGRA8Unorm, wgpu::TextureFormat::Depth24Plus };
+
+            uint64_t frameIndex = 0;
+            DrawQueue *drawQueue = nullptr;
+
+            TaskGraph frameGraph;
+
+            frameGraph.addTask("Update Instances", [&] {
+                jobSystem.parallelFor(INSTANCE_COUNT, 64, [&](uint32_t begin, uint32_t end) {
+                    // One transform in 64 moves per frame
+                    for (uint32_t i = begin; i < end; i++) {
+                        if ((i + frameIndex) % 64 == 0) {
+                            transforms[i][3].y += 1.0f;
+                        }
+                    }
+                });
+
+                instanceBuffer.write(transforms.data());
+                instanceBuffer.flush();
+            });
+
+            TaskId buildTask = frameGraph.addTask("Build Draw Queue", [&] {
+                drawQueue->clear(DRAW_COUNT);
+
+                for (uint32_t i = 0; i < DRAW_COUNT; i++) {
+                    drawQueue->push(drawCommands[i], sortInfos[i]);
+                }
+
+                drawQueue->sort();
+            });
+
+            frameGraph.addTask("Encode Bundles", [&] {
+                encoder.encode(drawQueue->getSortedCommands());
+            }, { buildTask });
+
+            auto frame = [&]() {
+                uint32_t frameSlot = static_cast<uint32_t>(frameIndex % FRAMES_IN_FLIGHT);
+
+                frameArena.beginFrame(frameSlot);
+                drawQueue = &drawQueues[frameSlot];
+
+                frameGraph.execute(jobSystem);
+                frameIndex++;
+            };
+
+            for (uint32_t i = 0; i < WARM_UP_FRAMES; i++) {
+                frame();
+            }
+
+            {
+                AllocationScope allocationScope{ true };
+
+                for (uint32_t i = 0; i < CHECKED_FRAMES; i++) {
+                    frame();
+                }
+
+                if (allocationScope.getAllocationCount() > 0) {
+                    throw std::runtime_error(std::to_string(CHECKED_FRAMES) + " steady-state frames allocated "
+                        + std::to_string(allocationScope.getAllocationCount()) + " times on the heap");
+                }
+            }
+
+            if (AllocationScope::isTrackingEnabled()) {
+                context.setCounter("allocations_per_frame", 0.0);
+            }
+
+            context.setItemsPerIteration(DRAW_COUNT);
+            context.run(frame);
+
+            delete masterBuffer;
+        });
+
+        // A null-device frame through the draw queue and the parallel encoder, checked against the command
+        // log after every frame: the draws, the state changes the sorted bundles need, the bundles and the
+        // one transform that moved. Anything else recorded in a frame, such as a create, makes it throw.
+        runner.add("frame/command_log", [](BenchmarkContext &context) {
+            Device device{ DeviceBackend::Null, 1280, 720 };
+            JobSystem jobSystem{ LOG_CHUNK_COUNT };
+            CommandLog *commandLog = device.getCommandLog();
+
+            std::vector<wgpu::RenderPipeline> pipelines;
+            for (uint32_t i = 0; i < LOG_PIPELINE_COUNT; i++) {
+                pipelines.push_back(device.createRenderPipeline(wgpu::RenderPipelineDescriptor{}));
+            }
+
+            std::vector<wgpu::BindGroup> materials;
+            for (uint32_t i = 0; i < LOG_MATERIAL_COUNT; i++) {
+                materials.push_back(device.createBindGroup(wgpu::BindGroupDescriptor{}));
+            }
+
+            wgpu::BindGroup sceneBindGroup = device.createBindGroup(wgpu::BindGroupDescriptor{});
+
+            wgpu::BufferDescriptor bufferDesc{};
+            bufferDesc.label = "Benchmark Mesh Buffer";
+            bufferDesc.size = 4096;
+            bufferDesc.usage = wgpu::BufferUsage::Vertex | wgpu::BufferUsage::Index | wgpu::BufferUsage::CopyDst;
+            bufferDesc.mappedAtCreation = false;
+
+            wgpu::Buffer meshBuffers[3];
+            for (auto &&meshBuffer : meshBuffers) {
+                meshBuffer = device.createBuffer(bufferDesc);
+            }
+
+            // Pushed interleaved, so only the sort brings equal state together
+            std::vector<DrawCommand> drawCommands;
+            std::vector<DrawSortInfo> sortInfos;
+
+            for (uint32_t i = 0; i < LOG_DRAW_COUNT; i++) {
+                DrawCommand drawCommand{};
+                drawCommand.pipeline = pipelines[i % LOG_PIPELINE_COUNT];
+                drawCommand.sceneBindGroup = sceneBindGroup;
+                drawCommand.objectBindGroup = materials[i / LOG_PIPELINE_COUNT % LOG_MATERIAL_COUNT];
+                drawCommand.positionBuffer = BufferInfo{ meshBuffers[0], bufferDesc.size, 0 };
+                drawCommand.textCoordBuffer = BufferInfo{ meshBuffers[1], bufferDesc.size, 0 };
+                drawCommand.indexBuffer = BufferInfo{ meshBuffers[2], bufferDesc.size, 0 };
+                drawCommand.indexCount = 36;
+
+                DrawSortInfo sortInfo{};
+                sortInfo.depth = static_cast<float>(i % 97) / 97.0f;
+
+                drawCommands.push_back(drawCommand);
+                sortInfos.push_back(sortInfo);
+            }
+
+            bufferDesc.label = "Benchmark Instance Buffer";
+            bufferDesc.size = LOG_INSTANCE_COUNT * sizeof(glm::mat4);
+            bufferDesc.usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::Storage;
+
+            MasterBuffer *masterBuffer = device.createMasterBuffer(bufferDesc);
+            ShadowBuffer instanceBuffer{ masterBuffer->createChildBuffer() };
+            std::vector<glm::mat4> transforms(LOG_INSTANCE_COUNT, glm::mat4{1.0f});
+
+            instanceBuffer.write(transforms.data());
+            instanceBuffer.flush();
+
+            LinearArena arena{ LOG_ARENA_SIZE };
+            DrawQueue drawQueue{ &arena };
+            ParallelEncoder encoder{ &device, &jobSystem, wgpu::TextureFormat::BGRA8Unorm, wgpu::TextureFormat::Depth24Plus };
+
+            uint64_t frameIndex = 0;
+
+            auto frame = [&]() {
+                commandLog->reset();
+
+                // One transform moves, a single block of the shadow buffer
+                transforms[frameIndex % LOG_INSTANCE_COUNT][3].y += 1.0f;
+                instanceBuffer.write(transforms.data());
+                instanceBuffer.flush();
+
+                arena.reset();
+                drawQueue.clear(LOG_DRAW_COUNT);
+
+                for (uint32_t i = 0; i < LOG_DRAW_COUNT; i++) {
+                    drawQueue.push(drawCommands[i], sortInfos[i]);
+                }
+
+                drawQueue.sort();
+                encoder.encode(drawQueue.getSortedCommands());
+                encoder.execute(nullptr);
+
+                frameIndex++;
+
+                // Every bundle sets a pipeline, both vertex streams, both bind groups and the index buffer once,
+                // and the object bind group once more where its second material starts
+                expectLogged(commandLog, LoggedCommand::DrawIndexed, LOG_DRAW_COUNT);
+                expectLogged(commandLog, LoggedCommand::SetPipeline, LOG_CHUNK_COUNT);
+                expectLogged(commandLog, LoggedCommand::SetVertexBuffer, LOG_CHUNK_COUNT * 2);
+                expectLogged(commandLog, LoggedCommand::SetBindGroup, LOG_CHUNK_COUNT * 3);
+                expectLogged(commandLog, LoggedCommand::SetIndexBuffer, LOG_CHUNK_COUNT);
+                expectLogged(commandLog, LoggedCommand::FinishBundle, LOG_CHUNK_COUNT);
+                expectLogged(commandLog, LoggedCommand::ExecuteBundles, 1);
+                expectLogged(commandLog, LoggedCommand::WriteBuffer, 1);
+
+                if (commandLog->getBytes(LoggedCommand::WriteBuffer) != sizeof(glm::mat4)) {
+                    throw std::runtime_error("null device logged " + std::to_string(commandLog->getBytes(LoggedCommand::WriteBuffer))
+                        + " bytes of buffer writes in a frame, expected " + std::to_string(sizeof(glm::mat4)));
+                }
+
+                // Seven state changes and the finish per bundle, the execute and the write
+                uint64_t expectedTotal = LOG_DRAW_COUNT + LOG_CHUNK_COUNT * 8 + 2;
+                if (commandLog->getTotalCount() != expectedTotal) {
+                    commandLog->print(std::cerr);
+                    throw std::runtime_error("null device logged " + std::to_string(commandLog->getTotalCount())
+                        + " commands in a frame, expected " + std::to_string(expectedTotal));
+                }
+            };
+
+            frame();
+            context.setCounter("state_changes", static_cast<double>(commandLog->getStateChanges()));
+
+            context.setItemsPerIteration(LOG_DRAW_COUNT);
+            context.run(frame);
+
+            delete masterBuffer;
+
+            for (auto &&meshBuffer : meshBuffers) {
+                device.releaseBuffer(meshBuffer);
+            }
+        });
+    }
+}
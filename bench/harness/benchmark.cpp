@@ -0,0 +1,355 @@
+#include "benchmark.hpp"
+
+#include <cmath>
+#include <ctime>
+#include <thread>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace nugie {
+    namespace {
+        std::string escapeJson(const std::string &text) {
+            std::string escaped;
+            for (char c : text) {
+                if (c == '"' || c == '\\') {
+                    escaped.push_back('\\');
+                }
+
+                escaped.push_back(c);
+            }
+
+            return escaped;
+        }
+
+        // Value of a "key": value line as written by writeJson(), with the quotes of strings removed
+        bool readJsonField(const std::string &line, const char* key, std::string &value) {
+            std::string pattern = std::string("\"") + key + "\": ";
+            size_t found = line.find(pattern);
+            if (found == std::string::npos) {
+                return false;
+            }
+
+            value = line.substr(found + pattern.size());
+            while (!value.empty() && (value.back() == ',' || value.back() == '\r')) {
+                value.pop_back();
+            }
+
+            if (value.size() >= 2 && value.front() == '"' && value.back() == '"') {
+                value = value.substr(1, value.size() - 2);
+            }
+
+            return true;
+        }
+    }
+
+    // ================================ Benchmark Context ================================
+
+    BenchmarkContext::BenchmarkContext(BenchmarkSettings settings) : settings{settings} {
+        this->settings.repetitions = std::max(this->settings.repetitions, 3u);
+    }
+
+    void BenchmarkContext::setCounter(const std::string &name, double value) {
+        for (auto &&counter : this->counters) {
+            if (counter.name == name) {
+                counter.value = value;
+                return;
+            }
+        }
+
+        this->counters.push_back(BenchmarkCounter{ name, value });
+    }
+
+    BenchmarkResult BenchmarkContext::summarize(const std::string &name) {
+        BenchmarkResult result{};
+        result.name = name;
+        result.iterationsPerSample = this->iterationsPerSample;
+        result.sampleCount = static_cast<uint32_t>(this->samples.size());
+        result.itemsPerIteration = this->itemsPerIteration;
+        result.counters = this->counters;
+
+        if (this->samples.empty()) {
+            return result;
+        }
+
+        std::vector<double> sorted = this->samples;
+        std::sort(sorted.begin(), sorted.end());
+
+        size_t n = sorted.size();
+        auto median = [](const std::vector<double> &values) {
+            size_t count = values.size();
+            return count % 2 == 1 ? values[count / 2] : (values[count / 2 - 1] + values[count / 2]) * 0.5;
+        };
+
+        result.medianNs = median(sorted);
+        result.minNs = sorted.front();
+        result.maxNs = sorted.back();
+
+        double sum = 0.0;
+        for (double sample : sorted) {
+            sum += sample;
+        }
+
+        result.meanNs = sum / static_cast<double>(n);
+
+        double squares = 0.0;
+        for (double sample : sorted) {
+            squares += (sample - result.meanNs) * (sample - result.meanNs);
+        }
+
+        result.stddevNs = n > 1 ? std::sqrt(squares / static_cast<double>(n - 1)) : 0.0;
+
+        std::vector<double> deviations;
+        for (double sample : sorted) {
+            deviations.push_back(std::abs(sample - result.medianNs));
+        }
+
+        std::sort(deviations.begin(), deviations.end());
+        result.madNs = median(deviations);
+
+        // The median lies between these two order statistics with 95% probability, whatever the distribution
+        double halfWidth = 1.96 * std::sqrt(static_cast<double>(n)) * 0.5;
+        size_t lowRank = static_cast<size_t>(std::max(1.0, std::floor(static_cast<double>(n) * 0.5 - halfWidth)));
+        size_t highRank = static_cast<size_t>(std::min(static_cast<double>(n), std::ceil(static_cast<double>(n) * 0.5 + halfWidth + 1.0)));
+
+        result.ciLowNs = sorted[lowRank - 1];
+        result.ciHighNs = sorted[highRank - 1];
+
+        // 1.4826 scales the MAD to a standard deviation for normal data
+        double scaledMad = 1.4826 * result.madNs;
+        for (double sample : sorted) {
+            if (scaledMad > 0.0 && std::abs(sample - result.medianNs) > 3.0 * scaledMad) {
+                result.outlierCount++;
+            }
+        }
+
+        result.itemsPerSecond = result.medianNs > 0.0 ? static_cast<double>(result.itemsPerIteration) * 1e9 / result.medianNs : 0.0;
+
+        return result;
+    }
+
+    // ================================ Benchmark Runner ================================
+
+    void BenchmarkRunner::add(const std::string &name, BenchmarkFunction function) {
+        this->entries.push_back(Entry{ name, std::move(function), "", 0 });
+    }
+
+    void BenchmarkRunner::addScaling(const std::string &name, uint32_t threadCount, std::function<void(BenchmarkContext &context, uint32_t threadCount)> function) {
+        BenchmarkFunction bound = [function, threadCount](BenchmarkContext &context) {
+            function(context, threadCount);
+        };
+
+        this->entries.push_back(Entry{ name + "/threads:" + std::to_string(threadCount), std::move(bound), name, threadCount });
+    }
+
+    bool BenchmarkRunner::run(BenchmarkSettings settings, const std::string &filter) {
+        this->results.clear();
+        bool passed = true;
+
+        for (auto &&entry : this->entries) {
+            if (!filter.empty() && entry.name.find(filter) == std::string::npos) {
+                continue;
+            }
+
+            // Benchmarks that check what they measure throw when the check fails, the others still run
+            BenchmarkContext context{ settings };
+            try {
+                entry.function(context);
+            } catch (const std::exception &error) {
+                std::cerr << entry.name << ": " << error.what() << std::endl;
+                passed = false;
+                continue;
+            }
+
+            BenchmarkResult result = context.summarize(entry.name);
+            if (result.sampleCount == 0) {
+                std::cerr << entry.name << ": the benchmark never called run()" << std::endl;
+                continue;
+            }
+
+            result.scalingGroup = entry.scalingGroup;
+            result.threadCount = entry.threadCount;
+
+            double relativeDeviation = result.medianNs > 0.0 ? 100.0 * 1.4826 * result.madNs / result.medianNs : 0.0;
+
+            std::cout << std::left << std::setw(56) << result.name << std::right
+                << std::setw(12) << formatTime(result.medianNs)
+                << "  [" << formatTime(result.ciLowNs) << ", " << formatTime(result.ciHighNs) << "]"
+                << "  +-" << std::fixed << std::setprecision(1) << relativeDeviation << "%";
+
+            if (result.itemsPerIteration > 1) {
+                std::cout << "  " << std::setprecision(2) << result.itemsPerSecond / 1e6 << " M items/s";
+            }
+
+            for (auto &&counter : result.counters) {
+                std::cout << "  " << counter.name << "=" << std::setprecision(2) << counter.value;
+            }
+
+            if (result.outlierCount > 0) {
+                std::cout << "  (" << result.outlierCount << " outliers)";
+            }
+
+            std::cout << std::defaultfloat << std::endl;
+
+            this->results.push_back(std::move(result));
+        }
+
+        std::cout << std::endl;
+        this->addScalingCounters();
+
+        return passed;
+    }
+
+    void BenchmarkRunner::list() {
+        for (auto &&entry : this->entries) {
+            std::cout << entry.name << std::endl;
+        }
+    }
+
+    void BenchmarkRunner::writeJson(const std::string &path, const std::string &commit, const std::string &buildType) {
+        std::ofstream file{ path };
+        if (!file) {
+            throw std::runtime_error("failed to open benchmark output: " + path);
+        }
+
+        std::time_t now = std::time(nullptr);
+        char date[32];
+        std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+        file << std::setprecision(10);
+        file << "{" << std::endl;
+        file << "  \"context\": {" << std::endl;
+        file << "    \"date\": \"" << date << "\"," << std::endl;
+        file << "    \"commit\": \"" << escapeJson(commit) << "\"," << std::endl;
+        file << "    \"build_type\": \"" << escapeJson(buildType) << "\"," << std::endl;
+        file << "    \"hardware_concurrency\": " << std::thread::hardware_concurrency() << std::endl;
+        file << "  }," << std::endl;
+        file << "  \"benchmarks\": [" << std::endl;
+
+        for (size_t i = 0; i < this->results.size(); i++) {
+            const BenchmarkResult &result = this->results[i];
+
+            // One field per line, compare() depends on it
+            file << "    {" << std::endl;
+            file << "      \"name\": \"" << escapeJson(result.name) << "\"," << std::endl;
+            file << "      \"iterations_per_sample\": " << result.iterationsPerSample << "," << std::endl;
+            file << "      \"samples\": " << result.sampleCount << "," << std::endl;
+            file << "      \"median_ns\": " << result.medianNs << "," << std::endl;
+            file << "      \"mean_ns\": " << result.meanNs << "," << std::endl;
+            file << "      \"stddev_ns\": " << result.stddevNs << "," << std::endl;
+            file << "      \"min_ns\": " << result.minNs << "," << std::endl;
+            file << "      \"max_ns\": " << result.maxNs << "," << std::endl;
+            file << "      \"mad_ns\": " << result.madNs << "," << std::endl;
+            file << "      \"ci_low_ns\": " << result.ciLowNs << "," << std::endl;
+            file << "      \"ci_high_ns\": " << result.ciHighNs << "," << std::endl;
+            file << "      \"outliers\": " << result.outlierCount << "," << std::endl;
+            file << "      \"items_per_iteration\": " << result.itemsPerIteration << "," << std::endl;
+            file << "      \"items_per_second\": " << result.itemsPerSecond << "," << std::endl;
+
+            file << "      \"counters\": {";
+            for (size_t j = 0; j < result.counters.size(); j++) {
+                file << (j > 0 ? ", " : " ") << "\"" << escapeJson(result.counters[j].name) << "\": " << result.counters[j].value;
+            }
+
+            file << (result.counters.empty() ? "}" : " }") << std::endl;
+            file << "    }" << (i + 1 < this->results.size() ? "," : "") << std::endl;
+        }
+
+        file << "  ]" << std::endl;
+        file << "}" << std::endl;
+
+        if (!file) {
+            throw std::runtime_error("failed to write benchmark output: " + path);
+        }
+    }
+
+    void BenchmarkRunner::compare(const std::string &baselinePath) {
+        struct Baseline {
+            double medianNs = 0.0;
+            double ciLowNs = 0.0;
+            double ciHighNs = 0.0;
+        };
+
+        std::ifstream file{ baselinePath };
+        if (!file) {
+            throw std::runtime_error("failed to open benchmark baseline: " + baselinePath);
+        }
+
+        std::unordered_map<std::string, Baseline> baselines;
+        std::string line, name, value;
+
+        while (std::getline(file, line)) {
+            if (readJsonField(line, "name", value)) {
+                name = value;
+            } else if (readJsonField(line, "median_ns", value)) {
+                baselines[name].medianNs = std::stod(value);
+            } else if (readJsonField(line, "ci_low_ns", value)) {
+                baselines[name].ciLowNs = std::stod(value);
+            } else if (readJsonField(line, "ci_high_ns", value)) {
+                baselines[name].ciHighNs = std::stod(value);
+            }
+        }
+
+        std::cout << std::endl << "Against " << baselinePath << ":" << std::endl;
+
+        for (auto &&result : this->results) {
+            auto found = baselines.find(result.name);
+            if (found == baselines.end() || found->second.medianNs <= 0.0) {
+                std::cout << std::left << std::setw(56) << result.name << std::right << "  new" << std::endl;
+                continue;
+            }
+
+            const Baseline &baseline = found->second;
+            double change = 100.0 * (result.medianNs - baseline.medianNs) / baseline.medianNs;
+            bool significant = result.ciHighNs < baseline.ciLowNs || result.ciLowNs > baseline.ciHighNs;
+
+            std::cout << std::left << std::setw(56) << result.name << std::right
+                << std::setw(12) << formatTime(baseline.medianNs) << " -> " << std::setw(10) << formatTime(result.medianNs)
+                << "  " << std::showpos << std::fixed << std::setprecision(1) << change << "%" << std::noshowpos << std::defaultfloat
+                << (significant ? (change < 0.0 ? "  faster" : "  slower") : "  within noise") << std::endl;
+        }
+    }
+
+    void BenchmarkRunner::addScalingCounters() {
+        for (auto &&result : this->results) {
+            if (result.scalingGroup.empty()) {
+                continue;
+            }
+
+            for (auto &&single : this->results) {
+                if (single.scalingGroup != result.scalingGroup || single.threadCount != 1 || result.medianNs <= 0.0) {
+                    continue;
+                }
+
+                double speedup = single.medianNs / result.medianNs;
+                double efficiency = speedup / static_cast<double>(result.threadCount);
+
+                result.counters.push_back(BenchmarkCounter{ "speedup", speedup });
+                result.counters.push_back(BenchmarkCounter{ "efficiency", efficiency });
+
+                std::cout << std::left << std::setw(56) << result.name << std::right << "  speedup " << std::fixed << std::setprecision(2)
+                    << speedup << "x, efficiency " << std::setprecision(0) << efficiency * 100.0 << "%" << std::defaultfloat << std::endl;
+            }
+        }
+    }
+
+    std::string BenchmarkRunner::formatTime(double nanoseconds) {
+        std::ostringstream stream;
+        stream << std::fixed << std::setprecision(nanoseconds < 10.0 ? 2 : 1);
+
+        if (nanoseconds < 1e3) {
+            stream << nanoseconds << " ns";
+        } else if (nanoseconds < 1e6) {
+            stream << nanoseconds / 1e3 << " us";
+        } else if (nanoseconds < 1e9) {
+            stream << nanoseconds / 1e6 << " ms";
+        } else {
+            stream << nanoseconds / 1e9 << " s";
+        }
+
+        return stream.str();
+    }
+}
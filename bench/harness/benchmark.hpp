@@ -0,0 +1,174 @@
+#ifndef NUGIE_BENCHMARK_HPP
+#define NUGIE_BENCHMARK_HPP
+
+#include <chrono>
+#include <string>
+#include <algorithm>
+#include <vector>
+#include <functional>
+
+namespace nugie {
+    struct BenchmarkSettings {
+        // Timed samples kept per benchmark, after one warm-up sample that is thrown away
+        uint32_t repetitions = 30;
+
+        // Iterations per sample are grown until one sample takes at least this long,
+        // so timer resolution and loop overhead stay far below the measurement
+        double minSampleSeconds = 0.01;
+    };
+
+    struct BenchmarkCounter {
+        std::string name;
+        double value;
+    };
+
+    // Per-iteration times of one benchmark, in nanoseconds
+    struct BenchmarkResult {
+        std::string name;
+
+        // Set for benchmarks added with addScaling()
+        std::string scalingGroup;
+        uint32_t threadCount = 0;
+
+        uint64_t iterationsPerSample = 0;
+        uint32_t sampleCount = 0;
+
+        double medianNs = 0.0;
+        double meanNs = 0.0;
+        double stddevNs = 0.0;
+        double minNs = 0.0;
+        double maxNs = 0.0;
+
+        // Median absolute deviation, robust against the odd preempted sample
+        double madNs = 0.0;
+
+        // Distribution-free 95% confidence interval of the median, from order statistics
+        double ciLowNs = 0.0;
+        double ciHighNs = 0.0;
+
+        // Samples further than 3 scaled MADs from the median
+        uint32_t outlierCount = 0;
+
+        uint64_t itemsPerIteration = 1;
+        double itemsPerSecond = 0.0;
+
+        std::vector<BenchmarkCounter> counters;
+    };
+
+    // Handed to a benchmark function, which does its setup, calls run() with the code to time and tears down after
+    class BenchmarkContext {
+    public:
+        BenchmarkContext(BenchmarkSettings settings);
+
+        // Calibrates the iteration count, then records the timed samples of body()
+        template<typename F>
+        void run(F &&body) {
+            uint64_t iterations = 1;
+
+            // The calibration runs double as warm-up, the first sample at the final count is discarded too
+            while (true) {
+                double seconds = this->timeLoop(body, iterations);
+                if (seconds >= this->settings.minSampleSeconds || iterations >= MAX_ITERATIONS) {
+                    break;
+                }
+
+                double wanted = seconds > 0.0 ? this->settings.minSampleSeconds * 1.2 / seconds : 10.0;
+                iterations = std::min<uint64_t>(MAX_ITERATIONS, static_cast<uint64_t>(static_cast<double>(iterations) * std::clamp(wanted, 2.0, 10.0)));
+            }
+
+            this->timeLoop(body, iterations);
+
+            this->iterationsPerSample = iterations;
+            this->samples.clear();
+
+            for (uint32_t i = 0; i < this->settings.repetitions; i++) {
+                this->samples.push_back(this->timeLoop(body, iterations) * 1e9 / static_cast<double>(iterations));
+            }
+        }
+
+        // Work done by one iteration, such as the number of draws sorted, for the throughput figure
+        void setItemsPerIteration(uint64_t items) { this->itemsPerIteration = items; }
+
+        // Extra figures reported with the result, such as state changes per frame
+        void setCounter(const std::string &name, double value);
+
+        BenchmarkResult summarize(const std::string &name);
+
+    private:
+        static constexpr uint64_t MAX_ITERATIONS = uint64_t(1) << 32;
+
+        using Clock = std::chrono::steady_clock;
+
+        BenchmarkSettings settings;
+
+        uint64_t iterationsPerSample = 0;
+        uint64_t itemsPerIteration = 1;
+        std::vector<double> samples;
+        std::vector<BenchmarkCounter> counters;
+
+        template<typename F>
+        double timeLoop(F &body, uint64_t iterations) {
+            Clock::time_point start = Clock::now();
+
+            for (uint64_t i = 0; i < iterations; i++) {
+                body();
+            }
+
+            return std::chrono::duration<double>(Clock::now() - start).count();
+        }
+    };
+
+    // Keeps the compiler from optimizing away a value a benchmark computes and never uses
+    template<typename T>
+    inline void doNotOptimize(const T &value) {
+        #if defined(__GNUC__) || defined(__clang__)
+            asm volatile("" : : "r,m"(value) : "memory");
+        #else
+            static volatile const void *sink;
+            sink = &value;
+        #endif
+    }
+
+    class BenchmarkRunner {
+    public:
+        using BenchmarkFunction = std::function<void(BenchmarkContext &context)>;
+
+        void add(const std::string &name, BenchmarkFunction function);
+
+        // Benchmarks of one scaling group share a name and differ in thread count,
+        // each gets speedup and efficiency counters against the single thread result
+        void addScaling(const std::string &name, uint32_t threadCount, std::function<void(BenchmarkContext &context, uint32_t threadCount)> function);
+
+        // Runs every benchmark whose name contains the filter, printing a line per result.
+        // Returns false when one of them threw, such as a check on what it measured.
+        bool run(BenchmarkSettings settings, const std::string &filter);
+
+        void list();
+
+        const std::vector<BenchmarkResult>& getResults() { return this->results; }
+
+        // Throws when the file cannot be written
+        void writeJson(const std::string &path, const std::string &commit, const std::string &buildType);
+
+        // Prints the change of every median against a JSON file from an earlier run. Changes are only called
+        // significant when the two confidence intervals do not overlap.
+        void compare(const std::string &baselinePath);
+
+    private:
+        struct Entry {
+            std::string name;
+            BenchmarkFunction function;
+            std::string scalingGroup;
+            uint32_t threadCount = 0;
+        };
+
+        std::vector<Entry> entries;
+        std::vector<BenchmarkResult> results;
+
+        void addScalingCounters();
+
+        static std::string formatTime(double nanoseconds);
+    };
+}
+
+#endif
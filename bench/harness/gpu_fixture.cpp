@@ -0,0 +1,80 @@
+#include "gpu_fixture.hpp"
+
+#include <thread>
+#include <stdexcept>
+
+namespace nugie {
+    namespace {
+        // The timer's and a few stats readbacks per frame in flight
+        constexpr uint32_t MAX_READBACKS_IN_FLIGHT = 16;
+    }
+
+    GpuFixture::GpuFixture()
+    : device{ "NugieBench", 64, 64, wgpu::PresentMode::Fifo, true },
+      shaderLibrary{ &this->device, "../asset/shaders/" },
+      frameSync{ &this->device, FRAMES_IN_FLIGHT },
+      readbackRing{ &this->device, &this->frameSync, MAX_READBACKS_IN_FLIGHT },
+      gpuTimer{ &this->device, &this->readbackRing, FRAMES_IN_FLIGHT }
+    {
+
+    }
+
+    GpuFixture::~GpuFixture() {
+        this->waitIdle();
+    }
+
+    void GpuFixture::requireTimestamps() {
+        if (!this->gpuTimer.isSupported()) {
+            throw std::runtime_error("the adapter has no timestamp queries");
+        }
+    }
+
+    uint32_t GpuFixture::beginFrame(nugie::RenderGraph &renderGraph) {
+        this->frameSlot = this->frameSync.beginFrame();
+
+        this->readbackRing.deliver();
+
+        renderGraph.setTimestampWrites(this->gpuTimer.getQuerySet(), this->gpuTimer.getBeginIndex(this->frameSlot), this->gpuTimer.getEndIndex(this->frameSlot));
+        return this->frameSlot;
+    }
+
+    wgpu::CommandEncoder GpuFixture::createCommandEncoder() {
+        wgpu::CommandEncoderDescriptor commandDesc{};
+        commandDesc.label = "GPU Bench Encoder";
+        commandDesc.nextInChain = nullptr;
+
+        return this->device.createCommandEncoder(commandDesc);
+    }
+
+    void GpuFixture::endFrame(wgpu::CommandEncoder commandEncoder) {
+        this->gpuTimer.resolve(commandEncoder, this->frameSlot);
+
+        wgpu::CommandBuffer commandBuffer = commandEncoder.finish();
+        commandEncoder.release();
+
+        this->device.submit(1, &commandBuffer);
+        commandBuffer.release();
+
+        this->readbackRing.mapPending();
+        this->frameSync.endFrame();
+    }
+
+    void GpuFixture::waitIdle() {
+        this->frameSync.waitIdle();
+
+        while (this->readbackRing.getInFlightCount() > 0) {
+            this->readbackRing.deliver();
+            std::this_thread::yield();
+        }
+    }
+
+    double GpuFixture::collectGpuTimeMs() {
+        uint64_t sampleCount = this->gpuTimer.getSampleCount() - this->collectedSampleCount;
+        double timeMs = this->gpuTimer.getTotalTimeMs() - this->collectedTimeMs;
+
+        this->collectedSampleCount = this->gpuTimer.getSampleCount();
+        this->collectedTimeMs = this->gpuTimer.getTotalTimeMs();
+
+        return sampleCount > 0 ? timeMs / sampleCount : -1.0;
+    }
+}
@@ -0,0 +1,59 @@
+#ifndef NUGIE_GPU_FIXTURE_HPP
+#define NUGIE_GPU_FIXTURE_HPP
+
+#include "../../src/device/device.hpp"
+#include "../../src/shader/library/shader_library.hpp"
+#include "../../src/frame/sync/frame_sync.hpp"
+#include "../../src/render/readback/readback_ring.hpp"
+#include "../../src/render/timing/gpu_timer.hpp"
+#include "../../src/render/graph/render_graph.hpp"
+
+namespace nugie {
+    // A headless device on a real adapter, with frames paced like the app's and every frame's render graph
+    // timed on the GPU. The timestamps come back through a readback ring a few frames later.
+    class GpuFixture {
+    public:
+        static constexpr uint32_t FRAMES_IN_FLIGHT = 2;
+
+        GpuFixture();
+        ~GpuFixture();
+
+        nugie::Device* getDevice() { return &this->device; }
+
+        nugie::ShaderLibrary* getShaderLibrary() { return &this->shaderLibrary; }
+
+        nugie::ReadbackRing* getReadbackRing() { return &this->readbackRing; }
+
+        // Throws when the adapter has no timestamp queries, the GPU benchmarks measure nothing else
+        void requireTimestamps();
+
+        // Waits for the frame's slot, delivers finished readbacks and times the graph, returns the slot
+        uint32_t beginFrame(nugie::RenderGraph &renderGraph);
+
+        wgpu::CommandEncoder createCommandEncoder();
+
+        // Resolves the timestamps, submits the encoder and starts mapping the frame's readbacks
+        void endFrame(wgpu::CommandEncoder commandEncoder);
+
+        // Waits until every frame finished and every readback was delivered
+        void waitIdle();
+
+        // Average GPU time of the frames delivered since the last call, negative when none was
+        double collectGpuTimeMs();
+
+    private:
+        nugie::Device device;
+        nugie::ShaderLibrary shaderLibrary;
+        nugie::FrameSync frameSync;
+        nugie::ReadbackRing readbackRing;
+        nugie::GpuTimer gpuTimer;
+
+        uint32_t frameSlot = 0;
+
+        // Of the timer, at the last collectGpuTimeMs()
+        uint64_t collectedSampleCount = 0;
+        double collectedTimeMs = 0.0;
+    };
+}
+
+#endif
@@ -0,0 +1,89 @@
+#include "scene_fixture.hpp"
+
+#include <random>
+
+namespace nugie {
+    SceneFixture::SceneFixture(nugie::Device *device, uint32_t pipelineCount, uint32_t materialCount, uint32_t meshCount) : device{device} {
+        for (uint32_t i = 0; i < pipelineCount; i++) {
+            this->pipelines.push_back(this->device->createRenderPipeline(wgpu::RenderPipelineDescriptor{}));
+        }
+
+        for (uint32_t i = 0; i < materialCount; i++) {
+            this->materials.push_back(this->device->createBindGroup(wgpu::BindGroupDescriptor{}));
+        }
+
+        // Position, texture coordinate and index buffer of every mesh
+        wgpu::BufferDescriptor bufferDesc{};
+        bufferDesc.label = "Benchmark Mesh Buffer";
+        bufferDesc.usage = wgpu::BufferUsage::Vertex | wgpu::BufferUsage::Index | wgpu::BufferUsage::CopyDst;
+        bufferDesc.size = MESH_BUFFER_SIZE;
+        bufferDesc.mappedAtCreation = false;
+
+        for (uint32_t i = 0; i < meshCount * 3; i++) {
+            this->meshBuffers.push_back(this->device->createBuffer(bufferDesc));
+        }
+
+        this->prepassPipeline = this->device->createRenderPipeline(wgpu::RenderPipelineDescriptor{});
+        this->sceneBindGroup = this->device->createBindGroup(wgpu::BindGroupDescriptor{});
+    }
+
+    SceneFixture::~SceneFixture() {
+        for (auto &&buffer : this->meshBuffers) {
+            this->device->releaseBuffer(buffer);
+        }
+    }
+
+    std::vector<DrawCommand> SceneFixture::createDraws(uint32_t drawCount, uint32_t seed) {
+        std::mt19937 random{ seed };
+        std::vector<DrawCommand> drawCommands;
+        drawCommands.reserve(drawCount);
+
+        for (uint32_t i = 0; i < drawCount; i++) {
+            size_t mesh = random() % (this->meshBuffers.size() / 3);
+
+            DrawCommand drawCommand{};
+            drawCommand.pipeline = this->pipelines[random() % this->pipelines.size()];
+            drawCommand.sceneBindGroup = this->sceneBindGroup;
+            drawCommand.objectBindGroup = this->materials[random() % this->materials.size()];
+            drawCommand.positionBuffer = BufferInfo{ this->meshBuffers[mesh * 3], MESH_BUFFER_SIZE, 0 };
+            drawCommand.textCoordBuffer = BufferInfo{ this->meshBuffers[mesh * 3 + 1], MESH_BUFFER_SIZE, 0 };
+            drawCommand.indexBuffer = BufferInfo{ this->meshBuffers[mesh * 3 + 2], MESH_BUFFER_SIZE, 0 };
+            drawCommand.indexCount = MESH_INDEX_COUNT;
+
+            drawCommands.push_back(drawCommand);
+        }
+
+        return drawCommands;
+    }
+
+    std::vector<DrawSortInfo> SceneFixture::createSortInfos(uint32_t drawCount, uint32_t seed) {
+        std::mt19937 random{ seed };
+        std::uniform_real_distribution<float> depth{ 0.0f, 1.0f };
+
+        std::vector<DrawSortInfo> sortInfos;
+        sortInfos.reserve(drawCount);
+
+        // One draw in ten is blended
+        for (uint32_t i = 0; i < drawCount; i++) {
+            DrawSortInfo sortInfo{};
+            sortInfo.pass = 0;
+            sortInfo.blended = random() % 10 == 0;
+            sortInfo.depth = depth(random);
+
+            sortInfos.push_back(sortInfo);
+        }
+
+        return sortInfos;
+    }
+
+    std::vector<DrawCommand> SceneFixture::createPrepassDraws(const std::vector<DrawCommand> &drawCommands) {
+        std::vector<DrawCommand> prepassDraws = drawCommands;
+
+        for (auto &&drawCommand : prepassDraws) {
+            drawCommand.pipeline = this->prepassPipeline;
+            drawCommand.textCoordBuffer = BufferInfo{};
+        }
+
+        return prepassDraws;
+    }
+}
@@ -0,0 +1,43 @@
+#ifndef NUGIE_SCENE_FIXTURE_HPP
+#define NUGIE_SCENE_FIXTURE_HPP
+
+#include <vector>
+
+#include "../../src/device/device.hpp"
+#include "../../src/render/queue/draw_queue.hpp"
+#include "../../src/struct.hpp"
+
+namespace nugie {
+    class Device;
+
+    // Draws over a fixed set of pipelines, materials and meshes made on a null device,
+    // shuffled the way a scene submits them before any sorting
+    class SceneFixture {
+    public:
+        SceneFixture(nugie::Device *device, uint32_t pipelineCount, uint32_t materialCount, uint32_t meshCount);
+        ~SceneFixture();
+
+        // The same seed always gives the same draws
+        std::vector<DrawCommand> createDraws(uint32_t drawCount, uint32_t seed);
+
+        std::vector<DrawSortInfo> createSortInfos(uint32_t drawCount, uint32_t seed);
+
+        // Position-only copies of the draws with the prepass pipeline, as the depth prepass records them
+        std::vector<DrawCommand> createPrepassDraws(const std::vector<DrawCommand> &drawCommands);
+
+    private:
+        static constexpr uint64_t MESH_BUFFER_SIZE = 4096;
+        static constexpr uint32_t MESH_INDEX_COUNT = 36;
+
+        nugie::Device *device;
+
+        std::vector<wgpu::RenderPipeline> pipelines;
+        std::vector<wgpu::BindGroup> materials;
+        std::vector<wgpu::Buffer> meshBuffers;
+
+        wgpu::RenderPipeline prepassPipeline;
+        wgpu::BindGroup sceneBindGroup;
+    };
+}
+
+#endif
@@ -0,0 +1,56 @@
+#include "../benchmarks.hpp"
+#include "../../src/job/system/job_system.hpp"
+
+#include <cmath>
+
+namespace nugie {
+    namespace {
+        constexpr uint32_t SPAWN_COUNT = 1024;
+        constexpr uint32_t PARALLEL_FOR_COUNT = 1 << 20;
+
+        const uint32_t THREAD_COUNTS[] = { 1, 2, 4, 8, 16 };
+    }
+
+    void registerJobBenchmarks(BenchmarkRunner &runner) {
+        // Empty jobs, so the time is spawning, stealing and counting them down
+        for (uint32_t threadCount : THREAD_COUNTS) {
+            runner.addScaling("job_system/spawn", threadCount, [](BenchmarkContext &context, uint32_t threadCount) {
+                JobSystem jobSystem{ threadCount };
+
+                context.setItemsPerIteration(SPAWN_COUNT);
+                context.run([&]() {
+                    JobCounter counter;
+                    for (uint32_t i = 0; i < SPAWN_COUNT; i++) {
+                        jobSystem.run(counter, []() {});
+                    }
+
+                    jobSystem.wait(counter);
+                });
+            });
+        }
+
+        for (uint32_t threadCount : THREAD_COUNTS) {
+            runner.addScaling("job_system/parallel_for", threadCount, [](BenchmarkContext &context, uint32_t threadCount) {
+                JobSystem jobSystem{ threadCount };
+
+                std::vector<float> input(PARALLEL_FOR_COUNT);
+                std::vector<float> output(PARALLEL_FOR_COUNT);
+
+                for (uint32_t i = 0; i < PARALLEL_FOR_COUNT; i++) {
+                    input[i] = static_cast<float>(i % 1000) * 0.001f;
+                }
+
+                context.setItemsPerIteration(PARALLEL_FOR_COUNT);
+                context.run([&]() {
+                    jobSystem.parallelFor(PARALLEL_FOR_COUNT, [&](uint32_t begin, uint32_t end) {
+                        for (uint32_t i = begin; i < end; i++) {
+                            output[i] = std::sqrt(input[i]) * 0.5f + std::sin(input[i]);
+                        }
+                    });
+
+                    doNotOptimize(output.data());
+                });
+            });
+        }
+    }
+}
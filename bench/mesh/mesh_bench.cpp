@@ -0,0 +1,115 @@
+#include "../benchmarks.hpp"
+
+#include <sstream>
+#include <unordered_map>
+#include <glm/glm.hpp>
+#include <tiny_obj_loader.h>
+
+namespace nugie {
+    namespace {
+        constexpr uint32_t GRID_SIZE = 256;
+
+        // A flat grid of quads, every quad with its own texture coordinates so welding has work to do
+        std::string createGridObj(uint32_t size) {
+            std::ostringstream obj;
+
+            for (uint32_t y = 0; y <= size; y++) {
+                for (uint32_t x = 0; x <= size; x++) {
+                    obj << "v " << x << " 0 " << y << "\n";
+                    obj << "vt " << static_cast<float>(x) / size << " " << static_cast<float>(y) / size << "\n";
+                }
+            }
+
+            for (uint32_t y = 0; y < size; y++) {
+                for (uint32_t x = 0; x < size; x++) {
+                    uint32_t a = y * (size + 1) + x + 1;
+                    uint32_t b = a + 1;
+                    uint32_t c = a + size + 2;
+                    uint32_t d = a + size + 1;
+
+                    obj << "f " << a << "/" << a << " " << b << "/" << b << " " << c << "/" << c << " " << d << "/" << d << "\n";
+                }
+            }
+
+            return obj.str();
+        }
+
+        bool loadObj(const std::string &text, tinyobj::attrib_t &attrib, std::vector<tinyobj::shape_t> &shapes) {
+            std::vector<tinyobj::material_t> materials;
+            std::string warning, error;
+            std::istringstream stream{ text };
+
+            return tinyobj::LoadObj(&attrib, &shapes, &materials, &warning, &error, &stream);
+        }
+
+        // The split streams the renderer draws from: positions, texture coordinates and 32-bit indices
+        struct WeldedMesh {
+            std::vector<glm::vec4> positions;
+            std::vector<glm::vec2> textCoords;
+            std::vector<uint32_t> indices;
+        };
+
+        // Corners sharing a position and a texture coordinate become one vertex
+        void weld(const tinyobj::attrib_t &attrib, const std::vector<tinyobj::shape_t> &shapes, WeldedMesh &mesh, std::unordered_map<uint64_t, uint32_t> &vertexIds) {
+            mesh.positions.clear();
+            mesh.textCoords.clear();
+            mesh.indices.clear();
+            vertexIds.clear();
+
+            for (auto &&shape : shapes) {
+                for (auto &&index : shape.mesh.indices) {
+                    uint64_t key = (static_cast<uint64_t>(static_cast<uint32_t>(index.vertex_index)) << 32) | static_cast<uint32_t>(index.texcoord_index);
+                    auto inserted = vertexIds.try_emplace(key, static_cast<uint32_t>(mesh.positions.size()));
+
+                    if (inserted.second) {
+                        size_t v = static_cast<size_t>(index.vertex_index) * 3;
+                        mesh.positions.push_back(glm::vec4(attrib.vertices[v], attrib.vertices[v + 1], attrib.vertices[v + 2], 1.0f));
+
+                        if (index.texcoord_index >= 0) {
+                            size_t t = static_cast<size_t>(index.texcoord_index) * 2;
+                            mesh.textCoords.push_back(glm::vec2(attrib.texcoords[t], attrib.texcoords[t + 1]));
+                        } else {
+                            mesh.textCoords.push_back(glm::vec2(0.0f));
+                        }
+                    }
+
+                    mesh.indices.push_back(inserted.first->second);
+                }
+            }
+        }
+    }
+
+    void registerMeshBenchmarks(BenchmarkRunner &runner) {
+        runner.add("mesh/load_obj/grid:256", [](BenchmarkContext &context) {
+            std::string text = createGridObj(GRID_SIZE);
+
+            context.setItemsPerIteration(GRID_SIZE * GRID_SIZE * 2);
+            context.run([&]() {
+                tinyobj::attrib_t attrib;
+                std::vector<tinyobj::shape_t> shapes;
+
+                bool loaded = loadObj(text, attrib, shapes);
+                doNotOptimize(loaded);
+            });
+        });
+
+        runner.add("mesh/weld/grid:256", [](BenchmarkContext &context) {
+            tinyobj::attrib_t attrib;
+            std::vector<tinyobj::shape_t> shapes;
+            loadObj(createGridObj(GRID_SIZE), attrib, shapes);
+
+            WeldedMesh mesh;
+            std::unordered_map<uint64_t, uint32_t> vertexIds;
+
+            weld(attrib, shapes, mesh, vertexIds);
+            context.setCounter("corners", static_cast<double>(mesh.indices.size()));
+            context.setCounter("unique_vertices", static_cast<double>(mesh.positions.size()));
+
+            context.setItemsPerIteration(mesh.indices.size());
+            context.run([&]() {
+                weld(attrib, shapes, mesh, vertexIds);
+                doNotOptimize(mesh.indices.data());
+            });
+        });
+    }
+}
@@ -0,0 +1,233 @@
+#include "../benchmarks.hpp"
+#include "../harness/gpu_fixture.hpp"
+#include "../../src/render/culling/occlusion_culler.hpp"
+#include "../../src/render/graph/render_graph.hpp"
+
+#include <random>
+#include <string>
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace nugie {
+    namespace {
+        const uint32_t OBJECT_COUNTS[] = { 4096, 65536 };
+
+        struct Resolution {
+            uint32_t width;
+            uint32_t height;
+        };
+
+        const Resolution RESOLUTIONS[] = { { 1280, 720 }, { 2560, 1440 } };
+
+        // Resolution of the cull benchmarks, which only read the pyramid
+        constexpr Resolution CULL_RESOLUTION{ 1920, 1080 };
+
+        // About 33 units from the camera, so roughly a third of the boxes lie in front of the cleared depth
+        constexpr float CLEARED_DEPTH = 0.998f;
+
+        // The state both benchmarks share: a depth buffer to build the pyramid from, and a culler with a field of boxes
+        struct CullingScene {
+            Device *device;
+            Resolution resolution;
+
+            wgpu::Texture depthTexture;
+            wgpu::TextureView depthView;
+
+            OcclusionCuller culler;
+            glm::mat4 viewProjection;
+
+            CullingScene(GpuFixture &fixture, Resolution resolution, uint32_t objectCount)
+            : device{fixture.getDevice()},
+              resolution{resolution},
+              culler{ fixture.getDevice(), fixture.getShaderLibrary(), fixture.getReadbackRing(), GpuFixture::FRAMES_IN_FLIGHT,
+                resolution.width, resolution.height, objectCount }
+            {
+                wgpu::TextureDescriptor textureDesc{};
+                textureDesc.nextInChain = nullptr;
+                textureDesc.label = "Benchmark Depth Texture";
+                textureDesc.dimension = wgpu::TextureDimension::_2D;
+                textureDesc.size = { resolution.width, resolution.height, 1 };
+                textureDesc.mipLevelCount = 1;
+                textureDesc.sampleCount = 1;
+                textureDesc.format = wgpu::TextureFormat::Depth16Unorm;
+                textureDesc.usage = wgpu::TextureUsage::RenderAttachment | wgpu::TextureUsage::TextureBinding;
+                textureDesc.viewFormatCount = 0;
+                textureDesc.viewFormats = nullptr;
+
+                this->depthTexture = this->device->createTexture(textureDesc);
+                this->depthView = this->depthTexture.createView();
+
+                std::mt19937 random{ objectCount };
+                std::uniform_real_distribution<float> spread{ -40.0f, 40.0f };
+                std::uniform_real_distribution<float> distance{ 2.0f, 90.0f };
+
+                for (uint32_t i = 0; i < objectCount; i++) {
+                    glm::vec3 center{ spread(random), spread(random) * 0.25f, -distance(random) };
+                    this->culler.addObject(center - glm::vec3{ 0.5f }, center + glm::vec3{ 0.5f }, 36);
+                }
+
+                this->culler.uploadObjects();
+                this->culler.setDepthView(this->depthView);
+
+                float aspect = static_cast<float>(resolution.width) / static_cast<float>(resolution.height);
+                this->viewProjection = glm::perspective(glm::radians(60.0f), aspect, 0.1f, 100.0f);
+            }
+
+            ~CullingScene() {
+                this->culler.release();
+                this->depthView.release();
+                this->depthTexture.destroy();
+                this->device->releaseTexture(this->depthTexture);
+            }
+
+            // Fills the depth buffer once, the benchmarks only read it
+            void clearDepth(GpuFixture &fixture) {
+                wgpu::RenderPassDepthStencilAttachment depthAttachment{};
+                depthAttachment.view = this->depthView;
+                depthAttachment.depthLoadOp = wgpu::LoadOp::Clear;
+                depthAttachment.depthStoreOp = wgpu::StoreOp::Store;
+                depthAttachment.depthClearValue = CLEARED_DEPTH;
+                depthAttachment.depthReadOnly = false;
+                depthAttachment.stencilLoadOp = wgpu::LoadOp::Undefined;
+                depthAttachment.stencilStoreOp = wgpu::StoreOp::Undefined;
+                depthAttachment.stencilReadOnly = true;
+
+                wgpu::RenderPassDescriptor renderPassDesc{};
+                renderPassDesc.nextInChain = nullptr;
+                renderPassDesc.label = "Benchmark Depth Clear";
+                renderPassDesc.colorAttachmentCount = 0;
+                renderPassDesc.colorAttachments = nullptr;
+                renderPassDesc.depthStencilAttachment = &depthAttachment;
+                renderPassDesc.timestampWrites = nullptr;
+
+                wgpu::CommandEncoder commandEncoder = fixture.createCommandEncoder();
+
+                wgpu::RenderPassEncoder renderPassEncoder = commandEncoder.beginRenderPass(renderPassDesc);
+                renderPassEncoder.end();
+                renderPassEncoder.release();
+
+                wgpu::CommandBuffer commandBuffer = commandEncoder.finish();
+                commandEncoder.release();
+
+                this->device->submit(1, &commandBuffer);
+                commandBuffer.release();
+            }
+
+            // Encodes and submits one frame of the graph, with the culler's uniforms for the frame's slot
+            void runFrame(GpuFixture &fixture, RenderGraph &renderGraph) {
+                uint32_t frameSlot = fixture.beginFrame(renderGraph);
+                this->culler.beginFrame(frameSlot, this->viewProjection, this->resolution.width, this->resolution.height);
+
+                wgpu::CommandEncoder commandEncoder = fixture.createCommandEncoder();
+                renderGraph.execute(commandEncoder);
+                this->culler.resolveStats(commandEncoder);
+
+                fixture.endFrame(commandEncoder);
+            }
+        };
+
+        // Times the graph's frames on the GPU, the harness's own timings are of the CPU encoding and pacing
+        void runTimed(BenchmarkContext &context, GpuFixture &fixture, CullingScene &scene, RenderGraph &renderGraph) {
+            for (uint32_t i = 0; i < GpuFixture::FRAMES_IN_FLIGHT * 2; i++) {
+                scene.runFrame(fixture, renderGraph);
+            }
+
+            fixture.waitIdle();
+            fixture.collectGpuTimeMs();
+
+            context.run([&]() {
+                scene.runFrame(fixture, renderGraph);
+            });
+
+            fixture.waitIdle();
+            context.setCounter("gpu_ms", fixture.collectGpuTimeMs());
+        }
+    }
+
+    void registerCullingBenchmarks(BenchmarkRunner &runner, bool gpu) {
+        // Both dispatches only exist on the GPU, so these need a real adapter and are left out unless asked for
+        if (!gpu) {
+            return;
+        }
+
+        // Every level of the pyramid, from a depth buffer of the render size
+        for (Resolution resolution : RESOLUTIONS) {
+            std::string name = "culling/hiz_build/" + std::to_string(resolution.width) + "x" + std::to_string(resolution.height);
+
+            runner.add(name, [resolution](BenchmarkContext &context) {
+                GpuFixture fixture;
+                fixture.requireTimestamps();
+
+                CullingScene scene{ fixture, resolution, 1 };
+                scene.clearDepth(fixture);
+
+                RenderGraph renderGraph{ fixture.getDevice() };
+                RenderResourceId depthResource = renderGraph.importTexture("Depth", true, true);
+
+                RenderPassId buildPass = renderGraph.addComputePass("Hi-Z Build", [&scene](wgpu::ComputePassEncoder computePassEncoder) {
+                    scene.culler.buildPyramid(computePassEncoder);
+                });
+
+                renderGraph.addRead(buildPass, depthResource);
+                renderGraph.setSideEffect(buildPass);
+                renderGraph.compile();
+                renderGraph.setImportedView(depthResource, scene.depthView);
+
+                context.setItemsPerIteration(uint64_t(resolution.width) * resolution.height);
+                runTimed(context, fixture, scene, renderGraph);
+
+                renderGraph.release();
+            });
+        }
+
+        // The early and the late test of every box against a pyramid built once, as two passes like the app's
+        for (uint32_t objectCount : OBJECT_COUNTS) {
+            runner.add("culling/cull/" + std::to_string(objectCount), [objectCount](BenchmarkContext &context) {
+                GpuFixture fixture;
+                fixture.requireTimestamps();
+
+                CullingScene scene{ fixture, CULL_RESOLUTION, objectCount };
+                scene.clearDepth(fixture);
+
+                // The pyramid is built once and stays as it is, the timed graph only culls
+                RenderGraph buildGraph{ fixture.getDevice() };
+                RenderResourceId depthResource = buildGraph.importTexture("Depth", true, true);
+
+                RenderPassId buildPass = buildGraph.addComputePass("Hi-Z Build", [&scene](wgpu::ComputePassEncoder computePassEncoder) {
+                    scene.culler.buildPyramid(computePassEncoder);
+                });
+
+                buildGraph.addRead(buildPass, depthResource);
+                buildGraph.setSideEffect(buildPass);
+                buildGraph.compile();
+                buildGraph.setImportedView(depthResource, scene.depthView);
+
+                scene.runFrame(fixture, buildGraph);
+                fixture.waitIdle();
+
+                RenderGraph renderGraph{ fixture.getDevice() };
+
+                RenderPassId earlyPass = renderGraph.addComputePass("Occlusion Cull Early", [&scene](wgpu::ComputePassEncoder computePassEncoder) {
+                    scene.culler.dispatchEarly(computePassEncoder);
+                });
+
+                RenderPassId latePass = renderGraph.addComputePass("Occlusion Cull Late", [&scene](wgpu::ComputePassEncoder computePassEncoder) {
+                    scene.culler.dispatchLate(computePassEncoder);
+                });
+
+                renderGraph.setSideEffect(earlyPass);
+                renderGraph.setSideEffect(latePass);
+                renderGraph.compile();
+
+                context.setItemsPerIteration(objectCount);
+                runTimed(context, fixture, scene, renderGraph);
+
+                CullStats stats = scene.culler.getStats();
+                context.setCounter("early_visible", stats.earlyVisible);
+                context.setCounter("late_visible", stats.lateVisible);
+
+                renderGraph.release();
+                buildGraph.release();
+            });
+        }
+    }
+}
@@ -0,0 +1,57 @@
+#include "../benchmarks.hpp"
+#include "../harness/scene_fixture.hpp"
+#include "../../src/render/queue/draw_queue.hpp"
+#include "../../src/render/bundle/parallel_encoder.hpp"
+#include "../../src/memory/arena/linear_arena.hpp"
+
+namespace nugie {
+    namespace {
+        constexpr uint32_t DRAW_COUNT = 100000;
+        constexpr size_t ARENA_CAPACITY = 64 * 1024 * 1024;
+    }
+
+    void registerDrawQueueBenchmarks(BenchmarkRunner &runner) {
+        runner.add("draw_queue/build_sort/100000", [](BenchmarkContext &context) {
+            Device device{ DeviceBackend::Null, 1280, 720 };
+            SceneFixture scene{ &device, 32, 512, 256 };
+
+            std::vector<DrawCommand> drawCommands = scene.createDraws(DRAW_COUNT, 1);
+            std::vector<DrawSortInfo> sortInfos = scene.createSortInfos(DRAW_COUNT, 2);
+
+            LinearArena arena{ ARENA_CAPACITY };
+            DrawQueue drawQueue{ &arena };
+
+            auto build = [&]() {
+                arena.reset();
+                drawQueue.clear(DRAW_COUNT);
+
+                for (uint32_t i = 0; i < DRAW_COUNT; i++) {
+                    drawQueue.push(drawCommands[i], sortInfos[i]);
+                }
+
+                drawQueue.sort();
+            };
+
+            // State changes a single bundle records, before and after sorting
+            {
+                JobSystem jobSystem{ 1 };
+                ParallelEncoder encoder{ &device, &jobSystem, wgpu::TextureFormat::BGRA8Unorm, wgpu::TextureFormat::Depth24Plus };
+
+                encoder.encode(drawCommands);
+                context.setCounter("unsorted_state_changes", encoder.getStats().getStateChanges());
+
+                build();
+                encoder.encode(drawQueue.getSortedCommands());
+                context.setCounter("sorted_state_changes", encoder.getStats().getStateChanges());
+            }
+
+            context.setItemsPerIteration(DRAW_COUNT);
+            context.run([&]() {
+                build();
+                doNotOptimize(drawQueue.getSortedCommands().data());
+            });
+
+            context.setCounter("sort_ms", drawQueue.getStats().sortTimeMs);
+        });
+    }
+}
@@ -0,0 +1,95 @@
+#include "../benchmarks.hpp"
+#include "../harness/scene_fixture.hpp"
+#include "../../src/render/queue/draw_queue.hpp"
+#include "../../src/render/bundle/parallel_encoder.hpp"
+#include "../../src/memory/arena/linear_arena.hpp"
+
+namespace nugie {
+    namespace {
+        constexpr uint32_t ENCODE_DRAW_COUNT = 50000;
+        constexpr uint32_t DENSE_DRAW_COUNT = 20000;
+        constexpr size_t ARENA_CAPACITY = 64 * 1024 * 1024;
+
+        const uint32_t THREAD_COUNTS[] = { 1, 2, 4, 8, 16 };
+
+        // Draws in the order the frame encodes them, after the draw queue sorted them
+        std::vector<DrawCommand> createSortedDraws(SceneFixture &scene, uint32_t drawCount) {
+            std::vector<DrawCommand> drawCommands = scene.createDraws(drawCount, 1);
+            std::vector<DrawSortInfo> sortInfos = scene.createSortInfos(drawCount, 2);
+
+            LinearArena arena{ ARENA_CAPACITY };
+            DrawQueue drawQueue{ &arena };
+
+            drawQueue.clear(drawCount);
+            for (uint32_t i = 0; i < drawCount; i++) {
+                drawQueue.push(drawCommands[i], sortInfos[i]);
+            }
+
+            drawQueue.sort();
+
+            const ArenaVector<DrawCommand> &sorted = drawQueue.getSortedCommands();
+            return std::vector<DrawCommand>(sorted.begin(), sorted.end());
+        }
+
+        void benchmarkDenseScene(BenchmarkContext &context, bool prepass) {
+            Device device{ DeviceBackend::Null, 1280, 720 };
+            SceneFixture scene{ &device, 8, 256, 64 };
+            JobSystem jobSystem;
+
+            std::vector<DrawCommand> drawCommands = createSortedDraws(scene, DENSE_DRAW_COUNT);
+            std::vector<DrawCommand> prepassDraws = scene.createPrepassDraws(drawCommands);
+
+            ParallelEncoder prepassEncoder{ &device, &jobSystem, wgpu::TextureFormat::Undefined, wgpu::TextureFormat::Depth24Plus };
+            ParallelEncoder encoder{ &device, &jobSystem, wgpu::TextureFormat::BGRA8Unorm, wgpu::TextureFormat::Depth24Plus };
+
+            auto encode = [&]() {
+                if (prepass) {
+                    prepassEncoder.encode(prepassDraws);
+                }
+
+                encoder.encode(drawCommands);
+            };
+
+            encode();
+
+            uint32_t stateChanges = encoder.getStats().getStateChanges() + (prepass ? prepassEncoder.getStats().getStateChanges() : 0);
+            context.setCounter("state_changes", stateChanges);
+            context.setCounter("draws", DENSE_DRAW_COUNT * (prepass ? 2 : 1));
+
+            context.setItemsPerIteration(DENSE_DRAW_COUNT);
+            context.run(encode);
+        }
+    }
+
+    void registerParallelEncoderBenchmarks(BenchmarkRunner &runner) {
+        for (uint32_t threadCount : THREAD_COUNTS) {
+            runner.addScaling("parallel_encoder/encode/50000", threadCount, [](BenchmarkContext &context, uint32_t threadCount) {
+                Device device{ DeviceBackend::Null, 1280, 720 };
+                SceneFixture scene{ &device, 32, 512, 256 };
+                JobSystem jobSystem{ threadCount };
+
+                std::vector<DrawCommand> drawCommands = createSortedDraws(scene, ENCODE_DRAW_COUNT);
+                ParallelEncoder encoder{ &device, &jobSystem, wgpu::TextureFormat::BGRA8Unorm, wgpu::TextureFormat::Depth24Plus };
+
+                encoder.encode(drawCommands);
+                context.setCounter("chunks", encoder.getChunkCount());
+                context.setCounter("state_changes", encoder.getStats().getStateChanges());
+
+                context.setItemsPerIteration(ENCODE_DRAW_COUNT);
+                context.run([&]() {
+                    encoder.encode(drawCommands);
+                });
+            });
+        }
+
+        // CPU side of the depth prepass on a dense scene: the prepass records every draw a second time.
+        // What it saves is fragment shading on the GPU, which the app's overdraw meter reports.
+        runner.add("depth_prepass/encode_dense/off", [](BenchmarkContext &context) {
+            benchmarkDenseScene(context, false);
+        });
+
+        runner.add("depth_prepass/encode_dense/on", [](BenchmarkContext &context) {
+            benchmarkDenseScene(context, true);
+        });
+    }
+}
@@ -0,0 +1,85 @@
+#include "../benchmarks.hpp"
+#include "../../src/render/particles/particle_system.hpp"
+#include "../../src/frame/sync/frame_sync.hpp"
+
+namespace nugie {
+    namespace {
+        const uint32_t PARTICLE_COUNTS[] = { 100000, 1000000 };
+
+        constexpr uint32_t FRAMES_IN_FLIGHT = 2;
+        constexpr float TIMESTEP = 1.0f / 60.0f;
+
+        // One frame of the simulation on its own: upload, the particle pass and a submit, paced by the frames in flight
+        void simulateFrame(Device &device, FrameSync &frameSync, ParticleSystem &particleSystem) {
+            frameSync.beginFrame();
+
+            particleSystem.update(TIMESTEP, glm::mat4{ 1.0f }, glm::vec3{ 1.0f, 0.0f, 0.0f }, glm::vec3{ 0.0f, 1.0f, 0.0f });
+
+            wgpu::CommandEncoderDescriptor commandDesc{};
+            commandDesc.label = "Particle Bench Encoder";
+            commandDesc.nextInChain = nullptr;
+
+            wgpu::CommandEncoder commandEncoder = device.createCommandEncoder(commandDesc);
+
+            wgpu::ComputePassDescriptor computePassDesc{};
+            computePassDesc.nextInChain = nullptr;
+            computePassDesc.label = "Particle Simulate Pass";
+            computePassDesc.timestampWrites = nullptr;
+
+            wgpu::ComputePassEncoder computePassEncoder = commandEncoder.beginComputePass(computePassDesc);
+            particleSystem.dispatch(computePassEncoder);
+            computePassEncoder.end();
+            computePassEncoder.release();
+
+            wgpu::CommandBuffer commandBuffer = commandEncoder.finish();
+            commandEncoder.release();
+
+            device.submit(1, &commandBuffer);
+            commandBuffer.release();
+
+            frameSync.endFrame();
+        }
+    }
+
+    void registerParticleBenchmarks(BenchmarkRunner &runner, bool gpu) {
+        // The simulation only exists on the GPU, so these need a real adapter and are left out unless asked for
+        if (!gpu) {
+            return;
+        }
+
+        for (uint32_t particleCount : PARTICLE_COUNTS) {
+            runner.add("particles/simulate/" + std::to_string(particleCount), [particleCount](BenchmarkContext &context) {
+                Device device{ "NugieBench", 64, 64, wgpu::PresentMode::Fifo, true };
+                ShaderLibrary shaderLibrary{ &device, "../asset/shaders/" };
+                FrameSync frameSync{ &device, FRAMES_IN_FLIGHT };
+
+                // Particles that never die and no further emission, so every frame updates the full pool
+                ParticleEmitter emitter{};
+                emitter.rate = 0.0f;
+                emitter.lifetimeMin = 1.0e9f;
+                emitter.lifetimeMax = 1.0e9f;
+
+                ParticleSystem particleSystem{ &device, &shaderLibrary, particleCount, wgpu::TextureFormat::Undefined, wgpu::TextureFormat::Undefined };
+                particleSystem.setEmitter(emitter);
+                particleSystem.burst(particleCount);
+
+                simulateFrame(device, frameSync, particleSystem);
+
+                uint64_t frames = 0;
+                auto start = std::chrono::steady_clock::now();
+
+                context.setItemsPerIteration(particleCount);
+                context.run([&]() {
+                    simulateFrame(device, frameSync, particleSystem);
+                    frames++;
+                });
+
+                // The last frames are still on the GPU, they count once they are done
+                frameSync.waitIdle();
+
+                double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                context.setCounter("particles_per_ms", static_cast<double>(frames) * particleCount / elapsedMs);
+            });
+        }
+    }
+}
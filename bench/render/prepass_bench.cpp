@@ -0,0 +1,399 @@
+#include "../benchmarks.hpp"
+#include "../harness/gpu_fixture.hpp"
+#include "../../src/render/prepass/overdraw_meter.hpp"
+#include "../../src/render/graph/render_graph.hpp"
+#include "../../src/shader/reflection/shader_reflection.hpp"
+
+#include <vector>
+#include <string>
+#include <iterator>
+#include <algorithm>
+#include <glm/glm.hpp>
+
+namespace nugie {
+    namespace {
+        constexpr uint32_t RENDER_WIDTH = 1920;
+        constexpr uint32_t RENDER_HEIGHT = 1080;
+        constexpr uint32_t TEXTURE_SIZE = 256;
+
+        // Full screen quads drawn back to front, the worst order for early depth testing
+        constexpr uint32_t LAYER_COUNT = 32;
+        constexpr uint32_t VERTEX_COUNT = LAYER_COUNT * 6;
+
+        // Room for SceneUniform in common/uniforms.wgsl, of which the shaders here only read the transforms
+        constexpr uint64_t SCENE_UNIFORM_SIZE = 256;
+
+        wgpu::Buffer createBuffer(Device *device, const char *label, WGPUBufferUsageFlags usage, const void *data, uint64_t size) {
+            wgpu::BufferDescriptor bufferDesc{};
+            bufferDesc.label = label;
+            bufferDesc.size = size;
+            bufferDesc.usage = usage | wgpu::BufferUsage::CopyDst;
+            bufferDesc.mappedAtCreation = false;
+
+            wgpu::Buffer buffer = device->createBuffer(bufferDesc);
+            device->writeBuffer(buffer, 0, data, size);
+
+            return buffer;
+        }
+
+        // The scene the app draws, reduced to what decides its fragment cost: the textured scene shader
+        // behind an optional depth prepass, over the same pixels many times
+        struct OverdrawScene {
+            Device *device;
+
+            wgpu::Buffer positionBuffer;
+            wgpu::Buffer textCoordBuffer;
+            wgpu::Buffer sceneUniformBuffer;
+            wgpu::Buffer objectUniformBuffer;
+
+            wgpu::Texture texture;
+            wgpu::TextureView textureView;
+            wgpu::Sampler sampler;
+
+            wgpu::BindGroupLayout sceneBindGroupLayout;
+            wgpu::BindGroupLayout objectBindGroupLayout;
+            wgpu::PipelineLayout pipelineLayout;
+            wgpu::BindGroup sceneBindGroup;
+            wgpu::BindGroup objectBindGroup;
+
+            wgpu::RenderPipeline prepassPipeline;
+            wgpu::RenderPipeline scenePipeline;
+            wgpu::RenderPipeline equalDepthPipeline;
+
+            OverdrawScene(GpuFixture &fixture)
+            : device{fixture.getDevice()}
+            {
+                this->createGeometry();
+                this->createTexture();
+                this->createLayouts(fixture.getShaderLibrary());
+                this->createPipelines(fixture.getShaderLibrary());
+            }
+
+            ~OverdrawScene() {
+                this->prepassPipeline.release();
+                this->scenePipeline.release();
+                this->equalDepthPipeline.release();
+
+                this->sceneBindGroup.release();
+                this->objectBindGroup.release();
+                this->pipelineLayout.release();
+                this->sceneBindGroupLayout.release();
+                this->objectBindGroupLayout.release();
+
+                this->sampler.release();
+                this->textureView.release();
+                this->texture.destroy();
+                this->device->releaseTexture(this->texture);
+
+                this->device->releaseBuffer(this->positionBuffer);
+                this->device->releaseBuffer(this->textCoordBuffer);
+                this->device->releaseBuffer(this->sceneUniformBuffer);
+                this->device->releaseBuffer(this->objectUniformBuffer);
+            }
+
+            void draw(wgpu::RenderPassEncoder renderPassEncoder, wgpu::RenderPipeline pipeline) {
+                renderPassEncoder.setPipeline(pipeline);
+                renderPassEncoder.setBindGroup(0, this->sceneBindGroup, 0, nullptr);
+                renderPassEncoder.setBindGroup(1, this->objectBindGroup, 0, nullptr);
+                renderPassEncoder.setVertexBuffer(0, this->positionBuffer, 0, this->positionBuffer.getSize());
+                renderPassEncoder.setVertexBuffer(1, this->textCoordBuffer, 0, this->textCoordBuffer.getSize());
+                renderPassEncoder.draw(VERTEX_COUNT, 1, 0, 0);
+            }
+
+            void createGeometry() {
+                std::vector<glm::vec3> positions;
+                std::vector<glm::vec2> textCoords;
+
+                glm::vec2 corners[6] { { -1.0f, -1.0f }, { 1.0f, -1.0f }, { 1.0f, 1.0f }, { -1.0f, -1.0f }, { 1.0f, 1.0f }, { -1.0f, 1.0f } };
+
+                // Identity transforms, so each layer's z is its depth
+                for (uint32_t layer = 0; layer < LAYER_COUNT; layer++) {
+                    float depth = 0.9f - 0.8f * static_cast<float>(layer) / LAYER_COUNT;
+
+                    for (glm::vec2 corner : corners) {
+                        positions.push_back(glm::vec3{ corner, depth });
+                        textCoords.push_back(corner * 0.5f + 0.5f);
+                    }
+                }
+
+                glm::mat4 sceneUniform[SCENE_UNIFORM_SIZE / sizeof(glm::mat4)];
+                std::fill(std::begin(sceneUniform), std::end(sceneUniform), glm::mat4{ 1.0f });
+
+                glm::mat4 objectUniform{ 1.0f };
+
+                this->positionBuffer = createBuffer(this->device, "Benchmark Position Buffer", wgpu::BufferUsage::Vertex, positions.data(), positions.size() * sizeof(glm::vec3));
+                this->textCoordBuffer = createBuffer(this->device, "Benchmark Texture Coordinate Buffer", wgpu::BufferUsage::Vertex, textCoords.data(), textCoords.size() * sizeof(glm::vec2));
+                this->sceneUniformBuffer = createBuffer(this->device, "Benchmark Scene Uniform Buffer", wgpu::BufferUsage::Uniform, sceneUniform, sizeof(sceneUniform));
+                this->objectUniformBuffer = createBuffer(this->device, "Benchmark Object Uniform Buffer", wgpu::BufferUsage::Uniform, &objectUniform, sizeof(objectUniform));
+            }
+
+            void createTexture() {
+                wgpu::TextureDescriptor textureDesc{};
+                textureDesc.nextInChain = nullptr;
+                textureDesc.label = "Benchmark Texture";
+                textureDesc.dimension = wgpu::TextureDimension::_2D;
+                textureDesc.size = { TEXTURE_SIZE, TEXTURE_SIZE, 1 };
+                textureDesc.mipLevelCount = 1;
+                textureDesc.sampleCount = 1;
+                textureDesc.format = wgpu::TextureFormat::RGBA8Unorm;
+                textureDesc.usage = wgpu::TextureUsage::TextureBinding | wgpu::TextureUsage::CopyDst;
+                textureDesc.viewFormatCount = 0;
+                textureDesc.viewFormats = nullptr;
+
+                this->texture = this->device->createTexture(textureDesc);
+                this->textureView = this->texture.createView();
+
+                std::vector<uint8_t> pixels(TEXTURE_SIZE * TEXTURE_SIZE * 4);
+                for (size_t i = 0; i < pixels.size(); i++) {
+                    pixels[i] = static_cast<uint8_t>(i * 7);
+                }
+
+                wgpu::ImageCopyTexture destination{};
+                destination.texture = this->texture;
+                destination.mipLevel = 0;
+                destination.origin = { 0, 0, 0 };
+                destination.aspect = wgpu::TextureAspect::All;
+
+                wgpu::TextureDataLayout dataLayout{};
+                dataLayout.offset = 0;
+                dataLayout.bytesPerRow = TEXTURE_SIZE * 4;
+                dataLayout.rowsPerImage = TEXTURE_SIZE;
+
+                this->device->writeTexture(destination, pixels.data(), pixels.size(), dataLayout, { TEXTURE_SIZE, TEXTURE_SIZE, 1 });
+
+                wgpu::SamplerDescriptor samplerDesc{};
+                samplerDesc.label = "Benchmark Sampler";
+                samplerDesc.nextInChain = nullptr;
+                samplerDesc.addressModeU = wgpu::AddressMode::Repeat;
+                samplerDesc.addressModeV = wgpu::AddressMode::Repeat;
+                samplerDesc.addressModeW = wgpu::AddressMode::Repeat;
+                samplerDesc.minFilter = wgpu::FilterMode::Linear;
+                samplerDesc.magFilter = wgpu::FilterMode::Linear;
+                samplerDesc.mipmapFilter = wgpu::MipmapFilterMode::Linear;
+                samplerDesc.lodMinClamp = 0.0f;
+                samplerDesc.lodMaxClamp = 1.0f;
+                samplerDesc.compare = wgpu::CompareFunction::Undefined;
+                samplerDesc.maxAnisotropy = 1u;
+
+                this->sampler = this->device->createSampler(samplerDesc);
+            }
+
+            // One layout for both shaders, as the app's scene pipelines share theirs
+            void createLayouts(ShaderLibrary *shaderLibrary) {
+                ShaderReflection reflection = shaderLibrary->getReflection("basic.wgsl", { { "TEXTURED", "" } });
+                reflection.merge(shaderLibrary->getReflection("depth_prepass.wgsl"));
+
+                this->sceneBindGroupLayout = reflection.createBindGroupLayout(this->device, "Benchmark Scene Bind Group Layout", 0);
+                this->objectBindGroupLayout = reflection.createBindGroupLayout(this->device, "Benchmark Object Bind Group Layout", 1);
+
+                WGPUBindGroupLayout bindGroupLayouts[2] { this->sceneBindGroupLayout, this->objectBindGroupLayout };
+
+                wgpu::PipelineLayoutDescriptor pipelineLayoutDesc{};
+                pipelineLayoutDesc.label = "Benchmark Pipeline Layout";
+                pipelineLayoutDesc.bindGroupLayoutCount = 2;
+                pipelineLayoutDesc.bindGroupLayouts = bindGroupLayouts;
+
+                this->pipelineLayout = this->device->createPipelineLayout(pipelineLayoutDesc);
+
+                wgpu::BindGroupEntry sceneEntry{};
+                sceneEntry.nextInChain = nullptr;
+                sceneEntry.binding = 0;
+                sceneEntry.buffer = this->sceneUniformBuffer;
+                sceneEntry.offset = 0;
+                sceneEntry.size = SCENE_UNIFORM_SIZE;
+
+                wgpu::BindGroupDescriptor bindGroupDesc{};
+                bindGroupDesc.label = "Benchmark Scene Bind Group";
+                bindGroupDesc.nextInChain = nullptr;
+                bindGroupDesc.entryCount = 1;
+                bindGroupDesc.entries = &sceneEntry;
+                bindGroupDesc.layout = this->sceneBindGroupLayout;
+
+                this->sceneBindGroup = this->device->createBindGroup(bindGroupDesc);
+
+                wgpu::BindGroupEntry objectEntries[3];
+
+                objectEntries[0].nextInChain = nullptr;
+                objectEntries[0].binding = 0;
+                objectEntries[0].buffer = this->objectUniformBuffer;
+                objectEntries[0].offset = 0;
+                objectEntries[0].size = sizeof(glm::mat4);
+
+                objectEntries[1].nextInChain = nullptr;
+                objectEntries[1].binding = 1;
+                objectEntries[1].textureView = this->textureView;
+
+                objectEntries[2].nextInChain = nullptr;
+                objectEntries[2].binding = 2;
+                objectEntries[2].sampler = this->sampler;
+
+                bindGroupDesc.label = "Benchmark Object Bind Group";
+                bindGroupDesc.entryCount = 3;
+                bindGroupDesc.entries = objectEntries;
+                bindGroupDesc.layout = this->objectBindGroupLayout;
+
+                this->objectBindGroup = this->device->createBindGroup(bindGroupDesc);
+            }
+
+            void createPipelines(ShaderLibrary *shaderLibrary) {
+                wgpu::VertexAttribute positionAttrib{};
+                positionAttrib.shaderLocation = 0;
+                positionAttrib.format = wgpu::VertexFormat::Float32x3;
+                positionAttrib.offset = 0;
+
+                wgpu::VertexAttribute textCoordAttrib{};
+                textCoordAttrib.shaderLocation = 1;
+                textCoordAttrib.format = wgpu::VertexFormat::Float32x2;
+                textCoordAttrib.offset = 0;
+
+                wgpu::VertexBufferLayout vertexBufferLayouts[2];
+                vertexBufferLayouts[0].attributeCount = 1;
+                vertexBufferLayouts[0].attributes = &positionAttrib;
+                vertexBufferLayouts[0].arrayStride = sizeof(glm::vec3);
+                vertexBufferLayouts[0].stepMode = wgpu::VertexStepMode::Vertex;
+
+                vertexBufferLayouts[1].attributeCount = 1;
+                vertexBufferLayouts[1].attributes = &textCoordAttrib;
+                vertexBufferLayouts[1].arrayStride = sizeof(glm::vec2);
+                vertexBufferLayouts[1].stepMode = wgpu::VertexStepMode::Vertex;
+
+                wgpu::ColorTargetState colorTarget{};
+                colorTarget.nextInChain = nullptr;
+                colorTarget.format = wgpu::TextureFormat::RGBA8Unorm;
+                colorTarget.blend = nullptr;
+                colorTarget.writeMask = wgpu::ColorWriteMask::All;
+
+                wgpu::DepthStencilState depthStencilState{};
+                depthStencilState.nextInChain = nullptr;
+                depthStencilState.depthWriteEnabled = true;
+                depthStencilState.depthCompare = wgpu::CompareFunction::Less;
+                depthStencilState.format = wgpu::TextureFormat::Depth16Unorm;
+                depthStencilState.stencilReadMask = 0;
+                depthStencilState.stencilWriteMask = 0;
+
+                wgpu::ShaderModule sceneModule = shaderLibrary->getModule("basic.wgsl", { { "TEXTURED", "" } });
+
+                wgpu::FragmentState fragmentState{};
+                fragmentState.nextInChain = nullptr;
+                fragmentState.module = sceneModule;
+                fragmentState.entryPoint = "fragmentMain";
+                fragmentState.constantCount = 0;
+                fragmentState.constants = nullptr;
+                fragmentState.targetCount = 1;
+                fragmentState.targets = &colorTarget;
+
+                wgpu::RenderPipelineDescriptor pipelineDesc{};
+                pipelineDesc.label = "Benchmark Scene Pipeline";
+                pipelineDesc.vertex.module = sceneModule;
+                pipelineDesc.vertex.entryPoint = "vertexMain";
+                pipelineDesc.vertex.bufferCount = 2;
+                pipelineDesc.vertex.buffers = vertexBufferLayouts;
+                pipelineDesc.primitive.topology = wgpu::PrimitiveTopology::TriangleList;
+                pipelineDesc.primitive.stripIndexFormat = wgpu::IndexFormat::Undefined;
+                pipelineDesc.primitive.frontFace = wgpu::FrontFace::CCW;
+                pipelineDesc.primitive.cullMode = wgpu::CullMode::None;
+                pipelineDesc.fragment = &fragmentState;
+                pipelineDesc.depthStencil = &depthStencilState;
+                pipelineDesc.multisample.count = 1;
+                pipelineDesc.multisample.mask = ~0u;
+                pipelineDesc.multisample.alphaToCoverageEnabled = false;
+                pipelineDesc.layout = this->pipelineLayout;
+
+                this->scenePipeline = this->device->createRenderPipeline(pipelineDesc);
+
+                // Behind the prepass only the fragments matching the nearest depth are shaded
+                depthStencilState.depthWriteEnabled = false;
+                depthStencilState.depthCompare = wgpu::CompareFunction::Equal;
+                pipelineDesc.label = "Benchmark Equal Depth Pipeline";
+
+                this->equalDepthPipeline = this->device->createRenderPipeline(pipelineDesc);
+
+                // No fragment stage and only positions, like the app's prepass
+                depthStencilState.depthWriteEnabled = true;
+                depthStencilState.depthCompare = wgpu::CompareFunction::Less;
+
+                pipelineDesc.label = "Benchmark Depth Prepass Pipeline";
+                pipelineDesc.vertex.module = shaderLibrary->getModule("depth_prepass.wgsl");
+                pipelineDesc.vertex.bufferCount = 1;
+                pipelineDesc.fragment = nullptr;
+
+                this->prepassPipeline = this->device->createRenderPipeline(pipelineDesc);
+            }
+        };
+    }
+
+    void registerPrepassBenchmarks(BenchmarkRunner &runner, bool gpu) {
+        // Fragment work only shows on the GPU, so these need a real adapter and are left out unless asked for
+        if (!gpu) {
+            return;
+        }
+
+        for (bool prepassEnabled : { false, true }) {
+            runner.add(std::string("prepass/dense_overdraw/") + (prepassEnabled ? "on" : "off"), [prepassEnabled](BenchmarkContext &context) {
+                GpuFixture fixture;
+                fixture.requireTimestamps();
+
+                OverdrawScene scene{ fixture };
+                OverdrawMeter overdrawMeter{ fixture.getDevice(), fixture.getReadbackRing(), GpuFixture::FRAMES_IN_FLIGHT };
+                uint32_t frameSlot = 0;
+
+                RenderGraph renderGraph{ fixture.getDevice() };
+                RenderResourceId colorResource = renderGraph.createTexture("Color", RenderTextureDesc{ RENDER_WIDTH, RENDER_HEIGHT, wgpu::TextureFormat::RGBA8Unorm });
+                RenderResourceId depthResource = renderGraph.createTexture("Depth", RenderTextureDesc{ RENDER_WIDTH, RENDER_HEIGHT, wgpu::TextureFormat::Depth16Unorm });
+
+                if (prepassEnabled) {
+                    RenderPassId depthPrepass = renderGraph.addRenderPass("Depth Prepass", [&](wgpu::RenderPassEncoder renderPassEncoder) {
+                        renderPassEncoder.beginOcclusionQuery(overdrawMeter.getDepthQueryIndex(frameSlot));
+                        scene.draw(renderPassEncoder, scene.prepassPipeline);
+                        renderPassEncoder.endOcclusionQuery();
+                    });
+
+                    renderGraph.addDepthAttachment(depthPrepass, depthResource, 1.0f);
+                    renderGraph.setOcclusionQuerySet(depthPrepass, overdrawMeter.getQuerySet());
+                }
+
+                RenderPassId scenePass = renderGraph.addRenderPass("Scene Pass", [&](wgpu::RenderPassEncoder renderPassEncoder) {
+                    renderPassEncoder.beginOcclusionQuery(overdrawMeter.getShadeQueryIndex(frameSlot));
+                    scene.draw(renderPassEncoder, prepassEnabled ? scene.equalDepthPipeline : scene.scenePipeline);
+                    renderPassEncoder.endOcclusionQuery();
+                });
+
+                renderGraph.addColorAttachment(scenePass, colorResource);
+                renderGraph.addDepthAttachment(scenePass, depthResource, 1.0f);
+                renderGraph.setOcclusionQuerySet(scenePass, overdrawMeter.getQuerySet());
+
+                // Nothing reads the picture back, it only has to be drawn
+                renderGraph.setSideEffect(scenePass);
+                renderGraph.compile();
+
+                auto frame = [&]() {
+                    frameSlot = fixture.beginFrame(renderGraph);
+
+                    wgpu::CommandEncoder commandEncoder = fixture.createCommandEncoder();
+                    renderGraph.execute(commandEncoder);
+                    overdrawMeter.resolve(commandEncoder, frameSlot, prepassEnabled, uint64_t(RENDER_WIDTH) * RENDER_HEIGHT);
+
+                    fixture.endFrame(commandEncoder);
+                };
+
+                for (uint32_t i = 0; i < GpuFixture::FRAMES_IN_FLIGHT * 2; i++) {
+                    frame();
+                }
+
+                fixture.waitIdle();
+                fixture.collectGpuTimeMs();
+
+                context.setItemsPerIteration(uint64_t(RENDER_WIDTH) * RENDER_HEIGHT);
+                context.run(frame);
+
+                fixture.waitIdle();
+                context.setCounter("gpu_ms", fixture.collectGpuTimeMs());
+                context.setCounter("depth_complexity", overdrawMeter.getDepthComplexity());
+                context.setCounter("shaded_overdraw", overdrawMeter.getShadedOverdraw());
+
+                renderGraph.release();
+                overdrawMeter.release();
+            });
+        }
+    }
+}
@@ -2,6 +2,12 @@
 #include <iostream>
 #include <cassert>
 #include <vector>
+#include <thread>
+#include <chrono>
+#include <string>
+#include <algorithm>
+#include <random>
+#include <cmath>
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -9,97 +15,267 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
 #include "src/camera/camera.hpp"
+#include "src/camera/path/camera_path.hpp"
+#include "src/batch/job/batch_job_list.hpp"
 #include "src/device/device.hpp"
+#include "src/device/upload/upload_queue.hpp"
 #include "src/buffer/master/master_buffer.hpp"
 #include "src/buffer/child/child_buffer.hpp"
+#include "src/buffer/shadow/shadow_buffer.hpp"
+#include "src/shader/library/shader_library.hpp"
+#include "src/render/bundle/parallel_encoder.hpp"
+#include "src/job/system/job_system.hpp"
+#include "src/job/graph/task_graph.hpp"
+#include "src/frame/sync/frame_sync.hpp"
+#include "src/frame/redraw/redraw_tracker.hpp"
+#include "src/render/graph/render_graph.hpp"
+#include "src/render/timing/gpu_timer.hpp"
+#include "src/render/resolution/dynamic_resolution.hpp"
+#include "src/render/prepass/overdraw_meter.hpp"
+#include "src/render/prepass/depth_prepass_policy.hpp"
+#include "src/render/queue/draw_queue.hpp"
+#include "src/render/lighting/clustered_lighting.hpp"
+#include "src/render/culling/occlusion_culler.hpp"
+#include "src/render/readback/readback_ring.hpp"
+#include "src/animation/skinning/skinning_system.hpp"
+#include "src/render/particles/particle_system.hpp"
+#include "src/world/streaming/world_streamer.hpp"
+#include "src/frame/arena/frame_arena.hpp"
+#include "src/frame/deletion/gpu_handle.hpp"
+#include "src/memory/tracking/allocation_tracker.hpp"
+#include "src/struct.hpp"
 
 nugie::Camera* camera;
 nugie::Device* device;
+nugie::ShaderLibrary* shaderLibrary;
+nugie::JobSystem* jobSystem;
+nugie::UploadQueue* uploadQueue;
+nugie::ParallelEncoder* parallelEncoder;
+nugie::ParallelEncoder* depthPrepassEncoder;
+nugie::ParallelEncoder* lateEncoder;
+nugie::FrameSync* frameSync;
+nugie::RedrawTracker* redrawTracker;
+nugie::FrameArena* frameArena;
+nugie::DeletionQueue* deletionQueue;
+nugie::GpuTimer* gpuTimer;
+nugie::DynamicResolution* dynamicResolution;
+nugie::OverdrawMeter* overdrawMeter;
+nugie::DepthPrepassPolicy* depthPrepassPolicy;
+nugie::ClusteredLighting* clusteredLighting;
+nugie::OcclusionCuller* occlusionCuller;
+nugie::ReadbackRing* readbackRing;
+nugie::SkinningSystem* skinningSystem;
+nugie::ParticleSystem* particleSystem;
+nugie::WorldStreamer* worldStreamer;
 
 nugie::MasterBuffer* vertexBuffer;
 nugie::MasterBuffer* uniformBuffer;
 
-wgpu::Buffer indexBuffer;
+nugie::BufferHandle indexBuffer;
 
-wgpu::Texture objectTexture;
+nugie::TextureHandle objectTexture;
 wgpu::TextureView objectTextureView;
 wgpu::Sampler objectSampler;
 
-wgpu::Texture depthTexture;
-wgpu::TextureView depthTextureView;
+nugie::RenderGraph* renderGraph;
+nugie::RenderResourceId surfaceResource;
+nugie::RenderResourceId sceneColorResource;
+
+wgpu::RenderPipeline upscalePipeline;
+wgpu::PipelineLayout upscalePipelineLayout;
+wgpu::BindGroupLayout upscaleBindGroupLayout;
+wgpu::Sampler upscaleSampler;
 
 wgpu::RenderPipeline renderPipeline;
+wgpu::RenderPipeline equalDepthPipeline;
+wgpu::RenderPipeline untexturedPipeline;
+wgpu::RenderPipeline untexturedEqualDepthPipeline;
+wgpu::RenderPipeline depthPrepassPipeline;
 wgpu::PipelineLayout renderPipelineLayout;
 
 wgpu::BindGroupLayout sceneBindGroupLayout;
 wgpu::BindGroupLayout objectBindGroupLayout;
 
-wgpu::BindGroup sceneBindGroup;
-wgpu::BindGroup objectBindGroup;
+// What the scene and upscale shaders declare, the bind group layouts are built from it
+nugie::ShaderReflection sceneReflection;
+nugie::ShaderReflection upscaleReflection;
+
+// Per-frame copies of everything the CPU rewrites while older frames may still be in flight
+// Uniforms are written whole every frame through a CPU copy, only what changed is uploaded
+struct FrameResources {
+    nugie::ShadowBuffer sceneUniformBuffer;
+    nugie::ShadowBuffer modelTransformBuffer;
+
+    nugie::ShadowBuffer upscaleUniformBuffer;
+
+    wgpu::BindGroup sceneBindGroup;
+    wgpu::BindGroup objectBindGroup;
+    wgpu::BindGroup upscaleBindGroup;
+    wgpu::BindGroup lightCullBindGroup;
+
+    // Scene draws, with the world space center of each used to sort it
+    std::vector<nugie::DrawCommand> drawCommands;
+    std::vector<nugie::DrawCommand> depthDrawCommands;
+    std::vector<glm::vec3> drawCenters;
+
+    // The same draws with the arguments of the late occlusion pass
+    std::vector<nugie::DrawCommand> lateDrawCommands;
+
+    nugie::DrawQueue drawQueue;
+    nugie::DrawQueue depthDrawQueue;
+    nugie::DrawQueue lateDrawQueue;
+};
+
+// Layout matches SceneUniform in common/uniforms.wgsl
+struct SceneUniform {
+    glm::mat4 cameraTransform;
+    glm::mat4 viewTransform;
+    glm::mat4 inverseProjection;
+    glm::vec3 cameraPosition;
+    uint32_t lightCount;
+    glm::vec2 screenSize;
+    float nearPlane;
+    float farPlane;
+    glm::uvec3 clusterCount;
+    uint32_t padding;
+};
+
+// Layout matches ObjectUniform in common/uniforms.wgsl
+struct ObjectUniform {
+    glm::mat4 modelTransform;
+};
+
+// Layout matches UpscaleUniform in upscale.wgsl
+struct UpscaleUniform {
+    glm::vec2 uvScale;
+    glm::vec2 texelSize;
+};
+
+std::vector<FrameResources> frameResources;
 
 // settings
 const unsigned int SCR_WIDTH = 800;
 const unsigned int SCR_HEIGHT = 600;
+const float NEAR_PLANE = 0.1f;
+const float FAR_PLANE = 100.0f;
+
+// Light every surface gets on top of the clustered lights, passed to the scene shader as an override constant
+const double AMBIENT_STRENGTH = 0.1;
+
+// Flat color of the materials without a texture, drawn with the scene shader's non-sampling variant
+const glm::vec3 UNTEXTURED_COLOR{ 1.0f, 0.5f, 0.31f };
+
+// Starting size of each frame arena, it grows once if a frame needs more
+const size_t FRAME_ARENA_SIZE = 4 * 1024 * 1024;
+
+// Frames after this one must not allocate on any thread in a tracked build, once the arenas have grown.
+// Streaming a cell, recording a camera path or taking a screenshot allocates, the frames in flight after
+// one of those are not checked either.
+const uint64_t STEADY_STATE_FRAME = 16;
+
+// Objects the occlusion culler can hold
+const uint32_t MAX_CULL_OBJECTS = 4096;
+
+// Room of the skinning system, over every animated instance
+const uint32_t MAX_SKINNED_VERTICES = 65536;
+const uint32_t MAX_SKINNED_JOINTS = 1024;
+const uint32_t MAX_SKINNED_INSTANCES = 64;
+
+wgpu::PresentMode presentMode = wgpu::PresentMode::Fifo;
+uint32_t framesInFlight = 2;
+
+// dynamic resolution
+double targetFrameMs = 16.0;
+bool edgeAwareUpscale = false;
+uint32_t renderWidth = SCR_WIDTH;
+uint32_t renderHeight = SCR_HEIGHT;
+
+// lighting
+uint32_t lightCount = 1024;
+std::vector<nugie::Light> lights;
+std::vector<nugie::Light> baseLights;
+std::vector<float> lightOrbitSpeeds;
+
+// particles, the fountain above the cube keeps the pool about full
+uint32_t particleCount = 262144;
+
+// world streaming, procedural cells of floor and boxes around the camera
+bool worldStreamingEnabled = true;
+const float WORLD_FLOOR_HEIGHT = -1.5f;
+const uint32_t WORLD_TEXTURE_SIZE = 64;
+
+// depth prepass
+nugie::DepthPrepassMode depthPrepassMode = nugie::DepthPrepassMode::Auto;
+bool depthPrepassEnabled = false;
+
+// camera paths, recorded while flying around and played back with a fixed timestep
+std::string recordCameraPath;
+std::string playCameraPath;
+float cameraTimestep = 1.0f / 60.0f;
+nugie::CameraRecorder* cameraRecorder = nullptr;
+nugie::CameraPlayer* cameraPlayer = nullptr;
 
 // camera
 float lastX = SCR_WIDTH / 2.0f;
 float lastY = SCR_HEIGHT / 2.0f;
 bool firstMouse = true;
 
-// timing
-float deltaTime = 0;
+// on-demand rendering, a frame is only drawn when something on screen changed and the loop sleeps in between.
+// The animation starts paused there, P pauses and resumes it in either mode.
+bool renderOnDemand = false;
+bool animationPaused = false;
+bool animationKeyDown = false;
+const double ON_DEMAND_WAIT_SECONDS = 0.1;
 
-const char* shaderSource = R"(
-    struct SceneUniform {
-        cameraTransform: mat4x4f
-    }
+// Longest step a frame may take. The first frame after an on-demand idle would otherwise see the whole
+// event wait as its delta time and jump the camera, the same goes for a stall such as a window drag.
+const float MAX_FRAME_DELTA_SECONDS = 1.0f / 30.0f;
 
-    struct ObjectUniform {
-        modelTransform: mat4x4f
-    }
+// screenshots, F12 saves the scene color of the next frame as a PNG
+bool screenshotRequested = false;
+bool screenshotKeyDown = false;
+uint32_t screenshotsInFlight = 0;
 
-    struct VertexInput {
-        @location(0) position: vec3f,
-        @location(1) uv: vec2f
-    }
+// batch rendering, every pose of a job file is rendered into a hidden target and written as a PNG
+std::string batchJobPath;
+nugie::BatchJobList batchJobs;
+const nugie::BatchJob* batchJob = nullptr;
+wgpu::Texture batchTarget;
+wgpu::TextureView batchTargetView;
 
-    struct VertexOutput {
-        @builtin(position) position: vec4f,
-        @location(0) uv: vec2f
-    }
+// Every batch image restarts the particles and simulates this one step, so the same pose gives the same image
+const float BATCH_PARTICLE_STEP = 1.0f / 60.0f;
 
-    @group(0) @binding(0) var<uniform> sceneUniform: SceneUniform;
-    @group(1) @binding(0) var<uniform> objectUniform: ObjectUniform;
-    @group(1) @binding(1) var objectTexture: texture_2d<f32>;
-    @group(1) @binding(2) var objectSampler: sampler;
-    
-    @vertex
-    fn vertexMain(input: VertexInput) -> VertexOutput {
-        var output: VertexOutput;
-        output.position = sceneUniform.cameraTransform * objectUniform.modelTransform * vec4f(input.position, 1.0);
-        output.uv = input.uv;
+// PNG compression runs on the job system, off the frame's critical path
+nugie::JobCounter pngWriteCounter;
 
-        return output;
-    }
+// Image readbacks that may wait for their mapping at the same time
+const uint32_t MAX_READBACKS_IN_FLIGHT = 8;
 
-    @fragment
-    fn fragmentMain(@location(0) uv: vec2f) -> @location(0) vec4f {
-        return textureSample(objectTexture, objectSampler, uv);
-    }
+// The GPU timer, overdraw meter and occlusion culler each read their results back every frame
+const uint32_t STATS_READBACKS_PER_FRAME = 3;
 
-    @fragment
-    fn fragmentMain_(@location(0) uv: vec2f) -> @location(0) vec4f {
-        var lightColor: vec3f = vec3f(1.0, 1.0, 1.0);
-        var objectColor: vec3f = vec3f(1.0, 0.5, 0.31);
-        var ambientStrength: f32 = 0.1;
+// GPU memory the renderer should stay under, zero for no budget
+uint64_t gpuMemoryBudgetMb = 0;
 
-        var ambient: vec3f = ambientStrength * lightColor;
+// skinning
+nugie::Skeleton cubeSkeleton;
+nugie::AnimationClip* twistClip;
+nugie::AnimationClip* swayClip;
+uint32_t cubeSkinInstance = 0;
 
-        var result: vec3f = ambient * objectColor;
-        return vec4f(result, 1.0);
-    }
-)";
+// timing
+float deltaTime = 0;
+
+// Drives the animation, taken from the camera path during playback so every run sees the same scene
+float sceneTime = 0;
+
+// How far sceneTime moved this frame, zero while the animation is paused
+float sceneDeltaTime = 0;
 
 void createVertexBuffer(nugie::Device* device, size_t vectorSize) {
     wgpu::BufferDescriptor bufferDesc;
@@ -128,7 +304,7 @@ void createIndexBuffer(nugie::Device* device, size_t vectorSize) {
     bufferDesc.usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::Index;
     bufferDesc.mappedAtCreation = false;
 
-    indexBuffer = device->createBuffer(bufferDesc);
+    indexBuffer = nugie::BufferHandle{ device->createBuffer(bufferDesc), deletionQueue };
 }
 
 void createAndLoadSimpleTexture(nugie::Device* device) {
@@ -150,7 +326,7 @@ void createAndLoadSimpleTexture(nugie::Device* device) {
     textureDesc.format = wgpu::TextureFormat::RGBA8Unorm;
     textureDesc.usage = wgpu::TextureUsage::CopyDst | wgpu::TextureUsage::TextureBinding;
 
-    objectTexture = device->createTexture(textureDesc);
+    objectTexture = nugie::TextureHandle{ device->createTexture(textureDesc), deletionQueue };
 
     wgpu::TextureViewDescriptor textureViewDesc{};
     textureViewDesc.nextInChain = nullptr;
@@ -160,12 +336,12 @@ void createAndLoadSimpleTexture(nugie::Device* device) {
     textureViewDesc.baseArrayLayer = 0;
     textureViewDesc.mipLevelCount = 1;
     textureViewDesc.baseMipLevel = 0;
-    textureViewDesc.format = objectTexture.getFormat();
+    textureViewDesc.format = objectTexture->getFormat();
 
-    objectTextureView = objectTexture.createView(textureViewDesc);
+    objectTextureView = objectTexture->createView(textureViewDesc);
 
     wgpu::ImageCopyTexture destination{};
-    destination.texture = objectTexture;
+    destination.texture = objectTexture.get();
     destination.aspect = wgpu::TextureAspect::All;
     destination.mipLevel = 0;
     destination.origin = { 0, 0, 0 };
@@ -175,33 +351,287 @@ void createAndLoadSimpleTexture(nugie::Device* device) {
     source.bytesPerRow = 4 * textureDesc.size.width;
     source.rowsPerImage = textureDesc.size.height;
 
-    device->getQueue().writeTexture(destination, pixels, imageSize, source, textureDesc.size);
+    device->writeTexture(destination, pixels, imageSize, source, textureDesc.size);
 }
 
-void createDepthTexture(nugie::Device* device) {
-    wgpu::TextureDescriptor textureDesc{};
-    textureDesc.nextInChain = nullptr;
-    textureDesc.label = "Depth Texture";
-    textureDesc.dimension = wgpu::TextureDimension::_2D;
-    textureDesc.size = { 800, 600, 1 };
-    textureDesc.mipLevelCount = 1;
-    textureDesc.sampleCount = 1;
-    textureDesc.format = wgpu::TextureFormat::Depth16Unorm;
-    textureDesc.usage = wgpu::TextureUsage::RenderAttachment;
+void createRenderGraph(nugie::Device* device) {
+    renderGraph = new nugie::RenderGraph(device);
+    renderGraph->setDeletionQueue(deletionQueue);
 
-    depthTexture = device->createTexture(textureDesc);
+    surfaceResource = renderGraph->importTexture("Surface Texture", false, true);
 
-    wgpu::TextureViewDescriptor textureViewDesc{};
-    textureViewDesc.nextInChain = nullptr;
-    textureViewDesc.aspect = wgpu::TextureAspect::DepthOnly;
-    textureViewDesc.dimension = wgpu::TextureViewDimension::_2D;
-    textureViewDesc.arrayLayerCount = 1;
-    textureViewDesc.baseArrayLayer = 0;
-    textureViewDesc.mipLevelCount = 1;
-    textureViewDesc.baseMipLevel = 0;
-    textureViewDesc.format = textureDesc.format;
+    // The scene is drawn into the top-left renderWidth x renderHeight corner of targets sized for the
+    // largest possible surface, so changing the scale or resizing the window never reallocates them
+    nugie::RenderTextureDesc colorDesc{};
+    colorDesc.width = device->getMaxWidth();
+    colorDesc.height = device->getMaxHeight();
+    colorDesc.format = device->getSurfaceFormat();
+    colorDesc.extraUsage = wgpu::TextureUsage::CopySrc;
+
+    nugie::RenderTextureDesc depthDesc{};
+    depthDesc.width = device->getMaxWidth();
+    depthDesc.height = device->getMaxHeight();
+    depthDesc.format = wgpu::TextureFormat::Depth16Unorm;
+
+    sceneColorResource = renderGraph->createTexture("Scene Color Texture", colorDesc);
+    nugie::RenderResourceId depthResource = renderGraph->createTexture("Depth Texture", depthDesc);
+
+    // Skinned positions are written to a buffer the graph does not track, so the pass is kept alive explicitly.
+    // It runs first, every pass that draws an animated mesh reads what it wrote.
+    nugie::RenderPassId skinningPass = renderGraph->addComputePass("Skinning Pass", [](wgpu::ComputePassEncoder computePassEncoder) {
+        skinningSystem->dispatch(computePassEncoder);
+    });
+
+    renderGraph->setSideEffect(skinningPass);
+
+    // The particle pool and its draw arguments are not tracked by the graph either
+    nugie::RenderPassId particleSimulatePass = renderGraph->addComputePass("Particle Simulate Pass", [](wgpu::ComputePassEncoder computePassEncoder) {
+        particleSystem->dispatch(computePassEncoder);
+    });
+
+    renderGraph->setSideEffect(particleSimulatePass);
+
+    // Light lists live in buffers the graph does not track, so the pass is kept alive explicitly
+    nugie::RenderPassId lightCullPass = renderGraph->addComputePass("Light Cull Pass", [](wgpu::ComputePassEncoder computePassEncoder) {
+        clusteredLighting->dispatch(computePassEncoder, frameResources[frameSync->getFrameSlot()].lightCullBindGroup);
+    });
+
+    renderGraph->setSideEffect(lightCullPass);
+
+    // Draw arguments are written to buffers the graph does not track, so the culling passes are kept alive explicitly
+    nugie::RenderPassId earlyCullPass = renderGraph->addComputePass("Occlusion Cull Early", [](wgpu::ComputePassEncoder computePassEncoder) {
+        occlusionCuller->dispatchEarly(computePassEncoder);
+    });
+
+    renderGraph->setSideEffect(earlyCullPass);
+
+    // Always part of the graph so it owns the depth clear, it only draws while the prepass is enabled
+    nugie::RenderPassId depthPrepass = renderGraph->addRenderPass("Depth Prepass", [](wgpu::RenderPassEncoder renderPassEncoder) {
+        if (!depthPrepassEnabled) {
+            return;
+        }
+
+        renderPassEncoder.setViewport(0.0f, 0.0f, static_cast<float>(renderWidth), static_cast<float>(renderHeight), 0.0f, 1.0f);
+        renderPassEncoder.setScissorRect(0, 0, renderWidth, renderHeight);
+
+        renderPassEncoder.beginOcclusionQuery(overdrawMeter->getDepthQueryIndex(frameSync->getFrameSlot()));
+        depthPrepassEncoder->execute(renderPassEncoder);
+        renderPassEncoder.endOcclusionQuery();
+    });
+
+    renderGraph->addDepthAttachment(depthPrepass, depthResource, 1.0f);
+
+    nugie::RenderPassId scenePass = renderGraph->addRenderPass("Scene Pass", [](wgpu::RenderPassEncoder renderPassEncoder) {
+        renderPassEncoder.setViewport(0.0f, 0.0f, static_cast<float>(renderWidth), static_cast<float>(renderHeight), 0.0f, 1.0f);
+        renderPassEncoder.setScissorRect(0, 0, renderWidth, renderHeight);
+
+        renderPassEncoder.beginOcclusionQuery(overdrawMeter->getShadeQueryIndex(frameSync->getFrameSlot()));
+        parallelEncoder->execute(renderPassEncoder);
+        renderPassEncoder.endOcclusionQuery();
+    });
+
+    renderGraph->addColorAttachment(scenePass, sceneColorResource, wgpu::Color{ 0, 0, 0, 0 });
+    renderGraph->addDepthAttachment(scenePass, depthResource, 1.0f);
+
+    renderGraph->setOcclusionQuerySet(depthPrepass, overdrawMeter->getQuerySet());
+    renderGraph->setOcclusionQuerySet(scenePass, overdrawMeter->getQuerySet());
+
+    // The pyramid is built from what the early draws left in the depth buffer
+    nugie::RenderPassId hizBuildPass = renderGraph->addComputePass("Hi-Z Build", [](wgpu::ComputePassEncoder computePassEncoder) {
+        occlusionCuller->buildPyramid(computePassEncoder);
+    });
+
+    renderGraph->addRead(hizBuildPass, depthResource);
+    renderGraph->setSideEffect(hizBuildPass);
+
+    nugie::RenderPassId lateCullPass = renderGraph->addComputePass("Occlusion Cull Late", [](wgpu::ComputePassEncoder computePassEncoder) {
+        occlusionCuller->dispatchLate(computePassEncoder);
+    });
+
+    renderGraph->setSideEffect(lateCullPass);
+
+    nugie::RenderPassId lateScenePass = renderGraph->addRenderPass("Scene Pass Late", [](wgpu::RenderPassEncoder renderPassEncoder) {
+        renderPassEncoder.setViewport(0.0f, 0.0f, static_cast<float>(renderWidth), static_cast<float>(renderHeight), 0.0f, 1.0f);
+        renderPassEncoder.setScissorRect(0, 0, renderWidth, renderHeight);
+
+        lateEncoder->execute(renderPassEncoder);
+    });
+
+    renderGraph->addColorAttachment(lateScenePass, sceneColorResource, wgpu::Color{ 0, 0, 0, 0 });
+    renderGraph->addDepthAttachment(lateScenePass, depthResource, 1.0f);
+
+    // Blended over everything opaque, after both scene passes have laid down depth
+    nugie::RenderPassId particlePass = renderGraph->addRenderPass("Particle Pass", [](wgpu::RenderPassEncoder renderPassEncoder) {
+        renderPassEncoder.setViewport(0.0f, 0.0f, static_cast<float>(renderWidth), static_cast<float>(renderHeight), 0.0f, 1.0f);
+        renderPassEncoder.setScissorRect(0, 0, renderWidth, renderHeight);
+
+        particleSystem->draw(renderPassEncoder);
+    });
+
+    renderGraph->addColorAttachment(particlePass, sceneColorResource, wgpu::Color{ 0, 0, 0, 0 });
+    renderGraph->addDepthAttachment(particlePass, depthResource, 1.0f, true);
+
+    nugie::RenderPassId upscalePass = renderGraph->addRenderPass("Upscale Pass", [](wgpu::RenderPassEncoder renderPassEncoder) {
+        renderPassEncoder.setPipeline(upscalePipeline);
+        renderPassEncoder.setBindGroup(0, frameResources[frameSync->getFrameSlot()].upscaleBindGroup, 0, nullptr);
+        renderPassEncoder.draw(3, 1, 0, 0);
+    });
+
+    renderGraph->addRead(upscalePass, sceneColorResource);
+    renderGraph->addColorAttachment(upscalePass, surfaceResource, wgpu::Color{ 0, 0, 0, 0 });
+
+    renderGraph->compile();
+
+    occlusionCuller->setDepthView(renderGraph->getTextureView(depthResource));
+}
+
+std::vector<nugie::ShaderDefine> getUpscaleDefines() {
+    std::vector<nugie::ShaderDefine> defines;
+    if (edgeAwareUpscale) {
+        defines.push_back({ "EDGE_AWARE", "" });
+    }
+
+    return defines;
+}
+
+std::vector<nugie::ShaderDefine> getSceneDefines(bool textured) {
+    std::vector<nugie::ShaderDefine> defines{ { "CLUSTERED_LIGHTING", "" } };
+    if (textured) {
+        defines.push_back({ "TEXTURED", "" });
+    }
+
+    return defines;
+}
+
+// Only sets the overrides the variant declares, a constant the shader does not know fails pipeline creation
+// ---------------------------------------------------------------------------------------------------------
+nugie::ShaderConstants getSceneConstants(const std::vector<nugie::ShaderDefine>& defines)
+{
+    auto hasDefine = [&defines](const std::string& name) {
+        return std::any_of(defines.begin(), defines.end(), [&name](const nugie::ShaderDefine& define) { return define.name == name; });
+    };
+
+    nugie::ShaderConstants constants;
+
+    if (hasDefine("CLUSTERED_LIGHTING")) {
+        constants.set("ambientStrength", AMBIENT_STRENGTH);
+    }
+
+    if (!hasDefine("TEXTURED")) {
+        constants.set("objectColorR", UNTEXTURED_COLOR.r);
+        constants.set("objectColorG", UNTEXTURED_COLOR.g);
+        constants.set("objectColorB", UNTEXTURED_COLOR.b);
+    }
+
+    return constants;
+}
+
+void createUpscalePipeline(nugie::Device* device) {
+    wgpu::SamplerDescriptor samplerDesc{};
+    samplerDesc.label = "Upscale Sampler";
+    samplerDesc.nextInChain = nullptr;
+    samplerDesc.addressModeU = wgpu::AddressMode::ClampToEdge;
+    samplerDesc.addressModeV = wgpu::AddressMode::ClampToEdge;
+    samplerDesc.addressModeW = wgpu::AddressMode::ClampToEdge;
+    samplerDesc.minFilter = wgpu::FilterMode::Linear;
+    samplerDesc.magFilter = wgpu::FilterMode::Linear;
+    samplerDesc.mipmapFilter = wgpu::MipmapFilterMode::Nearest;
+    samplerDesc.lodMinClamp = 0.0f;
+    samplerDesc.lodMaxClamp = 1.0f;
+    samplerDesc.compare = wgpu::CompareFunction::Undefined;
+    samplerDesc.maxAnisotropy = 1u;
+
+    upscaleSampler = device->createSampler(samplerDesc);
+
+    upscaleBindGroupLayout = upscaleReflection.createBindGroupLayout(device, "Upscale Bind Group Layout", 0);
+
+    WGPUBindGroupLayout bindGroupLayouts[1] {
+        upscaleBindGroupLayout
+    };
+
+    wgpu::PipelineLayoutDescriptor pipelineLayoutDesc{};
+    pipelineLayoutDesc.label = "Upscale Pipeline Layout";
+    pipelineLayoutDesc.bindGroupLayoutCount = 1;
+    pipelineLayoutDesc.bindGroupLayouts = bindGroupLayouts;
+
+    upscalePipelineLayout = device->createPipelineLayout(pipelineLayoutDesc);
+
+    wgpu::ShaderModule shaderModule = shaderLibrary->getModule("upscale.wgsl", getUpscaleDefines());
+
+    wgpu::ColorTargetState colorTarget{};
+    colorTarget.nextInChain = nullptr;
+    colorTarget.format = device->getSurfaceFormat();
+    colorTarget.blend = nullptr;
+    colorTarget.writeMask = wgpu::ColorWriteMask::All;
+
+    wgpu::VertexState vertexState{};
+    vertexState.nextInChain = nullptr;
+    vertexState.bufferCount = 0;
+    vertexState.buffers = nullptr;
+    vertexState.module = shaderModule;
+    vertexState.entryPoint = "vertexMain";
+    vertexState.constantCount = 0;
+    vertexState.constants = nullptr;
+
+    wgpu::PrimitiveState primitiveState{};
+    primitiveState.nextInChain = nullptr;
+    primitiveState.topology = wgpu::PrimitiveTopology::TriangleList;
+    primitiveState.stripIndexFormat = wgpu::IndexFormat::Undefined;
+    primitiveState.frontFace = wgpu::FrontFace::CCW;
+    primitiveState.cullMode = wgpu::CullMode::None;
+
+    wgpu::FragmentState fragmentState{};
+    fragmentState.nextInChain = nullptr;
+    fragmentState.module = shaderModule;
+    fragmentState.entryPoint = "fragmentMain";
+    fragmentState.constantCount = 0;
+    fragmentState.constants = nullptr;
+    fragmentState.targetCount = 1;
+    fragmentState.targets = &colorTarget;
+
+    wgpu::MultisampleState multiSampleState{};
+    multiSampleState.nextInChain = nullptr;
+    multiSampleState.count = 1;
+    multiSampleState.mask = ~0u;
+    multiSampleState.alphaToCoverageEnabled = false;
+
+    wgpu::RenderPipelineDescriptor pipelineDesc{};
+    pipelineDesc.label = "Upscale Pipeline";
+    pipelineDesc.vertex = vertexState;
+    pipelineDesc.primitive = primitiveState;
+    pipelineDesc.fragment = &fragmentState;
+    pipelineDesc.depthStencil = nullptr;
+    pipelineDesc.multisample = multiSampleState;
+    pipelineDesc.layout = upscalePipelineLayout;
+
+    upscalePipeline = device->createRenderPipeline(pipelineDesc);
+}
+
+wgpu::BindGroup createUpscaleBindGroup(nugie::Device* device, nugie::BufferInfo upscaleBufferInfo) {
+    wgpu::BindGroupEntry bindGroupEntries[3];
+
+    bindGroupEntries[0].nextInChain = nullptr;
+    bindGroupEntries[0].binding = 0;
+    bindGroupEntries[0].buffer = upscaleBufferInfo.buffer;
+    bindGroupEntries[0].offset = upscaleBufferInfo.offset;
+    bindGroupEntries[0].size = upscaleBufferInfo.size;
+
+    bindGroupEntries[1].nextInChain = nullptr;
+    bindGroupEntries[1].binding = 1;
+    bindGroupEntries[1].textureView = renderGraph->getTextureView(sceneColorResource);
+
+    bindGroupEntries[2].nextInChain = nullptr;
+    bindGroupEntries[2].binding = 2;
+    bindGroupEntries[2].sampler = upscaleSampler;
+
+    wgpu::BindGroupDescriptor bindGroupDesc{};
+    bindGroupDesc.label = "Upscale Bind Group";
+    bindGroupDesc.nextInChain = nullptr;
+    bindGroupDesc.entryCount = 3;
+    bindGroupDesc.entries = bindGroupEntries;
+    bindGroupDesc.layout = upscaleBindGroupLayout;
 
-    depthTextureView = depthTexture.createView(textureViewDesc);
+    return device->createBindGroup(bindGroupDesc);
 }
 
 void createSampler(nugie::Device* device) {
@@ -222,53 +652,53 @@ void createSampler(nugie::Device* device) {
     objectSampler = device->createSampler(samplerDesc);
 }
 
-void createSceneBindGroupLayout(nugie::Device* device) {
-    wgpu::BindGroupLayoutEntry bindGroupLayoutEntries[1];
-    bindGroupLayoutEntries[0].nextInChain = nullptr;
-    bindGroupLayoutEntries[0].binding = 0;
-    bindGroupLayoutEntries[0].visibility = wgpu::ShaderStage::Vertex;
-    bindGroupLayoutEntries[0].buffer.type = wgpu::BufferBindingType::Uniform;
-    bindGroupLayoutEntries[0].buffer.hasDynamicOffset = false;
-    bindGroupLayoutEntries[0].buffer.nextInChain = nullptr;
-
-    wgpu::BindGroupLayoutDescriptor bindGroupLayoutDesc{};
-    bindGroupLayoutDesc.label = "Scene Bind Group Layout";
-    bindGroupLayoutDesc.nextInChain = nullptr;
-    bindGroupLayoutDesc.entryCount = 1;
-    bindGroupLayoutDesc.entries = bindGroupLayoutEntries;
+// Reflects the scene and upscale shaders and checks every C++ struct that mirrors one of theirs,
+// so a layout that drifted stops the app here instead of shifting uniforms at draw time
+// -------------------------------------------------------------------------------------------------
+void reflectShaders()
+{
+    // The scene pipelines share one layout, so it covers what the main and the depth prepass shaders use.
+    // The textured variant binds everything the untextured one does.
+    sceneReflection = shaderLibrary->getReflection("basic.wgsl", getSceneDefines(true));
+    sceneReflection.merge(shaderLibrary->getReflection("depth_prepass.wgsl"));
+
+    upscaleReflection = shaderLibrary->getReflection("upscale.wgsl", getUpscaleDefines());
+
+    sceneReflection.validateStruct("SceneUniform", sizeof(SceneUniform), {
+        { "cameraTransform", offsetof(SceneUniform, cameraTransform) },
+        { "viewTransform", offsetof(SceneUniform, viewTransform) },
+        { "inverseProjection", offsetof(SceneUniform, inverseProjection) },
+        { "cameraPosition", offsetof(SceneUniform, cameraPosition) },
+        { "lightCount", offsetof(SceneUniform, lightCount) },
+        { "screenSize", offsetof(SceneUniform, screenSize) },
+        { "nearPlane", offsetof(SceneUniform, nearPlane) },
+        { "farPlane", offsetof(SceneUniform, farPlane) },
+        { "clusterCount", offsetof(SceneUniform, clusterCount) }
+    });
+
+    sceneReflection.validateStruct("ObjectUniform", sizeof(ObjectUniform), {
+        { "modelTransform", offsetof(ObjectUniform, modelTransform) }
+    });
+
+    sceneReflection.validateStruct("Light", sizeof(nugie::Light), {
+        { "positionRange", offsetof(nugie::Light, positionRange) },
+        { "colorIntensity", offsetof(nugie::Light, colorIntensity) },
+        { "directionType", offsetof(nugie::Light, directionType) },
+        { "spotAngles", offsetof(nugie::Light, spotAngles) }
+    });
+
+    upscaleReflection.validateStruct("UpscaleUniform", sizeof(UpscaleUniform), {
+        { "uvScale", offsetof(UpscaleUniform, uvScale) },
+        { "texelSize", offsetof(UpscaleUniform, texelSize) }
+    });
+}
 
-    sceneBindGroupLayout = device->createBindGroupLayout(bindGroupLayoutDesc);
+void createSceneBindGroupLayout(nugie::Device* device) {
+    sceneBindGroupLayout = sceneReflection.createBindGroupLayout(device, "Scene Bind Group Layout", 0);
 }
 
 void createObjectBindGroupLayout(nugie::Device* device) {
-    wgpu::BindGroupLayoutEntry bindGroupLayoutEntries[3];
-    bindGroupLayoutEntries[0].nextInChain = nullptr;
-    bindGroupLayoutEntries[0].binding = 0;
-    bindGroupLayoutEntries[0].visibility = wgpu::ShaderStage::Vertex;
-    bindGroupLayoutEntries[0].buffer.type = wgpu::BufferBindingType::Uniform;
-    bindGroupLayoutEntries[0].buffer.hasDynamicOffset = false;
-    bindGroupLayoutEntries[0].buffer.nextInChain = nullptr;
-
-    bindGroupLayoutEntries[1].nextInChain = nullptr;
-    bindGroupLayoutEntries[1].binding = 1;
-    bindGroupLayoutEntries[1].visibility = wgpu::ShaderStage::Fragment;
-    bindGroupLayoutEntries[1].texture.nextInChain = nullptr;
-    bindGroupLayoutEntries[1].texture.sampleType = wgpu::TextureSampleType::Float;
-    bindGroupLayoutEntries[1].texture.viewDimension = wgpu::TextureViewDimension::_2D;
-
-    bindGroupLayoutEntries[2].nextInChain = nullptr;
-    bindGroupLayoutEntries[2].binding = 2;
-    bindGroupLayoutEntries[2].visibility = wgpu::ShaderStage::Fragment;
-    bindGroupLayoutEntries[2].sampler.nextInChain = nullptr;
-    bindGroupLayoutEntries[2].sampler.type = wgpu::SamplerBindingType::Filtering;
-
-    wgpu::BindGroupLayoutDescriptor bindGroupLayoutDesc{};
-    bindGroupLayoutDesc.label = "Object Bind Group Layout";
-    bindGroupLayoutDesc.nextInChain = nullptr;
-    bindGroupLayoutDesc.entryCount = 3;
-    bindGroupLayoutDesc.entries = bindGroupLayoutEntries;
-
-    objectBindGroupLayout = device->createBindGroupLayout(bindGroupLayoutDesc);
+    objectBindGroupLayout = sceneReflection.createBindGroupLayout(device, "Object Bind Group Layout", 1);
 }
 
 void createRenderPipelineLayout(nugie::Device* device) {
@@ -286,15 +716,9 @@ void createRenderPipelineLayout(nugie::Device* device) {
 }
 
 void createPipeline(nugie::Device* device) {
-    wgpu::ShaderModuleWGSLDescriptor shaderCodeDesc{};
-    shaderCodeDesc.chain.next = nullptr;
-    shaderCodeDesc.chain.sType = wgpu::SType::ShaderModuleWGSLDescriptor;
-    shaderCodeDesc.code = shaderSource;    
-
-    wgpu::ShaderModuleDescriptor shaderDesc{};
-    shaderDesc.nextInChain = &shaderCodeDesc.chain;
+    wgpu::ShaderModule shaderModule = shaderLibrary->getModule("basic.wgsl", getSceneDefines(true));
 
-    wgpu::ShaderModule shaderModule = device->createShaderModule(shaderDesc);
+    nugie::ShaderConstants fragmentConstants = getSceneConstants(getSceneDefines(true));
 
     wgpu::VertexAttribute positionAttrib{};
     positionAttrib.shaderLocation = 0;
@@ -352,8 +776,8 @@ void createPipeline(nugie::Device* device) {
     fragmentState.nextInChain = nullptr;
     fragmentState.module = shaderModule;
     fragmentState.entryPoint = "fragmentMain";
-    fragmentState.constantCount = 0;
-    fragmentState.constants = nullptr;
+    fragmentState.constantCount = fragmentConstants.getCount();
+    fragmentState.constants = fragmentConstants.getEntries();
     fragmentState.targetCount = 1;
     fragmentState.targets = &colorTarget;
 
@@ -381,29 +805,122 @@ void createPipeline(nugie::Device* device) {
     pipelineDesc.layout = renderPipelineLayout;
 
     renderPipeline = device->createRenderPipeline(pipelineDesc);
-    shaderModule.release();
+
+    // Behind a depth prepass the buffer already holds the nearest surface, so only the fragments matching it are shaded
+    depthStencilState.depthWriteEnabled = false;
+    depthStencilState.depthCompare = wgpu::CompareFunction::Equal;
+    pipelineDesc.label = "Equal Depth Render Pipeline";
+
+    equalDepthPipeline = device->createRenderPipeline(pipelineDesc);
+
+    // Untextured materials keep the same layout, their bind group's texture and sampler are just never read
+    wgpu::ShaderModule untexturedModule = shaderLibrary->getModule("basic.wgsl", getSceneDefines(false));
+    nugie::ShaderConstants untexturedConstants = getSceneConstants(getSceneDefines(false));
+
+    pipelineDesc.vertex.module = untexturedModule;
+    fragmentState.module = untexturedModule;
+    fragmentState.constantCount = untexturedConstants.getCount();
+    fragmentState.constants = untexturedConstants.getEntries();
+
+    depthStencilState.depthWriteEnabled = true;
+    depthStencilState.depthCompare = wgpu::CompareFunction::Less;
+    pipelineDesc.label = "Untextured Render Pipeline";
+
+    untexturedPipeline = device->createRenderPipeline(pipelineDesc);
+
+    depthStencilState.depthWriteEnabled = false;
+    depthStencilState.depthCompare = wgpu::CompareFunction::Equal;
+    pipelineDesc.label = "Untextured Equal Depth Render Pipeline";
+
+    untexturedEqualDepthPipeline = device->createRenderPipeline(pipelineDesc);
 }
 
-void createSceneBindGroup(nugie::Device* device, nugie::BufferInfo cameraTransformBufferInfo) {
-    wgpu::BindGroupEntry bindGroupEntries[1];
+void createDepthPrepassPipeline(nugie::Device* device) {
+    wgpu::ShaderModule shaderModule = shaderLibrary->getModule("depth_prepass.wgsl");
 
-    bindGroupEntries[0].nextInChain = nullptr;
-    bindGroupEntries[0].binding = 0;
-    bindGroupEntries[0].buffer = cameraTransformBufferInfo.buffer;
-    bindGroupEntries[0].offset = cameraTransformBufferInfo.offset;
-    bindGroupEntries[0].size = cameraTransformBufferInfo.size;
+    wgpu::VertexAttribute positionAttrib{};
+    positionAttrib.shaderLocation = 0;
+    positionAttrib.format = wgpu::VertexFormat::Float32x3;
+    positionAttrib.offset = 0;
+
+    wgpu::VertexBufferLayout vertexBufferLayout{};
+    vertexBufferLayout.attributeCount = 1;
+    vertexBufferLayout.attributes = &positionAttrib;
+    vertexBufferLayout.arrayStride = sizeof(glm::vec3);
+    vertexBufferLayout.stepMode = wgpu::VertexStepMode::Vertex;
+
+    wgpu::VertexState vertexState{};
+    vertexState.nextInChain = nullptr;
+    vertexState.bufferCount = 1;
+    vertexState.buffers = &vertexBufferLayout;
+    vertexState.module = shaderModule;
+    vertexState.entryPoint = "vertexMain";
+    vertexState.constantCount = 0;
+    vertexState.constants = nullptr;
+
+    wgpu::PrimitiveState primitiveState{};
+    primitiveState.nextInChain = nullptr;
+    primitiveState.topology = wgpu::PrimitiveTopology::TriangleList;
+    primitiveState.stripIndexFormat = wgpu::IndexFormat::Undefined;
+    primitiveState.frontFace = wgpu::FrontFace::CCW;
+    primitiveState.cullMode = wgpu::CullMode::None;
+
+    wgpu::DepthStencilState depthStencilState{};
+    depthStencilState.nextInChain = nullptr;
+    depthStencilState.depthWriteEnabled = true;
+    depthStencilState.depthCompare = wgpu::CompareFunction::Less;
+    depthStencilState.format = wgpu::TextureFormat::Depth16Unorm;
+    depthStencilState.stencilReadMask = 0;
+    depthStencilState.stencilWriteMask = 0;
+
+    wgpu::MultisampleState multiSampleState{};
+    multiSampleState.nextInChain = nullptr;
+    multiSampleState.count = 1;
+    multiSampleState.mask = ~0u;
+    multiSampleState.alphaToCoverageEnabled = false;
+
+    // No fragment stage, the pass only lays down depth
+    wgpu::RenderPipelineDescriptor pipelineDesc{};
+    pipelineDesc.label = "Depth Prepass Pipeline";
+    pipelineDesc.vertex = vertexState;
+    pipelineDesc.primitive = primitiveState;
+    pipelineDesc.fragment = nullptr;
+    pipelineDesc.depthStencil = &depthStencilState;
+    pipelineDesc.multisample = multiSampleState;
+    pipelineDesc.layout = renderPipelineLayout;
+
+    depthPrepassPipeline = device->createRenderPipeline(pipelineDesc);
+}
+
+wgpu::BindGroup createSceneBindGroup(nugie::Device* device, nugie::BufferInfo sceneUniformBufferInfo) {
+    nugie::BufferInfo bufferInfos[4] {
+        sceneUniformBufferInfo,
+        clusteredLighting->getLightBufferInfo(),
+        clusteredLighting->getClusterBufferInfo(),
+        clusteredLighting->getIndexBufferInfo()
+    };
+
+    wgpu::BindGroupEntry bindGroupEntries[4];
+
+    for (uint32_t i = 0; i < 4; i++) {
+        bindGroupEntries[i].nextInChain = nullptr;
+        bindGroupEntries[i].binding = i;
+        bindGroupEntries[i].buffer = bufferInfos[i].buffer;
+        bindGroupEntries[i].offset = bufferInfos[i].offset;
+        bindGroupEntries[i].size = bufferInfos[i].size;
+    }
 
     wgpu::BindGroupDescriptor bindGroupDesc{};
     bindGroupDesc.label = "Scene Uniform Bind Group";
     bindGroupDesc.nextInChain = nullptr;
-    bindGroupDesc.entryCount = 1;
+    bindGroupDesc.entryCount = 4;
     bindGroupDesc.entries = bindGroupEntries;
     bindGroupDesc.layout = sceneBindGroupLayout;
     
-    sceneBindGroup = device->createBindGroup(bindGroupDesc);
+    return device->createBindGroup(bindGroupDesc);
 }
 
-void createObjectBindGroup(nugie::Device* device, nugie::BufferInfo modelTransformBufferInfo) {
+wgpu::BindGroup createObjectBindGroup(nugie::Device* device, nugie::BufferInfo modelTransformBufferInfo, wgpu::TextureView textureView) {
     wgpu::BindGroupEntry bindGroupEntries[3];
 
     bindGroupEntries[0].nextInChain = nullptr;
@@ -414,7 +931,7 @@ void createObjectBindGroup(nugie::Device* device, nugie::BufferInfo modelTransfo
 
     bindGroupEntries[1].nextInChain = nullptr;
     bindGroupEntries[1].binding = 1;
-    bindGroupEntries[1].textureView = objectTextureView;
+    bindGroupEntries[1].textureView = textureView;
 
     bindGroupEntries[2].nextInChain = nullptr;
     bindGroupEntries[2].binding = 2;
@@ -427,7 +944,7 @@ void createObjectBindGroup(nugie::Device* device, nugie::BufferInfo modelTransfo
     bindGroupDesc.entries = bindGroupEntries;
     bindGroupDesc.layout = objectBindGroupLayout;
     
-    objectBindGroup = device->createBindGroup(bindGroupDesc);
+    return device->createBindGroup(bindGroupDesc);
 }
 
 // process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
@@ -445,6 +962,19 @@ void processInput(GLFWwindow *window)
         camera->processKeyboard(nugie::CameraMovement::LEFT, deltaTime);
     if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
         camera->processKeyboard(nugie::CameraMovement::RIGHT, deltaTime);
+
+    // Once per press, not for every frame the key is held
+    bool screenshotKey = glfwGetKey(window, GLFW_KEY_F12) == GLFW_PRESS;
+    if (screenshotKey && !screenshotKeyDown)
+        screenshotRequested = true;
+
+    screenshotKeyDown = screenshotKey;
+
+    bool animationKey = glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS;
+    if (animationKey && !animationKeyDown)
+        animationPaused = !animationPaused;
+
+    animationKeyDown = animationKey;
 }
 
 // glfw: whenever the mouse moves, this callback is called
@@ -477,7 +1007,334 @@ void scrollCallback(GLFWwindow* /* window */, double /* xoffset */, double yoffs
     camera->processMouseScroll(static_cast<float>(yoffset));
 }
 
-int main (int, char**) {
+// glfw: whenever the window was uncovered or must be redrawn for another reason, this callback is called
+// -------------------------------------------------------------------------------------------------------
+void refreshCallback(GLFWwindow* /* window */)
+{
+    redrawTracker->markDirty(nugie::RedrawReason::Window);
+}
+
+// --present-mode=fifo|mailbox|immediate, --frames-in-flight=N, --target-frame-ms=N, --upscale=bilinear|edge
+// --depth-prepass=off|on|auto, --lights=N, --record-camera=PATH, --play-camera=PATH, --camera-timestep=S
+// --gpu-memory-budget-mb=N, --particles=N, --world-streaming=off|on, --render-mode=continuous|on-demand
+// and --batch=PATH
+// ----------------------------------------------------------------------------------------------------------
+void parseArguments(int argc, char** argv)
+{
+    for (int i = 1; i < argc; i++) {
+        std::string argument = argv[i];
+
+        if (argument == "--present-mode=mailbox")
+            presentMode = wgpu::PresentMode::Mailbox;
+        else if (argument == "--present-mode=immediate")
+            presentMode = wgpu::PresentMode::Immediate;
+        else if (argument == "--present-mode=fifo")
+            presentMode = wgpu::PresentMode::Fifo;
+        else if (argument.rfind("--frames-in-flight=", 0) == 0)
+            framesInFlight = static_cast<uint32_t>(std::max(1, std::stoi(argument.substr(19))));
+        else if (argument.rfind("--lights=", 0) == 0)
+            lightCount = static_cast<uint32_t>(std::max(0, std::stoi(argument.substr(9))));
+        else if (argument.rfind("--target-frame-ms=", 0) == 0)
+            targetFrameMs = std::max(1.0, std::stod(argument.substr(18)));
+        else if (argument == "--upscale=edge")
+            edgeAwareUpscale = true;
+        else if (argument == "--upscale=bilinear")
+            edgeAwareUpscale = false;
+        else if (argument == "--depth-prepass=off")
+            depthPrepassMode = nugie::DepthPrepassMode::Off;
+        else if (argument == "--depth-prepass=on")
+            depthPrepassMode = nugie::DepthPrepassMode::On;
+        else if (argument == "--depth-prepass=auto")
+            depthPrepassMode = nugie::DepthPrepassMode::Auto;
+        else if (argument.rfind("--record-camera=", 0) == 0)
+            recordCameraPath = argument.substr(16);
+        else if (argument.rfind("--play-camera=", 0) == 0)
+            playCameraPath = argument.substr(14);
+        else if (argument.rfind("--camera-timestep=", 0) == 0)
+            cameraTimestep = std::max(0.0001f, std::stof(argument.substr(18)));
+        else if (argument.rfind("--particles=", 0) == 0)
+            particleCount = static_cast<uint32_t>(std::max(1, std::stoi(argument.substr(12))));
+        else if (argument == "--world-streaming=off")
+            worldStreamingEnabled = false;
+        else if (argument == "--world-streaming=on")
+            worldStreamingEnabled = true;
+        else if (argument == "--render-mode=on-demand")
+            renderOnDemand = true;
+        else if (argument == "--render-mode=continuous")
+            renderOnDemand = false;
+        else if (argument.rfind("--batch=", 0) == 0)
+            batchJobPath = argument.substr(8);
+        else if (argument.rfind("--gpu-memory-budget-mb=", 0) == 0)
+            gpuMemoryBudgetMb = static_cast<uint64_t>(std::max(0, std::stoi(argument.substr(23))));
+        else
+            std::cerr << "Unknown argument " << argument << std::endl;
+    }
+}
+
+// Fills a streamed cell with a floor tile and, away from the cube, a few boxes. Runs on the job system's
+// background thread, everything it needs comes from the coordinate so a cell always looks the same.
+// ------------------------------------------------------------------------------------------------------
+void loadWorldCell(nugie::CellCoord coord, nugie::CellPayload &payload, float cellSize)
+{
+    std::mt19937 random{ static_cast<uint32_t>(coord.x) * 73856093u ^ static_cast<uint32_t>(coord.z) * 19349663u };
+    std::uniform_real_distribution<float> unit{ 0.0f, 1.0f };
+
+    auto addQuad = [&](glm::vec3 a, glm::vec3 b, glm::vec3 c, glm::vec3 d) {
+        uint32_t first = static_cast<uint32_t>(payload.positions.size());
+
+        payload.positions.insert(payload.positions.end(), { a, b, c, d });
+        payload.textCoords.insert(payload.textCoords.end(), { glm::vec2{ 0.0f, 0.0f }, glm::vec2{ 1.0f, 0.0f }, glm::vec2{ 1.0f, 1.0f }, glm::vec2{ 0.0f, 1.0f } });
+        payload.indices.insert(payload.indices.end(), { first, first + 1, first + 2, first + 2, first + 3, first });
+    };
+
+    glm::vec3 corner{ coord.x * cellSize, WORLD_FLOOR_HEIGHT, coord.z * cellSize };
+
+    addQuad(corner, corner + glm::vec3{ 0.0f, 0.0f, cellSize }, corner + glm::vec3{ cellSize, 0.0f, cellSize }, corner + glm::vec3{ cellSize, 0.0f, 0.0f });
+
+    bool nearCube = std::abs(coord.x) <= 1 && std::abs(coord.z) <= 1;
+    uint32_t boxCount = nearCube ? 0 : static_cast<uint32_t>(unit(random) * 4.0f);
+
+    for (uint32_t i = 0; i < boxCount; i++) {
+        glm::vec3 size{ 1.0f + unit(random) * 2.0f, 1.0f + unit(random) * 4.0f, 1.0f + unit(random) * 2.0f };
+        glm::vec3 min = corner + glm::vec3{ unit(random) * (cellSize - size.x), 0.0f, unit(random) * (cellSize - size.z) };
+        glm::vec3 max = min + size;
+
+        addQuad(glm::vec3{ min.x, min.y, max.z }, glm::vec3{ max.x, min.y, max.z }, glm::vec3{ max.x, max.y, max.z }, glm::vec3{ min.x, max.y, max.z });
+        addQuad(glm::vec3{ max.x, min.y, min.z }, glm::vec3{ min.x, min.y, min.z }, glm::vec3{ min.x, max.y, min.z }, glm::vec3{ max.x, max.y, min.z });
+        addQuad(glm::vec3{ min.x, min.y, min.z }, glm::vec3{ min.x, min.y, max.z }, glm::vec3{ min.x, max.y, max.z }, glm::vec3{ min.x, max.y, min.z });
+        addQuad(glm::vec3{ max.x, min.y, max.z }, glm::vec3{ max.x, min.y, min.z }, glm::vec3{ max.x, max.y, min.z }, glm::vec3{ max.x, max.y, max.z });
+        addQuad(glm::vec3{ min.x, max.y, max.z }, glm::vec3{ max.x, max.y, max.z }, glm::vec3{ max.x, max.y, min.z }, glm::vec3{ min.x, max.y, min.z });
+    }
+
+    // Every other cell is left untextured and drawn in the flat color, the rest get a checker board
+    // tinted per cell, so the cell borders stay visible
+    if ((coord.x + coord.z) % 2 != 0) {
+        return;
+    }
+
+    glm::vec3 tint{ 0.5f + 0.5f * unit(random), 0.5f + 0.5f * unit(random), 0.5f + 0.5f * unit(random) };
+
+    payload.textureWidth = WORLD_TEXTURE_SIZE;
+    payload.textureHeight = WORLD_TEXTURE_SIZE;
+    payload.texturePixels.resize(WORLD_TEXTURE_SIZE * WORLD_TEXTURE_SIZE * 4);
+
+    for (uint32_t y = 0; y < WORLD_TEXTURE_SIZE; y++) {
+        for (uint32_t x = 0; x < WORLD_TEXTURE_SIZE; x++) {
+            float shade = ((x / 8 + y / 8) % 2 == 0) ? 1.0f : 0.6f;
+            uint8_t *pixel = &payload.texturePixels[(y * WORLD_TEXTURE_SIZE + x) * 4];
+
+            pixel[0] = static_cast<uint8_t>(255.0f * shade * tint.r);
+            pixel[1] = static_cast<uint8_t>(255.0f * shade * tint.g);
+            pixel[2] = static_cast<uint8_t>(255.0f * shade * tint.b);
+            pixel[3] = 255;
+        }
+    }
+}
+
+// The light of the old single-light setup, plus random point and spot lights around the scene
+// ------------------------------------------------------------------------------------------
+void createLights(uint32_t count)
+{
+    std::mt19937 random{ 1 };
+    std::uniform_real_distribution<float> unit{ 0.0f, 1.0f };
+
+    baseLights.clear();
+    lightOrbitSpeeds.clear();
+
+    for (uint32_t i = 0; i < count; i++) {
+        nugie::Light light{};
+
+        if (i == 0) {
+            light.positionRange = glm::vec4{ 1.2f, 1.0f, 2.0f, 10.0f };
+            light.colorIntensity = glm::vec4{ 1.0f, 1.0f, 1.0f, 4.0f };
+            light.directionType = glm::vec4{ 0.0f, -1.0f, 0.0f, static_cast<float>(nugie::LightType::Point) };
+        } else {
+            glm::vec3 position{ unit(random) * 16.0f - 8.0f, unit(random) * 5.0f - 1.0f, unit(random) * 16.0f - 8.0f };
+            bool spot = i % 4 == 0;
+
+            light.positionRange = glm::vec4{ position, 1.0f + unit(random) * 2.0f };
+            light.colorIntensity = glm::vec4{ unit(random), unit(random), unit(random), 1.0f + unit(random) * 2.0f };
+            light.directionType = glm::vec4{ 0.0f, -1.0f, 0.0f, static_cast<float>(spot ? nugie::LightType::Spot : nugie::LightType::Point) };
+            light.spotAngles = glm::vec4{ std::cos(glm::radians(20.0f)), std::cos(glm::radians(30.0f)), 0.0f, 0.0f };
+        }
+
+        baseLights.push_back(light);
+        lightOrbitSpeeds.push_back(i == 0 ? 0.0f : unit(random) - 0.5f);
+    }
+
+    lights = baseLights;
+}
+
+// Lights orbit around the vertical axis, each at its own speed
+// ------------------------------------------------------------
+void animateLights(float time)
+{
+    for (size_t i = 0; i < lights.size(); i++) {
+        float angle = time * lightOrbitSpeeds[i];
+        glm::vec4 base = baseLights[i].positionRange;
+
+        lights[i].positionRange.x = base.x * std::cos(angle) - base.z * std::sin(angle);
+        lights[i].positionRange.z = base.x * std::sin(angle) + base.z * std::cos(angle);
+    }
+}
+
+// The cube is skinned to two joints, the bottom face follows the root and the top face its child.
+// One clip twists the top around the vertical axis, the other sways the whole cube sideways.
+// ------------------------------------------------------------------------------------------
+std::vector<nugie::SkinVertex> createCubeAnimation(const std::vector<glm::vec3> &vertices)
+{
+    nugie::JointTransform root{};
+    root.translation = glm::vec3{ 0.0f, -0.5f, 0.0f };
+
+    nugie::JointTransform top{};
+    top.translation = glm::vec3{ 0.0f, 1.0f, 0.0f };
+
+    uint32_t rootJoint = cubeSkeleton.addJoint(nugie::Skeleton::NO_PARENT, root);
+    uint32_t topJoint = cubeSkeleton.addJoint(static_cast<int32_t>(rootJoint), top);
+
+    twistClip = new nugie::AnimationClip(cubeSkeleton.getJointCount(), 4.0f);
+    swayClip = new nugie::AnimationClip(cubeSkeleton.getJointCount(), 3.0f);
+
+    const float twistAngles[] = { 0.0f, 0.6f, 0.0f, -0.6f, 0.0f };
+    const float swayAngles[] = { 0.0f, 0.3f, 0.0f, -0.3f, 0.0f };
+
+    for (uint32_t i = 0; i < 5; i++) {
+        nugie::JointTransform twist = top;
+        twist.rotation = glm::angleAxis(twistAngles[i], glm::vec3{ 0.0f, 1.0f, 0.0f });
+        twistClip->addKeyframe(topJoint, twistClip->getDuration() * i / 4.0f, twist);
+
+        nugie::JointTransform sway = root;
+        sway.rotation = glm::angleAxis(swayAngles[i], glm::vec3{ 0.0f, 0.0f, 1.0f });
+        swayClip->addKeyframe(rootJoint, swayClip->getDuration() * i / 4.0f, sway);
+    }
+
+    std::vector<nugie::SkinVertex> skinVertices;
+    for (auto &&vertex : vertices) {
+        uint32_t joint = vertex.y > 0.0f ? topJoint : rootJoint;
+        skinVertices.push_back(nugie::SkinVertex{ glm::vec4{ vertex, 1.0f }, glm::vec4{ 1.0f, 0.0f, 0.0f, 0.0f }, glm::uvec4{ joint, 0, 0, 0 } });
+    }
+
+    return skinVertices;
+}
+
+// Copies a delivered readback and compresses it into a PNG on a worker thread
+// ---------------------------------------------------------------------------
+struct PngWrite {
+    std::string path;
+    std::vector<uint8_t> pixels;
+    uint32_t width;
+    uint32_t height;
+    bool bgra;
+};
+
+void queuePngWrite(const nugie::ReadbackResult &result, const std::string &path)
+{
+    wgpu::TextureFormat format = device->getSurfaceFormat();
+
+    // Too large to be captured by a job, so the job owns it through a pointer
+    PngWrite *write = new PngWrite{ 
+        path, 
+        std::vector<uint8_t>(result.data, result.data + result.size), 
+        result.width, 
+        result.height, 
+        format == wgpu::TextureFormat::BGRA8Unorm || format == wgpu::TextureFormat::BGRA8UnormSrgb 
+    };
+
+    jobSystem->run(pngWriteCounter, [write] {
+        for (size_t i = 0; i < write->pixels.size(); i += 4) {
+            if (write->bgra) {
+                std::swap(write->pixels[i], write->pixels[i + 2]);
+            }
+
+            write->pixels[i + 3] = 255;
+        }
+
+        if (!stbi_write_png(write->path.c_str(), static_cast<int>(write->width), static_cast<int>(write->height), 4, write->pixels.data(), static_cast<int>(write->width * 4))) {
+            std::cerr << "Failed to write " << write->path << std::endl;
+        }
+
+        delete write;
+    });
+}
+
+// Reads the rendered part of the scene color back and writes it as a PNG a few frames later
+// -------------------------------------------------------------------------------------------
+void requestScreenshot(wgpu::CommandEncoder commandEncoder)
+{
+    std::string path = "screenshot_" + std::to_string(frameSync->getFrameIndex()) + ".png";
+
+    bool queued = readbackRing->readTexture(commandEncoder, renderGraph->getTexture(sceneColorResource), 0, 0, 0, renderWidth, renderHeight, 4, 
+        [path](const nugie::ReadbackResult &result) {
+            queuePngWrite(result, path);
+            screenshotsInFlight--;
+            std::cout << "Saved " << path << " after " << result.latencyFrames << " frames" << std::endl;
+        });
+
+    if (queued) {
+        screenshotsInFlight++;
+    } else {
+        std::cerr << "Every readback buffer is in use, screenshot skipped" << std::endl;
+    }
+}
+
+// The offscreen target batch frames are presented to, in the headless device's format
+// -----------------------------------------------------------------------------------
+void createBatchTarget(nugie::Device* device)
+{
+    wgpu::TextureDescriptor textureDesc{};
+    textureDesc.nextInChain = nullptr;
+    textureDesc.label = "Batch Target";
+    textureDesc.dimension = wgpu::TextureDimension::_2D;
+    textureDesc.size = { device->getWidth(), device->getHeight(), 1 };
+    textureDesc.mipLevelCount = 1;
+    textureDesc.sampleCount = 1;
+    textureDesc.format = device->getSurfaceFormat();
+    textureDesc.usage = wgpu::TextureUsage::RenderAttachment | wgpu::TextureUsage::CopySrc;
+
+    batchTarget = device->createTexture(textureDesc);
+
+    wgpu::TextureViewDescriptor textureViewDesc{};
+    textureViewDesc.nextInChain = nullptr;
+    textureViewDesc.aspect = wgpu::TextureAspect::All;
+    textureViewDesc.dimension = wgpu::TextureViewDimension::_2D;
+    textureViewDesc.arrayLayerCount = 1;
+    textureViewDesc.baseArrayLayer = 0;
+    textureViewDesc.mipLevelCount = 1;
+    textureViewDesc.baseMipLevel = 0;
+    textureViewDesc.format = textureDesc.format;
+
+    batchTargetView = batchTarget.createView(textureViewDesc);
+}
+
+// Records the readback of a finished batch image, the PNG is written once it arrives
+// ----------------------------------------------------------------------------------
+void requestBatchImage(wgpu::CommandEncoder commandEncoder, const nugie::BatchJob *job)
+{
+    std::string path = job->outputPath;
+
+    bool queued = readbackRing->readTexture(commandEncoder, batchTarget, 0, 0, 0, batchTarget.getWidth(), batchTarget.getHeight(), 4, 
+        [path](const nugie::ReadbackResult &result) {
+            queuePngWrite(result, path);
+        });
+
+    if (!queued) {
+        std::cerr << "Every readback buffer is in use, " << path << " skipped" << std::endl;
+    }
+}
+
+const char* getPresentModeName(wgpu::PresentMode mode)
+{
+    if (mode == wgpu::PresentMode::Mailbox)
+        return "Mailbox";
+    if (mode == wgpu::PresentMode::Immediate)
+        return "Immediate";
+
+    return "Fifo";
+}
+
+int main (int argc, char** argv) {
+    parseArguments(argc, argv);
+
     std::vector<glm::vec3> vertices {
         glm::vec3{ -0.5f, -0.5f, -0.5f },  
         glm::vec3{ -0.5f, -0.5f, -0.5f },
@@ -551,151 +1408,687 @@ int main (int, char**) {
     };
 
     camera = new nugie::Camera(glm::vec3(0.0f, 0.0f,  3.0f));
-    device = new nugie::Device("Nugie Renderer", 800, 600);
+
+    if (!playCameraPath.empty()) {
+        nugie::CameraPath cameraPath;
+        cameraPath.load(playCameraPath);
+
+        cameraPlayer = new nugie::CameraPlayer(cameraPath, cameraTimestep);
+    } else if (!recordCameraPath.empty()) {
+        cameraRecorder = new nugie::CameraRecorder();
+    }
+
+    bool batchMode = !batchJobPath.empty();
+    if (batchMode) {
+        batchJobs.load(batchJobPath);
+    }
+
+    // Batch jobs and camera playback change the picture every frame by design
+    if (renderOnDemand && (batchMode || cameraPlayer != nullptr)) {
+        std::cerr << "On-demand rendering does not apply to batch jobs or camera playback, rendering continuously" << std::endl;
+        renderOnDemand = false;
+    }
+
+    animationPaused = renderOnDemand;
+
+    device = new nugie::Device("Nugie Renderer", 800, 600, presentMode, batchMode);
+    frameSync = new nugie::FrameSync(device, framesInFlight);
+    deletionQueue = new nugie::DeletionQueue(device, frameSync);
+    // Room for the stats of every frame in flight and the one being delivered, next to the images
+    readbackRing = new nugie::ReadbackRing(device, frameSync, MAX_READBACKS_IN_FLIGHT + STATS_READBACKS_PER_FRAME * (framesInFlight + 1));
+
+    // Once a change is drawn, every frame slot and the readbacks that trail it by a frame get one more
+    redrawTracker = new nugie::RedrawTracker(framesInFlight + 1);
+
+    device->getMemoryTracker()->setBudget(gpuMemoryBudgetMb * 1024 * 1024, [](uint64_t liveBytes, uint64_t budgetBytes) {
+        std::cerr << "GPU memory budget exceeded: " << liveBytes / (1024 * 1024) << " MB of " << budgetBytes / (1024 * 1024) << " MB" << std::endl;
+
+        // Streamed cells are what can go without breaking the frame
+        if (worldStreamer != nullptr) {
+            worldStreamer->onMemoryPressure();
+            redrawTracker->markDirty(nugie::RedrawReason::Resources);
+        }
+    });
+
+    frameArena = new nugie::FrameArena(framesInFlight, FRAME_ARENA_SIZE);
+    shaderLibrary = new nugie::ShaderLibrary(device, "../asset/shaders/");
 
     createVertexBuffer(device, vertices.size());
     createIndexBuffer(device, indices.size());
-    createUniformBuffer(device, 512);
+    reflectShaders();
+
+    // Each uniform takes only its own size, at the finest offset alignment the device allows
+    uint64_t uniformAlignment = device->getMinUniformBufferOffsetAlignment();
+    auto alignUniform = [uniformAlignment](uint64_t size) {
+        return (size + uniformAlignment - 1) / uniformAlignment * uniformAlignment;
+    };
+
+    createUniformBuffer(device, (alignUniform(sizeof(SceneUniform)) + alignUniform(sizeof(ObjectUniform)) + alignUniform(sizeof(UpscaleUniform))) * framesInFlight);
 
-    nugie::ChildBuffer positionBuffer = vertexBuffer->createChildBuffer(vertices.size() * sizeof(glm::vec4));
     nugie::ChildBuffer textCoordBuffer = vertexBuffer->createChildBuffer(textCoords.size() * sizeof(glm::vec2));
 
-    nugie::ChildBuffer cameraTransformBuffer = uniformBuffer->createChildBuffer(256);
-    nugie::ChildBuffer modelTransformBuffer = uniformBuffer->createChildBuffer(256);
+    for (uint32_t i = 0; i < framesInFlight; i++) {
+        frameResources.push_back(FrameResources{ 
+            nugie::ShadowBuffer{ uniformBuffer->createChildBuffer(sizeof(SceneUniform), uniformAlignment) }, 
+            nugie::ShadowBuffer{ uniformBuffer->createChildBuffer(sizeof(ObjectUniform), uniformAlignment) },
+            nugie::ShadowBuffer{ uniformBuffer->createChildBuffer(sizeof(UpscaleUniform), uniformAlignment) },
+            nullptr,
+            nullptr,
+            nullptr,
+            nullptr,
+            {},
+            {},
+            {},
+            {},
+            nugie::DrawQueue{ frameArena->getArena(i) },
+            nugie::DrawQueue{ frameArena->getArena(i) },
+            nugie::DrawQueue{ frameArena->getArena(i) }
+        });
+    }
 
     createAndLoadSimpleTexture(device);
     createSampler(device);
 
-    createDepthTexture(device);
+    overdrawMeter = new nugie::OverdrawMeter(device, readbackRing, framesInFlight);
+
+    nugie::DepthPrepassSettings prepassSettings{};
+    prepassSettings.mode = depthPrepassMode;
+    depthPrepassPolicy = new nugie::DepthPrepassPolicy(prepassSettings);
+
+    clusteredLighting = new nugie::ClusteredLighting(device, shaderLibrary, lightCount);
+    createLights(lightCount);
+
+    skinningSystem = new nugie::SkinningSystem(device, shaderLibrary, MAX_SKINNED_VERTICES, MAX_SKINNED_JOINTS, MAX_SKINNED_INSTANCES);
+
+    uint32_t cubeSkinMesh = skinningSystem->addMesh(createCubeAnimation(vertices));
+    cubeSkinInstance = skinningSystem->addInstance(cubeSkinMesh, &cubeSkeleton);
+    skinningSystem->setAnimation(cubeSkinInstance, twistClip, swayClip, 0.0f);
+
+    particleSystem = new nugie::ParticleSystem(device, shaderLibrary, particleCount, device->getSurfaceFormat(), wgpu::TextureFormat::Depth16Unorm);
+
+    nugie::ParticleEmitter fountain{};
+    fountain.position = glm::vec3{ 0.0f, 1.0f, 0.0f };
+    fountain.velocity = glm::vec3{ 0.0f, 3.0f, 0.0f };
+    fountain.velocityJitter = 1.0f;
+    fountain.lifetimeMin = 1.0f;
+    fountain.lifetimeMax = 2.0f;
+    fountain.rate = static_cast<float>(particleCount) / 1.5f;
+    particleSystem->setEmitter(fountain);
+
+    occlusionCuller = new nugie::OcclusionCuller(device, shaderLibrary, readbackRing, framesInFlight, device->getMaxWidth(), device->getMaxHeight(), MAX_CULL_OBJECTS);
+
+    createRenderGraph(device);
 
     createSceneBindGroupLayout(device);
     createObjectBindGroupLayout(device);
 
     createRenderPipelineLayout(device);
     createPipeline(device);
-
-    createSceneBindGroup(device, cameraTransformBuffer.getInfo());
-    createObjectBindGroup(device, modelTransformBuffer.getInfo());
+    createDepthPrepassPipeline(device);
+    createUpscalePipeline(device);
+
+    for (auto &&frame : frameResources) {
+        frame.sceneBindGroup = createSceneBindGroup(device, frame.sceneUniformBuffer.getInfo());
+        frame.lightCullBindGroup = clusteredLighting->createCullBindGroup(frame.sceneUniformBuffer.getInfo());
+        frame.objectBindGroup = createObjectBindGroup(device, frame.modelTransformBuffer.getInfo(), objectTextureView);
+        frame.upscaleBindGroup = createUpscaleBindGroup(device, frame.upscaleUniformBuffer.getInfo());
+    }
     
-    positionBuffer.write(vertices.data());
     textCoordBuffer.write(textCoords.data());
 
-    device->getQueue().writeBuffer(indexBuffer, 0, indices.data(), indexBuffer.getSize());
+    device->writeBuffer(indexBuffer.get(), 0, indices.data(), indexBuffer->getSize());
 
-    nugie::BufferInfo positionBufferInfo = positionBuffer.getInfo();
-    nugie::BufferInfo textCoordBufferInfo = textCoordBuffer.getInfo();
+    // Large enough for every pose the cube's clips reach
+    uint32_t cubeObject = occlusionCuller->addObject(glm::vec3{ -1.0f }, glm::vec3{ 1.0f }, static_cast<uint32_t>(indices.size()));
+    occlusionCuller->uploadObjects();
 
-    // ================================================================
+    for (auto &&frame : frameResources) {
+        nugie::DrawCommand cubeDraw{};
+        cubeDraw.pipeline = renderPipeline;
+        cubeDraw.sceneBindGroup = frame.sceneBindGroup;
+        cubeDraw.objectBindGroup = frame.objectBindGroup;
+        cubeDraw.positionBuffer = skinningSystem->getOutputInfo(cubeSkinInstance);
+        cubeDraw.textCoordBuffer = textCoordBuffer.getInfo();
+        cubeDraw.indexBuffer = nugie::BufferInfo{ indexBuffer.get(), indexBuffer->getSize(), 0 };
+        cubeDraw.indexCount = static_cast<uint32_t>(indices.size());
+        cubeDraw.indirectBuffer = occlusionCuller->getEarlyArgs(cubeObject);
 
-    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 100.0f);
-    float lastFrame = 0.0f; // Time of last frame
+        frame.drawCommands.push_back(cubeDraw);
 
-    glfwSetCursorPosCallback(device->getWindow(), mouseCallback);
-    glfwSetScrollCallback(device->getWindow(), scrollCallback);
+        nugie::DrawCommand cubeLateDraw = cubeDraw;
+        cubeLateDraw.indirectBuffer = occlusionCuller->getLateArgs(cubeObject);
 
-    // glm::vec3 lightPos{1.2f, 1.0f, 2.0f};
+        frame.lateDrawCommands.push_back(cubeLateDraw);
 
-    while(device->isRunning()) {
-        device->poolEvents();
+        nugie::DrawCommand cubeDepthDraw{};
+        cubeDepthDraw.pipeline = depthPrepassPipeline;
+        cubeDepthDraw.sceneBindGroup = frame.sceneBindGroup;
+        cubeDepthDraw.objectBindGroup = frame.objectBindGroup;
+        cubeDepthDraw.positionBuffer = skinningSystem->getOutputInfo(cubeSkinInstance);
+        cubeDepthDraw.indexBuffer = nugie::BufferInfo{ indexBuffer.get(), indexBuffer->getSize(), 0 };
+        cubeDepthDraw.indexCount = static_cast<uint32_t>(indices.size());
+        cubeDepthDraw.indirectBuffer = occlusionCuller->getEarlyArgs(cubeObject);
 
-        float currentFrame = static_cast<float>(glfwGetTime());
-        deltaTime = currentFrame - lastFrame;
-        lastFrame = currentFrame;
+        frame.depthDrawCommands.push_back(cubeDepthDraw);
 
-        processInput(device->getWindow());
+        frame.drawCenters.push_back(glm::vec3{ 0.0f });
+    }
 
-        glm::mat4 view = camera->getViewMatrix();
-        glm::mat4 cameraTrans = projection * view;
+    jobSystem = new nugie::JobSystem(std::thread::hardware_concurrency());
+
+    // Drained with the frame's uniforms, for writes made off the main thread. Nothing in the app enqueues yet:
+    // streamed cells create their buffers once loaded and write them from update() on this thread.
+    uploadQueue = new nugie::UploadQueue(device);
+    parallelEncoder = new nugie::ParallelEncoder(device, jobSystem, device->getSurfaceFormat(), wgpu::TextureFormat::Depth16Unorm);
+    depthPrepassEncoder = new nugie::ParallelEncoder(device, jobSystem, wgpu::TextureFormat::Undefined, wgpu::TextureFormat::Depth16Unorm);
+    lateEncoder = new nugie::ParallelEncoder(device, jobSystem, device->getSurfaceFormat(), wgpu::TextureFormat::Depth16Unorm);
+
+    if (worldStreamingEnabled) {
+        nugie::StreamingSettings streamingSettings{};
+        float cellSize = streamingSettings.cellSize;
+
+        worldStreamer = new nugie::WorldStreamer(device, jobSystem, deletionQueue, streamingSettings, [cellSize](nugie::CellCoord coord, nugie::CellPayload &payload) {
+            loadWorldCell(coord, payload, cellSize);
+        });
+
+        // Cells are drawn with the identity model transform of each frame and their own texture, cells
+        // without one fall back to the object's
+        worldStreamer->setResidencyCallbacks([](nugie::CellCoord /* coord */, nugie::CellResources &resources) {
+            wgpu::TextureView textureView = resources.textureView ? resources.textureView.get() : objectTextureView;
+
+            for (auto &&frame : frameResources) {
+                resources.bindGroups.push_back(nugie::BindGroupHandle{
+                    createObjectBindGroup(device, frame.modelTransformBuffer.getInfo(), textureView), deletionQueue
+                });
+            }
+        }, nullptr);
+    }
+
+    gpuTimer = new nugie::GpuTimer(device, readbackRing, framesInFlight);
 
-        cameraTransformBuffer.write(&cameraTrans);
+    nugie::DynamicResolutionSettings resolutionSettings{};
+    resolutionSettings.targetFrameMs = targetFrameMs;
+    dynamicResolution = new nugie::DynamicResolution(resolutionSettings);
 
-        glm::mat4 modelTrans = glm::mat4{1.0f};
-        modelTransformBuffer.write(&modelTrans);
+    if (!gpuTimer->isSupported()) {
+        std::cerr << "Timestamp queries are not supported, rendering at full resolution" << std::endl;
+    }
+
+    for (auto &&occupancy : device->getMemoryTracker()->getMasterBufferOccupancy()) {
+        std::cout << occupancy.label << ": " << occupancy.usedBytes << " of " << occupancy.capacityBytes << " bytes suballocated" << std::endl;
+    }
 
+    // ================================================================
+
+    float lastFrame = 0.0f; // Time of last frame
+
+    // Batch jobs run on a headless device, which has no window and never initializes GLFW
+    if (!batchMode) {
+        glfwSetCursorPosCallback(device->getWindow(), mouseCallback);
+        glfwSetScrollCallback(device->getWindow(), scrollCallback);
+        glfwSetWindowRefreshCallback(device->getWindow(), refreshCallback);
+    }
+
+    SceneUniform sceneUniform;
+    UpscaleUniform upscaleUniform;
+    wgpu::TextureView surfaceTextureView;
+    FrameResources* frame = nullptr;
+    uint32_t frameSlot = 0;
+    uint64_t lastGpuSample = 0;
+    uint64_t lastOverdrawSample = 0;
+
+    // Input and presentation stay on the main thread, everything in between runs as a task graph
+    nugie::TaskGraph frameGraph;
+
+    nugie::TaskId updateUniformsTask = frameGraph.addTask("Update Uniforms", [&] {
+        animateLights(sceneTime);
+        clusteredLighting->setLights(lights);
+        clusteredLighting->beginFrame();
+
+        uploadQueue->drain();
+
+        frame->sceneUniformBuffer.write(&sceneUniform);
+
+        ObjectUniform objectUniform{ glm::mat4{1.0f} };
+        frame->modelTransformBuffer.write(&objectUniform);
+
+        frame->upscaleUniformBuffer.write(&upscaleUniform);
+
+        frame->sceneUniformBuffer.flush();
+        frame->modelTransformBuffer.flush();
+        frame->upscaleUniformBuffer.flush();
+    });
+
+    // Palettes are built across the workers, the skinning pass then writes the positions every pass draws
+    nugie::TaskId updateSkinningTask = frameGraph.addTask("Update Skinning", [&] {
+        skinningSystem->setBlendWeight(cubeSkinInstance, 0.5f + 0.5f * std::sin(sceneTime * 0.5f));
+        skinningSystem->update(jobSystem, sceneTime);
+    });
+
+    // Opaque draws go front to back along the view direction, grouped by state first
+    nugie::TaskId buildDrawQueuesTask = frameGraph.addTask("Build Draw Queues", [&] {
+        size_t cellCount = worldStreamer != nullptr ? worldStreamer->getStats().residentCells : 0;
+
+        frame->drawQueue.clear(frame->drawCommands.size() + cellCount);
+        frame->depthDrawQueue.clear(depthPrepassEnabled ? frame->depthDrawCommands.size() + cellCount : 0);
+        frame->lateDrawQueue.clear(frame->lateDrawCommands.size());
+
+        for (size_t i = 0; i < frame->drawCommands.size(); i++) {
+            nugie::DrawSortInfo sortInfo{};
+            sortInfo.depth = (glm::dot(frame->drawCenters[i] - camera->position, camera->front) - NEAR_PLANE) / (FAR_PLANE - NEAR_PLANE);
+
+            frame->drawQueue.push(frame->drawCommands[i], sortInfo);
+
+            frame->lateDrawQueue.push(frame->lateDrawCommands[i], sortInfo);
+
+            if (depthPrepassEnabled) {
+                frame->depthDrawQueue.push(frame->depthDrawCommands[i], sortInfo);
+            }
+        }
+
+        // Streamed cells are drawn directly, they are not part of the occlusion culled objects
+        if (worldStreamer != nullptr) {
+            worldStreamer->forEachResident([&](nugie::CellCoord /* coord */, nugie::CellResources &resources) {
+                nugie::DrawCommand cellDraw{};
+                if (resources.texture) {
+                    cellDraw.pipeline = depthPrepassEnabled ? equalDepthPipeline : renderPipeline;
+                } else {
+                    cellDraw.pipeline = depthPrepassEnabled ? untexturedEqualDepthPipeline : untexturedPipeline;
+                }
+
+                cellDraw.sceneBindGroup = frame->sceneBindGroup;
+                cellDraw.objectBindGroup = resources.bindGroups[frameSlot].get();
+                cellDraw.positionBuffer = nugie::BufferInfo{ resources.positionBuffer.get(), resources.positionBuffer->getSize(), 0 };
+                cellDraw.textCoordBuffer = nugie::BufferInfo{ resources.textCoordBuffer.get(), resources.textCoordBuffer->getSize(), 0 };
+                cellDraw.indexBuffer = nugie::BufferInfo{ resources.indexBuffer.get(), resources.indexBuffer->getSize(), 0 };
+                cellDraw.indexCount = resources.indexCount;
+
+                nugie::DrawSortInfo sortInfo{};
+                sortInfo.depth = (glm::dot(resources.center - camera->position, camera->front) - NEAR_PLANE) / (FAR_PLANE - NEAR_PLANE);
+
+                frame->drawQueue.push(cellDraw, sortInfo);
+
+                if (depthPrepassEnabled) {
+                    nugie::DrawCommand cellDepthDraw = cellDraw;
+                    cellDepthDraw.pipeline = depthPrepassPipeline;
+                    cellDepthDraw.textCoordBuffer = nugie::BufferInfo{};
+
+                    frame->depthDrawQueue.push(cellDepthDraw, sortInfo);
+                }
+            });
+        }
+
+        frame->drawQueue.sort();
+        frame->depthDrawQueue.sort();
+        frame->lateDrawQueue.sort();
+    });
+
+    nugie::TaskId encodeBundlesTask = frameGraph.addTask("Encode Bundles", [&] {
+        parallelEncoder->encode(frame->drawQueue.getSortedCommands());
+    }, { buildDrawQueuesTask });
+
+    nugie::TaskId encodeDepthBundlesTask = frameGraph.addTask("Encode Depth Bundles", [&] {
+        if (depthPrepassEnabled) {
+            depthPrepassEncoder->encode(frame->depthDrawQueue.getSortedCommands());
+        }
+    }, { buildDrawQueuesTask });
+
+    nugie::TaskId encodeLateBundlesTask = frameGraph.addTask("Encode Late Bundles", [&] {
+        lateEncoder->encode(frame->lateDrawQueue.getSortedCommands());
+    }, { buildDrawQueuesTask });
+
+    frameGraph.addTask("Record And Submit", [&] {
         wgpu::CommandEncoderDescriptor commandDesc{};
         commandDesc.label = "Command Encoder";
         commandDesc.nextInChain = nullptr;
 
         wgpu::CommandEncoder commandEncoder = device->createCommandEncoder(commandDesc);
-        wgpu::TextureView surfaceTextureView = device->getNextSurfaceTextureView();
-
-        wgpu::RenderPassColorAttachment colorAttach{};
-        colorAttach.nextInChain = nullptr;
-        colorAttach.view = surfaceTextureView;
-        colorAttach.loadOp = wgpu::LoadOp::Clear;
-        colorAttach.storeOp = wgpu::StoreOp::Store;
-        colorAttach.clearValue = wgpu::Color{ 0, 0, 0, 0 };
-        colorAttach.resolveTarget = nullptr;
-
-        wgpu::RenderPassDepthStencilAttachment depthAttach{};
-        depthAttach.view = depthTextureView;
-        depthAttach.depthLoadOp = wgpu::LoadOp::Clear;
-        depthAttach.depthStoreOp = wgpu::StoreOp::Discard;
-        depthAttach.depthClearValue = 1.0f;
-        depthAttach.depthReadOnly = false;
-
-        depthAttach.stencilLoadOp = wgpu::LoadOp::Undefined;
-        depthAttach.stencilStoreOp = wgpu::StoreOp::Undefined;
-        depthAttach.stencilClearValue = 0;
-        depthAttach.stencilReadOnly = true;
-
-        #ifndef WEBGPU_BACKEND_WGPU
-            colorAttach.depthSlice = WGPU_DEPTH_SLICE_UNDEFINED;
-        #endif // NOT WEBGPU_BACKEND_WGPU
-
-        wgpu::RenderPassDescriptor renderPassDesc{};
-        renderPassDesc.nextInChain = nullptr;
-        renderPassDesc.label = "Render Pass";
-        renderPassDesc.colorAttachmentCount = 1;
-        renderPassDesc.colorAttachments = &colorAttach;
-        renderPassDesc.depthStencilAttachment = &depthAttach;
-        renderPassDesc.timestampWrites = nullptr;
-        renderPassDesc.occlusionQuerySet = nullptr;
-
-        wgpu::RenderPassEncoder renderPassEncoder = commandEncoder.beginRenderPass(renderPassDesc);
-
-        renderPassEncoder.setPipeline(renderPipeline);
-        
-        renderPassEncoder.setVertexBuffer(0, positionBufferInfo.buffer, positionBufferInfo.offset, positionBufferInfo.size);
-        renderPassEncoder.setVertexBuffer(1, textCoordBufferInfo.buffer, textCoordBufferInfo.offset, textCoordBufferInfo.size);
-        
-        renderPassEncoder.setBindGroup(0, sceneBindGroup, 0, nullptr);
-        renderPassEncoder.setBindGroup(1, objectBindGroup, 0, nullptr);
-
-        renderPassEncoder.setIndexBuffer(indexBuffer, wgpu::IndexFormat::Uint32, 0, indexBuffer.getSize());
-        renderPassEncoder.drawIndexed(indices.size(), 1, 0, 0, 0);
-
-        renderPassEncoder.end();
-        renderPassEncoder.release();
+
+        renderGraph->execute(commandEncoder);
+
+        if (screenshotRequested) {
+            screenshotRequested = false;
+            requestScreenshot(commandEncoder);
+        }
+
+        if (batchJob != nullptr) {
+            requestBatchImage(commandEncoder, batchJob);
+        }
+
+        gpuTimer->resolve(commandEncoder, frameSlot);
+        overdrawMeter->resolve(commandEncoder, frameSlot, depthPrepassEnabled, uint64_t(renderWidth) * renderHeight);
+        occlusionCuller->resolveStats(commandEncoder);
 
         wgpu::CommandBuffer commandBuffer = commandEncoder.finish();
         commandEncoder.release();
 
-        device->getQueue().submit(1, &commandBuffer);
+        device->submit(1, &commandBuffer);
+        readbackRing->mapPending();
+    }, { updateUniformsTask, updateSkinningTask, encodeBundlesTask, encodeDepthBundlesTask, encodeLateBundlesTask });
+
+    nugie::FrameStats frameStats;
+    nugie::ReadbackStats readbackStats;
 
-        device->getSurface().present();
-        surfaceTextureView.release();
+    if (batchMode) {
+        createBatchTarget(device);
     }
 
-    sceneBindGroup.release();
-    objectBindGroup.release();
+    size_t batchIndex = 0;
+    auto batchStart = std::chrono::steady_clock::now();
+
+    nugie::RedrawStats redrawStats;
+
+    // The last frame that allocated for a reason of its own, see STEADY_STATE_FRAME
+    uint64_t lastAllocatingFrame = STEADY_STATE_FRAME;
+    bool allocationCheckFailed = false;
+
+    // Samples input and time and marks whatever changed since the last frame, returns whether this one is drawn
+    auto sampleFrame = [&]() {
+        if (device->updateSurfaceSize()) {
+            redrawTracker->markDirty(nugie::RedrawReason::Window);
+        }
+
+        float currentFrame = batchMode ? 0.0f : static_cast<float>(glfwGetTime());
+        deltaTime = std::min(currentFrame - lastFrame, MAX_FRAME_DELTA_SECONDS);
+        lastFrame = currentFrame;
+
+        if (batchMode) {
+            // Batch images are stills, the animation stays at its start
+            batchJob = &batchJobs.getJob(batchIndex++);
+            camera->setPose(batchJob->position, batchJob->yaw, batchJob->pitch, batchJob->zoom);
+
+            sceneTime = 0.0f;
+            sceneDeltaTime = BATCH_PARTICLE_STEP;
+            particleSystem->reset();
+        } else if (cameraPlayer != nullptr) {
+            // Every frame advances the path by the same step, however long it really took
+            deltaTime = cameraPlayer->getTimestep();
+
+            if (!cameraPlayer->step(camera)) {
+                glfwSetWindowShouldClose(device->getWindow(), true);
+            }
+
+            sceneTime = cameraPlayer->getTime();
+            sceneDeltaTime = deltaTime;
+        } else {
+            processInput(device->getWindow());
+
+            sceneDeltaTime = animationPaused ? 0.0f : deltaTime;
+            sceneTime += sceneDeltaTime;
+
+            if (cameraRecorder != nullptr) {
+                cameraRecorder->record(camera, currentFrame);
+            }
+        }
+
+        redrawTracker->trackCamera(camera);
+
+        // Lights, skinning and particles all follow the scene time
+        if (sceneDeltaTime > 0.0f) {
+            redrawTracker->markDirty(nugie::RedrawReason::Scene);
+        }
+
+        // Streamed cells that are still loading or went up last frame, uploads from other threads, and
+        // screenshots that only come back while frames are submitted. Every frame reads its stats back too,
+        // those must not keep the loop drawing.
+        bool streaming = false;
+        if (worldStreamer != nullptr) {
+            nugie::StreamingStats streamingStats = worldStreamer->getStats();
+            streaming = streamingStats.loadingCells > 0 || streamingStats.uploadedBytes > 0 || streamingStats.evictedCells > 0;
+        }
+
+        if (streaming || uploadQueue->hasPending() || screenshotsInFlight > 0) {
+            redrawTracker->markDirty(nugie::RedrawReason::Resources);
+        }
+
+        if (screenshotRequested) {
+            redrawTracker->markDirty(nugie::RedrawReason::Window);
+        }
+
+        bool draw = redrawTracker->beginFrame(!renderOnDemand);
+
+        if (redrawTracker->collectStats(1.0, redrawStats)) {
+            std::cout << (renderOnDemand ? "On demand: " : "Continuous: ") << redrawStats.drawnFrames << " frames drawn, "
+                << redrawStats.unchangedFrames << " unchanged (";
+
+            for (uint32_t i = 0; i < static_cast<uint32_t>(nugie::RedrawReason::Count); i++) {
+                nugie::RedrawReason reason = static_cast<nugie::RedrawReason>(i);
+                std::cout << (i > 0 ? ", " : "") << nugie::RedrawTracker::getReasonName(reason) << " " << redrawStats.reasonFrames[i];
+            }
+
+            std::cout << "), cpu " << redrawStats.cpuUtilization * 100.0 << "% of a core, gpu " << redrawStats.gpuUtilization * 100.0 << "%" << std::endl;
+        }
+
+        return draw;
+    };
+
+    while(batchMode ? batchIndex < batchJobs.getCount() : device->isRunning()) {
+        // On demand, input is sampled before the GPU wait to know whether there is a frame to draw at all.
+        // Until something changes the loop sleeps in the event wait, rather than encoding and submitting the same picture.
+        if (renderOnDemand) {
+            device->poolEvents(redrawTracker->getWaitTimeout(ON_DEMAND_WAIT_SECONDS));
+
+            if (!sampleFrame()) {
+                continue;
+            }
+        }
+
+        nugie::AllocationScope frameAllocations{ true };
+
+        // Waits for the GPU to release this frame's slot before input is sampled, to keep latency low
+        frameSlot = frameSync->beginFrame();
+        frame = &frameResources[frameSlot];
+        frameArena->beginFrame(frameSlot);
+        deletionQueue->collect();
+        readbackRing->deliver();
+
+        if (!renderOnDemand) {
+            device->poolEvents();
+            sampleFrame();
+        }
+
+        // Batch images are always rendered at full resolution
+        if (!batchMode && gpuTimer->getSampleCount() != lastGpuSample) {
+            lastGpuSample = gpuTimer->getSampleCount();
+            dynamicResolution->update(gpuTimer->getLastTimeMs());
+            redrawTracker->addGpuTime(gpuTimer->getLastTimeMs());
+        }
+
+        if (overdrawMeter->getSampleCount() != lastOverdrawSample) {
+            lastOverdrawSample = overdrawMeter->getSampleCount();
+            depthPrepassPolicy->update(overdrawMeter->getDepthComplexity());
+        }
+
+        depthPrepassEnabled = depthPrepassPolicy->isEnabled();
+
+        for (auto &&draw : frame->drawCommands) {
+            draw.pipeline = depthPrepassEnabled ? equalDepthPipeline : renderPipeline;
+        }
+
+        renderWidth = dynamicResolution->getRenderWidth(device->getWidth());
+        renderHeight = dynamicResolution->getRenderHeight(device->getHeight());
+
+        upscaleUniform.uvScale = glm::vec2{
+            static_cast<float>(renderWidth) / static_cast<float>(device->getMaxWidth()), 
+            static_cast<float>(renderHeight) / static_cast<float>(device->getMaxHeight())
+        };
+
+        upscaleUniform.texelSize = glm::vec2{ 
+            1.0f / static_cast<float>(device->getMaxWidth()), 
+            1.0f / static_cast<float>(device->getMaxHeight())
+        };
+
+        // The graph's first and last passes bracket everything the frame does on the GPU
+        if (gpuTimer->isSupported()) {
+            renderGraph->setTimestampWrites(gpuTimer->getQuerySet(), gpuTimer->getBeginIndex(frameSlot), gpuTimer->getEndIndex(frameSlot));
+        }
+
+        float aspect = static_cast<float>(device->getWidth()) / static_cast<float>(std::max(device->getHeight(), 1u));
+        glm::mat4 projection = glm::perspective(glm::radians(camera->zoom), aspect, NEAR_PLANE, FAR_PLANE);
+
+        glm::mat4 view = camera->getViewMatrix();
+
+        sceneUniform.cameraTransform = projection * view;
+        sceneUniform.viewTransform = view;
+        sceneUniform.inverseProjection = glm::inverse(projection);
+        sceneUniform.cameraPosition = camera->position;
+        sceneUniform.lightCount = clusteredLighting->getLightCount();
+        sceneUniform.screenSize = glm::vec2{ static_cast<float>(renderWidth), static_cast<float>(renderHeight) };
+        sceneUniform.nearPlane = NEAR_PLANE;
+        sceneUniform.farPlane = FAR_PLANE;
+        sceneUniform.clusterCount = glm::uvec3{ 
+            nugie::ClusteredLighting::CLUSTER_COUNT_X, 
+            nugie::ClusteredLighting::CLUSTER_COUNT_Y, 
+            nugie::ClusteredLighting::CLUSTER_COUNT_Z 
+        };
+
+        occlusionCuller->beginFrame(frameSlot, sceneUniform.cameraTransform, renderWidth, renderHeight);
+        particleSystem->update(sceneDeltaTime, sceneUniform.cameraTransform, camera->right, camera->up);
+
+        if (worldStreamer != nullptr) {
+            worldStreamer->update(camera);
+
+            nugie::StreamingStats streamingStats = worldStreamer->getStats();
+            if (streamingStats.loadingCells > 0 || streamingStats.pendingUploads > 0 || streamingStats.uploadedBytes > 0 || streamingStats.evictedCells > 0) {
+                lastAllocatingFrame = std::max(lastAllocatingFrame, frameSync->getFrameIndex());
+            }
+        }
+
+        if (batchMode || cameraRecorder != nullptr || screenshotRequested || screenshotsInFlight > 0) {
+            lastAllocatingFrame = std::max(lastAllocatingFrame, frameSync->getFrameIndex());
+        }
+
+        // A batch frame needs free readback buffers for its image and its stats, the ones in use are delivered a few frames later
+        while (batchMode && readbackRing->getInFlightCount() + 1 + STATS_READBACKS_PER_FRAME > readbackRing->getMaxInFlight()) {
+            readbackRing->deliver();
+            std::this_thread::yield();
+        }
+
+        surfaceTextureView = batchMode ? batchTargetView : device->getNextSurfaceTextureView();
+        renderGraph->setImportedView(surfaceResource, surfaceTextureView);
+
+        frameGraph.execute(*jobSystem);
+        frameSync->endFrame();
+
+        if (!batchMode) {
+            device->getSurface().present();
+            surfaceTextureView.release();
+        }
+
+        // Every frame slot's draw queues learn the ids of new cells the next time the slot comes around
+        if (frameSync->getFrameIndex() > lastAllocatingFrame + framesInFlight && frameAllocations.getAllocationCount() > 0) {
+            std::cerr << "Steady-state frame " << frameSync->getFrameIndex() << " allocated " << frameAllocations.getAllocationCount() << " times on the heap" << std::endl;
+            allocationCheckFailed = true;
+        }
+
+        if (frameSync->collectStats(1.0, frameStats)) {
+            std::cout << getPresentModeName(device->getPresentMode()) << ", " << framesInFlight << " frames in flight: "
+                << frameStats.framesPerSecond << " fps, latency avg " << frameStats.averageLatencyMs 
+                << " ms, max " << frameStats.maxLatencyMs << " ms, render scale " << dynamicResolution->getScale()
+                << " (" << renderWidth << "x" << renderHeight << "), gpu " << gpuTimer->getLastTimeMs() << " ms, depth prepass " << (depthPrepassEnabled ? "on" : "off")
+                << ", depth complexity " << overdrawMeter->getDepthComplexity() << ", shaded " << overdrawMeter->getShadedOverdraw()
+                << ", " << clusteredLighting->getLightCount() << " lights, " << parallelEncoder->getStats().drawCount << " draws, " << parallelEncoder->getStats().getStateChanges() << " state changes, sort "
+                << frame->drawQueue.getStats().sortTimeMs << " ms, occlusion culled " << occlusionCuller->getStats().culled << "/" << occlusionCuller->getStats().objectCount
+                << " (late " << occlusionCuller->getStats().lateVisible << "), gpu memory " << device->getMemoryTracker()->getTotalStats().liveBytes / (1024 * 1024)
+                << " MB (peak " << device->getMemoryTracker()->getTotalStats().highWaterBytes / (1024 * 1024) << " MB)" << std::endl;
+
+            if (worldStreamer != nullptr) {
+                nugie::StreamingStats streamingStats = worldStreamer->getStats();
+
+                std::cout << "World streaming: " << streamingStats.residentCells << " cells resident (" << streamingStats.residentBytes / 1024 << " KB of "
+                    << worldStreamer->getMemoryBudget() / 1024 << " KB), " << streamingStats.loadingCells << " loading, " << streamingStats.pendingUploads 
+                    << " waiting for upload" << std::endl;
+            }
+        }
+
+        if (readbackRing->collectStats(1.0, readbackStats) && readbackStats.deliveredCount > 0) {
+            std::cout << readbackStats.deliveredCount << " readbacks, latency avg " << readbackStats.averageLatencyFrames << " frames, max "
+                << readbackStats.maxLatencyFrames << " frames, " << readbackStats.throughputMBps << " MB/s" << std::endl;
+        }
+    }
+
+    frameSync->waitIdle();
+
+    // Every batch image is already submitted, only the last mappings and PNG writes are left
+    while (batchMode && readbackRing->getInFlightCount() > 0) {
+        readbackRing->deliver();
+        std::this_thread::yield();
+    }
+
+    readbackRing->deliver();
+    jobSystem->wait(pngWriteCounter);
+
+    if (batchMode) {
+        double batchSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - batchStart).count();
+        std::cout << "Rendered " << batchJobs.getCount() << " images in " << batchSeconds << " s, " 
+            << batchJobs.getCount() / std::max(batchSeconds, 0.000001) << " images/s" << std::endl;
+
+        batchTargetView.release();
+        device->releaseTexture(batchTarget);
+    }
+
+    if (cameraRecorder != nullptr) {
+        cameraRecorder->getPath().save(recordCameraPath);
+        std::cout << "Recorded " << cameraRecorder->getPath().getKeyframeCount() << " camera keyframes to " << recordCameraPath << std::endl;
+    }
+
+    for (auto &&resources : frameResources) {
+        resources.sceneBindGroup.release();
+        resources.objectBindGroup.release();
+        resources.upscaleBindGroup.release();
+        resources.lightCullBindGroup.release();
+    }
+
+    upscaleSampler.release();
+    upscalePipeline.release();
+    upscalePipelineLayout.release();
+    upscaleBindGroupLayout.release();
 
     sceneBindGroupLayout.release();
     objectBindGroupLayout.release();
 
     objectSampler.release();
-    objectTexture.release();
+    objectTexture.reset();
     
     renderPipeline.release();
+    equalDepthPipeline.release();
+    untexturedPipeline.release();
+    untexturedEqualDepthPipeline.release();
+    depthPrepassPipeline.release();
     renderPipelineLayout.release();
 
-    indexBuffer.release();
-
+    indexBuffer.reset();
+
+    delete dynamicResolution;
+    delete gpuTimer;
+    delete depthPrepassPolicy;
+    delete overdrawMeter;
+    delete clusteredLighting;
+    delete skinningSystem;
+    delete particleSystem;
+    delete worldStreamer;
+    delete twistClip;
+    delete swayClip;
+    delete occlusionCuller;
+    delete readbackRing;
+    delete renderGraph;
+    delete parallelEncoder;
+    delete depthPrepassEncoder;
+    delete lateEncoder;
+    delete jobSystem;
+    delete uploadQueue;
+    delete shaderLibrary;
     delete uniformBuffer;
     delete vertexBuffer;
 
+    delete deletionQueue;
+    delete redrawTracker;
+    delete frameSync;
+    delete frameArena;
     delete device;
+    delete cameraRecorder;
+    delete cameraPlayer;
     delete camera;
 
-    return 0;
+    return allocationCheckFailed ? 1 : 0;
 }
@@ -0,0 +1,68 @@
+#include "animation_clip.hpp"
+
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+
+namespace nugie {
+    AnimationClip::AnimationClip(uint32_t jointCount, float duration) 
+    : duration{std::max(duration, 0.0001f)},
+      tracks(jointCount)
+    {
+
+    }
+
+    void AnimationClip::addKeyframe(uint32_t joint, float time, const JointTransform &transform) {
+        if (joint >= this->tracks.size()) {
+            throw std::runtime_error("keyframe joint is outside the clip");
+        }
+
+        std::vector<JointKeyframe> &track = this->tracks[joint];
+        if (!track.empty() && time <= track.back().time) {
+            throw std::runtime_error("keyframes must be added in increasing time");
+        }
+
+        track.push_back(JointKeyframe{ time, transform });
+    }
+
+    void AnimationClip::sample(const Skeleton &skeleton, float time, LocalPose &pose) const {
+        float localTime = std::fmod(time, this->duration);
+        if (localTime < 0.0f) {
+            localTime += this->duration;
+        }
+
+        uint32_t jointCount = std::min(skeleton.getJointCount(), this->getJointCount());
+        for (uint32_t joint = 0; joint < jointCount; joint++) {
+            const std::vector<JointKeyframe> &track = this->tracks[joint];
+            pose.set(joint, track.empty() ? skeleton.getBindPose(joint) : sampleTrack(track, localTime));
+        }
+
+        for (uint32_t joint = jointCount; joint < skeleton.getJointCount(); joint++) {
+            pose.set(joint, skeleton.getBindPose(joint));
+        }
+    }
+
+    JointTransform AnimationClip::sampleTrack(const std::vector<JointKeyframe> &track, float time) {
+        auto next = std::upper_bound(track.begin(), track.end(), time, [](float time, const JointKeyframe &keyframe) {
+            return time < keyframe.time;
+        });
+
+        if (next == track.begin()) {
+            return track.front().transform;
+        }
+
+        if (next == track.end()) {
+            return track.back().transform;
+        }
+
+        const JointKeyframe &previous = *(next - 1);
+        float t = (time - previous.time) / (next->time - previous.time);
+
+        JointTransform transform;
+        transform.translation = glm::mix(previous.transform.translation, next->transform.translation, t);
+        transform.rotation = glm::slerp(previous.transform.rotation, next->transform.rotation, t);
+        transform.scale = glm::mix(previous.transform.scale, next->transform.scale, t);
+
+        return transform;
+    }
+}
@@ -0,0 +1,38 @@
+#ifndef NUGIE_ANIMATION_CLIP_HPP
+#define NUGIE_ANIMATION_CLIP_HPP
+
+#include <vector>
+
+#include "../skeleton/skeleton.hpp"
+#include "../pose/local_pose.hpp"
+
+namespace nugie {
+    struct JointKeyframe {
+        float time;
+        JointTransform transform;
+    };
+
+    // Keyframed joint transforms over a looping time range. Joints without keyframes hold their bind pose.
+    class AnimationClip {
+    public:
+        AnimationClip(uint32_t jointCount, float duration);
+
+        // Keyframes of a joint must be added in increasing time
+        void addKeyframe(uint32_t joint, float time, const JointTransform &transform);
+
+        // Writes every joint at the time wrapped into the clip, the pose must be sized for the skeleton
+        void sample(const Skeleton &skeleton, float time, LocalPose &pose) const;
+
+        float getDuration() const { return this->duration; }
+
+        uint32_t getJointCount() const { return static_cast<uint32_t>(this->tracks.size()); }
+
+    private:
+        float duration;
+        std::vector<std::vector<JointKeyframe>> tracks;
+
+        static JointTransform sampleTrack(const std::vector<JointKeyframe> &track, float time);
+    };
+}
+
+#endif
@@ -0,0 +1,83 @@
+#include "local_pose.hpp"
+#include "../simd/float4.hpp"
+
+namespace nugie {
+    void LocalPose::resize(uint32_t jointCount) {
+        this->jointCount = jointCount;
+        uint32_t paddedCount = (jointCount + 3) & ~3u;
+
+        for (std::vector<float> *lane : { &this->translationX, &this->translationY, &this->translationZ,
+                                          &this->rotationX, &this->rotationY, &this->rotationZ }) {
+            lane->assign(paddedCount, 0.0f);
+        }
+
+        for (std::vector<float> *lane : { &this->rotationW, &this->scaleX, &this->scaleY, &this->scaleZ }) {
+            lane->assign(paddedCount, 1.0f);
+        }
+    }
+
+    void LocalPose::set(uint32_t joint, const JointTransform &transform) {
+        this->translationX[joint] = transform.translation.x;
+        this->translationY[joint] = transform.translation.y;
+        this->translationZ[joint] = transform.translation.z;
+
+        this->rotationX[joint] = transform.rotation.x;
+        this->rotationY[joint] = transform.rotation.y;
+        this->rotationZ[joint] = transform.rotation.z;
+        this->rotationW[joint] = transform.rotation.w;
+
+        this->scaleX[joint] = transform.scale.x;
+        this->scaleY[joint] = transform.scale.y;
+        this->scaleZ[joint] = transform.scale.z;
+    }
+
+    JointTransform LocalPose::get(uint32_t joint) const {
+        JointTransform transform;
+        transform.translation = glm::vec3{ this->translationX[joint], this->translationY[joint], this->translationZ[joint] };
+        transform.rotation = glm::quat{ this->rotationW[joint], this->rotationX[joint], this->rotationY[joint], this->rotationZ[joint] };
+        transform.scale = glm::vec3{ this->scaleX[joint], this->scaleY[joint], this->scaleZ[joint] };
+
+        return transform;
+    }
+
+    void LocalPose::blend(const LocalPose &a, const LocalPose &b, float weight, LocalPose &result) {
+        Float4 t = Float4::splat(weight);
+        Float4 oneMinusT = Float4::splat(1.0f - weight);
+
+        for (uint32_t i = 0; i < a.getPaddedCount(); i += 4) {
+            Float4::lerp(Float4::load(&a.translationX[i]), Float4::load(&b.translationX[i]), t).store(&result.translationX[i]);
+            Float4::lerp(Float4::load(&a.translationY[i]), Float4::load(&b.translationY[i]), t).store(&result.translationY[i]);
+            Float4::lerp(Float4::load(&a.translationZ[i]), Float4::load(&b.translationZ[i]), t).store(&result.translationZ[i]);
+
+            Float4::lerp(Float4::load(&a.scaleX[i]), Float4::load(&b.scaleX[i]), t).store(&result.scaleX[i]);
+            Float4::lerp(Float4::load(&a.scaleY[i]), Float4::load(&b.scaleY[i]), t).store(&result.scaleY[i]);
+            Float4::lerp(Float4::load(&a.scaleZ[i]), Float4::load(&b.scaleZ[i]), t).store(&result.scaleZ[i]);
+
+            Float4 ax = Float4::load(&a.rotationX[i]);
+            Float4 ay = Float4::load(&a.rotationY[i]);
+            Float4 az = Float4::load(&a.rotationZ[i]);
+            Float4 aw = Float4::load(&a.rotationW[i]);
+
+            Float4 bx = Float4::load(&b.rotationX[i]);
+            Float4 by = Float4::load(&b.rotationY[i]);
+            Float4 bz = Float4::load(&b.rotationZ[i]);
+            Float4 bw = Float4::load(&b.rotationW[i]);
+
+            // q and -q are the same rotation, b is flipped onto a's hemisphere to take the short way round
+            Float4 dot = ax * bx + ay * by + az * bz + aw * bw;
+            Float4 weightB = Float4::copySignOf(t, dot);
+
+            Float4 x = ax * oneMinusT + bx * weightB;
+            Float4 y = ay * oneMinusT + by * weightB;
+            Float4 z = az * oneMinusT + bz * weightB;
+            Float4 w = aw * oneMinusT + bw * weightB;
+
+            Float4 length = Float4::sqrt(x * x + y * y + z * z + w * w);
+
+            (x / length).store(&result.rotationX[i]);
+            (y / length).store(&result.rotationY[i]);
+            (z / length).store(&result.rotationZ[i]);
+            (w / length).store(&result.rotationW[i]);
+        }
+    }
+}
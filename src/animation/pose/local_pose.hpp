@@ -0,0 +1,35 @@
+#ifndef NUGIE_LOCAL_POSE_HPP
+#define NUGIE_LOCAL_POSE_HPP
+
+#include <vector>
+#include <cstdint>
+
+#include "../skeleton/skeleton.hpp"
+
+namespace nugie {
+    // Every joint's parent-relative transform as a structure of arrays, so blends run four joints
+    // per instruction. The arrays are padded to a multiple of four with identity joints, which
+    // keeps the SIMD loops free of a scalar tail.
+    struct LocalPose {
+        std::vector<float> translationX, translationY, translationZ;
+        std::vector<float> rotationX, rotationY, rotationZ, rotationW;
+        std::vector<float> scaleX, scaleY, scaleZ;
+
+        uint32_t jointCount = 0;
+
+        // Sizes every array and resets all joints to identity
+        void resize(uint32_t jointCount);
+
+        uint32_t getPaddedCount() const { return static_cast<uint32_t>(this->translationX.size()); }
+
+        void set(uint32_t joint, const JointTransform &transform);
+
+        JointTransform get(uint32_t joint) const;
+
+        // result = a blended towards b by weight: lerped translation and scale, shortest-path nlerped
+        // rotation. The three poses must have the same joint count, result may be a or b.
+        static void blend(const LocalPose &a, const LocalPose &b, float weight, LocalPose &result);
+    };
+}
+
+#endif
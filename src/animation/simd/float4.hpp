@@ -0,0 +1,99 @@
+#ifndef NUGIE_FLOAT4_HPP
+#define NUGIE_FLOAT4_HPP
+
+#include <cmath>
+
+#include <glm/glm.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define NUGIE_SIMD_SSE
+    #include <emmintrin.h>
+#endif
+
+namespace nugie {
+    // Four floats processed together. Uses SSE where the target has it and plain loops elsewhere,
+    // so the animation code is written once for both. Loads and stores need no alignment.
+    struct Float4 {
+#ifdef NUGIE_SIMD_SSE
+        __m128 value;
+
+        static Float4 load(const float *data) { return Float4{ _mm_loadu_ps(data) }; }
+
+        static Float4 splat(float scalar) { return Float4{ _mm_set1_ps(scalar) }; }
+
+        void store(float *data) const { _mm_storeu_ps(data, this->value); }
+
+        friend Float4 operator+(Float4 a, Float4 b) { return Float4{ _mm_add_ps(a.value, b.value) }; }
+        friend Float4 operator-(Float4 a, Float4 b) { return Float4{ _mm_sub_ps(a.value, b.value) }; }
+        friend Float4 operator*(Float4 a, Float4 b) { return Float4{ _mm_mul_ps(a.value, b.value) }; }
+        friend Float4 operator/(Float4 a, Float4 b) { return Float4{ _mm_div_ps(a.value, b.value) }; }
+
+        static Float4 sqrt(Float4 a) { return Float4{ _mm_sqrt_ps(a.value) }; }
+
+        // Flips the sign of every lane of a where the same lane of b is negative
+        static Float4 copySignOf(Float4 a, Float4 b) {
+            __m128 signMask = _mm_set1_ps(-0.0f);
+            return Float4{ _mm_xor_ps(a.value, _mm_and_ps(b.value, signMask)) };
+        }
+#else
+        float value[4];
+
+        static Float4 load(const float *data) { return Float4{ { data[0], data[1], data[2], data[3] } }; }
+
+        static Float4 splat(float scalar) { return Float4{ { scalar, scalar, scalar, scalar } }; }
+
+        void store(float *data) const {
+            for (int i = 0; i < 4; i++) {
+                data[i] = this->value[i];
+            }
+        }
+
+        friend Float4 operator+(Float4 a, Float4 b) { return apply(a, b, [](float x, float y) { return x + y; }); }
+        friend Float4 operator-(Float4 a, Float4 b) { return apply(a, b, [](float x, float y) { return x - y; }); }
+        friend Float4 operator*(Float4 a, Float4 b) { return apply(a, b, [](float x, float y) { return x * y; }); }
+        friend Float4 operator/(Float4 a, Float4 b) { return apply(a, b, [](float x, float y) { return x / y; }); }
+
+        static Float4 sqrt(Float4 a) { return apply(a, a, [](float x, float) { return std::sqrt(x); }); }
+
+        static Float4 copySignOf(Float4 a, Float4 b) { return apply(a, b, [](float x, float y) { return std::signbit(y) ? -x : x; }); }
+
+        template<typename F>
+        static Float4 apply(Float4 a, Float4 b, F function) {
+            Float4 result;
+            for (int i = 0; i < 4; i++) {
+                result.value[i] = function(a.value[i], b.value[i]);
+            }
+
+            return result;
+        }
+#endif
+
+        // a + (b - a) * t
+        static Float4 lerp(Float4 a, Float4 b, Float4 t) { return a + (b - a) * t; }
+    };
+
+    // result = a * b for column-major matrices, one column of the result per four-wide multiply-add chain.
+    // result may alias a or b.
+    inline void multiplyMatrices(const glm::mat4 &a, const glm::mat4 &b, glm::mat4 &result) {
+        Float4 columnsA[4] {
+            Float4::load(&a[0][0]),
+            Float4::load(&a[1][0]),
+            Float4::load(&a[2][0]),
+            Float4::load(&a[3][0])
+        };
+
+        Float4 columns[4];
+        for (int i = 0; i < 4; i++) {
+            columns[i] = columnsA[0] * Float4::splat(b[i][0])
+                + columnsA[1] * Float4::splat(b[i][1])
+                + columnsA[2] * Float4::splat(b[i][2])
+                + columnsA[3] * Float4::splat(b[i][3]);
+        }
+
+        for (int i = 0; i < 4; i++) {
+            columns[i].store(&result[i][0]);
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,34 @@
+#include "skeleton.hpp"
+
+#include <stdexcept>
+
+namespace nugie {
+    glm::mat4 JointTransform::toMatrix() const {
+        glm::mat4 matrix = glm::mat4_cast(this->rotation);
+
+        matrix[0] *= this->scale.x;
+        matrix[1] *= this->scale.y;
+        matrix[2] *= this->scale.z;
+        matrix[3] = glm::vec4{ this->translation, 1.0f };
+
+        return matrix;
+    }
+
+    uint32_t Skeleton::addJoint(int32_t parent, const JointTransform &bindPose) {
+        if (parent != NO_PARENT && (parent < 0 || static_cast<uint32_t>(parent) >= this->getJointCount())) {
+            throw std::runtime_error("a joint's parent must be added before it");
+        }
+
+        glm::mat4 bindModelMatrix = bindPose.toMatrix();
+        if (parent != NO_PARENT) {
+            bindModelMatrix = this->bindModelMatrices[parent] * bindModelMatrix;
+        }
+
+        this->parents.push_back(parent);
+        this->bindPoses.push_back(bindPose);
+        this->bindModelMatrices.push_back(bindModelMatrix);
+        this->inverseBindMatrices.push_back(glm::inverse(bindModelMatrix));
+
+        return this->getJointCount() - 1;
+    }
+}
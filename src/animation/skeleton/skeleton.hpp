@@ -0,0 +1,45 @@
+#ifndef NUGIE_SKELETON_HPP
+#define NUGIE_SKELETON_HPP
+
+#include <vector>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+namespace nugie {
+    // Translation, rotation and scale of a joint relative to its parent
+    struct JointTransform {
+        glm::vec3 translation{ 0.0f };
+        glm::quat rotation{ 1.0f, 0.0f, 0.0f, 0.0f };
+        glm::vec3 scale{ 1.0f };
+
+        glm::mat4 toMatrix() const;
+    };
+
+    // A joint hierarchy stored parents first, so model space transforms are built in one forward loop
+    class Skeleton {
+    public:
+        static constexpr int32_t NO_PARENT = -1;
+
+        // The parent must have been added already, the bind pose is relative to it
+        uint32_t addJoint(int32_t parent, const JointTransform &bindPose);
+
+        uint32_t getJointCount() const { return static_cast<uint32_t>(this->parents.size()); }
+
+        int32_t getParent(uint32_t joint) const { return this->parents[joint]; }
+
+        const JointTransform& getBindPose(uint32_t joint) const { return this->bindPoses[joint]; }
+
+        // Takes a model space vertex into the joint's space in the bind pose
+        const glm::mat4& getInverseBindMatrix(uint32_t joint) const { return this->inverseBindMatrices[joint]; }
+
+    private:
+        std::vector<int32_t> parents;
+        std::vector<JointTransform> bindPoses;
+        std::vector<glm::mat4> bindModelMatrices;
+        std::vector<glm::mat4> inverseBindMatrices;
+    };
+}
+
+#endif
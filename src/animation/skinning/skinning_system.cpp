@@ -0,0 +1,296 @@
+#include "skinning_system.hpp"
+#include "../simd/float4.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace nugie {
+    SkinningSystem::SkinningSystem(nugie::Device *device, nugie::ShaderLibrary *shaderLibrary, uint32_t maxVertexCount, uint32_t maxJointCount, uint32_t maxInstanceCount)
+    : device{device},
+      maxJointCount{std::max(maxJointCount, 1u)},
+      maxInstanceCount{std::max(maxInstanceCount, 1u)}
+    {
+        // Rounding every instance up to four joints costs at most three joints each
+        this->palette.resize(this->maxJointCount + 3 * this->maxInstanceCount, glm::mat4{ 1.0f });
+
+        this->createBuffers(std::max(maxVertexCount, 1u));
+        this->createPipeline(shaderLibrary);
+    }
+
+    SkinningSystem::~SkinningSystem() {
+        this->release();
+    }
+
+    uint32_t SkinningSystem::addMesh(const std::vector<SkinVertex> &vertices) {
+        if (this->meshes.size() >= this->maxInstanceCount) {
+            throw std::runtime_error("skinning system has no room for another mesh");
+        }
+
+        uint64_t size = vertices.size() * sizeof(SkinVertex);
+        ChildBuffer childBuffer = this->vertexBuffer->createChildBuffer(alignSize(size));
+
+        if (childBuffer.getOffset() + childBuffer.getSize() > this->vertexBuffer->getSize()) {
+            throw std::runtime_error("skinning system has no room for the mesh vertices");
+        }
+
+        this->vertexBuffer->write(const_cast<SkinVertex*>(vertices.data()), size, childBuffer.getOffset());
+        this->meshes.push_back(SkinnedMesh{ childBuffer, static_cast<uint32_t>(vertices.size()) });
+
+        return static_cast<uint32_t>(this->meshes.size() - 1);
+    }
+
+    uint32_t SkinningSystem::addInstance(uint32_t mesh, const Skeleton *skeleton) {
+        uint32_t jointCount = skeleton->getJointCount();
+        uint32_t firstJoint = this->paletteJointCount;
+
+        if (this->instances.size() >= this->maxInstanceCount || firstJoint + jointCount > this->palette.size()) {
+            throw std::runtime_error("skinning system has no room for another instance");
+        }
+
+        uint32_t vertexCount = this->meshes[mesh].vertexCount;
+        ChildBuffer output = this->outputBuffer->createChildBuffer(alignSize(vertexCount * sizeof(glm::vec3)));
+
+        if (output.getOffset() + output.getSize() > this->outputBuffer->getSize()) {
+            throw std::runtime_error("skinning system has no room for the instance output");
+        }
+
+        SkinnedInstance instance{ mesh, skeleton, nullptr, nullptr, 0.0f, firstJoint, output, nullptr, {}, {}, {} };
+        instance.pose.resize(jointCount);
+        instance.blendPose.resize(jointCount);
+        instance.modelMatrices.resize(jointCount);
+
+        // Until a clip is set the instance holds its bind pose
+        for (uint32_t joint = 0; joint < jointCount; joint++) {
+            instance.pose.set(joint, skeleton->getBindPose(joint));
+        }
+
+        this->instances.push_back(std::move(instance));
+        this->paletteJointCount += (jointCount + 3) & ~3u;
+        this->skinnedVertexCount += vertexCount;
+
+        uint32_t index = static_cast<uint32_t>(this->instances.size() - 1);
+
+        SkinParams params{ vertexCount, std::max(jointCount, 1u), { 0, 0 } };
+        this->device->writeBuffer(this->paramsBuffer, index * BINDING_ALIGNMENT, &params, sizeof(SkinParams));
+
+        this->instances[index].bindGroup = this->createBindGroup(index);
+
+        return index;
+    }
+
+    void SkinningSystem::setAnimation(uint32_t instance, const AnimationClip *clip, const AnimationClip *blendClip, float blendWeight) {
+        this->instances[instance].clip = clip;
+        this->instances[instance].blendClip = blendClip;
+        this->setBlendWeight(instance, blendWeight);
+    }
+
+    void SkinningSystem::setBlendWeight(uint32_t instance, float blendWeight) {
+        this->instances[instance].blendWeight = std::clamp(blendWeight, 0.0f, 1.0f);
+    }
+
+    void SkinningSystem::update(JobSystem *jobSystem, float time) {
+        if (this->instances.empty()) {
+            return;
+        }
+
+        jobSystem->parallelFor(this->getInstanceCount(), 1, [this, time](uint32_t begin, uint32_t end) {
+            for (uint32_t i = begin; i < end; i++) {
+                this->evaluate(this->instances[i], time);
+            }
+        });
+
+        this->device->writeBuffer(this->paletteBuffer, 0, this->palette.data(), this->paletteJointCount * sizeof(glm::mat4));
+    }
+
+    void SkinningSystem::dispatch(wgpu::ComputePassEncoder computePassEncoder) {
+        if (this->instances.empty()) {
+            return;
+        }
+
+        computePassEncoder.setPipeline(this->pipeline);
+
+        for (auto &&instance : this->instances) {
+            uint32_t vertexCount = this->meshes[instance.mesh].vertexCount;
+
+            computePassEncoder.setBindGroup(0, instance.bindGroup, 0, nullptr);
+            computePassEncoder.dispatchWorkgroups((vertexCount + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1, 1);
+        }
+    }
+
+    BufferInfo SkinningSystem::getOutputInfo(uint32_t instance) {
+        const SkinnedInstance &skinnedInstance = this->instances[instance];
+        uint64_t size = this->meshes[skinnedInstance.mesh].vertexCount * sizeof(glm::vec3);
+
+        return BufferInfo{ this->outputBuffer->getNative(), size, skinnedInstance.output.getOffset() };
+    }
+
+    void SkinningSystem::release() {
+        if (this->released) {
+            return;
+        }
+
+        for (auto &&instance : this->instances) {
+            instance.bindGroup.release();
+        }
+
+        this->pipeline.release();
+        this->pipelineLayout.release();
+        this->bindGroupLayout.release();
+
+        this->device->releaseBuffer(this->paramsBuffer);
+        this->device->releaseBuffer(this->paletteBuffer);
+
+        delete this->outputBuffer;
+        delete this->vertexBuffer;
+
+        this->released = true;
+    }
+
+    void SkinningSystem::createBuffers(uint32_t maxVertexCount) {
+        // Each range is rounded up to the binding alignment, which costs at most one alignment per mesh or instance
+        uint64_t alignmentSlack = this->maxInstanceCount * BINDING_ALIGNMENT;
+
+        wgpu::BufferDescriptor bufferDesc{};
+        bufferDesc.mappedAtCreation = false;
+
+        bufferDesc.label = "Skin Vertex Buffer";
+        bufferDesc.size = maxVertexCount * sizeof(SkinVertex) + alignmentSlack;
+        bufferDesc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst;
+        this->vertexBuffer = this->device->createMasterBuffer(bufferDesc);
+
+        bufferDesc.label = "Skinned Position Buffer";
+        bufferDesc.size = maxVertexCount * sizeof(glm::vec3) + alignmentSlack;
+        bufferDesc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::Vertex;
+        this->outputBuffer = this->device->createMasterBuffer(bufferDesc);
+
+        bufferDesc.label = "Joint Palette Buffer";
+        bufferDesc.size = this->palette.size() * sizeof(glm::mat4);
+        bufferDesc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst;
+        this->paletteBuffer = this->device->createBuffer(bufferDesc);
+
+        bufferDesc.label = "Skin Params Buffer";
+        bufferDesc.size = this->maxInstanceCount * BINDING_ALIGNMENT;
+        bufferDesc.usage = wgpu::BufferUsage::Uniform | wgpu::BufferUsage::CopyDst;
+        this->paramsBuffer = this->device->createBuffer(bufferDesc);
+    }
+
+    void SkinningSystem::createPipeline(nugie::ShaderLibrary *shaderLibrary) {
+        const ShaderReflection &reflection = shaderLibrary->getReflection("skinning.wgsl");
+
+        reflection.validateStruct("SkinParams", sizeof(SkinParams), {
+            { "vertexCount", offsetof(SkinParams, vertexCount) },
+            { "jointCount", offsetof(SkinParams, jointCount) },
+            { "padding0", offsetof(SkinParams, padding) },
+            { "padding1", offsetof(SkinParams, padding) + sizeof(uint32_t) }
+        });
+
+        reflection.validateStruct("SkinVertex", sizeof(SkinVertex), {
+            { "position", offsetof(SkinVertex, position) },
+            { "weights", offsetof(SkinVertex, weights) },
+            { "joints", offsetof(SkinVertex, joints) }
+        });
+
+        wgpu::BindGroupLayoutEntry bindGroupLayoutEntries[4];
+
+        for (uint32_t i = 0; i < 4; i++) {
+            bindGroupLayoutEntries[i].nextInChain = nullptr;
+            bindGroupLayoutEntries[i].binding = i;
+            bindGroupLayoutEntries[i].visibility = wgpu::ShaderStage::Compute;
+            bindGroupLayoutEntries[i].buffer.nextInChain = nullptr;
+            bindGroupLayoutEntries[i].buffer.hasDynamicOffset = false;
+            bindGroupLayoutEntries[i].buffer.type = wgpu::BufferBindingType::ReadOnlyStorage;
+        }
+
+        bindGroupLayoutEntries[0].buffer.type = wgpu::BufferBindingType::Uniform;
+        bindGroupLayoutEntries[3].buffer.type = wgpu::BufferBindingType::Storage;
+
+        wgpu::BindGroupLayoutDescriptor bindGroupLayoutDesc{};
+        bindGroupLayoutDesc.label = "Skinning Bind Group Layout";
+        bindGroupLayoutDesc.nextInChain = nullptr;
+        bindGroupLayoutDesc.entryCount = 4;
+        bindGroupLayoutDesc.entries = bindGroupLayoutEntries;
+
+        this->bindGroupLayout = this->device->createBindGroupLayout(bindGroupLayoutDesc);
+
+        WGPUBindGroupLayout bindGroupLayouts[1] {
+            this->bindGroupLayout
+        };
+
+        wgpu::PipelineLayoutDescriptor pipelineLayoutDesc{};
+        pipelineLayoutDesc.label = "Skinning Pipeline Layout";
+        pipelineLayoutDesc.bindGroupLayoutCount = 1;
+        pipelineLayoutDesc.bindGroupLayouts = bindGroupLayouts;
+
+        this->pipelineLayout = this->device->createPipelineLayout(pipelineLayoutDesc);
+
+        wgpu::ComputePipelineDescriptor pipelineDesc{};
+        pipelineDesc.label = "Skinning Pipeline";
+        pipelineDesc.layout = this->pipelineLayout;
+        pipelineDesc.compute.nextInChain = nullptr;
+        pipelineDesc.compute.module = shaderLibrary->getModule("skinning.wgsl");
+        pipelineDesc.compute.entryPoint = "computeMain";
+        pipelineDesc.compute.constantCount = 0;
+        pipelineDesc.compute.constants = nullptr;
+
+        this->pipeline = this->device->createComputePipeline(pipelineDesc);
+    }
+
+    wgpu::BindGroup SkinningSystem::createBindGroup(uint32_t instance) {
+        SkinnedInstance &skinnedInstance = this->instances[instance];
+        SkinnedMesh &mesh = this->meshes[skinnedInstance.mesh];
+
+        uint32_t jointCount = skinnedInstance.skeleton->getJointCount();
+
+        BufferInfo infos[4] {
+            BufferInfo{ this->paramsBuffer, sizeof(SkinParams), instance * BINDING_ALIGNMENT },
+            BufferInfo{ this->vertexBuffer->getNative(), mesh.vertices.getSize(), mesh.vertices.getOffset() },
+            BufferInfo{ this->paletteBuffer, std::max(jointCount, 1u) * sizeof(glm::mat4), skinnedInstance.firstJoint * sizeof(glm::mat4) },
+            BufferInfo{ this->outputBuffer->getNative(), skinnedInstance.output.getSize(), skinnedInstance.output.getOffset() }
+        };
+
+        wgpu::BindGroupEntry bindGroupEntries[4];
+        for (uint32_t i = 0; i < 4; i++) {
+            bindGroupEntries[i].nextInChain = nullptr;
+            bindGroupEntries[i].binding = i;
+            bindGroupEntries[i].buffer = infos[i].buffer;
+            bindGroupEntries[i].offset = infos[i].offset;
+            bindGroupEntries[i].size = infos[i].size;
+        }
+
+        wgpu::BindGroupDescriptor bindGroupDesc{};
+        bindGroupDesc.label = "Skinning Bind Group";
+        bindGroupDesc.nextInChain = nullptr;
+        bindGroupDesc.entryCount = 4;
+        bindGroupDesc.entries = bindGroupEntries;
+        bindGroupDesc.layout = this->bindGroupLayout;
+
+        return this->device->createBindGroup(bindGroupDesc);
+    }
+
+    void SkinningSystem::evaluate(SkinnedInstance &instance, float time) {
+        const Skeleton *skeleton = instance.skeleton;
+
+        if (instance.clip != nullptr) {
+            instance.clip->sample(*skeleton, time, instance.pose);
+
+            if (instance.blendClip != nullptr && instance.blendWeight > 0.0f) {
+                instance.blendClip->sample(*skeleton, time, instance.blendPose);
+                LocalPose::blend(instance.pose, instance.blendPose, instance.blendWeight, instance.pose);
+            }
+        }
+
+        // Parents come first, so each joint's model matrix is ready before its children need it
+        for (uint32_t joint = 0; joint < skeleton->getJointCount(); joint++) {
+            glm::mat4 local = instance.pose.get(joint).toMatrix();
+            int32_t parent = skeleton->getParent(joint);
+
+            if (parent == Skeleton::NO_PARENT) {
+                instance.modelMatrices[joint] = local;
+            } else {
+                multiplyMatrices(instance.modelMatrices[parent], local, instance.modelMatrices[joint]);
+            }
+
+            multiplyMatrices(instance.modelMatrices[joint], skeleton->getInverseBindMatrix(joint), this->palette[instance.firstJoint + joint]);
+        }
+    }
+}
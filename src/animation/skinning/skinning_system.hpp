@@ -0,0 +1,138 @@
+#ifndef NUGIE_SKINNING_SYSTEM_HPP
+#define NUGIE_SKINNING_SYSTEM_HPP
+
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "../../device/device.hpp"
+#include "../../shader/library/shader_library.hpp"
+#include "../../job/system/job_system.hpp"
+#include "../../buffer/master/master_buffer.hpp"
+#include "../../buffer/child/child_buffer.hpp"
+#include "../skeleton/skeleton.hpp"
+#include "../clip/animation_clip.hpp"
+#include "../pose/local_pose.hpp"
+
+namespace nugie {
+    class Device;
+
+    // Layout matches SkinVertex in skinning.wgsl, weights of one vertex add up to one
+    struct SkinVertex {
+        glm::vec4 position;
+        glm::vec4 weights;
+        glm::uvec4 joints;
+    };
+
+    // Skins every animated mesh instance once per frame on the GPU.
+    //
+    // update() samples and blends each instance's clips and builds its joint palette on the job
+    // system, then uploads all palettes with a single write. dispatch() runs one compute pass that
+    // writes each instance's skinned positions into its own range of a shared output buffer, three
+    // floats per vertex. That range is bound as the position stream of every pass that draws the
+    // instance, so the depth prepass, the scene passes and any later pass see the same vertices and
+    // none of them skins again.
+    //
+    // The palettes are rewritten every frame while older frames may be in flight, which is safe
+    // because queue writes are ordered against the submits around them.
+    class SkinningSystem {
+    public:
+        SkinningSystem(nugie::Device *device, nugie::ShaderLibrary *shaderLibrary, uint32_t maxVertexCount, uint32_t maxJointCount, uint32_t maxInstanceCount);
+        ~SkinningSystem();
+
+        // Uploads the bind pose vertices once, returns the mesh index
+        uint32_t addMesh(const std::vector<SkinVertex> &vertices);
+
+        // An animated copy of a mesh with its own palette and output range, returns the instance index.
+        // The skeleton must outlive the system.
+        uint32_t addInstance(uint32_t mesh, const Skeleton *skeleton);
+
+        // Plays clip, blended towards blendClip by blendWeight when one is given. The clips must outlive the instance.
+        void setAnimation(uint32_t instance, const AnimationClip *clip, const AnimationClip *blendClip = nullptr, float blendWeight = 0.0f);
+
+        void setBlendWeight(uint32_t instance, float blendWeight);
+
+        // Evaluates every instance at the given time and uploads the palettes, once per frame before the skinning pass
+        void update(JobSystem *jobSystem, float time);
+
+        void dispatch(wgpu::ComputePassEncoder computePassEncoder);
+
+        // Skinned positions of an instance, three floats per vertex, to bind as a position stream
+        BufferInfo getOutputInfo(uint32_t instance);
+
+        uint32_t getInstanceCount() { return static_cast<uint32_t>(this->instances.size()); }
+
+        uint32_t getSkinnedVertexCount() { return this->skinnedVertexCount; }
+
+        void release();
+
+    private:
+        // Storage bindings must start at a multiple of this, so every range is rounded up to it
+        static constexpr uint64_t BINDING_ALIGNMENT = 256;
+        static constexpr uint32_t WORKGROUP_SIZE = 64;
+
+        // Layout matches SkinParams in skinning.wgsl
+        struct SkinParams {
+            uint32_t vertexCount;
+            uint32_t jointCount;
+            uint32_t padding[2];
+        };
+
+        struct SkinnedMesh {
+            ChildBuffer vertices;
+            uint32_t vertexCount;
+        };
+
+        struct SkinnedInstance {
+            uint32_t mesh;
+            const Skeleton *skeleton;
+            const AnimationClip *clip = nullptr;
+            const AnimationClip *blendClip = nullptr;
+            float blendWeight = 0.0f;
+
+            uint32_t firstJoint;
+            ChildBuffer output;
+            wgpu::BindGroup bindGroup;
+
+            // Scratch space of the evaluation, sized once so frames never allocate
+            LocalPose pose;
+            LocalPose blendPose;
+            std::vector<glm::mat4> modelMatrices;
+        };
+
+        nugie::Device *device;
+        uint32_t maxJointCount;
+        uint32_t maxInstanceCount;
+
+        std::vector<SkinnedMesh> meshes;
+        std::vector<SkinnedInstance> instances;
+
+        // Every instance's palette, its first joint is a multiple of four so each starts on a binding boundary
+        std::vector<glm::mat4> palette;
+        uint32_t paletteJointCount = 0;
+        uint32_t skinnedVertexCount = 0;
+
+        MasterBuffer *vertexBuffer;
+        MasterBuffer *outputBuffer;
+        wgpu::Buffer paletteBuffer;
+        wgpu::Buffer paramsBuffer;
+
+        wgpu::BindGroupLayout bindGroupLayout;
+        wgpu::PipelineLayout pipelineLayout;
+        wgpu::ComputePipeline pipeline;
+
+        bool released = false;
+
+        void createBuffers(uint32_t maxVertexCount);
+
+        void createPipeline(nugie::ShaderLibrary *shaderLibrary);
+
+        wgpu::BindGroup createBindGroup(uint32_t instance);
+
+        // Samples, blends and walks the hierarchy into the instance's slice of the palette
+        void evaluate(SkinnedInstance &instance, float time);
+
+        static uint64_t alignSize(uint64_t size) { return (size + BINDING_ALIGNMENT - 1) / BINDING_ALIGNMENT * BINDING_ALIGNMENT; }
+    };
+}
+
+#endif
@@ -0,0 +1,37 @@
+#include "batch_job_list.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace nugie {
+    void BatchJobList::load(const std::string& path) {
+        std::ifstream file{ path };
+        if (!file) {
+            throw std::runtime_error("failed to open batch job file: " + path);
+        }
+
+        this->jobs.clear();
+
+        std::string line;
+        uint32_t lineNumber = 0;
+
+        while (std::getline(file, line)) {
+            lineNumber++;
+
+            size_t first = line.find_first_not_of(" \t\r");
+            if (first == std::string::npos || line[first] == '#') {
+                continue;
+            }
+
+            BatchJob job{};
+            std::istringstream stream{ line };
+
+            if (!(stream >> job.position.x >> job.position.y >> job.position.z >> job.yaw >> job.pitch >> job.zoom >> job.outputPath)) {
+                throw std::runtime_error(path + ":" + std::to_string(lineNumber) + ": expected position, yaw, pitch, zoom and an output path");
+            }
+
+            this->jobs.push_back(job);
+        }
+    }
+}
@@ -0,0 +1,37 @@
+#ifndef NUGIE_BATCH_JOB_LIST_HPP
+#define NUGIE_BATCH_JOB_LIST_HPP
+
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace nugie {
+    // One image to render, the pose matches nugie::Camera
+    struct BatchJob {
+        glm::vec3 position;
+        float yaw;
+        float pitch;
+        float zoom;
+        std::string outputPath;
+    };
+
+    // Reads a text job file with one image per line:
+    //
+    //     positionX positionY positionZ yaw pitch zoom output.png
+    //
+    // Empty lines and lines starting with # are skipped.
+    class BatchJobList {
+    public:
+        // Throws when the file cannot be read or a line is malformed
+        void load(const std::string& path);
+
+        size_t getCount() { return this->jobs.size(); }
+
+        const BatchJob& getJob(size_t index) { return this->jobs[index]; }
+
+    private:
+        std::vector<BatchJob> jobs;
+    };
+}
+
+#endif
@@ -1,15 +1,29 @@
 #include "child_buffer.hpp"
 
+#include <string>
+#include <stdexcept>
+
 namespace nugie {
     BufferInfo ChildBuffer::getInfo() {
-        return BufferInfo{
-            .buffer = this->master->getNative(),
-            .offset = this->offset,
-            .size = this->size
-        };
+        return BufferInfo{ this->master->getNative(), this->size, this->offset };
     }
 
-    void ChildBuffer::write(void* data) {
+    void ChildBuffer::write(const void* data) {
         this->master->write(data, this->size, this->offset);
     }
+
+    void ChildBuffer::write(const void* data, uint64_t offset, uint64_t length) {
+        if (offset > this->size || length > this->size - offset) {
+            throw std::runtime_error("write of " + std::to_string(length) + " bytes at " + std::to_string(offset)
+                + " is out of a " + std::to_string(this->size) + " byte child buffer");
+        }
+
+        if ((this->offset + offset) % 4 != 0 || length % 4 != 0) {
+            throw std::runtime_error("child buffer writes must start and end on a multiple of 4 bytes");
+        }
+
+        if (length > 0) {
+            this->master->write(data, length, this->offset + offset);
+        }
+    }
 }
\ No newline at end of file
@@ -24,11 +24,20 @@ namespace nugie {
 
         MasterBuffer* getMasterBuffer() { return this->master; }
 
+        uint64_t getSize() { return this->size; }
+
+        uint64_t getOffset() { return this->offset; }
+
         BufferInfo getInfo();
 
         // =========================== wgpu::buffer function ===========================
 
-        void write(void* data);
+        // Uploads the whole slice, data must hold getSize() bytes
+        void write(const void* data);
+
+        // Uploads length bytes at offset into the slice. Throws std::runtime_error for a range past the
+        // end of the slice, or one that does not start and end on the 4 bytes a queue write needs.
+        void write(const void* data, uint64_t offset, uint64_t length);
 
     private:
         MasterBuffer* master;
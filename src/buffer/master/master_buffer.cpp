@@ -1,34 +1,120 @@
 #include "master_buffer.hpp"
 
+#include <algorithm>
+
 namespace nugie {
-    MasterBuffer::MasterBuffer(nugie::Device *device, wgpu::BufferDescriptor desc) : device{device} {
+    MasterBuffer::MasterBuffer(nugie::Device *device, wgpu::BufferDescriptor desc)
+    : device{device},
+      size{desc.size}
+    {
         this->buffer = this->device->createBuffer(desc);
+        this->device->getMemoryTracker()->trackMasterBuffer(this, desc.label, desc.size);
     }
 
     MasterBuffer::~MasterBuffer() {
         this->release();
     }
     
-   ChildBuffer MasterBuffer::createChildBuffer(uint64_t size) {
+    static uint64_t alignOffset(uint64_t offset, uint64_t alignment) {
+        return (offset + alignment - 1) / alignment * alignment;
+    }
+
+    ChildBuffer MasterBuffer::createChildBuffer(uint64_t size, uint64_t alignment) {
         if (size == ULLONG_MAX) {
-            size = this->buffer.getSize();
+            size = this->size;
+        }
+
+        for (auto range = this->freeRanges.begin(); range != this->freeRanges.end(); range++) {
+            uint64_t offset = alignOffset(range->offset, alignment);
+            uint64_t end = range->offset + range->size;
+
+            if (offset + size > end) {
+                continue;
+            }
+
+            ChildBuffer childBuffer{ this, size, offset };
+            this->freeBytes -= size;
+
+            if (offset == range->offset) {
+                range->offset += size;
+                range->size -= size;
+
+                if (range->size == 0) {
+                    this->freeRanges.erase(range);
+                }
+            } else {
+                // The gap in front of the aligned child stays free, and so does whatever is left behind it
+                range->size = offset - range->offset;
+
+                if (offset + size < end) {
+                    this->freeRanges.insert(range + 1, FreeRange{ offset + size, end - offset - size });
+                }
+            }
+
+            this->device->getMemoryTracker()->updateMasterBuffer(this, this->totalOffset - this->freeBytes);
+            return childBuffer;
+        }
+
+        uint64_t offset = alignOffset(this->totalOffset, alignment);
+
+        // Padding in front of an aligned child is free space like any other, a smaller child may use it
+        if (offset > this->totalOffset) {
+            this->freeRanges.push_back(FreeRange{ this->totalOffset, offset - this->totalOffset });
+            this->freeBytes += offset - this->totalOffset;
         }
 
-        ChildBuffer childBuffer{ this, size, this->totalOffset };
-        this->totalOffset += size;
+        ChildBuffer childBuffer{ this, size, offset };
+        this->totalOffset = offset + size;
+
+        this->device->getMemoryTracker()->updateMasterBuffer(this, this->totalOffset - this->freeBytes);
 
         return childBuffer;
     }
 
+    void MasterBuffer::releaseChildBuffer(ChildBuffer childBuffer) {
+        FreeRange released{ childBuffer.getOffset(), childBuffer.getSize() };
+        if (released.size == 0) {
+            return;
+        }
+
+        auto next = std::lower_bound(this->freeRanges.begin(), this->freeRanges.end(), released.offset, [](const FreeRange &range, uint64_t offset) {
+            return range.offset < offset;
+        });
+
+        auto inserted = this->freeRanges.insert(next, released);
+        this->freeBytes += released.size;
+
+        if (inserted + 1 != this->freeRanges.end() && inserted->offset + inserted->size == (inserted + 1)->offset) {
+            inserted->size += (inserted + 1)->size;
+            this->freeRanges.erase(inserted + 1);
+        }
+
+        if (inserted != this->freeRanges.begin() && (inserted - 1)->offset + (inserted - 1)->size == inserted->offset) {
+            (inserted - 1)->size += inserted->size;
+            inserted = this->freeRanges.erase(inserted) - 1;
+        }
+
+        // A range that ends where untouched space begins goes back to it
+        if (inserted->offset + inserted->size == this->totalOffset) {
+            this->totalOffset = inserted->offset;
+            this->freeBytes -= inserted->size;
+            this->freeRanges.erase(inserted);
+        }
+
+        this->device->getMemoryTracker()->updateMasterBuffer(this, this->totalOffset - this->freeBytes);
+    }
+
     uint64_t MasterBuffer::getSize() {
-        return this->buffer.getSize();
+        return this->size;
     }
 
-    void MasterBuffer::write(void* data, size_t size, uint64_t offset) {
-        device->getQueue().writeBuffer(this->buffer, offset, data, size);
+    void MasterBuffer::write(const void* data, size_t size, uint64_t offset) {
+        this->device->writeBuffer(this->buffer, offset, data, size);
     }
 
     void MasterBuffer::release() {
-        this->buffer.release();
+        this->device->getMemoryTracker()->untrackMasterBuffer(this);
+        this->device->releaseBuffer(this->buffer);
+        this->buffer = nullptr;
     }
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 #define NUGIE_MASTER_BUFFER_HPP
 
 #include <memory>
+#include <vector>
 #include "../../device/device.hpp"
 #include "../child/child_buffer.hpp"
 
@@ -16,20 +17,37 @@ namespace nugie {
 
         wgpu::Buffer getNative() { return this->buffer; }
 
-        ChildBuffer createChildBuffer(uint64_t size = ULLONG_MAX);
+        // Reuses the first released range that fits before growing into untouched space. The offset is a
+        // multiple of the alignment, such as the device's uniform offset alignment for a uniform binding.
+        ChildBuffer createChildBuffer(uint64_t size = ULLONG_MAX, uint64_t alignment = 1);
+
+        // Hands the range back for later child buffers, the GPU must be done with it (see DeletionQueue)
+        void releaseChildBuffer(ChildBuffer childBuffer);
 
         // =========================== wgpu::buffer function ===========================
 
         uint64_t getSize();
 
-        void write(void* data, size_t size, uint64_t offset);
+        void write(const void* data, size_t size, uint64_t offset);
 
         void release();
 
     private:
+        struct FreeRange {
+            uint64_t offset;
+            uint64_t size;
+        };
+
         nugie::Device *device;
+
+        // Kept from the descriptor, so sizes never have to be asked of the buffer (which a null device cannot answer)
+        uint64_t size;
         uint64_t totalOffset = 0;
 
+        // Released ranges sorted by offset, neighbours are merged
+        std::vector<FreeRange> freeRanges;
+        uint64_t freeBytes = 0;
+
         wgpu::Buffer buffer;
     };
 }
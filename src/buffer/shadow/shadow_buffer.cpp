@@ -0,0 +1,115 @@
+#include "shadow_buffer.hpp"
+
+#include <bit>
+#include <string>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+
+namespace nugie {
+    ShadowBuffer::ShadowBuffer(ChildBuffer childBuffer, uint64_t mergeGap)
+    : childBuffer{childBuffer},
+      mergeGap{mergeGap},
+      shadow(childBuffer.getSize(), 0),
+      dirtyBlocks((childBuffer.getSize() + COMPARE_BLOCK_SIZE * 64 - 1) / (COMPARE_BLOCK_SIZE * 64), 0)
+    {
+        if (childBuffer.getOffset() % 4 != 0 || childBuffer.getSize() % 4 != 0) {
+            throw std::runtime_error("shadow buffers need a child buffer that starts and ends on a multiple of 4 bytes");
+        }
+
+        // Nothing says what the GPU holds yet, the first flush uploads everything
+        this->markAllDirty();
+    }
+
+    void ShadowBuffer::write(const void* data) {
+        this->write(data, 0, this->shadow.size());
+    }
+
+    void ShadowBuffer::write(const void* data, uint64_t offset, uint64_t length) {
+        uint64_t size = this->shadow.size();
+
+        if (offset > size || length > size - offset) {
+            throw std::runtime_error("write of " + std::to_string(length) + " bytes at " + std::to_string(offset)
+                + " is out of a " + std::to_string(size) + " byte shadow buffer");
+        }
+
+        const uint8_t *source = static_cast<const uint8_t*>(data);
+        uint64_t end = offset + length;
+
+        // Blocks are aligned to the start of the buffer, only the part a write covers is compared
+        for (uint64_t block = offset / COMPARE_BLOCK_SIZE; block * COMPARE_BLOCK_SIZE < end; block++) {
+            uint64_t begin = std::max(block * COMPARE_BLOCK_SIZE, offset);
+            uint64_t blockEnd = std::min((block + 1) * COMPARE_BLOCK_SIZE, end);
+
+            if (std::memcmp(this->shadow.data() + begin, source + (begin - offset), blockEnd - begin) != 0) {
+                this->markDirty(block);
+            }
+        }
+
+        std::memcpy(this->shadow.data() + offset, source, length);
+    }
+
+    void ShadowBuffer::markAllDirty() {
+        uint64_t blockCount = (this->shadow.size() + COMPARE_BLOCK_SIZE - 1) / COMPARE_BLOCK_SIZE;
+
+        for (uint64_t block = 0; block < blockCount; block++) {
+            this->markDirty(block);
+        }
+    }
+
+    void ShadowBuffer::flush() {
+        this->flushStats = ShadowFlushStats{};
+
+        if (!this->dirty) {
+            return;
+        }
+
+        // Blocks start on multiples of 64 and the size is one of 4, so every range is a valid queue write
+        auto upload = [this](uint64_t begin, uint64_t end) {
+            this->childBuffer.write(this->shadow.data() + begin, begin, end - begin);
+
+            this->flushStats.writeCount++;
+            this->flushStats.uploadedBytes += end - begin;
+        };
+
+        uint64_t size = this->shadow.size();
+        uint64_t rangeBegin = 0;
+        uint64_t rangeEnd = 0;
+
+        for (size_t word = 0; word < this->dirtyBlocks.size(); word++) {
+            uint64_t bits = this->dirtyBlocks[word];
+            this->dirtyBlocks[word] = 0;
+
+            while (bits != 0) {
+                uint64_t block = word * 64 + std::countr_zero(bits);
+                bits &= bits - 1;
+
+                uint64_t begin = block * COMPARE_BLOCK_SIZE;
+                uint64_t end = std::min(begin + COMPARE_BLOCK_SIZE, size);
+
+                if (rangeEnd > 0 && begin <= rangeEnd + this->mergeGap) {
+                    rangeEnd = end;
+                    continue;
+                }
+
+                if (rangeEnd > 0) {
+                    upload(rangeBegin, rangeEnd);
+                }
+
+                rangeBegin = begin;
+                rangeEnd = end;
+            }
+        }
+
+        if (rangeEnd > 0) {
+            upload(rangeBegin, rangeEnd);
+        }
+
+        this->dirty = false;
+    }
+
+    void ShadowBuffer::markDirty(uint64_t block) {
+        this->dirtyBlocks[block / 64] |= uint64_t{1} << (block % 64);
+        this->dirty = true;
+    }
+}
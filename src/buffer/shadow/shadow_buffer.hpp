@@ -0,0 +1,74 @@
+#ifndef NUGIE_SHADOW_BUFFER_HPP
+#define NUGIE_SHADOW_BUFFER_HPP
+
+#include <vector>
+#include <cstdint>
+
+#include "../child/child_buffer.hpp"
+
+namespace nugie {
+    struct ShadowFlushStats {
+        uint32_t writeCount = 0;
+        uint64_t uploadedBytes = 0;
+    };
+
+    // A child buffer with a CPU copy of its contents. Writes go to the copy, and only the blocks that
+    // actually changed are marked dirty. flush() then uploads the dirty blocks, joined where the gap
+    // between two is small enough that one larger queue write is cheaper than two.
+    //
+    // Meant for large buffers that mostly stay the same from frame to frame, such as instance data
+    // where a few transforms move: write everything every frame, flush once, and only the moved
+    // transforms go over the bus.
+    class ShadowBuffer {
+    public:
+        // The child must start and end on a multiple of 4 bytes, throws std::runtime_error otherwise
+        explicit ShadowBuffer(ChildBuffer childBuffer, uint64_t mergeGap = DEFAULT_MERGE_GAP);
+
+        ChildBuffer getChildBuffer() { return this->childBuffer; }
+
+        BufferInfo getInfo() { return this->childBuffer.getInfo(); }
+
+        uint64_t getSize() { return this->childBuffer.getSize(); }
+
+        const uint8_t* getData() const { return this->shadow.data(); }
+
+        bool isDirty() const { return this->dirty; }
+
+        // Of the last flush()
+        ShadowFlushStats getFlushStats() const { return this->flushStats; }
+
+        // Copies into the shadow, the whole size
+        void write(const void* data);
+
+        // Copies length bytes at offset into the shadow, throws std::runtime_error for a range past the end
+        void write(const void* data, uint64_t offset, uint64_t length);
+
+        // For contents the GPU may hold differently than the shadow, like after the child's range was reused
+        void markAllDirty();
+
+        // Uploads the dirty blocks, once per frame after its writes and before its commands are submitted
+        void flush();
+
+    private:
+        static constexpr uint64_t DEFAULT_MERGE_GAP = 256;
+
+        // Writes are compared with the shadow a block at a time, changes are tracked at this granularity
+        static constexpr uint64_t COMPARE_BLOCK_SIZE = 64;
+
+        ChildBuffer childBuffer;
+        uint64_t mergeGap;
+
+        std::vector<uint8_t> shadow;
+
+        // One bit per block, however scattered the changes are nothing is uploaded that did not change
+        // or lies within the merge gap of a change
+        std::vector<uint64_t> dirtyBlocks;
+        bool dirty = false;
+
+        ShadowFlushStats flushStats;
+
+        void markDirty(uint64_t block);
+    };
+}
+
+#endif
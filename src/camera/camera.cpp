@@ -73,6 +73,15 @@ namespace nugie {
             this->zoom = 45.0f;
     }
 
+    void Camera::setPose(glm::vec3 position, float yaw, float pitch, float zoom) {
+        this->position = position;
+        this->yaw = yaw;
+        this->pitch = pitch;
+        this->zoom = zoom;
+
+        updateCameraVectors();
+    }
+
     void Camera::updateCameraVectors() {
         // calculate the new Front vector
         glm::vec3 newFront;
@@ -57,6 +57,9 @@ namespace nugie {
         // processes input received from a mouse scroll-wheel event. Only requires input on the vertical wheel-axis
         void processMouseScroll(float yoffset);
 
+        // places the camera directly, as when a recorded camera path is played back
+        void setPose(glm::vec3 position, float yaw, float pitch, float zoom);
+
     private:
         // calculates the front vector from the Camera's (updated) Euler Angles
         void updateCameraVectors();
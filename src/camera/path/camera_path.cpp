@@ -0,0 +1,206 @@
+#include "camera_path.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+
+namespace nugie {
+    namespace {
+        // Hermite segment between p1 and p2 with Catmull-Rom tangents, scaled for uneven key spacing
+        float interpolate(float p0, float p1, float p2, float p3, float t0, float t1, float t2, float t3, float s) {
+            float span = t2 - t1;
+            float m1 = t2 > t0 ? (p2 - p0) / (t2 - t0) * span : 0.0f;
+            float m2 = t3 > t1 ? (p3 - p1) / (t3 - t1) * span : 0.0f;
+
+            float s2 = s * s;
+            float s3 = s2 * s;
+
+            return (2.0f * s3 - 3.0f * s2 + 1.0f) * p1 + (s3 - 2.0f * s2 + s) * m1 + (-2.0f * s3 + 3.0f * s2) * p2 + (s3 - s2) * m2;
+        }
+
+        template<typename T>
+        void writeValue(std::ofstream &file, const T &value) {
+            file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+
+        template<typename T>
+        T readValue(std::ifstream &file) {
+            T value{};
+            file.read(reinterpret_cast<char*>(&value), sizeof(T));
+            return value;
+        }
+    }
+
+    // ================================ Camera Path ================================
+
+    void CameraPath::addKeyframe(const CameraKeyframe &keyframe) {
+        if (!this->keyframes.empty() && keyframe.time <= this->keyframes.back().time) {
+            throw std::runtime_error("camera keyframes must be added in increasing time");
+        }
+
+        this->keyframes.push_back(keyframe);
+    }
+
+    void CameraPath::save(const std::string& path) {
+        std::ofstream file{ path, std::ios::binary };
+        if (!file) {
+            throw std::runtime_error("failed to open camera path for writing: " + path);
+        }
+
+        writeValue(file, FILE_MAGIC);
+        writeValue(file, FILE_VERSION);
+        writeValue(file, static_cast<uint32_t>(this->keyframes.size()));
+
+        for (auto &&keyframe : this->keyframes) {
+            writeValue(file, keyframe.time);
+            writeValue(file, keyframe.position.x);
+            writeValue(file, keyframe.position.y);
+            writeValue(file, keyframe.position.z);
+            writeValue(file, keyframe.yaw);
+            writeValue(file, keyframe.pitch);
+            writeValue(file, keyframe.zoom);
+        }
+
+        if (!file) {
+            throw std::runtime_error("failed to write camera path: " + path);
+        }
+    }
+
+    void CameraPath::load(const std::string& path) {
+        std::ifstream file{ path, std::ios::binary };
+        if (!file) {
+            throw std::runtime_error("failed to open camera path: " + path);
+        }
+
+        if (readValue<uint32_t>(file) != FILE_MAGIC || readValue<uint32_t>(file) != FILE_VERSION) {
+            throw std::runtime_error("not a camera path file: " + path);
+        }
+
+        uint32_t keyframeCount = readValue<uint32_t>(file);
+
+        // Read aside, so a rejected file leaves the path as it was
+        std::vector<CameraKeyframe> keyframes;
+
+        for (uint32_t i = 0; i < keyframeCount && file; i++) {
+            CameraKeyframe keyframe{};
+            keyframe.time = readValue<float>(file);
+            keyframe.position.x = readValue<float>(file);
+            keyframe.position.y = readValue<float>(file);
+            keyframe.position.z = readValue<float>(file);
+            keyframe.yaw = readValue<float>(file);
+            keyframe.pitch = readValue<float>(file);
+            keyframe.zoom = readValue<float>(file);
+
+            // The order addKeyframe() enforces, sample() divides by the time between two keyframes
+            if (file && !keyframes.empty() && !(keyframe.time > keyframes.back().time)) {
+                throw std::runtime_error("camera path keyframes are not in increasing time: " + path);
+            }
+
+            keyframes.push_back(keyframe);
+        }
+
+        if (!file) {
+            throw std::runtime_error("camera path file is truncated: " + path);
+        }
+
+        this->keyframes = std::move(keyframes);
+    }
+
+    CameraKeyframe CameraPath::sample(float time) {
+        if (this->keyframes.empty()) {
+            throw std::runtime_error("cannot sample an empty camera path");
+        }
+
+        if (time <= this->keyframes.front().time) {
+            return this->keyframes.front();
+        }
+
+        if (time >= this->keyframes.back().time) {
+            return this->keyframes.back();
+        }
+
+        // First keyframe after the time, the segment runs from the one before it
+        auto next = std::upper_bound(this->keyframes.begin(), this->keyframes.end(), time, [](float t, const CameraKeyframe &keyframe) {
+            return t < keyframe.time;
+        });
+
+        size_t i2 = static_cast<size_t>(next - this->keyframes.begin());
+        size_t i1 = i2 - 1;
+        size_t i0 = i1 > 0 ? i1 - 1 : i1;
+        size_t i3 = std::min(i2 + 1, this->keyframes.size() - 1);
+
+        const CameraKeyframe &k0 = this->keyframes[i0];
+        const CameraKeyframe &k1 = this->keyframes[i1];
+        const CameraKeyframe &k2 = this->keyframes[i2];
+        const CameraKeyframe &k3 = this->keyframes[i3];
+
+        float s = (time - k1.time) / (k2.time - k1.time);
+        auto spline = [&](float p0, float p1, float p2, float p3) {
+            return interpolate(p0, p1, p2, p3, k0.time, k1.time, k2.time, k3.time, s);
+        };
+
+        CameraKeyframe result{};
+        result.time = time;
+        result.position.x = spline(k0.position.x, k1.position.x, k2.position.x, k3.position.x);
+        result.position.y = spline(k0.position.y, k1.position.y, k2.position.y, k3.position.y);
+        result.position.z = spline(k0.position.z, k1.position.z, k2.position.z, k3.position.z);
+        result.yaw = spline(k0.yaw, k1.yaw, k2.yaw, k3.yaw);
+        result.pitch = std::clamp(spline(k0.pitch, k1.pitch, k2.pitch, k3.pitch), -89.0f, 89.0f);
+        result.zoom = spline(k0.zoom, k1.zoom, k2.zoom, k3.zoom);
+
+        return result;
+    }
+
+    // ================================ Camera Recorder ================================
+
+    CameraRecorder::CameraRecorder(float interval)
+    : interval{interval}
+    {
+
+    }
+
+    void CameraRecorder::record(Camera *camera, float time) {
+        if (this->startTime < 0.0f) {
+            this->startTime = time;
+        }
+
+        float pathTime = time - this->startTime;
+        if (pathTime < this->nextTime) {
+            return;
+        }
+
+        CameraKeyframe keyframe{};
+        keyframe.time = pathTime;
+        keyframe.position = camera->position;
+        keyframe.yaw = camera->yaw;
+        keyframe.pitch = camera->pitch;
+        keyframe.zoom = camera->zoom;
+
+        this->path.addKeyframe(keyframe);
+        this->nextTime = pathTime + this->interval;
+    }
+
+    // ================================ Camera Player ================================
+
+    CameraPlayer::CameraPlayer(CameraPath path, float timestep)
+    : path{std::move(path)},
+      timestep{timestep}
+    {
+
+    }
+
+    bool CameraPlayer::step(Camera *camera) {
+        // Derived from the frame index rather than accumulated, so no rounding drifts in over long runs
+        this->time = static_cast<float>(static_cast<double>(this->frameIndex) * this->timestep);
+        if (this->path.getKeyframeCount() == 0 || this->time > this->path.getDuration()) {
+            return false;
+        }
+
+        CameraKeyframe keyframe = this->path.sample(this->time);
+        camera->setPose(keyframe.position, keyframe.yaw, keyframe.pitch, keyframe.zoom);
+
+        this->frameIndex++;
+        return true;
+    }
+}
@@ -0,0 +1,85 @@
+#ifndef NUGIE_CAMERA_PATH_HPP
+#define NUGIE_CAMERA_PATH_HPP
+
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "../camera.hpp"
+
+namespace nugie {
+    struct CameraKeyframe {
+        float time;
+        glm::vec3 position;
+        float yaw;
+        float pitch;
+        float zoom;
+    };
+
+    // A timed sequence of camera poses, stored in a compact binary file and sampled with a
+    // Catmull-Rom spline, so captures see the same views on every run
+    class CameraPath {
+    public:
+        // Keyframes must be added in increasing time
+        void addKeyframe(const CameraKeyframe &keyframe);
+
+        void clear() { this->keyframes.clear(); }
+
+        // Both throw when the file cannot be written or is not a camera path, load() also when its keyframes
+        // are not in increasing time, and leaves the path as it was
+        void save(const std::string& path);
+        void load(const std::string& path);
+
+        // Pose at any time, clamped to the first and last keyframes
+        CameraKeyframe sample(float time);
+
+        size_t getKeyframeCount() { return this->keyframes.size(); }
+
+        float getDuration() { return this->keyframes.empty() ? 0.0f : this->keyframes.back().time; }
+
+    private:
+        static constexpr uint32_t FILE_MAGIC = 0x4D41434E; // "NCAM"
+        static constexpr uint32_t FILE_VERSION = 1;
+
+        std::vector<CameraKeyframe> keyframes;
+    };
+
+    // Samples the live camera at a fixed interval, the spline fills in between on playback
+    class CameraRecorder {
+    public:
+        CameraRecorder(float interval = 0.1f);
+
+        void record(Camera *camera, float time);
+
+        CameraPath& getPath() { return this->path; }
+
+    private:
+        CameraPath path;
+        float interval;
+        float startTime = -1.0f;
+        float nextTime = 0.0f;
+    };
+
+    // Steps a path with a fixed timestep, independent of how long frames actually take
+    class CameraPlayer {
+    public:
+        CameraPlayer(CameraPath path, float timestep);
+
+        // Places the camera at the current time and advances it, returns false once the path has ended
+        bool step(Camera *camera);
+
+        float getTime() { return this->time; }
+
+        float getTimestep() { return this->timestep; }
+
+        uint64_t getFrameIndex() { return this->frameIndex; }
+
+    private:
+        CameraPath path;
+        float timestep;
+        float time = 0.0f;
+        uint64_t frameIndex = 0;
+    };
+}
+
+#endif
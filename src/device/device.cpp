@@ -3,10 +3,23 @@
 
 #include "device.hpp"
 #include <iostream>
+#include <algorithm>
+
+#ifdef WEBGPU_BACKEND_WGPU
+    #include <webgpu/wgpu.h>
+#endif // WEBGPU_BACKEND_WGPU
 
 namespace nugie {
-    Device::Device(const char* appTitle, int width, int height) {
-        this->initialize(appTitle, width, height);
+    Device::Device(const char* appTitle, int width, int height, wgpu::PresentMode presentMode, bool headless) {
+        this->initialize(appTitle, width, height, presentMode, headless);
+    }
+
+    Device::Device(DeviceBackend backend, int width, int height) : backend{backend} {
+        if (backend == DeviceBackend::Null) {
+            this->initializeNull(width, height);
+        } else {
+            this->initialize("Nugie", width, height, wgpu::PresentMode::Fifo, false);
+        }
     }
 
     Device::~Device() {
@@ -14,6 +27,15 @@ namespace nugie {
     }
 
     wgpu::TextureView Device::getNextSurfaceTextureView() {
+        if (this->isNull()) {
+            return this->createDummyHandle<WGPUTextureView>(LoggedCommand::CreateTextureView);
+        }
+
+        // A headless device has no surface to take a texture from
+        if (this->headless) {
+            return nullptr;
+        }
+
         // Get the next target texture view
         wgpu::SurfaceTexture surfaceTexture;
         this->surface.getCurrentTexture(&surfaceTexture);
@@ -45,47 +67,107 @@ namespace nugie {
         return targetView;
     }
 
+    void Device::enableBufferMirror() {
+        if (this->isNull() && !this->bufferMirror) {
+            this->bufferMirror = std::make_unique<BufferMirror>();
+        }
+    }
+
     wgpu::Buffer Device::createBuffer(wgpu::BufferDescriptor desc) {
-        return this->device.createBuffer(desc);
+        wgpu::Buffer buffer = this->isNull()
+            ? wgpu::Buffer{ this->createDummyHandle<WGPUBuffer>(LoggedCommand::CreateBuffer, desc.size) }
+            : this->device.createBuffer(desc);
+        this->memoryTracker.trackBuffer(buffer, desc);
+
+        return buffer;
     }
 
     wgpu::Texture Device::createTexture(wgpu::TextureDescriptor desc) {
-        return this->device.createTexture(desc);
+        wgpu::Texture texture = this->isNull()
+            ? wgpu::Texture{ this->createDummyHandle<WGPUTexture>(LoggedCommand::CreateTexture) }
+            : this->device.createTexture(desc);
+        this->memoryTracker.trackTexture(texture, desc);
+
+        return texture;
+    }
+
+    wgpu::QuerySet Device::createQuerySet(wgpu::QuerySetDescriptor desc) {
+        if (this->isNull()) {
+            return this->createDummyHandle<WGPUQuerySet>(LoggedCommand::CreateQuerySet);
+        }
+
+        return this->device.createQuerySet(desc);
     }
 
     wgpu::Sampler Device::createSampler(wgpu::SamplerDescriptor desc) {
+        if (this->isNull()) {
+            return this->createDummyHandle<WGPUSampler>(LoggedCommand::CreateSampler);
+        }
+
         return this->device.createSampler(desc);
     }
 
     wgpu::BindGroupLayout Device::createBindGroupLayout(wgpu::BindGroupLayoutDescriptor desc) {
+        if (this->isNull()) {
+            return this->createDummyHandle<WGPUBindGroupLayout>(LoggedCommand::CreateBindGroupLayout);
+        }
+
         return this->device.createBindGroupLayout(desc);
     }
 
     wgpu::PipelineLayout Device::createPipelineLayout(wgpu::PipelineLayoutDescriptor desc) {
+        if (this->isNull()) {
+            return this->createDummyHandle<WGPUPipelineLayout>(LoggedCommand::CreatePipelineLayout);
+        }
+
         return this->device.createPipelineLayout(desc);
     }
 
     wgpu::BindGroup Device::createBindGroup(wgpu::BindGroupDescriptor desc) {
+        if (this->isNull()) {
+            return this->createDummyHandle<WGPUBindGroup>(LoggedCommand::CreateBindGroup);
+        }
+
         return this->device.createBindGroup(desc);
     }
 
     wgpu::ShaderModule Device::createShaderModule(wgpu::ShaderModuleDescriptor desc) {
+        if (this->isNull()) {
+            return this->createDummyHandle<WGPUShaderModule>(LoggedCommand::CreateShaderModule);
+        }
+
         return this->device.createShaderModule(desc);
     }
 
     wgpu::RenderPipeline Device::createRenderPipeline(wgpu::RenderPipelineDescriptor desc) {
+        if (this->isNull()) {
+            return this->createDummyHandle<WGPURenderPipeline>(LoggedCommand::CreateRenderPipeline);
+        }
+
         return this->device.createRenderPipeline(desc);
     }
 
     wgpu::ComputePipeline Device::createComputePipeline(wgpu::ComputePipelineDescriptor desc) {
+        if (this->isNull()) {
+            return this->createDummyHandle<WGPUComputePipeline>(LoggedCommand::CreateComputePipeline);
+        }
+
         return this->device.createComputePipeline(desc);
     }
 
     wgpu::CommandEncoder Device::createCommandEncoder(wgpu::CommandEncoderDescriptor desc) {
+        if (this->isNull()) {
+            return this->createDummyHandle<WGPUCommandEncoder>(LoggedCommand::CreateCommandEncoder);
+        }
+
         return this->device.createCommandEncoder(desc);
     }
 
     wgpu::RenderBundleEncoder Device::createRenderBundleEncoder(wgpu::RenderBundleEncoderDescriptor desc) {
+        if (this->isNull()) {
+            return this->createDummyHandle<WGPURenderBundleEncoder>(LoggedCommand::CreateRenderBundleEncoder);
+        }
+
         return this->device.createRenderBundleEncoder(desc);
     }
 
@@ -93,7 +175,71 @@ namespace nugie {
         return new MasterBuffer(this, desc);
     }
 
-    bool Device::initialize(const char* appTitle, int width, int height) {
+    void Device::writeBuffer(wgpu::Buffer buffer, uint64_t offset, const void *data, size_t size) {
+        if (this->isNull()) {
+            this->commandLog.record(LoggedCommand::WriteBuffer, size);
+
+            if (this->bufferMirror) {
+                this->bufferMirror->write(buffer, offset, data, size);
+            }
+
+            return;
+        }
+
+        this->queue.writeBuffer(buffer, offset, data, size);
+    }
+
+    void Device::writeTexture(const wgpu::ImageCopyTexture &destination, const void *data, size_t size, const wgpu::TextureDataLayout &dataLayout, const wgpu::Extent3D &writeSize) {
+        if (this->isNull()) {
+            this->commandLog.record(LoggedCommand::WriteTexture, size);
+            return;
+        }
+
+        this->queue.writeTexture(destination, data, size, dataLayout, writeSize);
+    }
+
+    void Device::submit(size_t commandCount, const wgpu::CommandBuffer *commands) {
+        if (this->isNull()) {
+            this->commandLog.record(LoggedCommand::Submit);
+            return;
+        }
+
+        this->queue.submit(commandCount, commands);
+    }
+
+    void Device::releaseBuffer(wgpu::Buffer buffer) {
+        if (buffer == nullptr) {
+            return;
+        }
+
+        this->memoryTracker.untrack(buffer);
+
+        if (this->isNull()) {
+            this->commandLog.record(LoggedCommand::ReleaseBuffer);
+
+            if (this->bufferMirror) {
+                this->bufferMirror->release(buffer);
+            }
+        } else {
+            buffer.release();
+        }
+    }
+
+    void Device::releaseTexture(wgpu::Texture texture) {
+        if (texture == nullptr) {
+            return;
+        }
+
+        this->memoryTracker.untrack(texture);
+
+        if (this->isNull()) {
+            this->commandLog.record(LoggedCommand::ReleaseTexture);
+        } else {
+            texture.release();
+        }
+    }
+
+    bool Device::initialize(const char* appTitle, int width, int height, wgpu::PresentMode presentMode, bool headless) {
         // We create a descriptor
         wgpu::InstanceDescriptor instanceDesc = {};
         instanceDesc.nextInChain = nullptr;
@@ -107,14 +253,30 @@ namespace nugie {
             return false;
         }
 
+        // No compatible surface is asked for, offscreen rendering works on any adapter
         wgpu::RequestAdapterOptions adapterOpts = {};
         adapterOpts.nextInChain = nullptr;
+        adapterOpts.compatibleSurface = nullptr;
         this->adapter = this->instance.requestAdapter(adapterOpts);
 
         wgpu::DeviceDescriptor deviceDesc = {};
         deviceDesc.nextInChain = nullptr;
         deviceDesc.label = "This Device"; // anything works here, that's your call
-        deviceDesc.requiredFeatureCount = 0; // we do not require any specific feature
+        // Timestamp queries are optional, GPU timing is simply unavailable without them
+        WGPUFeatureName requiredFeatures[1] { wgpu::FeatureName::TimestampQuery };
+        this->timestampQuerySupported = this->adapter.hasFeature(wgpu::FeatureName::TimestampQuery);
+
+        deviceDesc.requiredFeatureCount = this->timestampQuerySupported ? 1 : 0;
+        deviceDesc.requiredFeatures = requiredFeatures;
+        // The device gets what the adapter supports rather than the defaults, the uniform offset alignment above all
+        wgpu::SupportedLimits supportedLimits{};
+        this->adapter.getLimits(&supportedLimits);
+
+        wgpu::RequiredLimits requiredLimits{};
+        requiredLimits.nextInChain = nullptr;
+        requiredLimits.limits = supportedLimits.limits;
+        deviceDesc.requiredLimits = &requiredLimits;
+
         deviceDesc.defaultQueue.nextInChain = nullptr;
         deviceDesc.defaultQueue.label = "This queue";
 
@@ -128,6 +290,7 @@ namespace nugie {
 
         this->device = this->adapter.requestDevice(deviceDesc);
         this->queue = this->device.getQueue();
+        this->minUniformBufferOffsetAlignment = supportedLimits.limits.minUniformBufferOffsetAlignment;
 
         auto onDeviceError = [](wgpu::ErrorType type, char const* message) {
             std::cout << "Uncaptured device error: type " << type;
@@ -137,15 +300,37 @@ namespace nugie {
 
         uncapturedErrorCallbackHandle = this->device.setUncapturedErrorCallback(onDeviceError);
 
+        // Without GLFW there is nothing to present to, the offscreen targets take the format and size instead
+        if (headless) {
+            this->headless = true;
+            this->presentMode = presentMode;
+
+            this->surfaceFormat = wgpu::TextureFormat::RGBA8Unorm;
+            this->surfaceConfig = {};
+            this->surfaceConfig.format = this->surfaceFormat;
+            this->surfaceConfig.width = static_cast<uint32_t>(width);
+            this->surfaceConfig.height = static_cast<uint32_t>(height);
+
+            this->maxWidth = this->surfaceConfig.width;
+            this->maxHeight = this->surfaceConfig.height;
+
+            return true;
+        }
+
         if (!glfwInit()) {
             std::cerr << "Could not initialize GLFW!" << std::endl;
             return false;
         }
 
         glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API); // <-- extra info for glfwCreateWindow
-        glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+        glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
 
         this->window = glfwCreateWindow(width, height, appTitle, nullptr, nullptr);
+
+        // The window can never get larger than the monitor, so render targets sized for it never reallocate
+        const GLFWvidmode *videoMode = glfwGetVideoMode(glfwGetPrimaryMonitor());
+        this->maxWidth = std::max(static_cast<uint32_t>(width), videoMode != nullptr ? static_cast<uint32_t>(videoMode->width) : 0u);
+        this->maxHeight = std::max(static_cast<uint32_t>(height), videoMode != nullptr ? static_cast<uint32_t>(videoMode->height) : 0u);
         glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 
         // Get the surface
@@ -156,28 +341,62 @@ namespace nugie {
 
         this->surfaceFormat = surfaceCapability.formats[0];
 
-        wgpu::SurfaceConfiguration config = {};
-        config.nextInChain = nullptr;
-        config.width = width;
-        config.height = height;
-        config.format = this->surfaceFormat;
-        config.viewFormatCount = 0;
-        config.viewFormats = nullptr;
-        config.usage = wgpu::TextureUsage::RenderAttachment;
-        config.device = this->device;
-        config.presentMode = wgpu::PresentMode::Fifo;
-        config.alphaMode = surfaceCapability.alphaModes[0];
+        // Fifo is the only mode every surface has to support, so it is the fallback
+        this->presentMode = wgpu::PresentMode::Fifo;
+        for (size_t i = 0; i < surfaceCapability.presentModeCount; i++) {
+            if (surfaceCapability.presentModes[i] == presentMode) {
+                this->presentMode = presentMode;
+            }
+        }
+
+        if (this->presentMode != presentMode) {
+            std::cerr << "Present mode " << presentMode << " is not supported, falling back to Fifo" << std::endl;
+        }
 
-        this->surface.configure(config);
+        this->surfaceConfig = {};
+        this->surfaceConfig.nextInChain = nullptr;
+        this->surfaceConfig.width = width;
+        this->surfaceConfig.height = height;
+        this->surfaceConfig.format = this->surfaceFormat;
+        this->surfaceConfig.viewFormatCount = 0;
+        this->surfaceConfig.viewFormats = nullptr;
+        this->surfaceConfig.usage = wgpu::TextureUsage::RenderAttachment;
+        this->surfaceConfig.device = this->device;
+        this->surfaceConfig.presentMode = this->presentMode;
+        this->surfaceConfig.alphaMode = surfaceCapability.alphaModes[0];
+
+        this->surface.configure(this->surfaceConfig);
 
         return true;
     }
 
+    void Device::initializeNull(int width, int height) {
+        this->surfaceFormat = wgpu::TextureFormat::BGRA8Unorm;
+        this->surfaceConfig.format = this->surfaceFormat;
+        this->surfaceConfig.width = static_cast<uint32_t>(width);
+        this->surfaceConfig.height = static_cast<uint32_t>(height);
+
+        this->maxWidth = this->surfaceConfig.width;
+        this->maxHeight = this->surfaceConfig.height;
+    }
+
     void Device::terminate() {
-        this->surface.unconfigure();
-        this->surface.release();
+        GpuMemoryStats leaked = this->memoryTracker.getTotalStats();
+        if (leaked.allocationCount > 0) {
+            std::cerr << leaked.allocationCount << " GPU resources (" << leaked.liveBytes << " bytes) were never released through the device:" << std::endl;
+            this->memoryTracker.dumpLive(std::cerr);
+        }
+
+        if (this->isNull()) {
+            return;
+        }
+
+        if (!this->headless) {
+            this->surface.unconfigure();
+            this->surface.release();
 
-        glfwDestroyWindow(window);
+            glfwDestroyWindow(window);
+        }
         
         this->queue.release();
         this->device.release();
@@ -186,10 +405,61 @@ namespace nugie {
     }    
 
     bool Device::isRunning() {
+        if (this->isNull() || this->headless) {
+            return true;
+        }
+
         return !glfwWindowShouldClose(this->window);
     }
     
-    void Device::poolEvents() {
-        glfwPollEvents();
+    void Device::poolEvents(double timeout) {
+        if (this->isNull() || this->headless) {
+            return;
+        }
+
+        if (timeout > 0.0) {
+            glfwWaitEventsTimeout(timeout);
+        } else {
+            glfwPollEvents();
+        }
+    }
+
+    bool Device::updateSurfaceSize() {
+        if (this->isNull() || this->headless) {
+            return false;
+        }
+
+        int width, height;
+        glfwGetFramebufferSize(this->window, &width, &height);
+
+        // A minimized window reports 0x0, which is not a valid surface size
+        if (width <= 0 || height <= 0) {
+            return false;
+        }
+
+        uint32_t newWidth = std::min(static_cast<uint32_t>(width), this->maxWidth);
+        uint32_t newHeight = std::min(static_cast<uint32_t>(height), this->maxHeight);
+
+        if (newWidth == this->surfaceConfig.width && newHeight == this->surfaceConfig.height) {
+            return false;
+        }
+
+        this->surfaceConfig.width = newWidth;
+        this->surfaceConfig.height = newHeight;
+        this->surface.configure(this->surfaceConfig);
+
+        return true;
+    }
+
+    void Device::processGpuEvents() {
+        if (this->isNull()) {
+            return;
+        }
+
+        #if defined(WEBGPU_BACKEND_DAWN)
+            this->device.tick();
+        #elif defined(WEBGPU_BACKEND_WGPU)
+            wgpuDevicePoll(this->device, false, nullptr);
+        #endif // WEBGPU_BACKEND_DAWN
     }
 }
\ No newline at end of file
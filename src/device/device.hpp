@@ -4,36 +4,96 @@
 #include <webgpu/webgpu.hpp>
 #include <GLFW/glfw3.h>
 #include <glfw3webgpu.h>
+#include <memory>
+#include <cstddef>
 
 #include "../buffer/master/master_buffer.hpp"
+#include "memory/memory_tracker.hpp"
+#include "null/command_log.hpp"
+#include "null/buffer_mirror.hpp"
 
 namespace nugie {
     class MasterBuffer;
+
+    enum class DeviceBackend {
+        WebGpu,
+
+        // Opens no window and never touches the GPU: creation returns dummy handles and uploads,
+        // submits and bundle draws are only counted in the command log. Dummy handles may be compared,
+        // hashed and tracked but never passed to wgpu, so only code that goes through the Device
+        // (buffers, DrawQueue, ParallelEncoder) runs on it. Used to measure CPU cost on its own, and
+        // with a buffer mirror to check what was uploaded.
+        Null
+    };
     
     class Device {
     public:
-        Device(const char* appTitle, int width, int height);
+        // A headless device opens no window and has no surface, for offline rendering into textures of its own.
+        // It needs no display server, and its surface format is the RGBA8Unorm those textures are made in.
+        Device(const char* appTitle, int width, int height, wgpu::PresentMode presentMode = wgpu::PresentMode::Fifo, bool headless = false);
+
+        // A WebGpu backend made this way is a visible window with the default title and present mode
+        Device(DeviceBackend backend, int width, int height);
 
         ~Device();
 
         // ================================ Getter Function ================================
 
+        // Null on a headless or null device
         GLFWwindow* getWindow() { return this->window; }
 
+        bool isHeadless() { return this->headless; }
+
         wgpu::Queue getQueue() { return this->queue; }
 
         wgpu::TextureFormat getSurfaceFormat() { return this->surfaceFormat; }
 
         wgpu::Surface getSurface() { return this->surface; }
 
+        // The mode actually in use, which is Fifo when the requested one is not supported
+        wgpu::PresentMode getPresentMode() { return this->presentMode; }
+
+        uint32_t getWidth() { return this->surfaceConfig.width; }
+
+        uint32_t getHeight() { return this->surfaceConfig.height; }
+
+        // Largest size the surface can be resized to
+        uint32_t getMaxWidth() { return this->maxWidth; }
+
+        uint32_t getMaxHeight() { return this->maxHeight; }
+
+        bool isTimestampQuerySupported() { return this->timestampQuerySupported; }
+
+        // Uniform bindings must start at a multiple of this, often finer than the 256 bytes WebGPU guarantees
+        uint32_t getMinUniformBufferOffsetAlignment() { return this->minUniformBufferOffsetAlignment; }
+
+        // Null when the surface has no texture to give, always on a headless device
         wgpu::TextureView getNextSurfaceTextureView();        
 
+        GpuMemoryTracker* getMemoryTracker() { return &this->memoryTracker; }
+
+        DeviceBackend getBackend() { return this->backend; }
+
+        bool isNull() { return this->backend == DeviceBackend::Null; }
+
+        // Only recorded into on a null device
+        CommandLog* getCommandLog() { return &this->commandLog; }
+
+        // Null until enableBufferMirror()
+        BufferMirror* getBufferMirror() { return this->bufferMirror.get(); }
+
+        // On a null device, applies every later buffer write to a CPU copy of the buffer as well.
+        // Off by default, since copying the data would be measured along with the code that uploads it.
+        void enableBufferMirror();
+
         // ================================ WebGPU Creation Function ================================
 
         wgpu::Buffer createBuffer(wgpu::BufferDescriptor desc);
 
         wgpu::Texture createTexture(wgpu::TextureDescriptor desc) ;
 
+        wgpu::QuerySet createQuerySet(wgpu::QuerySetDescriptor desc);
+
         wgpu::Sampler createSampler(wgpu::SamplerDescriptor desc);
 
         wgpu::BindGroupLayout createBindGroupLayout(wgpu::BindGroupLayoutDescriptor desc);
@@ -56,27 +116,75 @@ namespace nugie {
 
         MasterBuffer* createMasterBuffer(wgpu::BufferDescriptor desc);
 
+        // ================================ Queue Function ================================
+
+        // Queue work goes through here rather than getQueue(), so a null device can count it
+        void writeBuffer(wgpu::Buffer buffer, uint64_t offset, const void *data, size_t size);
+
+        void writeTexture(const wgpu::ImageCopyTexture &destination, const void *data, size_t size, const wgpu::TextureDataLayout &dataLayout, const wgpu::Extent3D &writeSize);
+
+        void submit(size_t commandCount, const wgpu::CommandBuffer *commands);
+
+        // ================================ Release Function ================================
+
+        // Buffers and textures released here leave the memory tracker, anything else is reported as leaked
+        void releaseBuffer(wgpu::Buffer buffer);
+
+        void releaseTexture(wgpu::Texture texture);
+
         // ================================ Lifecycle Function ================================
 
-        bool initialize(const char* appTitle, int width, int height);
+        bool initialize(const char* appTitle, int width, int height, wgpu::PresentMode presentMode, bool headless);
 
         void terminate();
 
         bool isRunning();
 
-        void poolEvents();
+        // Blocks for up to timeout seconds until an event arrives when a timeout is given, so an idle loop sleeps
+        void poolEvents(double timeout = 0.0);
+
+        // Reconfigures the surface when the framebuffer size changed, and returns whether it did
+        bool updateSurfaceSize();
+
+        // Fires the callbacks of finished GPU work (onSubmittedWorkDone, mapAsync) without blocking
+        void processGpuEvents();
 
     private:
+        DeviceBackend backend = DeviceBackend::WebGpu;
+
         wgpu::Instance instance;
         wgpu::Adapter adapter;
         wgpu::Device device;
         wgpu::Queue queue;
         wgpu::Surface surface;
 
-        GLFWwindow *window;
+        GLFWwindow *window = nullptr;
+        bool headless = false;
         wgpu::TextureFormat surfaceFormat = wgpu::TextureFormat::Undefined;
+        wgpu::PresentMode presentMode = wgpu::PresentMode::Fifo;
+        wgpu::SurfaceConfiguration surfaceConfig;
+
+        uint32_t maxWidth = 0;
+        uint32_t maxHeight = 0;
+        bool timestampQuerySupported = false;
+        uint32_t minUniformBufferOffsetAlignment = 256;
 
         std::unique_ptr<wgpu::ErrorCallback> uncapturedErrorCallbackHandle;
+
+        GpuMemoryTracker memoryTracker;
+
+        CommandLog commandLog;
+        std::unique_ptr<BufferMirror> bufferMirror;
+        std::atomic<uintptr_t> nextDummyHandle{ 1 };
+
+        // Distinct, never dereferenced, and aligned like a real allocation
+        template<typename Native>
+        Native createDummyHandle(LoggedCommand command, uint64_t bytes = 0) {
+            this->commandLog.record(command, bytes);
+            return reinterpret_cast<Native>(this->nextDummyHandle.fetch_add(1, std::memory_order_relaxed) * alignof(std::max_align_t));
+        }
+
+        void initializeNull(int width, int height);
     };
 }
 
@@ -0,0 +1,234 @@
+#include "memory_tracker.hpp"
+
+#include <algorithm>
+
+namespace nugie {
+    // ================================ Tracking Function ================================
+
+    void GpuMemoryTracker::trackBuffer(WGPUBuffer buffer, const wgpu::BufferDescriptor &desc) {
+        if (buffer == nullptr) {
+            return;
+        }
+
+        this->add(buffer, Allocation{ desc.label != nullptr ? desc.label : "Unnamed Buffer", getBufferCategory(desc.usage), desc.size });
+    }
+
+    void GpuMemoryTracker::trackTexture(WGPUTexture texture, const wgpu::TextureDescriptor &desc) {
+        if (texture == nullptr) {
+            return;
+        }
+
+        this->add(texture, Allocation{ desc.label != nullptr ? desc.label : "Unnamed Texture", getTextureCategory(desc.usage), getTextureSize(desc) });
+    }
+
+    void GpuMemoryTracker::untrack(void *handle) {
+        std::lock_guard<std::mutex> lock{ this->mutex };
+
+        auto found = this->allocations.find(handle);
+        if (found == this->allocations.end()) {
+            return;
+        }
+
+        GpuMemoryStats &categoryStats = this->categoryStats[static_cast<size_t>(found->second.category)];
+        categoryStats.liveBytes -= found->second.size;
+        categoryStats.allocationCount--;
+
+        this->totalStats.liveBytes -= found->second.size;
+        this->totalStats.allocationCount--;
+
+        if (this->totalStats.liveBytes <= this->budgetBytes) {
+            this->overBudget = false;
+        }
+
+        this->allocations.erase(found);
+    }
+
+    void GpuMemoryTracker::trackMasterBuffer(const MasterBuffer *master, const char* label, uint64_t capacityBytes) {
+        std::lock_guard<std::mutex> lock{ this->mutex };
+        this->masterBuffers[master] = MasterBufferOccupancy{ label != nullptr ? label : "Unnamed Master Buffer", 0, capacityBytes };
+    }
+
+    void GpuMemoryTracker::updateMasterBuffer(const MasterBuffer *master, uint64_t usedBytes) {
+        std::lock_guard<std::mutex> lock{ this->mutex };
+
+        auto found = this->masterBuffers.find(master);
+        if (found != this->masterBuffers.end()) {
+            found->second.usedBytes = usedBytes;
+        }
+    }
+
+    void GpuMemoryTracker::untrackMasterBuffer(const MasterBuffer *master) {
+        std::lock_guard<std::mutex> lock{ this->mutex };
+        this->masterBuffers.erase(master);
+    }
+
+    // ================================ Budget Function ================================
+
+    void GpuMemoryTracker::setBudget(uint64_t budgetBytes, BudgetCallback callback) {
+        std::lock_guard<std::mutex> lock{ this->mutex };
+
+        this->budgetBytes = budgetBytes;
+        this->budgetCallback = std::move(callback);
+        this->overBudget = false;
+    }
+
+    uint64_t GpuMemoryTracker::getBudget() {
+        std::lock_guard<std::mutex> lock{ this->mutex };
+        return this->budgetBytes;
+    }
+
+    bool GpuMemoryTracker::isOverBudget() {
+        std::lock_guard<std::mutex> lock{ this->mutex };
+        return this->overBudget;
+    }
+
+    // ================================ Getter Function ================================
+
+    GpuMemoryStats GpuMemoryTracker::getTotalStats() {
+        std::lock_guard<std::mutex> lock{ this->mutex };
+        return this->totalStats;
+    }
+
+    GpuMemoryStats GpuMemoryTracker::getStats(GpuMemoryCategory category) {
+        std::lock_guard<std::mutex> lock{ this->mutex };
+        return this->categoryStats[static_cast<size_t>(category)];
+    }
+
+    std::vector<MasterBufferOccupancy> GpuMemoryTracker::getMasterBufferOccupancy() {
+        std::lock_guard<std::mutex> lock{ this->mutex };
+
+        std::vector<MasterBufferOccupancy> occupancy;
+        for (auto &&master : this->masterBuffers) {
+            occupancy.push_back(master.second);
+        }
+
+        return occupancy;
+    }
+
+    size_t GpuMemoryTracker::dumpLive(std::ostream &stream) {
+        std::lock_guard<std::mutex> lock{ this->mutex };
+
+        // Largest first, those are the leaks worth chasing
+        std::vector<const Allocation*> sorted;
+        for (auto &&allocation : this->allocations) {
+            sorted.push_back(&allocation.second);
+        }
+
+        std::sort(sorted.begin(), sorted.end(), [](const Allocation *a, const Allocation *b) {
+            return a->size > b->size;
+        });
+
+        for (auto &&allocation : sorted) {
+            stream << "  " << allocation->label << " (" << getCategoryName(allocation->category) << "): " << allocation->size << " bytes" << std::endl;
+        }
+
+        return sorted.size();
+    }
+
+    const char* GpuMemoryTracker::getCategoryName(GpuMemoryCategory category) {
+        switch (category) {
+            case GpuMemoryCategory::VertexBuffer: return "Vertex Buffer";
+            case GpuMemoryCategory::IndexBuffer: return "Index Buffer";
+            case GpuMemoryCategory::UniformBuffer: return "Uniform Buffer";
+            case GpuMemoryCategory::StorageBuffer: return "Storage Buffer";
+            case GpuMemoryCategory::IndirectBuffer: return "Indirect Buffer";
+            case GpuMemoryCategory::ReadbackBuffer: return "Readback Buffer";
+            case GpuMemoryCategory::UploadBuffer: return "Upload Buffer";
+            case GpuMemoryCategory::QueryBuffer: return "Query Buffer";
+            case GpuMemoryCategory::OtherBuffer: return "Other Buffer";
+            case GpuMemoryCategory::RenderTarget: return "Render Target";
+            case GpuMemoryCategory::StorageTexture: return "Storage Texture";
+            case GpuMemoryCategory::SampledTexture: return "Sampled Texture";
+            default: return "Unknown";
+        }
+    }
+
+    void GpuMemoryTracker::add(void *handle, Allocation allocation) {
+        BudgetCallback callback;
+        uint64_t liveBytes = 0;
+        uint64_t budgetBytes = 0;
+
+        {
+            std::lock_guard<std::mutex> lock{ this->mutex };
+
+            GpuMemoryStats &categoryStats = this->categoryStats[static_cast<size_t>(allocation.category)];
+            categoryStats.liveBytes += allocation.size;
+            categoryStats.highWaterBytes = std::max(categoryStats.highWaterBytes, categoryStats.liveBytes);
+            categoryStats.allocationCount++;
+
+            this->totalStats.liveBytes += allocation.size;
+            this->totalStats.highWaterBytes = std::max(this->totalStats.highWaterBytes, this->totalStats.liveBytes);
+            this->totalStats.allocationCount++;
+
+            this->allocations[handle] = std::move(allocation);
+
+            if (this->budgetBytes > 0 && !this->overBudget && this->totalStats.liveBytes > this->budgetBytes) {
+                this->overBudget = true;
+
+                callback = this->budgetCallback;
+                liveBytes = this->totalStats.liveBytes;
+                budgetBytes = this->budgetBytes;
+            }
+        }
+
+        // Called without the lock, so the callback can release resources to get back under budget
+        if (callback) {
+            callback(liveBytes, budgetBytes);
+        }
+    }
+
+    GpuMemoryCategory GpuMemoryTracker::getBufferCategory(WGPUBufferUsageFlags usage) {
+        // The first match wins, a storage buffer that is also read indirectly counts as indirect
+        if (usage & WGPUBufferUsage_MapRead) return GpuMemoryCategory::ReadbackBuffer;
+        if (usage & WGPUBufferUsage_MapWrite) return GpuMemoryCategory::UploadBuffer;
+        if (usage & WGPUBufferUsage_QueryResolve) return GpuMemoryCategory::QueryBuffer;
+        if (usage & WGPUBufferUsage_Indirect) return GpuMemoryCategory::IndirectBuffer;
+        if (usage & WGPUBufferUsage_Vertex) return GpuMemoryCategory::VertexBuffer;
+        if (usage & WGPUBufferUsage_Index) return GpuMemoryCategory::IndexBuffer;
+        if (usage & WGPUBufferUsage_Uniform) return GpuMemoryCategory::UniformBuffer;
+        if (usage & WGPUBufferUsage_Storage) return GpuMemoryCategory::StorageBuffer;
+
+        return GpuMemoryCategory::OtherBuffer;
+    }
+
+    GpuMemoryCategory GpuMemoryTracker::getTextureCategory(WGPUTextureUsageFlags usage) {
+        if (usage & WGPUTextureUsage_RenderAttachment) return GpuMemoryCategory::RenderTarget;
+        if (usage & WGPUTextureUsage_StorageBinding) return GpuMemoryCategory::StorageTexture;
+
+        return GpuMemoryCategory::SampledTexture;
+    }
+
+    uint64_t GpuMemoryTracker::getTextureSize(const wgpu::TextureDescriptor &desc) {
+        uint64_t size = 0;
+
+        for (uint32_t level = 0; level < std::max(desc.mipLevelCount, 1u); level++) {
+            uint64_t width = std::max(desc.size.width >> level, 1u);
+            uint64_t height = std::max(desc.size.height >> level, 1u);
+            uint64_t depth = desc.dimension == wgpu::TextureDimension::_3D ? std::max(desc.size.depthOrArrayLayers >> level, 1u) : desc.size.depthOrArrayLayers;
+
+            size += width * height * depth;
+        }
+
+        return size * getBytesPerPixel(desc.format) * std::max(desc.sampleCount, 1u);
+    }
+
+    uint32_t GpuMemoryTracker::getBytesPerPixel(wgpu::TextureFormat format) {
+        if (format == wgpu::TextureFormat::R8Unorm) {
+            return 1;
+        }
+
+        if (format == wgpu::TextureFormat::Depth16Unorm || format == wgpu::TextureFormat::R16Float || format == wgpu::TextureFormat::RG8Unorm) {
+            return 2;
+        }
+
+        if (format == wgpu::TextureFormat::RGBA16Float || format == wgpu::TextureFormat::RG32Float) {
+            return 8;
+        }
+
+        if (format == wgpu::TextureFormat::RGBA32Float) {
+            return 16;
+        }
+
+        return 4;
+    }
+}
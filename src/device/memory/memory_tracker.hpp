@@ -0,0 +1,123 @@
+#ifndef NUGIE_MEMORY_TRACKER_HPP
+#define NUGIE_MEMORY_TRACKER_HPP
+
+#include <mutex>
+#include <string>
+#include <vector>
+#include <ostream>
+#include <functional>
+#include <unordered_map>
+#include <webgpu/webgpu.hpp>
+
+namespace nugie {
+    class MasterBuffer;
+
+    enum class GpuMemoryCategory : uint32_t {
+        VertexBuffer,
+        IndexBuffer,
+        UniformBuffer,
+        StorageBuffer,
+        IndirectBuffer,
+        ReadbackBuffer,
+        UploadBuffer,
+        QueryBuffer,
+        OtherBuffer,
+        RenderTarget,
+        StorageTexture,
+        SampledTexture,
+        Count
+    };
+
+    struct GpuMemoryStats {
+        uint64_t liveBytes = 0;
+        uint64_t highWaterBytes = 0;
+        uint32_t allocationCount = 0;
+    };
+
+    // Suballocated and total bytes of one MasterBuffer
+    struct MasterBufferOccupancy {
+        std::string label;
+        uint64_t usedBytes;
+        uint64_t capacityBytes;
+    };
+
+    // Records every buffer and texture the Device creates, by label, usage and size.
+    //
+    // WebGPU has no way to ask how much memory is in use, so the sizes are what the descriptors
+    // ask for. Resources have to be released through the Device for the totals to go down,
+    // whatever is still recorded at the end is reported as a leak.
+    class GpuMemoryTracker {
+    public:
+        using BudgetCallback = std::function<void(uint64_t liveBytes, uint64_t budgetBytes)>;
+
+        // ================================ Tracking Function ================================
+
+        void trackBuffer(WGPUBuffer buffer, const wgpu::BufferDescriptor &desc);
+
+        void trackTexture(WGPUTexture texture, const wgpu::TextureDescriptor &desc);
+
+        // Unknown handles are ignored, so releasing twice is harmless
+        void untrack(void *handle);
+
+        void trackMasterBuffer(const MasterBuffer *master, const char* label, uint64_t capacityBytes);
+
+        void updateMasterBuffer(const MasterBuffer *master, uint64_t usedBytes);
+
+        void untrackMasterBuffer(const MasterBuffer *master);
+
+        // ================================ Budget Function ================================
+
+        // The callback fires once every time the live total goes from within the budget to above it,
+        // a budget of zero disables it
+        void setBudget(uint64_t budgetBytes, BudgetCallback callback);
+
+        uint64_t getBudget();
+
+        // Set from the callback until the live total is back within the budget
+        bool isOverBudget();
+
+        // ================================ Getter Function ================================
+
+        GpuMemoryStats getTotalStats();
+
+        GpuMemoryStats getStats(GpuMemoryCategory category);
+
+        std::vector<MasterBufferOccupancy> getMasterBufferOccupancy();
+
+        // Writes every allocation still live and returns how many there were
+        size_t dumpLive(std::ostream &stream);
+
+        static const char* getCategoryName(GpuMemoryCategory category);
+
+    private:
+        struct Allocation {
+            std::string label;
+            GpuMemoryCategory category;
+            uint64_t size;
+        };
+
+        std::mutex mutex;
+
+        std::unordered_map<void*, Allocation> allocations;
+        std::unordered_map<const MasterBuffer*, MasterBufferOccupancy> masterBuffers;
+
+        GpuMemoryStats totalStats;
+        GpuMemoryStats categoryStats[static_cast<size_t>(GpuMemoryCategory::Count)];
+
+        uint64_t budgetBytes = 0;
+        bool overBudget = false;
+        BudgetCallback budgetCallback;
+
+        void add(void *handle, Allocation allocation);
+
+        static GpuMemoryCategory getBufferCategory(WGPUBufferUsageFlags usage);
+
+        static GpuMemoryCategory getTextureCategory(WGPUTextureUsageFlags usage);
+
+        static uint64_t getTextureSize(const wgpu::TextureDescriptor &desc);
+
+        static uint32_t getBytesPerPixel(wgpu::TextureFormat format);
+    };
+}
+
+#endif
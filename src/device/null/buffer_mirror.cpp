@@ -0,0 +1,35 @@
+#include "buffer_mirror.hpp"
+
+#include <cstring>
+#include <algorithm>
+
+namespace nugie {
+    void BufferMirror::write(const void *buffer, uint64_t offset, const void *data, uint64_t size) {
+        std::lock_guard<std::mutex> lock{ this->mutex };
+        std::vector<uint8_t> &bytes = this->contents[buffer];
+
+        if (bytes.size() < offset + size) {
+            bytes.resize(offset + size, 0);
+        }
+
+        std::memcpy(bytes.data() + offset, data, size);
+    }
+
+    std::vector<uint8_t> BufferMirror::read(const void *buffer, uint64_t offset, uint64_t size) {
+        std::lock_guard<std::mutex> lock{ this->mutex };
+        std::vector<uint8_t> result(size, 0);
+
+        auto entry = this->contents.find(buffer);
+        if (entry != this->contents.end() && offset < entry->second.size()) {
+            uint64_t available = std::min<uint64_t>(size, entry->second.size() - offset);
+            std::memcpy(result.data(), entry->second.data() + offset, available);
+        }
+
+        return result;
+    }
+
+    void BufferMirror::release(const void *buffer) {
+        std::lock_guard<std::mutex> lock{ this->mutex };
+        this->contents.erase(buffer);
+    }
+}
@@ -0,0 +1,28 @@
+#ifndef NUGIE_BUFFER_MIRROR_HPP
+#define NUGIE_BUFFER_MIRROR_HPP
+
+#include <mutex>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+
+namespace nugie {
+    // CPU copies of a null device's buffers, with every queue write applied in the order it was made.
+    // Lets a test compare what ended up in a buffer against what it expected, rather than only counting bytes.
+    // A buffer's copy starts out zeroed and grows to the furthest byte written.
+    class BufferMirror {
+    public:
+        void write(const void *buffer, uint64_t offset, const void *data, uint64_t size);
+
+        // Zeros where nothing was written
+        std::vector<uint8_t> read(const void *buffer, uint64_t offset, uint64_t size);
+
+        void release(const void *buffer);
+
+    private:
+        std::mutex mutex;
+        std::unordered_map<const void*, std::vector<uint8_t>> contents;
+    };
+}
+
+#endif
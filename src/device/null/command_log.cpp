@@ -0,0 +1,96 @@
+#include "command_log.hpp"
+
+namespace nugie {
+    void CommandLog::record(LoggedCommand command, uint64_t bytes) {
+        this->counts[static_cast<size_t>(command)].fetch_add(1, std::memory_order_relaxed);
+
+        if (bytes > 0) {
+            this->bytes[static_cast<size_t>(command)].fetch_add(bytes, std::memory_order_relaxed);
+        }
+    }
+
+    void CommandLog::merge(const CommandCounts &counts, const CommandCounts *bytes) {
+        for (size_t i = 0; i < counts.size(); i++) {
+            if (counts[i] > 0) {
+                this->counts[i].fetch_add(counts[i], std::memory_order_relaxed);
+            }
+
+            if (bytes != nullptr && (*bytes)[i] > 0) {
+                this->bytes[i].fetch_add((*bytes)[i], std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void CommandLog::reset() {
+        for (size_t i = 0; i < static_cast<size_t>(LoggedCommand::Count); i++) {
+            this->counts[i].store(0, std::memory_order_relaxed);
+            this->bytes[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    uint64_t CommandLog::getTotalCount() {
+        uint64_t total = 0;
+        for (size_t i = 0; i < static_cast<size_t>(LoggedCommand::Count); i++) {
+            total += this->counts[i].load(std::memory_order_relaxed);
+        }
+
+        return total;
+    }
+
+    uint64_t CommandLog::getStateChanges() {
+        return this->getCount(LoggedCommand::SetPipeline) + this->getCount(LoggedCommand::SetBindGroup)
+            + this->getCount(LoggedCommand::SetVertexBuffer) + this->getCount(LoggedCommand::SetIndexBuffer);
+    }
+
+    void CommandLog::print(std::ostream &stream) {
+        for (size_t i = 0; i < static_cast<size_t>(LoggedCommand::Count); i++) {
+            LoggedCommand command = static_cast<LoggedCommand>(i);
+            uint64_t count = this->getCount(command);
+
+            if (count == 0) {
+                continue;
+            }
+
+            stream << "  " << getCommandName(command) << ": " << count;
+
+            uint64_t bytes = this->getBytes(command);
+            if (bytes > 0) {
+                stream << " (" << bytes << " bytes)";
+            }
+
+            stream << std::endl;
+        }
+    }
+
+    const char* CommandLog::getCommandName(LoggedCommand command) {
+        switch (command) {
+            case LoggedCommand::CreateBuffer: return "create buffer";
+            case LoggedCommand::CreateTexture: return "create texture";
+            case LoggedCommand::CreateTextureView: return "create texture view";
+            case LoggedCommand::CreateQuerySet: return "create query set";
+            case LoggedCommand::CreateSampler: return "create sampler";
+            case LoggedCommand::CreateBindGroupLayout: return "create bind group layout";
+            case LoggedCommand::CreatePipelineLayout: return "create pipeline layout";
+            case LoggedCommand::CreateBindGroup: return "create bind group";
+            case LoggedCommand::CreateShaderModule: return "create shader module";
+            case LoggedCommand::CreateRenderPipeline: return "create render pipeline";
+            case LoggedCommand::CreateComputePipeline: return "create compute pipeline";
+            case LoggedCommand::CreateCommandEncoder: return "create command encoder";
+            case LoggedCommand::CreateRenderBundleEncoder: return "create render bundle encoder";
+            case LoggedCommand::ReleaseBuffer: return "release buffer";
+            case LoggedCommand::ReleaseTexture: return "release texture";
+            case LoggedCommand::WriteBuffer: return "write buffer";
+            case LoggedCommand::WriteTexture: return "write texture";
+            case LoggedCommand::Submit: return "submit";
+            case LoggedCommand::SetPipeline: return "set pipeline";
+            case LoggedCommand::SetBindGroup: return "set bind group";
+            case LoggedCommand::SetVertexBuffer: return "set vertex buffer";
+            case LoggedCommand::SetIndexBuffer: return "set index buffer";
+            case LoggedCommand::DrawIndexed: return "draw indexed";
+            case LoggedCommand::DrawIndexedIndirect: return "draw indexed indirect";
+            case LoggedCommand::FinishBundle: return "finish bundle";
+            case LoggedCommand::ExecuteBundles: return "execute bundles";
+            default: return "unknown";
+        }
+    }
+}
@@ -0,0 +1,79 @@
+#ifndef NUGIE_COMMAND_LOG_HPP
+#define NUGIE_COMMAND_LOG_HPP
+
+#include <array>
+#include <atomic>
+#include <ostream>
+
+namespace nugie {
+    enum class LoggedCommand : uint32_t {
+        CreateBuffer,
+        CreateTexture,
+        CreateTextureView,
+        CreateQuerySet,
+        CreateSampler,
+        CreateBindGroupLayout,
+        CreatePipelineLayout,
+        CreateBindGroup,
+        CreateShaderModule,
+        CreateRenderPipeline,
+        CreateComputePipeline,
+        CreateCommandEncoder,
+        CreateRenderBundleEncoder,
+        ReleaseBuffer,
+        ReleaseTexture,
+        WriteBuffer,
+        WriteTexture,
+        Submit,
+        SetPipeline,
+        SetBindGroup,
+        SetVertexBuffer,
+        SetIndexBuffer,
+        DrawIndexed,
+        DrawIndexedIndirect,
+        FinishBundle,
+        ExecuteBundles,
+        Count
+    };
+
+    using CommandCounts = std::array<uint64_t, static_cast<size_t>(LoggedCommand::Count)>;
+
+    // What a null device was asked to do, as a count and a byte total per command.
+    //
+    // Nothing is kept per call, so the log stays the same size however long it records.
+    // Counters are atomic and may be recorded from any thread, hot loops should count
+    // locally and merge() once instead (see NullBundleEncoder).
+    class CommandLog {
+    public:
+        void record(LoggedCommand command, uint64_t bytes = 0);
+
+        // Adds counts gathered elsewhere, bytes may be null
+        void merge(const CommandCounts &counts, const CommandCounts *bytes = nullptr);
+
+        void reset();
+
+        // ================================ Getter Function ================================
+
+        uint64_t getCount(LoggedCommand command) { return this->counts[static_cast<size_t>(command)].load(std::memory_order_relaxed); }
+
+        uint64_t getBytes(LoggedCommand command) { return this->bytes[static_cast<size_t>(command)].load(std::memory_order_relaxed); }
+
+        uint64_t getTotalCount();
+
+        // Pipeline, bind group, vertex and index buffer bindings
+        uint64_t getStateChanges();
+
+        uint64_t getDrawCount() { return this->getCount(LoggedCommand::DrawIndexed) + this->getCount(LoggedCommand::DrawIndexedIndirect); }
+
+        // Writes every command that was recorded at least once
+        void print(std::ostream &stream);
+
+        static const char* getCommandName(LoggedCommand command);
+
+    private:
+        std::atomic<uint64_t> counts[static_cast<size_t>(LoggedCommand::Count)] = {};
+        std::atomic<uint64_t> bytes[static_cast<size_t>(LoggedCommand::Count)] = {};
+    };
+}
+
+#endif
@@ -0,0 +1,40 @@
+#include "null_bundle_encoder.hpp"
+
+namespace nugie {
+    NullBundleEncoder::NullBundleEncoder(CommandLog *commandLog)
+    : commandLog{commandLog}
+    {
+
+    }
+
+    void NullBundleEncoder::setPipeline(wgpu::RenderPipeline /* pipeline */) {
+        this->count(LoggedCommand::SetPipeline);
+    }
+
+    void NullBundleEncoder::setBindGroup(uint32_t /* groupIndex */, wgpu::BindGroup /* group */, size_t /* dynamicOffsetCount */, const uint32_t* /* dynamicOffsets */) {
+        this->count(LoggedCommand::SetBindGroup);
+    }
+
+    void NullBundleEncoder::setVertexBuffer(uint32_t /* slot */, wgpu::Buffer /* buffer */, uint64_t /* offset */, uint64_t /* size */) {
+        this->count(LoggedCommand::SetVertexBuffer);
+    }
+
+    void NullBundleEncoder::setIndexBuffer(wgpu::Buffer /* buffer */, wgpu::IndexFormat /* format */, uint64_t /* offset */, uint64_t /* size */) {
+        this->count(LoggedCommand::SetIndexBuffer);
+    }
+
+    void NullBundleEncoder::drawIndexed(uint32_t /* indexCount */, uint32_t /* instanceCount */, uint32_t /* firstIndex */, int32_t /* baseVertex */, uint32_t /* firstInstance */) {
+        this->count(LoggedCommand::DrawIndexed);
+    }
+
+    void NullBundleEncoder::drawIndexedIndirect(wgpu::Buffer /* indirectBuffer */, uint64_t /* indirectOffset */) {
+        this->count(LoggedCommand::DrawIndexedIndirect);
+    }
+
+    void NullBundleEncoder::finish() {
+        this->count(LoggedCommand::FinishBundle);
+
+        this->commandLog->merge(this->counts);
+        this->counts.fill(0);
+    }
+}
@@ -0,0 +1,38 @@
+#ifndef NUGIE_NULL_BUNDLE_ENCODER_HPP
+#define NUGIE_NULL_BUNDLE_ENCODER_HPP
+
+#include <webgpu/webgpu.hpp>
+
+#include "command_log.hpp"
+
+namespace nugie {
+    // Stands in for wgpu::RenderBundleEncoder on a null device, with the same calls used to record draws.
+    // Counts stay local to the encoder until finish(), so encoders on different threads never share a cache line.
+    class NullBundleEncoder {
+    public:
+        NullBundleEncoder(CommandLog *commandLog);
+
+        void setPipeline(wgpu::RenderPipeline pipeline);
+
+        void setBindGroup(uint32_t groupIndex, wgpu::BindGroup group, size_t dynamicOffsetCount, const uint32_t *dynamicOffsets);
+
+        void setVertexBuffer(uint32_t slot, wgpu::Buffer buffer, uint64_t offset, uint64_t size);
+
+        void setIndexBuffer(wgpu::Buffer buffer, wgpu::IndexFormat format, uint64_t offset, uint64_t size);
+
+        void drawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t baseVertex, uint32_t firstInstance);
+
+        void drawIndexedIndirect(wgpu::Buffer indirectBuffer, uint64_t indirectOffset);
+
+        // Merges the counts into the log and starts over
+        void finish();
+
+    private:
+        CommandLog *commandLog;
+        CommandCounts counts{};
+
+        void count(LoggedCommand command) { this->counts[static_cast<size_t>(command)]++; }
+    };
+}
+
+#endif
@@ -0,0 +1,301 @@
+#include "upload_queue.hpp"
+#include "../device.hpp"
+
+#include <string>
+#include <cstring>
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+
+namespace nugie {
+    namespace {
+        std::atomic<uint64_t> nextQueueId{1};
+
+        // The staging a thread last enqueued to, ids are never reused so a destroyed queue cannot be mistaken for a new one
+        struct ProducerCache {
+            uint64_t queueId = 0;
+            uint32_t index = 0;
+        };
+
+        thread_local ProducerCache producerCache;
+
+        const void* getDestination(const wgpu::Buffer &buffer) {
+            return buffer;
+        }
+    }
+
+    UploadQueue::UploadQueue(nugie::Device *device, uint32_t capacity, uint64_t stagingBytesPerThread)
+    : device{device},
+      id{nextQueueId.fetch_add(1, std::memory_order_relaxed)},
+      capacity{capacity},
+      mask{capacity - 1u},
+      slots{new Slot[capacity]},
+      stagingBytes{stagingBytesPerThread}
+    {
+        if (capacity == 0 || (capacity & (capacity - 1)) != 0) {
+            throw std::runtime_error("upload queue capacity must be a power of two");
+        }
+
+        for (uint64_t i = 0; i < this->capacity; i++) {
+            this->slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        this->bufferRequests.reserve(capacity);
+    }
+
+    bool UploadQueue::enqueueBuffer(wgpu::Buffer buffer, uint64_t offset, const void *data, uint64_t size) {
+        if (offset % 4 != 0 || size % 4 != 0) {
+            throw std::runtime_error("queued buffer writes must start and end on a multiple of 4 bytes");
+        }
+
+        UploadRequest request{};
+        request.kind = UploadKind::Buffer;
+        request.size = size;
+        request.buffer = buffer;
+        request.offset = offset;
+
+        return this->enqueue(request, data);
+    }
+
+    bool UploadQueue::enqueueTexture(const wgpu::ImageCopyTexture &destination, const void *data, uint64_t size, const wgpu::TextureDataLayout &dataLayout, const wgpu::Extent3D &writeSize) {
+        UploadRequest request{};
+        request.kind = UploadKind::Texture;
+        request.size = size;
+        request.texture = destination;
+        request.dataLayout = dataLayout;
+        request.writeSize = writeSize;
+
+        return this->enqueue(request, data);
+    }
+
+    bool UploadQueue::hasPending() {
+        const Slot &slot = this->slots[this->dequeuePosition & this->mask];
+        return slot.sequence.load(std::memory_order_acquire) == this->dequeuePosition + 1;
+    }
+
+    UploadQueueStats UploadQueue::getStats() {
+        UploadQueueStats stats = this->stats;
+        stats.rejectedCount = this->rejectedCount.load(std::memory_order_relaxed);
+        stats.producerCount = this->producerCount.load(std::memory_order_acquire);
+
+        return stats;
+    }
+
+    UploadQueue::Producer* UploadQueue::getProducer(uint32_t &index) {
+        if (producerCache.queueId == this->id) {
+            index = producerCache.index;
+            return this->producers[index].get();
+        }
+
+        // Once per thread, or again after the thread enqueued to another queue
+        std::lock_guard<std::mutex> lock{ this->producerMutex };
+
+        std::thread::id owner = std::this_thread::get_id();
+        uint32_t count = this->producerCount.load(std::memory_order_relaxed);
+
+        index = count;
+        for (uint32_t i = 0; i < count; i++) {
+            if (this->producers[i]->owner == owner) {
+                index = i;
+                break;
+            }
+        }
+
+        if (index == count) {
+            if (count == MAX_PRODUCERS) {
+                throw std::runtime_error("more than " + std::to_string(MAX_PRODUCERS) + " threads enqueued uploads");
+            }
+
+            auto producer = std::make_unique<Producer>();
+            producer->owner = owner;
+            producer->memory = std::make_unique<uint8_t[]>(this->stagingBytes);
+
+            this->producers[count] = std::move(producer);
+            this->producerCount.store(count + 1, std::memory_order_release);
+        }
+
+        producerCache = ProducerCache{ this->id, index };
+        return this->producers[index].get();
+    }
+
+    bool UploadQueue::enqueue(UploadRequest &request, const void *data) {
+        if (request.size == 0) {
+            return true;
+        }
+
+        if (request.size > this->stagingBytes) {
+            throw std::runtime_error("upload of " + std::to_string(request.size) + " bytes is larger than the "
+                + std::to_string(this->stagingBytes) + " bytes of staging a thread has");
+        }
+
+        uint32_t index = 0;
+        Producer *producer = this->getProducer(index);
+
+        // Requests point at one contiguous copy, so one that does not fit before the end of the ring skips to its start
+        uint64_t head = producer->head;
+        uint64_t position = head % this->stagingBytes;
+
+        if (position + request.size > this->stagingBytes) {
+            head += this->stagingBytes - position;
+        }
+
+        uint64_t end = head + request.size;
+        if (end - producer->consumed.load(std::memory_order_acquire) > this->stagingBytes) {
+            this->rejectedCount.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        uint8_t *staging = producer->memory.get() + head % this->stagingBytes;
+        std::memcpy(staging, data, request.size);
+
+        request.producer = index;
+        request.data = staging;
+        request.stagingEnd = end;
+
+        uint64_t queuePosition = this->enqueuePosition.load(std::memory_order_relaxed);
+        Slot *slot = nullptr;
+
+        while (true) {
+            slot = &this->slots[queuePosition & this->mask];
+            uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+            int64_t difference = static_cast<int64_t>(sequence) - static_cast<int64_t>(queuePosition);
+
+            if (difference == 0) {
+                if (this->enqueuePosition.compare_exchange_weak(queuePosition, queuePosition + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (difference < 0) {
+                // The slot still holds a request from a lap ago that was not drained yet. The staging copy
+                // is left where it is, it sits past head and is overwritten by the next enqueue.
+                this->rejectedCount.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            } else {
+                queuePosition = this->enqueuePosition.load(std::memory_order_relaxed);
+            }
+        }
+
+        request.sequence = queuePosition;
+        slot->request = request;
+        slot->sequence.store(queuePosition + 1, std::memory_order_release);
+
+        producer->head = end;
+        return true;
+    }
+
+    void UploadQueue::drain() {
+        this->stats = UploadQueueStats{};
+        this->bufferRequests.clear();
+
+        // Stops at the first slot not published yet, even if later ones are, so every producer's requests stay in order
+        while (true) {
+            Slot &slot = this->slots[this->dequeuePosition & this->mask];
+            if (slot.sequence.load(std::memory_order_acquire) != this->dequeuePosition + 1) {
+                break;
+            }
+
+            // The slot is free again once the request is copied out, the staging it points at stays taken until written
+            UploadRequest request = slot.request;
+            slot.sequence.store(this->dequeuePosition + this->capacity, std::memory_order_release);
+
+            if (request.kind == UploadKind::Texture) {
+                this->device->writeTexture(request.texture, request.data, request.size, request.dataLayout, request.writeSize);
+
+                this->stats.textureWriteCount++;
+                this->stats.uploadedBytes += request.size;
+            } else {
+                this->bufferRequests.push_back(request);
+            }
+
+            this->releasedEnds[request.producer] = request.stagingEnd;
+            this->stats.requestCount++;
+            this->dequeuePosition++;
+
+            // Producers that keep up with the drain would otherwise keep it going forever
+            if (this->stats.requestCount == this->capacity) {
+                break;
+            }
+        }
+
+        this->writeBuffers();
+
+        uint32_t producerCount = this->producerCount.load(std::memory_order_acquire);
+        for (uint32_t i = 0; i < producerCount; i++) {
+            if (this->releasedEnds[i] != 0) {
+                this->producers[i]->consumed.store(this->releasedEnds[i], std::memory_order_release);
+                this->releasedEnds[i] = 0;
+            }
+        }
+    }
+
+    void UploadQueue::writeBuffers() {
+        std::less<const void*> before;
+
+        std::sort(this->bufferRequests.begin(), this->bufferRequests.end(), [&before](const UploadRequest &a, const UploadRequest &b) {
+            const void *bufferA = getDestination(a.buffer);
+            const void *bufferB = getDestination(b.buffer);
+
+            if (bufferA != bufferB) {
+                return before(bufferA, bufferB);
+            }
+
+            return a.offset != b.offset ? a.offset < b.offset : a.sequence < b.sequence;
+        });
+
+        auto groupBegin = this->bufferRequests.begin();
+        while (groupBegin != this->bufferRequests.end()) {
+            const void *buffer = getDestination(groupBegin->buffer);
+            auto groupEnd = std::find_if(groupBegin, this->bufferRequests.end(), [buffer](const UploadRequest &request) {
+                return getDestination(request.buffer) != buffer;
+            });
+
+            // Disjoint writes may go in any order, overlapping ones must land as they were enqueued
+            uint64_t coveredEnd = 0;
+            for (auto request = groupBegin; request != groupEnd; request++) {
+                if (request->offset < coveredEnd) {
+                    std::sort(groupBegin, groupEnd, [](const UploadRequest &a, const UploadRequest &b) {
+                        return a.sequence < b.sequence;
+                    });
+
+                    break;
+                }
+
+                coveredEnd = std::max(coveredEnd, request->offset + request->size);
+            }
+
+            // Each run of requests where one starts where the last ended becomes a single write
+            auto runBegin = groupBegin;
+            while (runBegin != groupEnd) {
+                auto runEnd = runBegin + 1;
+                uint64_t end = runBegin->offset + runBegin->size;
+
+                while (runEnd != groupEnd && runEnd->offset == end) {
+                    end += runEnd->size;
+                    runEnd++;
+                }
+
+                uint64_t size = end - runBegin->offset;
+
+                if (runEnd - runBegin == 1) {
+                    this->device->writeBuffer(runBegin->buffer, runBegin->offset, runBegin->data, size);
+                } else {
+                    if (this->batchStaging.size() < size) {
+                        this->batchStaging.resize(size);
+                    }
+
+                    for (auto request = runBegin; request != runEnd; request++) {
+                        std::memcpy(this->batchStaging.data() + (request->offset - runBegin->offset), request->data, request->size);
+                    }
+
+                    this->device->writeBuffer(runBegin->buffer, runBegin->offset, this->batchStaging.data(), size);
+                }
+
+                this->stats.bufferWriteCount++;
+                this->stats.uploadedBytes += size;
+
+                runBegin = runEnd;
+            }
+
+            groupBegin = groupEnd;
+        }
+    }
+}
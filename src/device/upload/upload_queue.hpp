@@ -0,0 +1,140 @@
+#ifndef NUGIE_UPLOAD_QUEUE_HPP
+#define NUGIE_UPLOAD_QUEUE_HPP
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <webgpu/webgpu.hpp>
+
+namespace nugie {
+    class Device;
+
+    struct UploadQueueStats {
+        // Of the last drain()
+        uint32_t requestCount = 0;
+        uint32_t bufferWriteCount = 0;
+        uint32_t textureWriteCount = 0;
+        uint64_t uploadedBytes = 0;
+
+        // Since creation, enqueues that found the queue or their thread's staging full
+        uint64_t rejectedCount = 0;
+
+        uint32_t producerCount = 0;
+    };
+
+    // Lets any thread queue buffer and texture writes for the one thread that drains them into the device queue.
+    //
+    // A producer copies its data into staging memory of its own, a ring only its thread allocates from, and
+    // pushes a request pointing there onto a bounded lock-free queue (Vyukov's MPMC ring, drained by a single
+    // consumer). Neither step takes a lock, only a thread's first enqueue does to find its staging.
+    //
+    // drain() takes every published request once per frame. Buffer writes are sorted by destination and those
+    // that cover contiguous bytes of the same buffer go up as one queue write, in the order they were enqueued
+    // wherever two overlap. Staging is handed back to its producer once its requests are written.
+    class UploadQueue {
+    public:
+        // capacity must be a power of two
+        UploadQueue(nugie::Device *device, uint32_t capacity = DEFAULT_CAPACITY, uint64_t stagingBytesPerThread = DEFAULT_STAGING_BYTES);
+
+        // Returns false when the queue or the calling thread's staging is full, the caller may retry after the next drain.
+        // Throws std::runtime_error for a write that is not 4 byte aligned, larger than the staging, or from more threads than MAX_PRODUCERS.
+        bool enqueueBuffer(wgpu::Buffer buffer, uint64_t offset, const void *data, uint64_t size);
+
+        bool enqueueTexture(const wgpu::ImageCopyTexture &destination, const void *data, uint64_t size, const wgpu::TextureDataLayout &dataLayout, const wgpu::Extent3D &writeSize);
+
+        // From one thread at a time, once per frame before the frame's commands are submitted.
+        // Requests enqueued while it runs may be left for the next drain.
+        void drain();
+
+        // Whether the last drain() wrote anything
+        bool hasUploaded() { return this->stats.requestCount > 0; }
+
+        // Whether the next drain() has anything to write, from the draining thread
+        bool hasPending();
+
+        UploadQueueStats getStats();
+
+    private:
+        static constexpr uint32_t DEFAULT_CAPACITY = 4096;
+        static constexpr uint64_t DEFAULT_STAGING_BYTES = 1024 * 1024;
+        static constexpr uint32_t MAX_PRODUCERS = 64;
+
+        enum class UploadKind : uint32_t {
+            Buffer,
+            Texture
+        };
+
+        struct UploadRequest {
+            UploadKind kind;
+            uint32_t producer;
+
+            // Position in the queue, the order overlapping writes are applied in
+            uint64_t sequence;
+
+            const uint8_t *data;
+            uint64_t size;
+
+            // Where the producer's staging may be reused from once this request is written
+            uint64_t stagingEnd;
+
+            wgpu::Buffer buffer;
+            uint64_t offset;
+
+            wgpu::ImageCopyTexture texture;
+            wgpu::TextureDataLayout dataLayout;
+            wgpu::Extent3D writeSize;
+        };
+
+        struct Slot {
+            std::atomic<uint64_t> sequence;
+            UploadRequest request;
+        };
+
+        // The staging ring of one thread. head only moves on the producer, consumed only on the consumer.
+        struct Producer {
+            std::thread::id owner;
+            std::unique_ptr<uint8_t[]> memory;
+
+            alignas(64) uint64_t head = 0;
+            alignas(64) std::atomic<uint64_t> consumed{0};
+        };
+
+        nugie::Device *device;
+        uint64_t id;
+
+        uint64_t capacity;
+        uint64_t mask;
+        std::unique_ptr<Slot[]> slots;
+
+        alignas(64) std::atomic<uint64_t> enqueuePosition{0};
+        alignas(64) uint64_t dequeuePosition = 0;
+
+        uint64_t stagingBytes;
+        std::unique_ptr<Producer> producers[MAX_PRODUCERS];
+        std::atomic<uint32_t> producerCount{0};
+        std::mutex producerMutex;
+
+        std::atomic<uint64_t> rejectedCount{0};
+
+        // The consumer's, reused by every drain so it stops allocating once grown
+        std::vector<UploadRequest> bufferRequests;
+        std::vector<uint8_t> batchStaging;
+
+        // Per producer, the staging end of its last drained request, or zero
+        uint64_t releasedEnds[MAX_PRODUCERS] = {};
+
+        UploadQueueStats stats;
+
+        Producer* getProducer(uint32_t &index);
+
+        // Copies the data into the calling thread's staging and publishes the request, the staging is only taken once it is
+        bool enqueue(UploadRequest &request, const void *data);
+
+        void writeBuffers();
+    };
+}
+
+#endif
@@ -0,0 +1,25 @@
+#include "frame_arena.hpp"
+
+#include <algorithm>
+
+namespace nugie {
+    FrameArena::FrameArena(uint32_t framesInFlight, size_t capacity) {
+        for (uint32_t i = 0; i < framesInFlight; i++) {
+            this->arenas.push_back(std::make_unique<LinearArena>(capacity));
+        }
+    }
+
+    void FrameArena::beginFrame(uint32_t frameSlot) {
+        this->currentSlot = frameSlot;
+        this->arenas[frameSlot]->reset();
+    }
+
+    size_t FrameArena::getHighWaterMark() {
+        size_t highWaterMark = 0;
+        for (auto &&arena : this->arenas) {
+            highWaterMark = std::max(highWaterMark, arena->getHighWaterMark());
+        }
+
+        return highWaterMark;
+    }
+}
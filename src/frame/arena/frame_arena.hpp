@@ -0,0 +1,32 @@
+#ifndef NUGIE_FRAME_ARENA_HPP
+#define NUGIE_FRAME_ARENA_HPP
+
+#include <memory>
+#include <vector>
+
+#include "../../memory/arena/linear_arena.hpp"
+
+namespace nugie {
+    // One linear arena per frame in flight. A frame slot's arena is reset when the slot is reused,
+    // so per-frame data stays valid while the frames after it are being built.
+    class FrameArena {
+    public:
+        FrameArena(uint32_t framesInFlight, size_t capacity);
+
+        LinearArena* getArena(uint32_t frameSlot) { return this->arenas[frameSlot].get(); }
+
+        LinearArena* getCurrent() { return this->arenas[this->currentSlot].get(); }
+
+        // Frees everything the slot allocated the last time it was used, call it after FrameSync::beginFrame
+        void beginFrame(uint32_t frameSlot);
+
+        // Largest amount any slot needed in one frame
+        size_t getHighWaterMark();
+
+    private:
+        std::vector<std::unique_ptr<LinearArena>> arenas;
+        uint32_t currentSlot = 0;
+    };
+}
+
+#endif
@@ -0,0 +1,90 @@
+#include "deletion_queue.hpp"
+
+#include <vector>
+
+namespace nugie {
+    DeletionQueue::DeletionQueue(nugie::Device *device, nugie::FrameSync *frameSync)
+    : device{device},
+      frameSync{frameSync}
+    {
+
+    }
+
+    DeletionQueue::~DeletionQueue() {
+        this->flush();
+    }
+
+    // ================================ Release Function ================================
+
+    void DeletionQueue::release(wgpu::Buffer buffer) {
+        if (buffer != nullptr) {
+            this->defer([device = this->device, buffer] { device->releaseBuffer(buffer); });
+        }
+    }
+
+    void DeletionQueue::release(wgpu::Texture texture) {
+        if (texture != nullptr) {
+            this->defer([device = this->device, texture] { device->releaseTexture(texture); });
+        }
+    }
+
+    void DeletionQueue::release(wgpu::TextureView textureView) {
+        if (textureView != nullptr) {
+            this->defer([textureView] () mutable { textureView.release(); });
+        }
+    }
+
+    void DeletionQueue::release(wgpu::BindGroup bindGroup) {
+        if (bindGroup != nullptr) {
+            this->defer([bindGroup] () mutable { bindGroup.release(); });
+        }
+    }
+
+    void DeletionQueue::release(ChildBuffer childBuffer) {
+        this->defer([childBuffer] () mutable { childBuffer.getMasterBuffer()->releaseChildBuffer(childBuffer); });
+    }
+
+    void DeletionQueue::defer(std::function<void()> function) {
+        std::lock_guard<std::mutex> lock{ this->mutex };
+        this->entries.push_back(Entry{ this->frameSync->getFrameIndex(), std::move(function) });
+    }
+
+    // ================================ Lifecycle Function ================================
+
+    void DeletionQueue::collect() {
+        uint64_t completedFrameIndex = this->frameSync->getCompletedFrameIndex();
+        std::vector<std::function<void()>> ready;
+
+        {
+            std::lock_guard<std::mutex> lock{ this->mutex };
+
+            // Entries are pushed in frame order, so the completed ones are all at the front
+            while (!this->entries.empty() && this->entries.front().frameIndex < completedFrameIndex) {
+                ready.push_back(std::move(this->entries.front().function));
+                this->entries.pop_front();
+            }
+        }
+
+        for (auto &&function : ready) {
+            function();
+        }
+    }
+
+    void DeletionQueue::flush() {
+        std::deque<Entry> remaining;
+
+        {
+            std::lock_guard<std::mutex> lock{ this->mutex };
+            remaining.swap(this->entries);
+        }
+
+        for (auto &&entry : remaining) {
+            entry.function();
+        }
+    }
+
+    size_t DeletionQueue::getPendingCount() {
+        std::lock_guard<std::mutex> lock{ this->mutex };
+        return this->entries.size();
+    }
+}
@@ -0,0 +1,64 @@
+#ifndef NUGIE_DELETION_QUEUE_HPP
+#define NUGIE_DELETION_QUEUE_HPP
+
+#include <deque>
+#include <mutex>
+#include <functional>
+
+#include "../../device/device.hpp"
+#include "../../buffer/child/child_buffer.hpp"
+#include "../sync/frame_sync.hpp"
+
+namespace nugie {
+    class Device;
+    class FrameSync;
+
+    // Holds on to resources dropped while the GPU may still use them. Each one is tagged with the
+    // frame that dropped it and only released once FrameSync reports that frame as completed, so
+    // resources can be replaced mid-session without waiting for the whole device to go idle.
+    class DeletionQueue {
+    public:
+        DeletionQueue(nugie::Device *device, nugie::FrameSync *frameSync);
+        ~DeletionQueue();
+
+        // ================================ Release Function ================================
+
+        void release(wgpu::Buffer buffer);
+
+        void release(wgpu::Texture texture);
+
+        void release(wgpu::TextureView textureView);
+
+        void release(wgpu::BindGroup bindGroup);
+
+        // The range goes back to its master buffer, to be handed out again
+        void release(ChildBuffer childBuffer);
+
+        // Anything else, the function runs once the GPU is done with the current frame
+        void defer(std::function<void()> function);
+
+        // ================================ Lifecycle Function ================================
+
+        // Releases everything whose frame has completed, call it once per frame after FrameSync::beginFrame
+        void collect();
+
+        // Releases everything, only valid once the GPU is idle
+        void flush();
+
+        size_t getPendingCount();
+
+    private:
+        struct Entry {
+            uint64_t frameIndex;
+            std::function<void()> function;
+        };
+
+        nugie::Device *device;
+        nugie::FrameSync *frameSync;
+
+        std::mutex mutex;
+        std::deque<Entry> entries;
+    };
+}
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef NUGIE_GPU_HANDLE_HPP
+#define NUGIE_GPU_HANDLE_HPP
+
+#include <optional>
+#include <utility>
+
+#include "deletion_queue.hpp"
+
+namespace nugie {
+    // Owns one GPU object and hands it to a DeletionQueue when it goes out of scope or is replaced,
+    // so dropping it never releases something a frame in flight still uses. Move only.
+    template<typename T>
+    class GpuHandle {
+    public:
+        GpuHandle() = default;
+
+        GpuHandle(T handle, DeletionQueue *deletionQueue)
+        : handle{std::move(handle)},
+          deletionQueue{deletionQueue}
+        {
+
+        }
+
+        ~GpuHandle() {
+            this->reset();
+        }
+
+        GpuHandle(const GpuHandle&) = delete;
+        GpuHandle& operator=(const GpuHandle&) = delete;
+
+        GpuHandle(GpuHandle &&other) noexcept
+        : handle{std::move(other.handle)},
+          deletionQueue{other.deletionQueue}
+        {
+            other.handle.reset();
+        }
+
+        GpuHandle& operator=(GpuHandle &&other) noexcept {
+            if (this != &other) {
+                this->reset();
+
+                this->handle = std::move(other.handle);
+                this->deletionQueue = other.deletionQueue;
+                other.handle.reset();
+            }
+
+            return *this;
+        }
+
+        T& get() { return *this->handle; }
+
+        T* operator->() { return &*this->handle; }
+
+        explicit operator bool() const { return this->handle.has_value(); }
+
+        // Queues the object for release, the handle is empty afterwards
+        void reset() {
+            if (this->handle.has_value()) {
+                this->deletionQueue->release(std::move(*this->handle));
+                this->handle.reset();
+            }
+        }
+
+        // Gives up ownership without releasing anything
+        T detach() {
+            T detached = std::move(*this->handle);
+            this->handle.reset();
+
+            return detached;
+        }
+
+    private:
+        std::optional<T> handle;
+        DeletionQueue *deletionQueue = nullptr;
+    };
+
+    using BufferHandle = GpuHandle<wgpu::Buffer>;
+    using TextureHandle = GpuHandle<wgpu::Texture>;
+    using TextureViewHandle = GpuHandle<wgpu::TextureView>;
+    using BindGroupHandle = GpuHandle<wgpu::BindGroup>;
+    using ChildBufferHandle = GpuHandle<ChildBuffer>;
+}
+
+#endif
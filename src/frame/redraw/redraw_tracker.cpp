@@ -0,0 +1,96 @@
+#include "redraw_tracker.hpp"
+
+namespace nugie {
+    RedrawTracker::RedrawTracker(uint32_t settleFrames)
+    : settleFrames{settleFrames}
+    {
+        // The first frame has nothing on screen to keep
+        this->markDirty(RedrawReason::Window);
+    }
+
+    void RedrawTracker::markDirty(RedrawReason reason) {
+        this->dirtyReasons.fetch_or(1u << static_cast<uint32_t>(reason), std::memory_order_release);
+    }
+
+    void RedrawTracker::trackCamera(nugie::Camera *camera) {
+        bool moved = !this->hasCameraPose || camera->position != this->cameraPosition || camera->front != this->cameraFront
+            || camera->zoom != this->cameraZoom;
+
+        if (moved) {
+            this->hasCameraPose = true;
+            this->cameraPosition = camera->position;
+            this->cameraFront = camera->front;
+            this->cameraZoom = camera->zoom;
+
+            this->markDirty(RedrawReason::Camera);
+        }
+    }
+
+    double RedrawTracker::getWaitTimeout(double idleTimeout) {
+        if (this->remainingFrames > 0 || this->dirtyReasons.load(std::memory_order_acquire) != 0) {
+            return 0.0;
+        }
+
+        return idleTimeout;
+    }
+
+    bool RedrawTracker::beginFrame(bool force) {
+        uint32_t reasons = this->dirtyReasons.exchange(0, std::memory_order_acq_rel);
+
+        for (uint32_t i = 0; i < static_cast<uint32_t>(RedrawReason::Count); i++) {
+            if ((reasons & (1u << i)) != 0) {
+                this->stats.reasonFrames[i]++;
+            }
+        }
+
+        if (reasons != 0) {
+            this->remainingFrames = this->settleFrames + 1;
+        } else {
+            this->stats.unchangedFrames++;
+        }
+
+        if (this->remainingFrames == 0 && !force) {
+            return false;
+        }
+
+        if (this->remainingFrames > 0) {
+            this->remainingFrames--;
+        }
+
+        this->stats.drawnFrames++;
+        return true;
+    }
+
+    bool RedrawTracker::collectStats(double interval, RedrawStats &stats) {
+        Clock::time_point now = Clock::now();
+
+        double elapsed = std::chrono::duration<double>(now - this->statsStart).count();
+        if (elapsed < interval) {
+            return false;
+        }
+
+        std::clock_t cpuNow = std::clock();
+        double cpuSeconds = static_cast<double>(cpuNow - this->statsCpuStart) / CLOCKS_PER_SEC;
+
+        stats = this->stats;
+        stats.cpuUtilization = cpuSeconds / elapsed;
+        stats.gpuUtilization = this->statsGpuMs / 1000.0 / elapsed;
+
+        this->statsStart = now;
+        this->statsCpuStart = cpuNow;
+        this->statsGpuMs = 0.0;
+        this->stats = RedrawStats{};
+
+        return true;
+    }
+
+    const char* RedrawTracker::getReasonName(RedrawReason reason) {
+        switch (reason) {
+            case RedrawReason::Camera: return "camera";
+            case RedrawReason::Scene: return "scene";
+            case RedrawReason::Resources: return "resources";
+            case RedrawReason::Window: return "window";
+            default: return "unknown";
+        }
+    }
+}
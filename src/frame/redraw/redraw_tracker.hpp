@@ -0,0 +1,88 @@
+#ifndef NUGIE_REDRAW_TRACKER_HPP
+#define NUGIE_REDRAW_TRACKER_HPP
+
+#include <ctime>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+#include "../../camera/camera.hpp"
+
+namespace nugie {
+    class Camera;
+
+    // What can change the picture from one frame to the next
+    enum class RedrawReason : uint32_t {
+        Camera,
+        Scene,
+        Resources,
+        Window,
+        Count
+    };
+
+    struct RedrawStats {
+        uint32_t drawnFrames = 0;
+
+        // Frames where nothing changed, skipped when rendering on demand and drawn anyway otherwise
+        uint32_t unchangedFrames = 0;
+
+        // Frames each reason was marked in, a frame may count for several
+        uint32_t reasonFrames[static_cast<size_t>(RedrawReason::Count)] = {};
+
+        // Of the interval: the process's CPU time over one core, and the GPU time of the rendered frames
+        double cpuUtilization = 0.0;
+        double gpuUtilization = 0.0;
+    };
+
+    // Decides which frames need drawing when rendering on demand.
+    //
+    // Whatever changes the picture marks its reason dirty, and beginFrame() draws when any was. Drawing
+    // goes on for settleFrames frames after the last change, so state that lags the picture (occlusion
+    // history, GPU timings and readbacks that come back frames later) catches up before it goes idle.
+    class RedrawTracker {
+    public:
+        RedrawTracker(uint32_t settleFrames);
+
+        // Safe to call from any thread
+        void markDirty(RedrawReason reason);
+
+        // Marks the camera dirty when it moved, turned or zoomed since the last call
+        void trackCamera(nugie::Camera *camera);
+
+        // How long the loop may block waiting for events, zero while frames are still needed
+        double getWaitTimeout(double idleTimeout);
+
+        // Consumes the marks and returns whether the frame is drawn. A forced frame is always drawn, but still
+        // counts as unchanged when nothing was marked, to show what rendering on demand would save.
+        bool beginFrame(bool force);
+
+        // GPU time of a drawn frame, as its timestamps come back
+        void addGpuTime(double milliseconds) { this->statsGpuMs += milliseconds; }
+
+        // Fills stats and returns true once every interval seconds
+        bool collectStats(double interval, RedrawStats &stats);
+
+        static const char* getReasonName(RedrawReason reason);
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        std::atomic<uint32_t> dirtyReasons{0};
+
+        uint32_t settleFrames;
+        uint32_t remainingFrames = 0;
+
+        bool hasCameraPose = false;
+        glm::vec3 cameraPosition{ 0.0f };
+        glm::vec3 cameraFront{ 0.0f };
+        float cameraZoom = 0.0f;
+
+        Clock::time_point statsStart = Clock::now();
+        std::clock_t statsCpuStart = std::clock();
+        double statsGpuMs = 0.0;
+        RedrawStats stats;
+    };
+}
+
+#endif
@@ -0,0 +1,97 @@
+#include "frame_sync.hpp"
+
+#include <algorithm>
+#include <thread>
+
+namespace nugie {
+    FrameSync::FrameSync(nugie::Device *device, uint32_t framesInFlight) : device{device} {
+        framesInFlight = std::max(framesInFlight, 1u);
+
+        for (uint32_t i = 0; i < framesInFlight; i++) {
+            this->slots.emplace_back(std::make_unique<FrameSlot>());
+        }
+    }
+
+    FrameSync::~FrameSync() {
+        this->waitIdle();
+    }
+
+    uint32_t FrameSync::beginFrame() {
+        if (this->frameStarted) {
+            this->frameIndex++;
+        }
+
+        FrameSlot &slot = *this->slots[this->getFrameSlot()];
+        this->waitForSlot(slot);
+
+        slot.frameIndex = this->frameIndex;
+        slot.startTime = Clock::now();
+        this->frameStarted = true;
+
+        return this->getFrameSlot();
+    }
+
+    void FrameSync::endFrame() {
+        FrameSlot &slot = *this->slots[this->getFrameSlot()];
+        slot.inFlight.store(true, std::memory_order_release);
+
+        // Nothing ever runs on a null device, so its frames are done as soon as they are submitted
+        if (this->device->isNull()) {
+            slot.endTime = Clock::now();
+
+            this->completedFrameIndex.store(slot.frameIndex + 1, std::memory_order_release);
+            slot.inFlight.store(false, std::memory_order_release);
+            return;
+        }
+
+        // Queue work completes in submission order, so this frame finishing means all before it did too
+        slot.workDoneCallback = this->device->getQueue().onSubmittedWorkDone([this, &slot](wgpu::QueueWorkDoneStatus /* status */) {
+            slot.endTime = Clock::now();
+
+            this->completedFrameIndex.store(slot.frameIndex + 1, std::memory_order_release);
+            slot.inFlight.store(false, std::memory_order_release);
+        });
+    }
+
+    void FrameSync::waitIdle() {
+        for (auto &&slot : this->slots) {
+            this->waitForSlot(*slot);
+        }
+    }
+
+    bool FrameSync::collectStats(double interval, FrameStats &stats) {
+        double elapsed = std::chrono::duration<double>(Clock::now() - this->statsStart).count();
+        if (elapsed < interval) {
+            return false;
+        }
+
+        stats.framesPerSecond = this->statsFrames / elapsed;
+        stats.averageLatencyMs = this->statsFrames > 0 ? this->statsLatencySum / this->statsFrames : 0.0;
+        stats.maxLatencyMs = this->statsLatencyMax;
+
+        this->statsStart = Clock::now();
+        this->statsFrames = 0;
+        this->statsLatencySum = 0.0;
+        this->statsLatencyMax = 0.0;
+
+        return true;
+    }
+
+    void FrameSync::waitForSlot(FrameSlot &slot) {
+        while (slot.inFlight.load(std::memory_order_acquire)) {
+            this->device->processGpuEvents();
+            std::this_thread::yield();
+        }
+
+        // Statistics are gathered here rather than in the callback, which may run on another thread
+        if (slot.workDoneCallback != nullptr) {
+            double latency = std::chrono::duration<double, std::milli>(slot.endTime - slot.startTime).count();
+
+            this->statsFrames++;
+            this->statsLatencySum += latency;
+            this->statsLatencyMax = std::max(this->statsLatencyMax, latency);
+
+            slot.workDoneCallback.reset();
+        }
+    }
+}
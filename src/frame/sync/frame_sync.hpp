@@ -0,0 +1,78 @@
+#ifndef NUGIE_FRAME_SYNC_HPP
+#define NUGIE_FRAME_SYNC_HPP
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "../../device/device.hpp"
+
+namespace nugie {
+    class Device;
+
+    struct FrameStats {
+        double framesPerSecond = 0.0;
+
+        // From the start of a frame (just before input is sampled) until the GPU finished it
+        double averageLatencyMs = 0.0;
+        double maxLatencyMs = 0.0;
+    };
+
+    // Lets the CPU run up to framesInFlight frames ahead of the GPU. Every frame owns one slot, and
+    // per-frame resources indexed by the slot are safe to overwrite once beginFrame() returned it.
+    class FrameSync {
+    public:
+        FrameSync(nugie::Device *device, uint32_t framesInFlight);
+        ~FrameSync();
+
+        uint32_t getFramesInFlight() { return static_cast<uint32_t>(this->slots.size()); }
+
+        // Monotonic index of the current frame
+        uint64_t getFrameIndex() { return this->frameIndex; }
+
+        uint32_t getFrameSlot() { return static_cast<uint32_t>(this->frameIndex % this->slots.size()); }
+
+        // Every frame with an index below this one has finished on the GPU
+        uint64_t getCompletedFrameIndex() { return this->completedFrameIndex.load(std::memory_order_acquire); }
+
+        // Waits until the GPU is done with the frame that used the next slot, then returns that slot
+        uint32_t beginFrame();
+
+        // Must be called right after the frame's last submit
+        void endFrame();
+
+        // Blocks until every submitted frame has finished
+        void waitIdle();
+
+        // Fills stats and returns true once every interval seconds
+        bool collectStats(double interval, FrameStats &stats);
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        struct FrameSlot {
+            std::atomic<bool> inFlight{false};
+            uint64_t frameIndex = 0;
+            Clock::time_point startTime;
+            Clock::time_point endTime;
+            std::unique_ptr<wgpu::QueueWorkDoneCallback> workDoneCallback;
+        };
+
+        nugie::Device *device;
+        std::vector<std::unique_ptr<FrameSlot>> slots;
+
+        uint64_t frameIndex = 0;
+        bool frameStarted = false;
+        std::atomic<uint64_t> completedFrameIndex{0};
+
+        Clock::time_point statsStart = Clock::now();
+        uint32_t statsFrames = 0;
+        double statsLatencySum = 0.0;
+        double statsLatencyMax = 0.0;
+
+        void waitForSlot(FrameSlot &slot);
+    };
+}
+
+#endif
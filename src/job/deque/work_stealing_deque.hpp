@@ -0,0 +1,100 @@
+#ifndef NUGIE_WORK_STEALING_DEQUE_HPP
+#define NUGIE_WORK_STEALING_DEQUE_HPP
+
+#include <atomic>
+#include <memory>
+#include <cstdint>
+
+namespace nugie {
+    // Fixed-capacity Chase-Lev deque (with the C11 orderings of Le et al.).
+    // Only the owning thread may push() and pop(), at the bottom; any thread may steal() from the top.
+    template<typename T>
+    class WorkStealingDeque {
+    public:
+        // capacity must be a power of two
+        WorkStealingDeque(int64_t capacity)
+        : capacity{capacity},
+          mask{capacity - 1},
+          buffer{new std::atomic<T*>[capacity]}
+        {
+
+        }
+
+        // Returns false when the deque is full, the caller should then run the item itself
+        bool push(T* item) {
+            int64_t b = this->bottom.load(std::memory_order_relaxed);
+            int64_t t = this->top.load(std::memory_order_acquire);
+
+            if (b - t >= this->capacity) {
+                return false;
+            }
+
+            this->buffer[b & this->mask].store(item, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            this->bottom.store(b + 1, std::memory_order_relaxed);
+
+            return true;
+        }
+
+        T* pop() {
+            int64_t b = this->bottom.load(std::memory_order_relaxed) - 1;
+            this->bottom.store(b, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t t = this->top.load(std::memory_order_relaxed);
+
+            if (t > b) {
+                this->bottom.store(b + 1, std::memory_order_relaxed);
+                return nullptr;
+            }
+
+            T* item = this->buffer[b & this->mask].load(std::memory_order_relaxed);
+
+            // Last item left: race the thieves for it
+            if (t == b) {
+                if (!this->top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                    item = nullptr;
+                }
+
+                this->bottom.store(b + 1, std::memory_order_relaxed);
+            }
+
+            return item;
+        }
+
+        T* steal() {
+            int64_t t = this->top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t b = this->bottom.load(std::memory_order_acquire);
+
+            if (t >= b) {
+                return nullptr;
+            }
+
+            T* item = this->buffer[t & this->mask].load(std::memory_order_relaxed);
+            if (!this->top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                return nullptr;
+            }
+
+            return item;
+        }
+
+        // Approximate when called from a thief, exact from the owner
+        int64_t size() {
+            int64_t b = this->bottom.load(std::memory_order_relaxed);
+            int64_t t = this->top.load(std::memory_order_relaxed);
+
+            return b > t ? b - t : 0;
+        }
+
+    private:
+        int64_t capacity;
+        int64_t mask;
+
+        std::unique_ptr<std::atomic<T*>[]> buffer;
+
+        alignas(64) std::atomic<int64_t> top{0};
+        alignas(64) std::atomic<int64_t> bottom{0};
+    };
+}
+
+#endif
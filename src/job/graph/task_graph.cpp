@@ -0,0 +1,54 @@
+#include "task_graph.hpp"
+
+#include <stdexcept>
+
+namespace nugie {
+    TaskId TaskGraph::addTask(const char* name, std::function<void()> function, std::vector<TaskId> dependencies) {
+        TaskId id = static_cast<TaskId>(this->tasks.size());
+
+        auto task = std::make_unique<Task>();
+        task->name = name;
+        task->function = std::move(function);
+        task->dependencyCount = static_cast<uint32_t>(dependencies.size());
+
+        for (auto &&dependency : dependencies) {
+            if (dependency >= id) {
+                throw std::runtime_error(std::string("task depends on a task added after it: ") + name);
+            }
+
+            this->tasks[dependency]->successors.push_back(id);
+        }
+
+        this->tasks.push_back(std::move(task));
+        return id;
+    }
+
+    void TaskGraph::execute(JobSystem &jobSystem) {
+        for (auto &&task : this->tasks) {
+            task->remainingDependencies.store(task->dependencyCount, std::memory_order_relaxed);
+        }
+
+        JobCounter counter;
+        for (auto &&task : this->tasks) {
+            if (task->dependencyCount == 0) {
+                this->spawn(jobSystem, counter, task.get());
+            }
+        }
+
+        jobSystem.wait(counter);
+    }
+
+    void TaskGraph::spawn(JobSystem &jobSystem, JobCounter &counter, Task *task) {
+        jobSystem.run(counter, [this, &jobSystem, &counter, task] {
+            task->function();
+
+            for (auto &&successorId : task->successors) {
+                Task *successor = this->tasks[successorId].get();
+
+                if (successor->remainingDependencies.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    this->spawn(jobSystem, counter, successor);
+                }
+            }
+        });
+    }
+}
@@ -0,0 +1,43 @@
+#ifndef NUGIE_TASK_GRAPH_HPP
+#define NUGIE_TASK_GRAPH_HPP
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <functional>
+
+#include "../system/job_system.hpp"
+
+namespace nugie {
+    using TaskId = uint32_t;
+
+    // A DAG of tasks that is built once and executed on the job system every frame.
+    // A task is spawned as soon as all of its dependencies have finished.
+    class TaskGraph {
+    public:
+        // Dependencies must be tasks that were added before, so the graph can never contain a cycle
+        TaskId addTask(const char* name, std::function<void()> function, std::vector<TaskId> dependencies = {});
+
+        size_t getTaskCount() { return this->tasks.size(); }
+
+        const char* getTaskName(TaskId id) { return this->tasks[id]->name; }
+
+        // Runs every task once and returns when all of them are done
+        void execute(JobSystem &jobSystem);
+
+    private:
+        struct Task {
+            const char* name;
+            std::function<void()> function;
+            std::vector<TaskId> successors;
+            uint32_t dependencyCount = 0;
+            std::atomic<uint32_t> remainingDependencies{0};
+        };
+
+        std::vector<std::unique_ptr<Task>> tasks;
+
+        void spawn(JobSystem &jobSystem, JobCounter &counter, Task *task);
+    };
+}
+
+#endif
@@ -0,0 +1,175 @@
+#include "job_system.hpp"
+
+namespace nugie {
+    // Only the constructing thread and the workers get an index, everything else stays invalid
+    thread_local uint32_t JobSystem::threadIndex = JobSystem::INVALID_THREAD_INDEX;
+
+    JobSystem::JobSystem(uint32_t threadCount) {
+        threadCount = std::max(threadCount, 1u);
+
+        for (uint32_t i = 0; i < threadCount; i++) {
+            this->queues.emplace_back(std::make_unique<WorkStealingDeque<Job>>(QUEUE_CAPACITY));
+            this->threadData.emplace_back(std::make_unique<ThreadData>());
+            this->threadData[i]->randomState = 0x9E3779B9u * (i + 1);
+        }
+
+        threadIndex = 0;
+
+        for (uint32_t i = 1; i < threadCount; i++) {
+            this->workers.emplace_back(&JobSystem::workerLoop, this, i);
+        }
+
+        this->backgroundWorker = std::thread{ &JobSystem::backgroundLoop, this };
+    }
+
+    JobSystem::~JobSystem() {
+        this->release();
+    }
+
+    void JobSystem::wait(JobCounter &counter) {
+        if (threadIndex == INVALID_THREAD_INDEX) {
+            throw std::runtime_error("job counters can only be waited on from the job system's own threads");
+        }
+
+        while (!counter.isDone()) {
+            Job *job = this->findJob();
+
+            if (job != nullptr) {
+                job->run();
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void JobSystem::release() {
+        {
+            std::lock_guard<std::mutex> lock(this->sleepMutex);
+            this->stopping.store(true);
+        }
+
+        this->wakeCondition.notify_all();
+        for (auto &&worker : this->workers) {
+            worker.join();
+        }
+
+        this->workers.clear();
+
+        // Whatever is queued in the background still runs, its counters may be waited on
+        if (this->backgroundWorker.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(this->backgroundMutex);
+                this->backgroundStopping = true;
+            }
+
+            this->backgroundCondition.notify_all();
+            this->backgroundWorker.join();
+        }
+    }
+
+    Job* JobSystem::allocateJob() {
+        if (threadIndex == INVALID_THREAD_INDEX) {
+            throw std::runtime_error("jobs can only be spawned from the job system's own threads");
+        }
+
+        ThreadData &data = *this->threadData[threadIndex];
+        Job *job = &data.jobPool[data.nextJob % JOB_POOL_SIZE];
+
+        if (job->isBusy()) {
+            return nullptr;
+        }
+
+        data.nextJob++;
+        return job;
+    }
+
+    void JobSystem::submit(Job *job) {
+        this->queuedJobs.fetch_add(1);
+
+        if (!this->queues[threadIndex]->push(job)) {
+            // Queue is full, so there is plenty of parallel work already
+            this->queuedJobs.fetch_sub(1);
+            job->run();
+            return;
+        }
+
+        if (this->sleepingWorkers.load() > 0) {
+            std::lock_guard<std::mutex> lock(this->sleepMutex);
+            this->wakeCondition.notify_one();
+        }
+    }
+
+    Job* JobSystem::findJob() {
+        Job *job = this->queues[threadIndex]->pop();
+
+        if (job == nullptr) {
+            ThreadData &data = *this->threadData[threadIndex];
+            uint32_t threadCount = this->getThreadCount();
+
+            // xorshift picks the first victim, then every other thread is tried once
+            data.randomState ^= data.randomState << 13;
+            data.randomState ^= data.randomState >> 17;
+            data.randomState ^= data.randomState << 5;
+
+            uint32_t start = data.randomState % threadCount;
+            for (uint32_t i = 0; i < threadCount && job == nullptr; i++) {
+                uint32_t victim = (start + i) % threadCount;
+
+                if (victim != threadIndex) {
+                    job = this->queues[victim]->steal();
+                }
+            }
+        }
+
+        if (job != nullptr) {
+            this->queuedJobs.fetch_sub(1);
+        }
+
+        return job;
+    }
+
+    void JobSystem::workerLoop(uint32_t index) {
+        threadIndex = index;
+
+        while (!this->stopping.load(std::memory_order_relaxed)) {
+            Job *job = this->findJob();
+
+            if (job != nullptr) {
+                job->run();
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(this->sleepMutex);
+            this->sleepingWorkers.fetch_add(1);
+
+            this->wakeCondition.wait(lock, [this] {
+                return this->stopping.load() || this->queuedJobs.load() > 0;
+            });
+
+            this->sleepingWorkers.fetch_sub(1);
+        }
+    }
+
+    void JobSystem::backgroundLoop() {
+        std::unique_lock<std::mutex> lock(this->backgroundMutex);
+
+        while (true) {
+            this->backgroundCondition.wait(lock, [this] {
+                return this->backgroundStopping || !this->backgroundJobs.empty();
+            });
+
+            if (this->backgroundJobs.empty()) {
+                return;
+            }
+
+            Job *job = this->backgroundJobs.front();
+            this->backgroundJobs.pop_front();
+
+            lock.unlock();
+            job->run();
+            lock.lock();
+
+            this->freeBackgroundJobs.push_back(job);
+        }
+    }
+}
@@ -0,0 +1,219 @@
+#ifndef NUGIE_JOB_SYSTEM_HPP
+#define NUGIE_JOB_SYSTEM_HPP
+
+#include <atomic>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include <new>
+#include <cstddef>
+#include <type_traits>
+#include <cstdint>
+#include <stdexcept>
+
+#include "../deque/work_stealing_deque.hpp"
+
+namespace nugie {
+    // Counts the jobs that have been spawned against it and not finished yet
+    struct JobCounter {
+        std::atomic<uint32_t> pending{0};
+
+        bool isDone() { return this->pending.load(std::memory_order_acquire) == 0; }
+    };
+
+    // A type-erased callable stored inline, so spawning never touches the heap
+    class Job {
+    public:
+        template<typename F>
+        void set(F&& function, JobCounter *counter) {
+            using Function = std::decay_t<F>;
+            static_assert(sizeof(Function) <= sizeof(storage), "job capture is too large");
+            static_assert(alignof(Function) <= alignof(std::max_align_t), "job capture is over-aligned");
+
+            new (this->storage) Function(std::forward<F>(function));
+
+            this->invoke = [](void *storage) {
+                Function *function = std::launder(reinterpret_cast<Function*>(storage));
+                (*function)();
+                function->~Function();
+            };
+
+            this->counter = counter;
+            this->busy.store(true, std::memory_order_relaxed);
+        }
+
+        void run() {
+            // The slot may be taken again as soon as it is not busy, so nothing of it is read after that
+            JobCounter *counter = this->counter;
+
+            this->invoke(this->storage);
+            this->busy.store(false, std::memory_order_release);
+
+            if (counter != nullptr) {
+                counter->pending.fetch_sub(1, std::memory_order_release);
+            }
+        }
+
+        // From set() until run() returned, a stolen job may still be running long after it was spawned
+        bool isBusy() { return this->busy.load(std::memory_order_acquire); }
+
+    private:
+        alignas(std::max_align_t) unsigned char storage[64];
+        void (*invoke)(void*) = nullptr;
+        JobCounter *counter = nullptr;
+        std::atomic<bool> busy{false};
+    };
+
+    // Work-stealing job system. Thread 0 is the thread that constructed it, which takes part in
+    // the work whenever it waits on a counter. Jobs may only be spawned, and counters waited on,
+    // from thread 0 or from inside other jobs; any other thread throws std::runtime_error.
+    //
+    // Besides the workers there is one background thread for long jobs such as loads. Those are
+    // never stolen, so a wait() on a frame's counter cannot end up running one inline. The background
+    // thread is not one of the system's own either: its jobs must not spawn, wait or use parallelFor(),
+    // only runBackground() is open to them.
+    class JobSystem {
+    public:
+        static constexpr uint32_t INVALID_THREAD_INDEX = UINT32_MAX;
+
+        JobSystem(uint32_t threadCount = std::thread::hardware_concurrency());
+        ~JobSystem();
+
+        uint32_t getThreadCount() { return static_cast<uint32_t>(this->queues.size()); }
+
+        // Index of the calling thread inside this system, INVALID_THREAD_INDEX on a thread it does not own
+        uint32_t getThreadIndex() { return threadIndex; }
+
+        template<typename F>
+        void run(JobCounter &counter, F&& function) {
+            Job *job = this->allocateJob();
+
+            // The pool has wrapped around to a job that is still running, there is plenty of parallel work already
+            if (job == nullptr) {
+                function();
+                return;
+            }
+
+            counter.pending.fetch_add(1, std::memory_order_relaxed);
+            job->set(std::forward<F>(function), &counter);
+
+            this->submit(job);
+        }
+
+        // Queues the job for the background thread, which runs them one at a time in the order they came.
+        // May be called from any thread.
+        template<typename F>
+        void runBackground(JobCounter &counter, F&& function) {
+            counter.pending.fetch_add(1, std::memory_order_relaxed);
+
+            {
+                std::lock_guard<std::mutex> lock(this->backgroundMutex);
+
+                Job *job = nullptr;
+                if (this->freeBackgroundJobs.empty()) {
+                    this->backgroundJobPool.emplace_back(std::make_unique<Job>());
+                    job = this->backgroundJobPool.back().get();
+                } else {
+                    job = this->freeBackgroundJobs.back();
+                    this->freeBackgroundJobs.pop_back();
+                }
+
+                job->set(std::forward<F>(function), &counter);
+                this->backgroundJobs.push_back(job);
+            }
+
+            this->backgroundCondition.notify_one();
+        }
+
+        // Blocks until the counter reaches zero, running other jobs meanwhile
+        void wait(JobCounter &counter);
+
+        // Calls function(begin, end) over [0, count). The range is split in half lazily, only while
+        // the local queue is nearly empty, so the grain adapts to how busy the other threads are.
+        template<typename F>
+        void parallelFor(uint32_t count, uint32_t minGrain, const F &function) {
+            if (count == 0) {
+                return;
+            }
+
+            JobCounter counter;
+            this->splitRange(counter, 0, count, std::max(minGrain, 1u), &function);
+            this->wait(counter);
+        }
+
+        template<typename F>
+        void parallelFor(uint32_t count, const F &function) {
+            this->parallelFor(count, count / (this->getThreadCount() * 16), function);
+        }
+
+        void release();
+
+    private:
+        static constexpr int64_t QUEUE_CAPACITY = 4096;
+        static constexpr uint32_t JOB_POOL_SIZE = 4096;
+        static constexpr int64_t SPLIT_THRESHOLD = 2;
+
+        struct ThreadData {
+            std::vector<Job> jobPool = std::vector<Job>(JOB_POOL_SIZE);
+            uint32_t nextJob = 0;
+            uint32_t randomState = 0;
+        };
+
+        static thread_local uint32_t threadIndex;
+
+        std::vector<std::unique_ptr<WorkStealingDeque<Job>>> queues;
+        std::vector<std::unique_ptr<ThreadData>> threadData;
+        std::vector<std::thread> workers;
+
+        std::atomic<bool> stopping{false};
+        std::atomic<int32_t> queuedJobs{0};
+        std::atomic<uint32_t> sleepingWorkers{0};
+
+        std::mutex sleepMutex;
+        std::condition_variable wakeCondition;
+
+        // Jobs are recycled through the free list, so the pool only grows to the most ever queued at once
+        std::thread backgroundWorker;
+        std::vector<std::unique_ptr<Job>> backgroundJobPool;
+        std::vector<Job*> freeBackgroundJobs;
+        std::deque<Job*> backgroundJobs;
+        bool backgroundStopping = false;
+
+        std::mutex backgroundMutex;
+        std::condition_variable backgroundCondition;
+
+        // Jobs come from a per-thread ring. Returns nullptr when the next slot's job has not finished yet,
+        // which happens when it was stolen and runs long while this thread spawned JOB_POOL_SIZE more.
+        // Throws on a thread the system does not own, whose spawns would push onto another thread's deque.
+        Job* allocateJob();
+
+        void submit(Job *job);
+
+        Job* findJob();
+
+        void workerLoop(uint32_t index);
+
+        void backgroundLoop();
+
+        template<typename F>
+        void splitRange(JobCounter &counter, uint32_t begin, uint32_t end, uint32_t minGrain, const F *function) {
+            while (end - begin > minGrain && this->queues[threadIndex]->size() < SPLIT_THRESHOLD) {
+                uint32_t middle = begin + (end - begin) / 2;
+
+                this->run(counter, [this, &counter, middle, end, minGrain, function] {
+                    this->splitRange(counter, middle, end, minGrain, function);
+                });
+
+                end = middle;
+            }
+
+            (*function)(begin, end);
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef NUGIE_ARENA_ALLOCATOR_HPP
+#define NUGIE_ARENA_ALLOCATOR_HPP
+
+#include <vector>
+
+#include "linear_arena.hpp"
+
+namespace nugie {
+    // Lets standard containers allocate from a LinearArena. Deallocation does nothing, the memory
+    // comes back when the arena is reset, so a container must not outlive the reset of its arena.
+    template<typename T>
+    class ArenaAllocator {
+    public:
+        using value_type = T;
+
+        // Containers that are default constructed must be given an arena before they allocate
+        ArenaAllocator() : arena{nullptr} {}
+
+        ArenaAllocator(LinearArena *arena) : arena{arena} {}
+
+        template<typename U>
+        ArenaAllocator(const ArenaAllocator<U> &other) : arena{other.getArena()} {}
+
+        T* allocate(size_t count) { return this->arena->template allocate<T>(count); }
+
+        void deallocate(T* /* pointer */, size_t /* count */) {}
+
+        LinearArena* getArena() const { return this->arena; }
+
+        template<typename U>
+        bool operator==(const ArenaAllocator<U> &other) const { return this->arena == other.getArena(); }
+
+    private:
+        LinearArena *arena;
+    };
+
+    template<typename T>
+    using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+}
+
+#endif
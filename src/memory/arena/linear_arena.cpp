@@ -0,0 +1,54 @@
+#include "linear_arena.hpp"
+
+#include <algorithm>
+
+namespace nugie {
+    LinearArena::LinearArena(size_t capacity)
+    : block{std::make_unique<std::byte[]>(capacity)},
+      capacity{capacity}
+    {
+
+    }
+
+    void* LinearArena::allocate(size_t size, size_t alignment) {
+        // Reserving size + alignment - 1 bytes leaves room to align any start the add returns
+        size_t reserved = size + alignment - 1;
+        size_t start = this->offset.fetch_add(reserved, std::memory_order_relaxed);
+
+        if (start + reserved > this->capacity) {
+            return this->allocateOverflow(size, alignment);
+        }
+
+        uintptr_t address = reinterpret_cast<uintptr_t>(this->block.get()) + start;
+        uintptr_t aligned = (address + alignment - 1) & ~uintptr_t(alignment - 1);
+
+        return reinterpret_cast<void*>(aligned);
+    }
+
+    void LinearArena::reset() {
+        size_t used = this->getUsedSize();
+        this->highWaterMark = std::max(this->highWaterMark, used);
+
+        if (used > this->capacity) {
+            this->capacity = used + used / 2;
+            this->block = std::make_unique<std::byte[]>(this->capacity);
+        }
+
+        this->overflowBlocks.clear();
+        this->overflowSize = 0;
+        this->offset.store(0, std::memory_order_relaxed);
+    }
+
+    void* LinearArena::allocateOverflow(size_t size, size_t alignment) {
+        std::lock_guard<std::mutex> lock{ this->overflowMutex };
+
+        size_t reserved = size + alignment - 1;
+        this->overflowBlocks.push_back(std::make_unique<std::byte[]>(reserved));
+        this->overflowSize += reserved;
+
+        uintptr_t address = reinterpret_cast<uintptr_t>(this->overflowBlocks.back().get());
+        uintptr_t aligned = (address + alignment - 1) & ~uintptr_t(alignment - 1);
+
+        return reinterpret_cast<void*>(aligned);
+    }
+}
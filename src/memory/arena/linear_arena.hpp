@@ -0,0 +1,54 @@
+#ifndef NUGIE_LINEAR_ARENA_HPP
+#define NUGIE_LINEAR_ARENA_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace nugie {
+    // A bump allocator whose allocations are all freed at once by reset(). Allocation is one atomic
+    // add, so several threads may allocate from the same arena while nobody resets it.
+    //
+    // When the block runs out, allocations spill into separate heap blocks and the next reset()
+    // grows the block to everything used, so a steady workload stops touching the heap after one frame.
+    class LinearArena {
+    public:
+        LinearArena(size_t capacity);
+
+        LinearArena(const LinearArena&) = delete;
+        LinearArena& operator=(const LinearArena&) = delete;
+
+        void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+        template<typename T>
+        T* allocate(size_t count) { return static_cast<T*>(this->allocate(count * sizeof(T), alignof(T))); }
+
+        // Must not run while another thread allocates
+        void reset();
+
+        size_t getCapacity() { return this->capacity; }
+
+        // Bytes handed out since the last reset, including the spilled ones
+        size_t getUsedSize() { return std::min(this->offset.load(std::memory_order_relaxed), this->capacity) + this->overflowSize; }
+
+        size_t getHighWaterMark() { return this->highWaterMark; }
+
+    private:
+        std::unique_ptr<std::byte[]> block;
+        size_t capacity;
+        std::atomic<size_t> offset{0};
+
+        std::mutex overflowMutex;
+        std::vector<std::unique_ptr<std::byte[]>> overflowBlocks;
+        size_t overflowSize = 0;
+
+        size_t highWaterMark = 0;
+
+        void* allocateOverflow(size_t size, size_t alignment);
+    };
+}
+
+#endif
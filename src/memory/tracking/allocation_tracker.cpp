@@ -0,0 +1,71 @@
+#include "allocation_tracker.hpp"
+
+#include <atomic>
+
+#ifdef NUGIE_TRACK_ALLOCATIONS
+#include <cstdlib>
+#include <new>
+#endif
+
+namespace {
+    thread_local uint64_t threadAllocationCount = 0;
+    std::atomic<uint64_t> totalAllocationCount{0};
+}
+
+#ifdef NUGIE_TRACK_ALLOCATIONS
+void* operator new(std::size_t size) {
+    threadAllocationCount++;
+    totalAllocationCount.fetch_add(1, std::memory_order_relaxed);
+
+    if (void* pointer = std::malloc(size > 0 ? size : 1)) {
+        return pointer;
+    }
+
+    throw std::bad_alloc{};
+}
+
+void* operator new[](std::size_t size) {
+    return ::operator new(size);
+}
+
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t /* size */) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t /* size */) noexcept {
+    std::free(pointer);
+}
+#endif // NUGIE_TRACK_ALLOCATIONS
+
+namespace nugie {
+    AllocationScope::AllocationScope(bool allThreads)
+    : allThreads{allThreads},
+      startCount{allThreads ? totalAllocationCount.load(std::memory_order_relaxed) : threadAllocationCount}
+    {
+
+    }
+
+    uint64_t AllocationScope::getAllocationCount() {
+        if (this->allThreads) {
+            return totalAllocationCount.load(std::memory_order_relaxed) - this->startCount;
+        }
+
+        return threadAllocationCount - this->startCount;
+    }
+
+    bool AllocationScope::isTrackingEnabled() {
+#ifdef NUGIE_TRACK_ALLOCATIONS
+        return true;
+#else
+        return false;
+#endif
+    }
+}
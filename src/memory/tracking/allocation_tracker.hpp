@@ -0,0 +1,28 @@
+#ifndef NUGIE_ALLOCATION_TRACKER_HPP
+#define NUGIE_ALLOCATION_TRACKER_HPP
+
+#include <cstdint>
+
+namespace nugie {
+    // Counts calls to the global operator new made while the scope is alive, by the current thread or
+    // by every thread. The counting operator new is only compiled in with NUGIE_TRACK_ALLOCATIONS,
+    // without it every scope reports zero and costs nothing.
+    //
+    // Only wrap code the renderer owns, the WebGPU implementation is free to allocate on its own.
+    // wgpu-native allocates outside of operator new, so a whole frame can be wrapped with it.
+    class AllocationScope {
+    public:
+        // With allThreads, allocations of the job system's workers and any other thread count too
+        explicit AllocationScope(bool allThreads = false);
+
+        uint64_t getAllocationCount();
+
+        static bool isTrackingEnabled();
+
+    private:
+        bool allThreads;
+        uint64_t startCount;
+    };
+}
+
+#endif
@@ -0,0 +1,166 @@
+#include "parallel_encoder.hpp"
+#include "../../device/null/null_bundle_encoder.hpp"
+
+#include <algorithm>
+
+namespace nugie {
+    ParallelEncoder::ParallelEncoder(nugie::Device *device, nugie::JobSystem *jobSystem, wgpu::TextureFormat colorFormat, wgpu::TextureFormat depthFormat)
+    : device{device},
+      jobSystem{jobSystem},
+      colorFormat{colorFormat},
+      depthFormat{depthFormat}
+    {
+        this->bundles.resize(jobSystem->getThreadCount());
+        this->nativeBundles.resize(jobSystem->getThreadCount());
+        this->chunkStats.resize(jobSystem->getThreadCount());
+    }
+
+    ParallelEncoder::~ParallelEncoder() {
+        this->release();
+    }
+
+    void ParallelEncoder::encode(const DrawCommand *drawCommands, size_t drawCount) {
+        this->releaseBundles();
+
+        // One chunk per thread at most, and never so small that the bundle overhead dominates
+        size_t wantedChunks = (drawCount + MIN_DRAWS_PER_CHUNK - 1) / MIN_DRAWS_PER_CHUNK;
+
+        this->drawCommands = drawCommands;
+        this->drawCount = drawCount;
+        this->chunkCount = static_cast<uint32_t>(std::clamp<size_t>(wantedChunks, 1, this->bundles.size()));
+        this->chunkSize = (this->drawCount + this->chunkCount - 1) / this->chunkCount;
+
+        this->jobSystem->parallelFor(this->chunkCount, 1, [this](uint32_t begin, uint32_t end) {
+            for (uint32_t i = begin; i < end; i++) {
+                this->encodeChunk(i);
+            }
+        });
+
+        this->stats = EncodeStats{};
+        for (uint32_t i = 0; i < this->chunkCount; i++) {
+            this->stats.drawCount += this->chunkStats[i].drawCount;
+            this->stats.pipelineChanges += this->chunkStats[i].pipelineChanges;
+            this->stats.bindGroupChanges += this->chunkStats[i].bindGroupChanges;
+            this->stats.vertexBufferChanges += this->chunkStats[i].vertexBufferChanges;
+            this->stats.indexBufferChanges += this->chunkStats[i].indexBufferChanges;
+        }
+    }
+
+    void ParallelEncoder::execute(wgpu::RenderPassEncoder renderPassEncoder) {
+        if (this->device->isNull()) {
+            this->device->getCommandLog()->record(LoggedCommand::ExecuteBundles);
+            return;
+        }
+
+        for (uint32_t i = 0; i < this->chunkCount; i++) {
+            this->nativeBundles[i] = this->bundles[i];
+        }
+
+        renderPassEncoder.executeBundles(this->chunkCount, this->nativeBundles.data());
+    }
+
+    void ParallelEncoder::release() {
+        this->releaseBundles();
+    }
+
+    void ParallelEncoder::encodeChunk(uint32_t chunkIndex) {
+        size_t begin = std::min(this->drawCount, chunkIndex * this->chunkSize);
+        size_t end = std::min(this->drawCount, begin + this->chunkSize);
+
+        // A bundle starts with no state bound, so the first draw of every chunk sets everything
+        EncodeStats &chunkStats = this->chunkStats[chunkIndex];
+        chunkStats = EncodeStats{};
+
+        if (this->device->isNull()) {
+            NullBundleEncoder bundleEncoder{ this->device->getCommandLog() };
+            this->recordDraws(bundleEncoder, begin, end, chunkStats);
+            bundleEncoder.finish();
+            return;
+        }
+
+        wgpu::RenderBundleEncoderDescriptor bundleEncoderDesc{};
+        bundleEncoderDesc.nextInChain = nullptr;
+        bundleEncoderDesc.label = "Render Bundle Encoder";
+        bundleEncoderDesc.colorFormatCount = this->colorFormat == WGPUTextureFormat_Undefined ? 0 : 1;
+        bundleEncoderDesc.colorFormats = this->colorFormat == WGPUTextureFormat_Undefined ? nullptr : &this->colorFormat;
+        bundleEncoderDesc.depthStencilFormat = this->depthFormat;
+        bundleEncoderDesc.sampleCount = 1;
+        bundleEncoderDesc.depthReadOnly = false;
+        bundleEncoderDesc.stencilReadOnly = true;
+
+        wgpu::RenderBundleEncoder bundleEncoder = this->device->createRenderBundleEncoder(bundleEncoderDesc);
+        this->recordDraws(bundleEncoder, begin, end, chunkStats);
+
+        wgpu::RenderBundleDescriptor bundleDesc{};
+        bundleDesc.nextInChain = nullptr;
+        bundleDesc.label = "Render Bundle";
+
+        this->bundles[chunkIndex] = bundleEncoder.finish(bundleDesc);
+        bundleEncoder.release();
+    }
+
+    template<typename Encoder>
+    void ParallelEncoder::recordDraws(Encoder &bundleEncoder, size_t begin, size_t end, EncodeStats &chunkStats) {
+        const DrawCommand *previous = nullptr;
+
+        auto sameBuffer = [](const BufferInfo &a, const BufferInfo &b) {
+            return a.buffer == b.buffer && a.offset == b.offset && a.size == b.size;
+        };
+
+        for (size_t i = begin; i < end; i++) {
+            const DrawCommand &draw = this->drawCommands[i];
+
+            if (previous == nullptr || previous->pipeline != draw.pipeline) {
+                bundleEncoder.setPipeline(draw.pipeline);
+                chunkStats.pipelineChanges++;
+            }
+
+            if (previous == nullptr || !sameBuffer(previous->positionBuffer, draw.positionBuffer)) {
+                bundleEncoder.setVertexBuffer(0, draw.positionBuffer.buffer, draw.positionBuffer.offset, draw.positionBuffer.size);
+                chunkStats.vertexBufferChanges++;
+            }
+
+            // Position-only draws, such as the depth prepass, leave the second stream empty
+            if (draw.textCoordBuffer.buffer != nullptr && (previous == nullptr || !sameBuffer(previous->textCoordBuffer, draw.textCoordBuffer))) {
+                bundleEncoder.setVertexBuffer(1, draw.textCoordBuffer.buffer, draw.textCoordBuffer.offset, draw.textCoordBuffer.size);
+                chunkStats.vertexBufferChanges++;
+            }
+
+            if (previous == nullptr || previous->sceneBindGroup != draw.sceneBindGroup) {
+                bundleEncoder.setBindGroup(0, draw.sceneBindGroup, 0, nullptr);
+                chunkStats.bindGroupChanges++;
+            }
+
+            if (previous == nullptr || previous->objectBindGroup != draw.objectBindGroup) {
+                bundleEncoder.setBindGroup(1, draw.objectBindGroup, 0, nullptr);
+                chunkStats.bindGroupChanges++;
+            }
+
+            if (previous == nullptr || !sameBuffer(previous->indexBuffer, draw.indexBuffer)) {
+                bundleEncoder.setIndexBuffer(draw.indexBuffer.buffer, wgpu::IndexFormat::Uint32, draw.indexBuffer.offset, draw.indexBuffer.size);
+                chunkStats.indexBufferChanges++;
+            }
+
+            if (draw.indirectBuffer.buffer != nullptr) {
+                bundleEncoder.drawIndexedIndirect(draw.indirectBuffer.buffer, draw.indirectBuffer.offset);
+            } else {
+                bundleEncoder.drawIndexed(draw.indexCount, draw.instanceCount, 0, 0, 0);
+            }
+
+            chunkStats.drawCount++;
+            previous = &draw;
+        }
+    }
+
+    void ParallelEncoder::releaseBundles() {
+        for (uint32_t i = 0; i < this->chunkCount; i++) {
+            // Null devices never make real bundles
+            if (this->bundles[i] != nullptr) {
+                this->bundles[i].release();
+                this->bundles[i] = nullptr;
+            }
+        }
+
+        this->chunkCount = 0;
+    }
+}
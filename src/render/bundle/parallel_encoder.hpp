@@ -0,0 +1,78 @@
+#ifndef NUGIE_PARALLEL_ENCODER_HPP
+#define NUGIE_PARALLEL_ENCODER_HPP
+
+#include <vector>
+
+#include "../../device/device.hpp"
+#include "../../job/system/job_system.hpp"
+#include "../../struct.hpp"
+
+namespace nugie {
+    class Device;
+
+    // State set by the last encode(), after redundant calls were skipped
+    struct EncodeStats {
+        uint32_t drawCount = 0;
+        uint32_t pipelineChanges = 0;
+        uint32_t bindGroupChanges = 0;
+        uint32_t vertexBufferChanges = 0;
+        uint32_t indexBufferChanges = 0;
+
+        uint32_t getStateChanges() { return this->pipelineChanges + this->bindGroupChanges + this->vertexBufferChanges + this->indexBufferChanges; }
+    };
+
+    // Splits a draw list into contiguous chunks and records each chunk into its own render bundle
+    // on the job system. Bundles are executed in chunk order, so the result matches a serial encode.
+    // An Undefined color format makes depth-only bundles, for passes without color attachments.
+    // State equal to the previous draw of the same bundle is not set again, so sorted draw lists are cheaper to record.
+    // On a null device the same chunks are recorded into the command log instead of real bundles.
+    class ParallelEncoder {
+    public:
+        ParallelEncoder(nugie::Device *device, nugie::JobSystem *jobSystem, wgpu::TextureFormat colorFormat, wgpu::TextureFormat depthFormat);
+        ~ParallelEncoder();
+
+        uint32_t getChunkCount() { return this->chunkCount; }
+
+        EncodeStats getStats() { return this->stats; }
+
+        // Records the draws into bundles, blocking until every chunk is finished
+        void encode(const DrawCommand *drawCommands, size_t drawCount);
+
+        template<typename Allocator>
+        void encode(const std::vector<DrawCommand, Allocator>& drawCommands) { this->encode(drawCommands.data(), drawCommands.size()); }
+
+        // Replays the bundles of the last encode() into the pass, which is not touched on a null device
+        void execute(wgpu::RenderPassEncoder renderPassEncoder);
+
+        void release();
+
+    private:
+        static constexpr size_t MIN_DRAWS_PER_CHUNK = 256;
+
+        nugie::Device *device;
+        nugie::JobSystem *jobSystem;
+        WGPUTextureFormat colorFormat;
+        WGPUTextureFormat depthFormat;
+
+        const DrawCommand *drawCommands = nullptr;
+        size_t drawCount = 0;
+        size_t chunkSize = 0;
+        uint32_t chunkCount = 0;
+
+        std::vector<wgpu::RenderBundle> bundles;
+        std::vector<WGPURenderBundle> nativeBundles;
+        std::vector<EncodeStats> chunkStats;
+
+        EncodeStats stats;
+
+        void encodeChunk(uint32_t chunkIndex);
+
+        // Shared by real and null bundle encoders
+        template<typename Encoder>
+        void recordDraws(Encoder &encoder, size_t begin, size_t end, EncodeStats &chunkStats);
+
+        void releaseBundles();
+    };
+}
+
+#endif
@@ -0,0 +1,433 @@
+#include "occlusion_culler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace nugie {
+    OcclusionCuller::OcclusionCuller(nugie::Device *device, nugie::ShaderLibrary *shaderLibrary, nugie::ReadbackRing *readbackRing, uint32_t framesInFlight, 
+        uint32_t maxWidth, uint32_t maxHeight, uint32_t maxObjectCount)
+    : device{device},
+      readbackRing{readbackRing},
+      maxObjectCount{std::max(maxObjectCount, 1u)}
+    {
+        this->createBuffers(framesInFlight);
+        this->createPyramid(maxWidth, maxHeight);
+        this->createPipelines(shaderLibrary);
+
+        this->depthBindGroups.resize(framesInFlight, nullptr);
+
+        for (uint32_t i = 0; i < framesInFlight; i++) {
+            wgpu::BindGroupEntry bindGroupEntries[6];
+
+            wgpu::Buffer buffers[5] { this->uniformBuffer, this->objectBuffer, this->earlyArgsBuffer, this->lateArgsBuffer, this->counterBuffer };
+            for (uint32_t j = 0; j < 5; j++) {
+                bindGroupEntries[j].nextInChain = nullptr;
+                bindGroupEntries[j].binding = j;
+                bindGroupEntries[j].buffer = buffers[j];
+                bindGroupEntries[j].offset = 0;
+                bindGroupEntries[j].size = buffers[j].getSize();
+            }
+
+            bindGroupEntries[0].offset = i * UNIFORM_STRIDE;
+            bindGroupEntries[0].size = sizeof(CullUniform);
+
+            bindGroupEntries[5].nextInChain = nullptr;
+            bindGroupEntries[5].binding = 5;
+            bindGroupEntries[5].textureView = this->pyramidView;
+
+            wgpu::BindGroupDescriptor bindGroupDesc{};
+            bindGroupDesc.label = "Occlusion Cull Bind Group";
+            bindGroupDesc.nextInChain = nullptr;
+            bindGroupDesc.entryCount = 6;
+            bindGroupDesc.entries = bindGroupEntries;
+            bindGroupDesc.layout = this->cullBindGroupLayout;
+
+            this->cullBindGroups.push_back(this->device->createBindGroup(bindGroupDesc));
+        }
+
+        for (uint32_t level = 1; level < this->mipCount; level++) {
+            wgpu::BindGroupEntry bindGroupEntries[2];
+
+            bindGroupEntries[0].nextInChain = nullptr;
+            bindGroupEntries[0].binding = 1;
+            bindGroupEntries[0].textureView = this->levelViews[level - 1];
+
+            bindGroupEntries[1].nextInChain = nullptr;
+            bindGroupEntries[1].binding = 2;
+            bindGroupEntries[1].textureView = this->levelViews[level];
+
+            wgpu::BindGroupDescriptor bindGroupDesc{};
+            bindGroupDesc.label = "Hi-Z Level Bind Group";
+            bindGroupDesc.nextInChain = nullptr;
+            bindGroupDesc.entryCount = 2;
+            bindGroupDesc.entries = bindGroupEntries;
+            bindGroupDesc.layout = this->levelBindGroupLayout;
+
+            this->levelBindGroups.push_back(this->device->createBindGroup(bindGroupDesc));
+        }
+    }
+
+    OcclusionCuller::~OcclusionCuller() {
+        this->release();
+    }
+
+    uint32_t OcclusionCuller::addObject(glm::vec3 boundsMin, glm::vec3 boundsMax, uint32_t indexCount, uint32_t firstIndex, int32_t baseVertex) {
+        if (this->objects.size() >= this->maxObjectCount) {
+            throw std::runtime_error("too many objects for the occlusion culler");
+        }
+
+        CullObject object{};
+        object.boundsMin = glm::vec4{ boundsMin, 0.0f };
+        object.boundsMax = glm::vec4{ boundsMax, 0.0f };
+        object.indexCount = indexCount;
+        object.firstIndex = firstIndex;
+        object.baseVertex = baseVertex;
+
+        this->objects.push_back(object);
+        return static_cast<uint32_t>(this->objects.size() - 1);
+    }
+
+    void OcclusionCuller::uploadObjects() {
+        if (!this->objects.empty()) {
+            this->device->writeBuffer(this->objectBuffer, 0, this->objects.data(), this->objects.size() * sizeof(CullObject));
+        }
+    }
+
+    void OcclusionCuller::setDepthView(wgpu::TextureView depthView) {
+        this->releaseDepthBindGroups();
+
+        for (uint32_t i = 0; i < this->depthBindGroups.size(); i++) {
+            wgpu::BindGroupEntry bindGroupEntries[3];
+
+            bindGroupEntries[0].nextInChain = nullptr;
+            bindGroupEntries[0].binding = 0;
+            bindGroupEntries[0].buffer = this->uniformBuffer;
+            bindGroupEntries[0].offset = i * UNIFORM_STRIDE;
+            bindGroupEntries[0].size = sizeof(CullUniform);
+
+            bindGroupEntries[1].nextInChain = nullptr;
+            bindGroupEntries[1].binding = 1;
+            bindGroupEntries[1].textureView = depthView;
+
+            bindGroupEntries[2].nextInChain = nullptr;
+            bindGroupEntries[2].binding = 2;
+            bindGroupEntries[2].textureView = this->levelViews[0];
+
+            wgpu::BindGroupDescriptor bindGroupDesc{};
+            bindGroupDesc.label = "Hi-Z Depth Bind Group";
+            bindGroupDesc.nextInChain = nullptr;
+            bindGroupDesc.entryCount = 3;
+            bindGroupDesc.entries = bindGroupEntries;
+            bindGroupDesc.layout = this->depthBindGroupLayout;
+
+            this->depthBindGroups[i] = this->device->createBindGroup(bindGroupDesc);
+        }
+    }
+
+    void OcclusionCuller::beginFrame(uint32_t frameSlot, glm::mat4 viewProjection, uint32_t renderWidth, uint32_t renderHeight) {
+        this->frameSlot = frameSlot;
+
+        // The pyramid still holds last frame's depth, seen from last frame's camera
+        this->uniform.previousViewProjection = this->uniform.viewProjection;
+        this->uniform.previousRenderSize = this->uniform.renderSize;
+
+        this->uniform.viewProjection = viewProjection;
+        this->uniform.renderSize = glm::vec2{ static_cast<float>(renderWidth), static_cast<float>(renderHeight) };
+        this->uniform.objectCount = static_cast<uint32_t>(this->objects.size());
+        this->uniform.mipCount = this->mipCount;
+
+        uint32_t zeros[2] { 0, 0 };
+
+        this->device->writeBuffer(this->uniformBuffer, frameSlot * UNIFORM_STRIDE, &this->uniform, sizeof(CullUniform));
+        this->device->writeBuffer(this->counterBuffer, 0, zeros, sizeof(zeros));
+    }
+
+    void OcclusionCuller::dispatchEarly(wgpu::ComputePassEncoder computePassEncoder) {
+        uint32_t workgroupCount = (this->uniform.objectCount + CULL_WORKGROUP_SIZE - 1) / CULL_WORKGROUP_SIZE;
+        if (workgroupCount == 0) {
+            return;
+        }
+
+        computePassEncoder.setPipeline(this->earlyCullPipeline);
+        computePassEncoder.setBindGroup(0, this->cullBindGroups[this->frameSlot], 0, nullptr);
+        computePassEncoder.dispatchWorkgroups(workgroupCount, 1, 1);
+    }
+
+    void OcclusionCuller::buildPyramid(wgpu::ComputePassEncoder computePassEncoder) {
+        for (uint32_t level = 0; level < this->mipCount; level++) {
+            uint32_t width = std::max(this->pyramidTexture.getWidth() >> level, 1u);
+            uint32_t height = std::max(this->pyramidTexture.getHeight() >> level, 1u);
+
+            if (level == 0) {
+                computePassEncoder.setPipeline(this->depthBuildPipeline);
+                computePassEncoder.setBindGroup(0, this->depthBindGroups[this->frameSlot], 0, nullptr);
+            } else {
+                computePassEncoder.setPipeline(this->levelBuildPipeline);
+                computePassEncoder.setBindGroup(0, this->levelBindGroups[level - 1], 0, nullptr);
+            }
+
+            computePassEncoder.dispatchWorkgroups((width + BUILD_WORKGROUP_SIZE - 1) / BUILD_WORKGROUP_SIZE, (height + BUILD_WORKGROUP_SIZE - 1) / BUILD_WORKGROUP_SIZE, 1);
+        }
+    }
+
+    void OcclusionCuller::dispatchLate(wgpu::ComputePassEncoder computePassEncoder) {
+        uint32_t workgroupCount = (this->uniform.objectCount + CULL_WORKGROUP_SIZE - 1) / CULL_WORKGROUP_SIZE;
+        if (workgroupCount == 0) {
+            return;
+        }
+
+        computePassEncoder.setPipeline(this->lateCullPipeline);
+        computePassEncoder.setBindGroup(0, this->cullBindGroups[this->frameSlot], 0, nullptr);
+        computePassEncoder.dispatchWorkgroups(workgroupCount, 1, 1);
+    }
+
+    void OcclusionCuller::resolveStats(wgpu::CommandEncoder commandEncoder) {
+        uint32_t objectCount = this->uniform.objectCount;
+
+        this->readbackRing->readBuffer(commandEncoder, this->counterBuffer, 0, 2 * sizeof(uint32_t), [this, objectCount](const ReadbackResult &result) {
+            const uint32_t *counters = reinterpret_cast<const uint32_t*>(result.data);
+
+            this->stats.objectCount = objectCount;
+            this->stats.earlyVisible = counters[0];
+            this->stats.lateVisible = counters[1];
+            this->stats.culled = objectCount - std::min(objectCount, counters[0] + counters[1]);
+        });
+    }
+
+    void OcclusionCuller::release() {
+        if (this->released) {
+            return;
+        }
+
+        this->releaseDepthBindGroups();
+
+        for (auto &&bindGroup : this->cullBindGroups) bindGroup.release();
+        for (auto &&bindGroup : this->levelBindGroups) bindGroup.release();
+        for (auto &&view : this->levelViews) view.release();
+
+        this->earlyCullPipeline.release();
+        this->lateCullPipeline.release();
+        this->depthBuildPipeline.release();
+        this->levelBuildPipeline.release();
+
+        this->cullPipelineLayout.release();
+        this->depthPipelineLayout.release();
+        this->levelPipelineLayout.release();
+
+        this->cullBindGroupLayout.release();
+        this->depthBindGroupLayout.release();
+        this->levelBindGroupLayout.release();
+
+        this->pyramidView.release();
+        this->pyramidTexture.destroy();
+        this->device->releaseTexture(this->pyramidTexture);
+
+        this->device->releaseBuffer(this->uniformBuffer);
+        this->device->releaseBuffer(this->objectBuffer);
+        this->device->releaseBuffer(this->earlyArgsBuffer);
+        this->device->releaseBuffer(this->lateArgsBuffer);
+        this->device->releaseBuffer(this->counterBuffer);
+
+        this->released = true;
+    }
+
+    void OcclusionCuller::createBuffers(uint32_t framesInFlight) {
+        wgpu::BufferDescriptor bufferDesc{};
+        bufferDesc.mappedAtCreation = false;
+
+        bufferDesc.label = "Cull Uniform Buffer";
+        bufferDesc.size = framesInFlight * UNIFORM_STRIDE;
+        bufferDesc.usage = wgpu::BufferUsage::Uniform | wgpu::BufferUsage::CopyDst;
+        this->uniformBuffer = this->device->createBuffer(bufferDesc);
+
+        bufferDesc.label = "Cull Object Buffer";
+        bufferDesc.size = this->maxObjectCount * sizeof(CullObject);
+        bufferDesc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst;
+        this->objectBuffer = this->device->createBuffer(bufferDesc);
+
+        bufferDesc.label = "Early Draw Args Buffer";
+        bufferDesc.size = this->maxObjectCount * DRAW_ARGS_SIZE;
+        bufferDesc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::Indirect;
+        this->earlyArgsBuffer = this->device->createBuffer(bufferDesc);
+
+        bufferDesc.label = "Late Draw Args Buffer";
+        this->lateArgsBuffer = this->device->createBuffer(bufferDesc);
+
+        bufferDesc.label = "Cull Counter Buffer";
+        bufferDesc.size = 2 * sizeof(uint32_t);
+        bufferDesc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc | wgpu::BufferUsage::CopyDst;
+        this->counterBuffer = this->device->createBuffer(bufferDesc);
+    }
+
+    void OcclusionCuller::createPyramid(uint32_t maxWidth, uint32_t maxHeight) {
+        uint32_t width = std::max(maxWidth / 2, 1u);
+        uint32_t height = std::max(maxHeight / 2, 1u);
+
+        this->mipCount = static_cast<uint32_t>(std::floor(std::log2(std::max(width, height)))) + 1;
+
+        wgpu::TextureDescriptor textureDesc{};
+        textureDesc.nextInChain = nullptr;
+        textureDesc.label = "Hi-Z Pyramid";
+        textureDesc.dimension = wgpu::TextureDimension::_2D;
+        textureDesc.size = { width, height, 1 };
+        textureDesc.mipLevelCount = this->mipCount;
+        textureDesc.sampleCount = 1;
+        textureDesc.format = wgpu::TextureFormat::R32Float;
+        textureDesc.usage = wgpu::TextureUsage::TextureBinding | wgpu::TextureUsage::StorageBinding;
+        textureDesc.viewFormatCount = 0;
+        textureDesc.viewFormats = nullptr;
+
+        this->pyramidTexture = this->device->createTexture(textureDesc);
+
+        wgpu::TextureViewDescriptor viewDesc{};
+        viewDesc.nextInChain = nullptr;
+        viewDesc.label = "Hi-Z Pyramid View";
+        viewDesc.format = wgpu::TextureFormat::R32Float;
+        viewDesc.dimension = wgpu::TextureViewDimension::_2D;
+        viewDesc.baseMipLevel = 0;
+        viewDesc.mipLevelCount = this->mipCount;
+        viewDesc.baseArrayLayer = 0;
+        viewDesc.arrayLayerCount = 1;
+        viewDesc.aspect = wgpu::TextureAspect::All;
+
+        this->pyramidView = this->pyramidTexture.createView(viewDesc);
+
+        for (uint32_t level = 0; level < this->mipCount; level++) {
+            viewDesc.label = "Hi-Z Level View";
+            viewDesc.baseMipLevel = level;
+            viewDesc.mipLevelCount = 1;
+
+            this->levelViews.push_back(this->pyramidTexture.createView(viewDesc));
+        }
+    }
+
+    void OcclusionCuller::createPipelines(nugie::ShaderLibrary *shaderLibrary) {
+        const ShaderReflection &reflection = shaderLibrary->getReflection("occlusion_cull.wgsl");
+
+        reflection.validateStruct("CullUniform", sizeof(CullUniform), {
+            { "viewProjection", offsetof(CullUniform, viewProjection) },
+            { "previousViewProjection", offsetof(CullUniform, previousViewProjection) },
+            { "renderSize", offsetof(CullUniform, renderSize) },
+            { "previousRenderSize", offsetof(CullUniform, previousRenderSize) },
+            { "objectCount", offsetof(CullUniform, objectCount) },
+            { "mipCount", offsetof(CullUniform, mipCount) }
+        });
+
+        reflection.validateStruct("CullObject", sizeof(CullObject), {
+            { "boundsMin", offsetof(CullObject, boundsMin) },
+            { "boundsMax", offsetof(CullObject, boundsMax) },
+            { "indexCount", offsetof(CullObject, indexCount) },
+            { "firstIndex", offsetof(CullObject, firstIndex) },
+            { "baseVertex", offsetof(CullObject, baseVertex) },
+            { "padding", offsetof(CullObject, padding) }
+        });
+
+        wgpu::BindGroupLayoutEntry cullEntries[6];
+        for (uint32_t i = 0; i < 6; i++) {
+            cullEntries[i].nextInChain = nullptr;
+            cullEntries[i].binding = i;
+            cullEntries[i].visibility = wgpu::ShaderStage::Compute;
+        }
+
+        cullEntries[0].buffer.type = wgpu::BufferBindingType::Uniform;
+        cullEntries[1].buffer.type = wgpu::BufferBindingType::ReadOnlyStorage;
+        cullEntries[2].buffer.type = wgpu::BufferBindingType::Storage;
+        cullEntries[3].buffer.type = wgpu::BufferBindingType::Storage;
+        cullEntries[4].buffer.type = wgpu::BufferBindingType::Storage;
+        cullEntries[5].texture.sampleType = wgpu::TextureSampleType::UnfilterableFloat;
+        cullEntries[5].texture.viewDimension = wgpu::TextureViewDimension::_2D;
+
+        wgpu::BindGroupLayoutEntry depthEntries[3];
+        for (uint32_t i = 0; i < 3; i++) {
+            depthEntries[i].nextInChain = nullptr;
+            depthEntries[i].binding = i;
+            depthEntries[i].visibility = wgpu::ShaderStage::Compute;
+        }
+
+        depthEntries[0].buffer.type = wgpu::BufferBindingType::Uniform;
+        depthEntries[1].texture.sampleType = wgpu::TextureSampleType::Depth;
+        depthEntries[1].texture.viewDimension = wgpu::TextureViewDimension::_2D;
+        depthEntries[2].storageTexture.access = wgpu::StorageTextureAccess::WriteOnly;
+        depthEntries[2].storageTexture.format = wgpu::TextureFormat::R32Float;
+        depthEntries[2].storageTexture.viewDimension = wgpu::TextureViewDimension::_2D;
+
+        wgpu::BindGroupLayoutEntry levelEntries[2];
+        for (uint32_t i = 0; i < 2; i++) {
+            levelEntries[i].nextInChain = nullptr;
+            levelEntries[i].binding = i + 1;
+            levelEntries[i].visibility = wgpu::ShaderStage::Compute;
+        }
+
+        levelEntries[0].texture.sampleType = wgpu::TextureSampleType::UnfilterableFloat;
+        levelEntries[0].texture.viewDimension = wgpu::TextureViewDimension::_2D;
+        levelEntries[1].storageTexture.access = wgpu::StorageTextureAccess::WriteOnly;
+        levelEntries[1].storageTexture.format = wgpu::TextureFormat::R32Float;
+        levelEntries[1].storageTexture.viewDimension = wgpu::TextureViewDimension::_2D;
+
+        this->cullBindGroupLayout = this->createBindGroupLayout("Occlusion Cull Bind Group Layout", cullEntries, 6);
+        this->depthBindGroupLayout = this->createBindGroupLayout("Hi-Z Depth Bind Group Layout", depthEntries, 3);
+        this->levelBindGroupLayout = this->createBindGroupLayout("Hi-Z Level Bind Group Layout", levelEntries, 2);
+
+        this->cullPipelineLayout = this->createPipelineLayout("Occlusion Cull Pipeline Layout", this->cullBindGroupLayout);
+        this->depthPipelineLayout = this->createPipelineLayout("Hi-Z Depth Pipeline Layout", this->depthBindGroupLayout);
+        this->levelPipelineLayout = this->createPipelineLayout("Hi-Z Level Pipeline Layout", this->levelBindGroupLayout);
+
+        this->earlyCullPipeline = this->createPipeline("Early Occlusion Cull Pipeline", this->cullPipelineLayout, 
+            shaderLibrary->getModule("occlusion_cull.wgsl"));
+
+        this->lateCullPipeline = this->createPipeline("Late Occlusion Cull Pipeline", this->cullPipelineLayout, 
+            shaderLibrary->getModule("occlusion_cull.wgsl", { { "LATE_PHASE", "" } }));
+
+        this->depthBuildPipeline = this->createPipeline("Hi-Z Depth Pipeline", this->depthPipelineLayout, 
+            shaderLibrary->getModule("hiz_build.wgsl", { { "FROM_DEPTH", "" } }));
+
+        this->levelBuildPipeline = this->createPipeline("Hi-Z Level Pipeline", this->levelPipelineLayout, 
+            shaderLibrary->getModule("hiz_build.wgsl"));
+    }
+
+    void OcclusionCuller::releaseDepthBindGroups() {
+        for (auto &&bindGroup : this->depthBindGroups) {
+            if (bindGroup != nullptr) {
+                bindGroup.release();
+                bindGroup = nullptr;
+            }
+        }
+    }
+
+    wgpu::BindGroupLayout OcclusionCuller::createBindGroupLayout(const char* label, wgpu::BindGroupLayoutEntry *entries, uint32_t entryCount) {
+        wgpu::BindGroupLayoutDescriptor bindGroupLayoutDesc{};
+        bindGroupLayoutDesc.label = label;
+        bindGroupLayoutDesc.nextInChain = nullptr;
+        bindGroupLayoutDesc.entryCount = entryCount;
+        bindGroupLayoutDesc.entries = entries;
+
+        return this->device->createBindGroupLayout(bindGroupLayoutDesc);
+    }
+
+    wgpu::PipelineLayout OcclusionCuller::createPipelineLayout(const char* label, wgpu::BindGroupLayout bindGroupLayout) {
+        WGPUBindGroupLayout bindGroupLayouts[1] {
+            bindGroupLayout
+        };
+
+        wgpu::PipelineLayoutDescriptor pipelineLayoutDesc{};
+        pipelineLayoutDesc.label = label;
+        pipelineLayoutDesc.bindGroupLayoutCount = 1;
+        pipelineLayoutDesc.bindGroupLayouts = bindGroupLayouts;
+
+        return this->device->createPipelineLayout(pipelineLayoutDesc);
+    }
+
+    wgpu::ComputePipeline OcclusionCuller::createPipeline(const char* label, wgpu::PipelineLayout layout, wgpu::ShaderModule module) {
+        wgpu::ComputePipelineDescriptor pipelineDesc{};
+        pipelineDesc.label = label;
+        pipelineDesc.layout = layout;
+        pipelineDesc.compute.nextInChain = nullptr;
+        pipelineDesc.compute.module = module;
+        pipelineDesc.compute.entryPoint = "computeMain";
+        pipelineDesc.compute.constantCount = 0;
+        pipelineDesc.compute.constants = nullptr;
+
+        return this->device->createComputePipeline(pipelineDesc);
+    }
+}
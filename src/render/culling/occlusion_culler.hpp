@@ -0,0 +1,157 @@
+#ifndef NUGIE_OCCLUSION_CULLER_HPP
+#define NUGIE_OCCLUSION_CULLER_HPP
+
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "../../device/device.hpp"
+#include "../../shader/library/shader_library.hpp"
+#include "../readback/readback_ring.hpp"
+#include "../../struct.hpp"
+
+namespace nugie {
+    class Device;
+    class ReadbackRing;
+
+    struct CullStats {
+        uint32_t objectCount = 0;
+        uint32_t earlyVisible = 0;
+        uint32_t lateVisible = 0;
+        uint32_t culled = 0;
+    };
+
+    // Two-phase occlusion culling on the GPU against a hierarchical depth (Hi-Z) pyramid.
+    //
+    // The early phase tests every object against the pyramid of the previous frame, from the previous
+    // camera, and writes indirect draw arguments for what was visible then. After those objects are
+    // drawn, the pyramid is rebuilt from the new depth and the late phase re-tests only the rejected
+    // objects from the current camera, so anything that became visible is drawn the same frame.
+    //
+    // A frame is: beginFrame(), dispatchEarly(), the early passes, buildPyramid(), dispatchLate(),
+    // the late pass, then resolveStats() before the frame's commands are finished.
+    class OcclusionCuller {
+    public:
+        OcclusionCuller(nugie::Device *device, nugie::ShaderLibrary *shaderLibrary, nugie::ReadbackRing *readbackRing, uint32_t framesInFlight, 
+            uint32_t maxWidth, uint32_t maxHeight, uint32_t maxObjectCount);
+
+        ~OcclusionCuller();
+
+        // ================================ Object Function ================================
+
+        // Registers a world space box and its indexed draw, returns the object index
+        uint32_t addObject(glm::vec3 boundsMin, glm::vec3 boundsMax, uint32_t indexCount, uint32_t firstIndex = 0, int32_t baseVertex = 0);
+
+        void uploadObjects();
+
+        // Indirect arguments of an object for the early and the late passes
+        BufferInfo getEarlyArgs(uint32_t object) { return BufferInfo{ this->earlyArgsBuffer, DRAW_ARGS_SIZE, object * DRAW_ARGS_SIZE }; }
+        BufferInfo getLateArgs(uint32_t object) { return BufferInfo{ this->lateArgsBuffer, DRAW_ARGS_SIZE, object * DRAW_ARGS_SIZE }; }
+
+        // ================================ Frame Function ================================
+
+        // Depth the pyramid is built from, call it again whenever the view changes
+        void setDepthView(wgpu::TextureView depthView);
+
+        void beginFrame(uint32_t frameSlot, glm::mat4 viewProjection, uint32_t renderWidth, uint32_t renderHeight);
+
+        void dispatchEarly(wgpu::ComputePassEncoder computePassEncoder);
+
+        void buildPyramid(wgpu::ComputePassEncoder computePassEncoder);
+
+        void dispatchLate(wgpu::ComputePassEncoder computePassEncoder);
+
+        // Reads the frame's visible counts back through the ring, skipped when every ring buffer is in use
+        void resolveStats(wgpu::CommandEncoder commandEncoder);
+
+        // Counts of a recent frame, read back asynchronously
+        CullStats getStats() { return this->stats; }
+
+        void release();
+
+    private:
+        static constexpr uint64_t DRAW_ARGS_SIZE = 5 * sizeof(uint32_t);
+        static constexpr uint64_t UNIFORM_STRIDE = 256;
+        static constexpr uint32_t CULL_WORKGROUP_SIZE = 64;
+        static constexpr uint32_t BUILD_WORKGROUP_SIZE = 8;
+
+        // Layout matches CullUniform in common/culling.wgsl
+        struct CullUniform {
+            glm::mat4 viewProjection;
+            glm::mat4 previousViewProjection;
+            glm::vec2 renderSize;
+            glm::vec2 previousRenderSize;
+            uint32_t objectCount;
+            uint32_t mipCount;
+            uint32_t padding[2];
+        };
+
+        // Layout matches CullObject in occlusion_cull.wgsl
+        struct CullObject {
+            glm::vec4 boundsMin;
+            glm::vec4 boundsMax;
+            uint32_t indexCount;
+            uint32_t firstIndex;
+            int32_t baseVertex;
+            uint32_t padding;
+        };
+
+        nugie::Device *device;
+        nugie::ReadbackRing *readbackRing;
+        uint32_t maxObjectCount;
+
+        std::vector<CullObject> objects;
+        CullUniform uniform{};
+        uint32_t frameSlot = 0;
+
+        wgpu::Buffer uniformBuffer;
+        wgpu::Buffer objectBuffer;
+        wgpu::Buffer earlyArgsBuffer;
+        wgpu::Buffer lateArgsBuffer;
+        wgpu::Buffer counterBuffer;
+
+        wgpu::Texture pyramidTexture;
+        wgpu::TextureView pyramidView;
+        std::vector<wgpu::TextureView> levelViews;
+        uint32_t mipCount;
+
+        wgpu::BindGroupLayout cullBindGroupLayout;
+        wgpu::BindGroupLayout depthBindGroupLayout;
+        wgpu::BindGroupLayout levelBindGroupLayout;
+
+        wgpu::PipelineLayout cullPipelineLayout;
+        wgpu::PipelineLayout depthPipelineLayout;
+        wgpu::PipelineLayout levelPipelineLayout;
+
+        wgpu::ComputePipeline earlyCullPipeline;
+        wgpu::ComputePipeline lateCullPipeline;
+        wgpu::ComputePipeline depthBuildPipeline;
+        wgpu::ComputePipeline levelBuildPipeline;
+
+        // Per frame slot, since each points at its own uniform slice
+        std::vector<wgpu::BindGroup> cullBindGroups;
+        std::vector<wgpu::BindGroup> depthBindGroups;
+
+        // Level i reads level i - 1
+        std::vector<wgpu::BindGroup> levelBindGroups;
+
+        CullStats stats;
+
+        bool released = false;
+
+        void createBuffers(uint32_t framesInFlight);
+
+        void createPyramid(uint32_t maxWidth, uint32_t maxHeight);
+
+        void createPipelines(nugie::ShaderLibrary *shaderLibrary);
+
+        void releaseDepthBindGroups();
+
+        wgpu::BindGroupLayout createBindGroupLayout(const char* label, wgpu::BindGroupLayoutEntry *entries, uint32_t entryCount);
+
+        wgpu::PipelineLayout createPipelineLayout(const char* label, wgpu::BindGroupLayout bindGroupLayout);
+
+        wgpu::ComputePipeline createPipeline(const char* label, wgpu::PipelineLayout layout, wgpu::ShaderModule module);
+    };
+}
+
+#endif
@@ -0,0 +1,451 @@
+#include "render_graph.hpp"
+
+#include <algorithm>
+
+namespace nugie {
+    RenderGraph::RenderGraph(nugie::Device *device) : device{device} {
+
+    }
+
+    RenderGraph::~RenderGraph() {
+        this->release();
+    }
+
+    RenderResourceId RenderGraph::createTexture(const char* name, RenderTextureDesc desc) {
+        Resource resource{};
+        resource.name = name;
+        resource.imported = false;
+        resource.desc = desc;
+
+        this->resources.push_back(resource);
+        return static_cast<RenderResourceId>(this->resources.size() - 1);
+    }
+
+    RenderResourceId RenderGraph::importTexture(const char* name, bool keepContents, bool storeContents) {
+        Resource resource{};
+        resource.name = name;
+        resource.imported = true;
+        resource.keepContents = keepContents;
+        resource.storeContents = storeContents;
+
+        this->resources.push_back(resource);
+        return static_cast<RenderResourceId>(this->resources.size() - 1);
+    }
+
+    RenderPassId RenderGraph::addRenderPass(const char* name, std::function<void(wgpu::RenderPassEncoder)> execute) {
+        Pass pass{};
+        pass.name = name;
+        pass.type = PassType::Render;
+        pass.executeRender = std::move(execute);
+
+        this->passes.push_back(std::move(pass));
+        return static_cast<RenderPassId>(this->passes.size() - 1);
+    }
+
+    RenderPassId RenderGraph::addComputePass(const char* name, std::function<void(wgpu::ComputePassEncoder)> execute) {
+        Pass pass{};
+        pass.name = name;
+        pass.type = PassType::Compute;
+        pass.executeCompute = std::move(execute);
+
+        this->passes.push_back(std::move(pass));
+        return static_cast<RenderPassId>(this->passes.size() - 1);
+    }
+
+    void RenderGraph::addColorAttachment(RenderPassId pass, RenderResourceId resource, wgpu::Color clearValue) {
+        Attachment attachment{};
+        attachment.resource = resource;
+        attachment.clearValue = clearValue;
+        attachment.readOnly = false;
+
+        this->passes[pass].colorAttachments.push_back(attachment);
+    }
+
+    void RenderGraph::addDepthAttachment(RenderPassId pass, RenderResourceId resource, float clearValue, bool readOnly) {
+        Attachment attachment{};
+        attachment.resource = resource;
+        attachment.depthClearValue = clearValue;
+        attachment.readOnly = readOnly;
+
+        this->passes[pass].depthAttachments.assign(1, attachment);
+    }
+
+    void RenderGraph::addRead(RenderPassId pass, RenderResourceId resource) {
+        this->passes[pass].reads.push_back(resource);
+    }
+
+    void RenderGraph::addWrite(RenderPassId pass, RenderResourceId resource) {
+        this->passes[pass].writes.push_back(resource);
+    }
+
+    void RenderGraph::setSideEffect(RenderPassId pass) {
+        this->passes[pass].sideEffect = true;
+    }
+
+    void RenderGraph::setTimestampWrites(wgpu::QuerySet querySet, uint32_t beginIndex, uint32_t endIndex) {
+        this->timestampQuerySet = querySet;
+        this->timestampBeginIndex = beginIndex;
+        this->timestampEndIndex = endIndex;
+    }
+
+    void RenderGraph::setOcclusionQuerySet(RenderPassId pass, wgpu::QuerySet querySet) {
+        this->passes[pass].occlusionQuerySet = querySet;
+    }
+
+    void RenderGraph::compile() {
+        this->cullPasses();
+        this->computeLifetimes();
+        this->assignLoadStoreOps();
+        this->allocatePhysicalTextures();
+
+        this->firstLivePass = UINT32_MAX;
+        this->lastLivePass = UINT32_MAX;
+
+        for (uint32_t i = 0; i < this->passes.size(); i++) {
+            Pass &pass = this->passes[i];
+            if (!pass.live) {
+                continue;
+            }
+
+            if (this->firstLivePass == UINT32_MAX) {
+                this->firstLivePass = i;
+            }
+
+            this->lastLivePass = i;
+
+            if (pass.type == PassType::Render) {
+                this->buildNativeAttachments(pass);
+            }
+        }
+    }
+
+    void RenderGraph::setImportedView(RenderResourceId resource, wgpu::TextureView view) {
+        this->resources[resource].importedView = view;
+    }
+
+    void RenderGraph::execute(wgpu::CommandEncoder commandEncoder) {
+        for (uint32_t i = 0; i < this->passes.size(); i++) {
+            Pass &pass = this->passes[i];
+            if (!pass.live) {
+                continue;
+            }
+
+            // Only the first pass writes the beginning timestamp and only the last the end one
+            bool timed = this->timestampQuerySet != nullptr && (i == this->firstLivePass || i == this->lastLivePass);
+            uint32_t beginIndex = i == this->firstLivePass ? this->timestampBeginIndex : WGPU_QUERY_SET_INDEX_UNDEFINED;
+            uint32_t endIndex = i == this->lastLivePass ? this->timestampEndIndex : WGPU_QUERY_SET_INDEX_UNDEFINED;
+
+            if (pass.type == PassType::Compute) {
+                wgpu::ComputePassTimestampWrites timestampWrites{};
+                timestampWrites.querySet = this->timestampQuerySet;
+                timestampWrites.beginningOfPassWriteIndex = beginIndex;
+                timestampWrites.endOfPassWriteIndex = endIndex;
+
+                wgpu::ComputePassDescriptor computePassDesc{};
+                computePassDesc.nextInChain = nullptr;
+                computePassDesc.label = pass.name;
+                computePassDesc.timestampWrites = timed ? &timestampWrites : nullptr;
+
+                wgpu::ComputePassEncoder computePassEncoder = commandEncoder.beginComputePass(computePassDesc);
+                pass.executeCompute(computePassEncoder);
+
+                computePassEncoder.end();
+                computePassEncoder.release();
+
+                continue;
+            }
+
+            // Imported views change every frame, the rest was filled in by compile()
+            for (size_t i = 0; i < pass.colorAttachments.size(); i++) {
+                pass.nativeColorAttachments[i].view = this->getTextureView(pass.colorAttachments[i].resource);
+            }
+
+            if (!pass.depthAttachments.empty()) {
+                pass.nativeDepthAttachment.view = this->getTextureView(pass.depthAttachments[0].resource);
+            }
+
+            wgpu::RenderPassTimestampWrites timestampWrites{};
+            timestampWrites.querySet = this->timestampQuerySet;
+            timestampWrites.beginningOfPassWriteIndex = beginIndex;
+            timestampWrites.endOfPassWriteIndex = endIndex;
+
+            wgpu::RenderPassDescriptor renderPassDesc{};
+            renderPassDesc.nextInChain = nullptr;
+            renderPassDesc.label = pass.name;
+            renderPassDesc.colorAttachmentCount = pass.nativeColorAttachments.size();
+            renderPassDesc.colorAttachments = pass.nativeColorAttachments.data();
+            renderPassDesc.depthStencilAttachment = pass.depthAttachments.empty() ? nullptr : &pass.nativeDepthAttachment;
+            renderPassDesc.timestampWrites = timed ? &timestampWrites : nullptr;
+            renderPassDesc.occlusionQuerySet = pass.occlusionQuerySet;
+
+            wgpu::RenderPassEncoder renderPassEncoder = commandEncoder.beginRenderPass(renderPassDesc);
+            pass.executeRender(renderPassEncoder);
+
+            renderPassEncoder.end();
+            renderPassEncoder.release();
+        }
+    }
+
+    void RenderGraph::release() {
+        this->releasePhysicalTextures();
+    }
+
+    wgpu::TextureView RenderGraph::getTextureView(RenderResourceId resource) {
+        const Resource &entry = this->resources[resource];
+
+        if (entry.imported) {
+            return entry.importedView;
+        }
+
+        return entry.physicalIndex >= 0 ? this->physicalTextures[entry.physicalIndex].view : nullptr;
+    }
+
+    wgpu::Texture RenderGraph::getTexture(RenderResourceId resource) {
+        const Resource &entry = this->resources[resource];
+        return entry.physicalIndex >= 0 ? this->physicalTextures[entry.physicalIndex].texture : nullptr;
+    }
+
+    void RenderGraph::cullPasses() {
+        // Walking backwards, a pass survives if it has a side effect or writes something still needed.
+        // Everything a surviving pass touches is needed by it, including what it writes, since a
+        // partial write depends on the earlier writers of the same texture.
+        std::vector<bool> needed(this->resources.size(), false);
+        for (size_t i = 0; i < this->resources.size(); i++) {
+            needed[i] = this->resources[i].imported && this->resources[i].storeContents;
+        }
+
+        for (size_t p = this->passes.size(); p-- > 0;) {
+            Pass &pass = this->passes[p];
+            pass.live = pass.sideEffect;
+
+            auto markLive = [&](RenderResourceId resource) {
+                if (needed[resource]) {
+                    pass.live = true;
+                }
+            };
+
+            for (auto &&attachment : pass.colorAttachments) markLive(attachment.resource);
+            for (auto &&attachment : pass.depthAttachments) {
+                if (!attachment.readOnly) markLive(attachment.resource);
+            }
+
+            for (auto &&resource : pass.writes) markLive(resource);
+
+            if (!pass.live) {
+                continue;
+            }
+
+            for (auto &&attachment : pass.colorAttachments) needed[attachment.resource] = true;
+            for (auto &&attachment : pass.depthAttachments) needed[attachment.resource] = true;
+            for (auto &&resource : pass.reads) needed[resource] = true;
+            for (auto &&resource : pass.writes) needed[resource] = true;
+        }
+    }
+
+    void RenderGraph::computeLifetimes() {
+        for (auto &&resource : this->resources) {
+            resource.usage = resource.imported ? WGPUTextureUsage_None : resource.desc.extraUsage;
+            resource.firstPass = UINT32_MAX;
+            resource.lastPass = 0;
+        }
+
+        for (uint32_t p = 0; p < this->passes.size(); p++) {
+            Pass &pass = this->passes[p];
+            if (!pass.live) {
+                continue;
+            }
+
+            auto touch = [&](RenderResourceId id, WGPUTextureUsageFlags usage) {
+                Resource &resource = this->resources[id];
+                resource.usage |= usage;
+                resource.firstPass = std::min(resource.firstPass, p);
+                resource.lastPass = std::max(resource.lastPass, p);
+            };
+
+            for (auto &&attachment : pass.colorAttachments) touch(attachment.resource, wgpu::TextureUsage::RenderAttachment);
+            for (auto &&attachment : pass.depthAttachments) touch(attachment.resource, wgpu::TextureUsage::RenderAttachment);
+            for (auto &&resource : pass.reads) touch(resource, wgpu::TextureUsage::TextureBinding);
+            for (auto &&resource : pass.writes) touch(resource, wgpu::TextureUsage::StorageBinding);
+        }
+    }
+
+    void RenderGraph::assignLoadStoreOps() {
+        for (uint32_t p = 0; p < this->passes.size(); p++) {
+            Pass &pass = this->passes[p];
+            if (!pass.live) {
+                continue;
+            }
+
+            auto assign = [&](Attachment &attachment) {
+                const Resource &resource = this->resources[attachment.resource];
+
+                // Contents exist before this pass if an earlier live pass produced them or they were imported
+                bool hasContents = resource.imported ? resource.keepContents || resource.firstPass < p : resource.firstPass < p;
+                bool usedLater = resource.lastPass > p || (resource.imported && resource.storeContents);
+
+                attachment.loadOp = hasContents ? wgpu::LoadOp::Load : wgpu::LoadOp::Clear;
+                attachment.storeOp = usedLater ? wgpu::StoreOp::Store : wgpu::StoreOp::Discard;
+            };
+
+            for (auto &&attachment : pass.colorAttachments) assign(attachment);
+            for (auto &&attachment : pass.depthAttachments) assign(attachment);
+        }
+    }
+
+    void RenderGraph::allocatePhysicalTextures() {
+        this->releasePhysicalTextures();
+        this->transientMemorySize = 0;
+        this->unaliasedMemorySize = 0;
+
+        std::vector<RenderResourceId> order;
+        for (RenderResourceId i = 0; i < this->resources.size(); i++) {
+            this->resources[i].physicalIndex = -1;
+
+            if (!this->resources[i].imported && this->resources[i].firstPass != UINT32_MAX) {
+                order.push_back(i);
+            }
+        }
+
+        std::sort(order.begin(), order.end(), [this](RenderResourceId a, RenderResourceId b) {
+            return this->resources[a].firstPass < this->resources[b].firstPass;
+        });
+
+        // WebGPU has no memory heaps to place resources in, so aliasing happens at the texture level:
+        // a compatible texture whose last user ran before this resource's first user is handed over.
+        for (auto &&id : order) {
+            Resource &resource = this->resources[id];
+            uint64_t size = uint64_t(resource.desc.width) * resource.desc.height * getBytesPerPixel(resource.desc.format);
+            this->unaliasedMemorySize += size;
+
+            for (size_t i = 0; i < this->physicalTextures.size(); i++) {
+                PhysicalTexture &physical = this->physicalTextures[i];
+
+                if (physical.lastPass < resource.firstPass &&
+                    physical.desc.width == resource.desc.width &&
+                    physical.desc.height == resource.desc.height &&
+                    physical.desc.format == resource.desc.format &&
+                    physical.usage == resource.usage)
+                {
+                    physical.lastPass = resource.lastPass;
+                    resource.physicalIndex = static_cast<int32_t>(i);
+                    break;
+                }
+            }
+
+            if (resource.physicalIndex >= 0) {
+                continue;
+            }
+
+            wgpu::TextureDescriptor textureDesc{};
+            textureDesc.nextInChain = nullptr;
+            textureDesc.label = resource.name;
+            textureDesc.dimension = wgpu::TextureDimension::_2D;
+            textureDesc.size = { resource.desc.width, resource.desc.height, 1 };
+            textureDesc.mipLevelCount = 1;
+            textureDesc.sampleCount = 1;
+            textureDesc.format = resource.desc.format;
+            textureDesc.usage = resource.usage;
+
+            PhysicalTexture physical{};
+            physical.desc = resource.desc;
+            physical.usage = resource.usage;
+            physical.lastPass = resource.lastPass;
+            physical.texture = this->device->createTexture(textureDesc);
+
+            wgpu::TextureViewDescriptor textureViewDesc{};
+            textureViewDesc.nextInChain = nullptr;
+            textureViewDesc.aspect = isDepthFormat(resource.desc.format) ? wgpu::TextureAspect::DepthOnly : wgpu::TextureAspect::All;
+            textureViewDesc.dimension = wgpu::TextureViewDimension::_2D;
+            textureViewDesc.arrayLayerCount = 1;
+            textureViewDesc.baseArrayLayer = 0;
+            textureViewDesc.mipLevelCount = 1;
+            textureViewDesc.baseMipLevel = 0;
+            textureViewDesc.format = resource.desc.format;
+
+            physical.view = physical.texture.createView(textureViewDesc);
+
+            resource.physicalIndex = static_cast<int32_t>(this->physicalTextures.size());
+            this->physicalTextures.push_back(physical);
+            this->transientMemorySize += size;
+        }
+    }
+
+    void RenderGraph::releasePhysicalTextures() {
+        for (auto &&physical : this->physicalTextures) {
+            if (this->deletionQueue != nullptr) {
+                this->deletionQueue->release(physical.view);
+                this->deletionQueue->release(physical.texture);
+            } else {
+                physical.view.release();
+                this->device->releaseTexture(physical.texture);
+            }
+        }
+
+        this->physicalTextures.clear();
+    }
+
+    void RenderGraph::buildNativeAttachments(Pass &pass) {
+        pass.nativeColorAttachments.resize(pass.colorAttachments.size());
+
+        for (size_t i = 0; i < pass.colorAttachments.size(); i++) {
+            const Attachment &attachment = pass.colorAttachments[i];
+            wgpu::RenderPassColorAttachment &colorAttach = pass.nativeColorAttachments[i];
+
+            colorAttach = wgpu::RenderPassColorAttachment{};
+            colorAttach.nextInChain = nullptr;
+            colorAttach.view = nullptr;
+            colorAttach.loadOp = attachment.loadOp;
+            colorAttach.storeOp = attachment.storeOp;
+            colorAttach.clearValue = attachment.clearValue;
+            colorAttach.resolveTarget = nullptr;
+
+            #ifndef WEBGPU_BACKEND_WGPU
+                colorAttach.depthSlice = WGPU_DEPTH_SLICE_UNDEFINED;
+            #endif // NOT WEBGPU_BACKEND_WGPU
+        }
+
+        if (pass.depthAttachments.empty()) {
+            return;
+        }
+
+        const Attachment &attachment = pass.depthAttachments[0];
+        wgpu::RenderPassDepthStencilAttachment &depthAttach = pass.nativeDepthAttachment;
+
+        depthAttach = wgpu::RenderPassDepthStencilAttachment{};
+        depthAttach.view = nullptr;
+        depthAttach.depthClearValue = attachment.depthClearValue;
+        depthAttach.depthReadOnly = attachment.readOnly;
+
+        // Read-only depth must not name load/store ops at all
+        depthAttach.depthLoadOp = attachment.readOnly ? wgpu::LoadOp::Undefined : attachment.loadOp;
+        depthAttach.depthStoreOp = attachment.readOnly ? wgpu::StoreOp::Undefined : attachment.storeOp;
+
+        depthAttach.stencilLoadOp = wgpu::LoadOp::Undefined;
+        depthAttach.stencilStoreOp = wgpu::StoreOp::Undefined;
+        depthAttach.stencilClearValue = 0;
+        depthAttach.stencilReadOnly = true;
+    }
+
+    bool RenderGraph::isDepthFormat(wgpu::TextureFormat format) {
+        return format == wgpu::TextureFormat::Depth16Unorm ||
+            format == wgpu::TextureFormat::Depth24Plus ||
+            format == wgpu::TextureFormat::Depth24PlusStencil8 ||
+            format == wgpu::TextureFormat::Depth32Float;
+    }
+
+    uint32_t RenderGraph::getBytesPerPixel(wgpu::TextureFormat format) {
+        if (format == wgpu::TextureFormat::Depth16Unorm || format == wgpu::TextureFormat::R16Float) {
+            return 2;
+        }
+
+        if (format == wgpu::TextureFormat::RGBA16Float || format == wgpu::TextureFormat::RG32Float) {
+            return 8;
+        }
+
+        if (format == wgpu::TextureFormat::RGBA32Float) {
+            return 16;
+        }
+
+        return 4;
+    }
+}
@@ -0,0 +1,192 @@
+#ifndef NUGIE_RENDER_GRAPH_HPP
+#define NUGIE_RENDER_GRAPH_HPP
+
+#include <vector>
+#include <functional>
+
+#include "../../device/device.hpp"
+#include "../../frame/deletion/deletion_queue.hpp"
+
+namespace nugie {
+    class Device;
+
+    using RenderResourceId = uint32_t;
+    using RenderPassId = uint32_t;
+
+    struct RenderTextureDesc {
+        uint32_t width;
+        uint32_t height;
+        wgpu::TextureFormat format;
+
+        // Added to whatever usage the graph derives from the passes
+        WGPUTextureUsageFlags extraUsage = wgpu::TextureUsage::None;
+    };
+
+    // Passes declare the textures they read and write and the graph works out the rest:
+    // passes whose results never reach an output are culled, transient textures whose lifetimes
+    // do not overlap share one physical texture, and every attachment gets the cheapest
+    // load/store ops that still keep the contents later passes depend on.
+    //
+    // The graph is built once, compiled, then executed every frame. Only imported views
+    // (such as the surface texture) are expected to change between frames.
+    class RenderGraph {
+    public:
+        RenderGraph(nugie::Device *device);
+        ~RenderGraph();
+
+        // ================================ Declaration Function ================================
+
+        RenderResourceId createTexture(const char* name, RenderTextureDesc desc);
+
+        // keepContents loads what the texture held before the graph ran, storeContents keeps the result after it
+        RenderResourceId importTexture(const char* name, bool keepContents, bool storeContents);
+
+        RenderPassId addRenderPass(const char* name, std::function<void(wgpu::RenderPassEncoder)> execute);
+
+        RenderPassId addComputePass(const char* name, std::function<void(wgpu::ComputePassEncoder)> execute);
+
+        void addColorAttachment(RenderPassId pass, RenderResourceId resource, wgpu::Color clearValue = wgpu::Color{ 0, 0, 0, 0 });
+
+        void addDepthAttachment(RenderPassId pass, RenderResourceId resource, float clearValue = 1.0f, bool readOnly = false);
+
+        // The pass samples or loads the texture in a shader
+        void addRead(RenderPassId pass, RenderResourceId resource);
+
+        // The pass writes the texture from a shader, as a storage texture
+        void addWrite(RenderPassId pass, RenderResourceId resource);
+
+        // Keeps the pass alive even when nothing reads what it writes
+        void setSideEffect(RenderPassId pass);
+
+        // Writes a GPU timestamp at the beginning of the first pass that runs and at the end of the last,
+        // so the two bracket the whole graph. May be changed every frame.
+        void setTimestampWrites(wgpu::QuerySet querySet, uint32_t beginIndex, uint32_t endIndex);
+
+        // Lets the pass begin and end occlusion queries of this set
+        void setOcclusionQuerySet(RenderPassId pass, wgpu::QuerySet querySet);
+
+        // Physical textures replaced by a later compile() go through the queue instead of being released
+        // immediately, so the graph can be recompiled (on a resize for example) without waiting for the GPU
+        void setDeletionQueue(DeletionQueue *deletionQueue) { this->deletionQueue = deletionQueue; }
+
+        // ================================ Lifecycle Function ================================
+
+        // Culls passes, computes lifetimes and load/store ops, and (re)allocates physical textures
+        void compile();
+
+        void setImportedView(RenderResourceId resource, wgpu::TextureView view);
+
+        void execute(wgpu::CommandEncoder commandEncoder);
+
+        void release();
+
+        // ================================ Getter Function ================================
+
+        wgpu::TextureView getTextureView(RenderResourceId resource);
+
+        wgpu::Texture getTexture(RenderResourceId resource);
+
+        bool isPassCulled(RenderPassId pass) { return !this->passes[pass].live; }
+
+        uint32_t getPhysicalTextureCount() { return static_cast<uint32_t>(this->physicalTextures.size()); }
+
+        // Bytes of all physical transient textures, and what they would take without aliasing
+        uint64_t getTransientMemorySize() { return this->transientMemorySize; }
+        uint64_t getUnaliasedMemorySize() { return this->unaliasedMemorySize; }
+
+    private:
+        enum class PassType {
+            Render,
+            Compute
+        };
+
+        struct Attachment {
+            RenderResourceId resource;
+            wgpu::Color clearValue;
+            float depthClearValue;
+            bool readOnly;
+            wgpu::LoadOp loadOp = wgpu::LoadOp::Clear;
+            wgpu::StoreOp storeOp = wgpu::StoreOp::Store;
+        };
+
+        struct Pass {
+            const char* name;
+            PassType type;
+            std::function<void(wgpu::RenderPassEncoder)> executeRender;
+            std::function<void(wgpu::ComputePassEncoder)> executeCompute;
+
+            std::vector<Attachment> colorAttachments;
+            std::vector<Attachment> depthAttachments;
+            std::vector<RenderResourceId> reads;
+            std::vector<RenderResourceId> writes;
+
+            bool sideEffect = false;
+            bool live = true;
+
+            wgpu::QuerySet occlusionQuerySet = nullptr;
+
+            std::vector<wgpu::RenderPassColorAttachment> nativeColorAttachments;
+            wgpu::RenderPassDepthStencilAttachment nativeDepthAttachment;
+        };
+
+        struct Resource {
+            const char* name;
+            bool imported;
+            bool keepContents = false;
+            bool storeContents = false;
+            RenderTextureDesc desc;
+
+            WGPUTextureUsageFlags usage = wgpu::TextureUsage::None;
+            uint32_t firstPass = UINT32_MAX;
+            uint32_t lastPass = 0;
+            int32_t physicalIndex = -1;
+
+            wgpu::TextureView importedView;
+        };
+
+        struct PhysicalTexture {
+            RenderTextureDesc desc;
+            WGPUTextureUsageFlags usage;
+            uint32_t lastPass;
+
+            wgpu::Texture texture;
+            wgpu::TextureView view;
+        };
+
+        nugie::Device *device;
+        nugie::DeletionQueue *deletionQueue = nullptr;
+
+        std::vector<Pass> passes;
+        std::vector<Resource> resources;
+        std::vector<PhysicalTexture> physicalTextures;
+
+        uint64_t transientMemorySize = 0;
+        uint64_t unaliasedMemorySize = 0;
+
+        wgpu::QuerySet timestampQuerySet = nullptr;
+        uint32_t timestampBeginIndex = 0;
+        uint32_t timestampEndIndex = 0;
+
+        // Of the passes that survived culling, set by compile()
+        uint32_t firstLivePass = UINT32_MAX;
+        uint32_t lastLivePass = UINT32_MAX;
+
+        void cullPasses();
+
+        void computeLifetimes();
+
+        void assignLoadStoreOps();
+
+        void allocatePhysicalTextures();
+
+        void releasePhysicalTextures();
+
+        void buildNativeAttachments(Pass &pass);
+
+        static bool isDepthFormat(wgpu::TextureFormat format);
+
+        static uint32_t getBytesPerPixel(wgpu::TextureFormat format);
+    };
+}
+
+#endif
@@ -0,0 +1,153 @@
+#include "clustered_lighting.hpp"
+
+#include <algorithm>
+
+namespace nugie {
+    ClusteredLighting::ClusteredLighting(nugie::Device *device, nugie::ShaderLibrary *shaderLibrary, uint32_t maxLightCount)
+    : device{device},
+      maxLightCount{std::max(maxLightCount, 1u)}
+    {
+        this->createBuffers();
+        this->createCullPipeline(shaderLibrary);
+    }
+
+    ClusteredLighting::~ClusteredLighting() {
+        this->release();
+    }
+
+    void ClusteredLighting::setLights(const std::vector<Light> &lights) {
+        this->lightCount = static_cast<uint32_t>(std::min<size_t>(lights.size(), this->maxLightCount));
+
+        if (this->lightCount > 0) {
+            this->device->writeBuffer(this->lightBuffer, 0, lights.data(), this->lightCount * sizeof(Light));
+        }
+    }
+
+    void ClusteredLighting::beginFrame() {
+        uint32_t zero = 0;
+        this->device->writeBuffer(this->counterBuffer, 0, &zero, sizeof(uint32_t));
+    }
+
+    void ClusteredLighting::dispatch(wgpu::ComputePassEncoder computePassEncoder, wgpu::BindGroup cullBindGroup) {
+        computePassEncoder.setPipeline(this->cullPipeline);
+        computePassEncoder.setBindGroup(0, cullBindGroup, 0, nullptr);
+        computePassEncoder.dispatchWorkgroups(CLUSTER_COUNT_X, CLUSTER_COUNT_Y, CLUSTER_COUNT_Z);
+    }
+
+    wgpu::BindGroup ClusteredLighting::createCullBindGroup(BufferInfo sceneUniformInfo) {
+        BufferInfo infos[5] {
+            sceneUniformInfo,
+            this->getLightBufferInfo(),
+            this->getClusterBufferInfo(),
+            this->getIndexBufferInfo(),
+            BufferInfo{ this->counterBuffer, this->counterBuffer.getSize(), 0 }
+        };
+
+        wgpu::BindGroupEntry bindGroupEntries[5];
+        for (uint32_t i = 0; i < 5; i++) {
+            bindGroupEntries[i].nextInChain = nullptr;
+            bindGroupEntries[i].binding = i;
+            bindGroupEntries[i].buffer = infos[i].buffer;
+            bindGroupEntries[i].offset = infos[i].offset;
+            bindGroupEntries[i].size = infos[i].size;
+        }
+
+        wgpu::BindGroupDescriptor bindGroupDesc{};
+        bindGroupDesc.label = "Light Cull Bind Group";
+        bindGroupDesc.nextInChain = nullptr;
+        bindGroupDesc.entryCount = 5;
+        bindGroupDesc.entries = bindGroupEntries;
+        bindGroupDesc.layout = this->cullBindGroupLayout;
+
+        return this->device->createBindGroup(bindGroupDesc);
+    }
+
+    void ClusteredLighting::release() {
+        if (this->released) {
+            return;
+        }
+
+        this->cullPipeline.release();
+        this->cullPipelineLayout.release();
+        this->cullBindGroupLayout.release();
+
+        this->device->releaseBuffer(this->counterBuffer);
+        this->device->releaseBuffer(this->indexBuffer);
+        this->device->releaseBuffer(this->clusterBuffer);
+        this->device->releaseBuffer(this->lightBuffer);
+
+        this->released = true;
+    }
+
+    void ClusteredLighting::createBuffers() {
+        wgpu::BufferDescriptor bufferDesc{};
+        bufferDesc.mappedAtCreation = false;
+
+        bufferDesc.label = "Light Buffer";
+        bufferDesc.size = this->maxLightCount * sizeof(Light);
+        bufferDesc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst;
+        this->lightBuffer = this->device->createBuffer(bufferDesc);
+
+        // One offset and count pair per cluster
+        bufferDesc.label = "Cluster Light Buffer";
+        bufferDesc.size = this->getClusterCount() * 2 * sizeof(uint32_t);
+        bufferDesc.usage = wgpu::BufferUsage::Storage;
+        this->clusterBuffer = this->device->createBuffer(bufferDesc);
+
+        bufferDesc.label = "Light Index Buffer";
+        bufferDesc.size = this->getClusterCount() * AVERAGE_LIGHTS_PER_CLUSTER * sizeof(uint32_t);
+        bufferDesc.usage = wgpu::BufferUsage::Storage;
+        this->indexBuffer = this->device->createBuffer(bufferDesc);
+
+        bufferDesc.label = "Light Index Counter Buffer";
+        bufferDesc.size = sizeof(uint32_t);
+        bufferDesc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst;
+        this->counterBuffer = this->device->createBuffer(bufferDesc);
+    }
+
+    void ClusteredLighting::createCullPipeline(nugie::ShaderLibrary *shaderLibrary) {
+        wgpu::BindGroupLayoutEntry bindGroupLayoutEntries[5];
+
+        for (uint32_t i = 0; i < 5; i++) {
+            bindGroupLayoutEntries[i].nextInChain = nullptr;
+            bindGroupLayoutEntries[i].binding = i;
+            bindGroupLayoutEntries[i].visibility = wgpu::ShaderStage::Compute;
+            bindGroupLayoutEntries[i].buffer.nextInChain = nullptr;
+            bindGroupLayoutEntries[i].buffer.hasDynamicOffset = false;
+            bindGroupLayoutEntries[i].buffer.type = wgpu::BufferBindingType::Storage;
+        }
+
+        bindGroupLayoutEntries[0].buffer.type = wgpu::BufferBindingType::Uniform;
+        bindGroupLayoutEntries[1].buffer.type = wgpu::BufferBindingType::ReadOnlyStorage;
+
+        wgpu::BindGroupLayoutDescriptor bindGroupLayoutDesc{};
+        bindGroupLayoutDesc.label = "Light Cull Bind Group Layout";
+        bindGroupLayoutDesc.nextInChain = nullptr;
+        bindGroupLayoutDesc.entryCount = 5;
+        bindGroupLayoutDesc.entries = bindGroupLayoutEntries;
+
+        this->cullBindGroupLayout = this->device->createBindGroupLayout(bindGroupLayoutDesc);
+
+        WGPUBindGroupLayout bindGroupLayouts[1] {
+            this->cullBindGroupLayout
+        };
+
+        wgpu::PipelineLayoutDescriptor pipelineLayoutDesc{};
+        pipelineLayoutDesc.label = "Light Cull Pipeline Layout";
+        pipelineLayoutDesc.bindGroupLayoutCount = 1;
+        pipelineLayoutDesc.bindGroupLayouts = bindGroupLayouts;
+
+        this->cullPipelineLayout = this->device->createPipelineLayout(pipelineLayoutDesc);
+
+        wgpu::ComputePipelineDescriptor pipelineDesc{};
+        pipelineDesc.label = "Light Cull Pipeline";
+        pipelineDesc.layout = this->cullPipelineLayout;
+        pipelineDesc.compute.nextInChain = nullptr;
+        pipelineDesc.compute.module = shaderLibrary->getModule("light_cluster.wgsl");
+        pipelineDesc.compute.entryPoint = "computeMain";
+        pipelineDesc.compute.constantCount = 0;
+        pipelineDesc.compute.constants = nullptr;
+
+        this->cullPipeline = this->device->createComputePipeline(pipelineDesc);
+    }
+}
@@ -0,0 +1,76 @@
+#ifndef NUGIE_CLUSTERED_LIGHTING_HPP
+#define NUGIE_CLUSTERED_LIGHTING_HPP
+
+#include <vector>
+
+#include "../../device/device.hpp"
+#include "../../shader/library/shader_library.hpp"
+#include "../../struct.hpp"
+
+namespace nugie {
+    class Device;
+
+    // Bins point and spot lights into a froxel grid every frame with a compute pass. The grid splits
+    // the view frustum into screen tiles and exponential depth slices, built from the inverse projection
+    // in the scene uniform, and every cluster gets a compact list of the lights that touch it.
+    //
+    // The scene uniform must carry the view, inverse projection, planes, screen size, cluster counts
+    // and light count (see common/uniforms.wgsl). The scene bind group then exposes the light, cluster
+    // and index buffers read-only so fragment shaders only loop over their own cluster's lights.
+    class ClusteredLighting {
+    public:
+        static constexpr uint32_t CLUSTER_COUNT_X = 16;
+        static constexpr uint32_t CLUSTER_COUNT_Y = 9;
+        static constexpr uint32_t CLUSTER_COUNT_Z = 24;
+
+        // Sizes the shared index list, a cluster may use more as long as the average holds
+        static constexpr uint32_t AVERAGE_LIGHTS_PER_CLUSTER = 32;
+
+        ClusteredLighting(nugie::Device *device, nugie::ShaderLibrary *shaderLibrary, uint32_t maxLightCount);
+        ~ClusteredLighting();
+
+        // Uploads the lights, anything past the maximum is ignored
+        void setLights(const std::vector<Light> &lights);
+
+        // Resets the index list, once per frame before the cull pass is submitted
+        void beginFrame();
+
+        void dispatch(wgpu::ComputePassEncoder computePassEncoder, wgpu::BindGroup cullBindGroup);
+
+        wgpu::BindGroup createCullBindGroup(BufferInfo sceneUniformInfo);
+
+        // ================================ Getter Function ================================
+
+        uint32_t getLightCount() { return this->lightCount; }
+
+        uint32_t getClusterCount() { return CLUSTER_COUNT_X * CLUSTER_COUNT_Y * CLUSTER_COUNT_Z; }
+
+        BufferInfo getLightBufferInfo() { return BufferInfo{ this->lightBuffer, this->lightBuffer.getSize(), 0 }; }
+        BufferInfo getClusterBufferInfo() { return BufferInfo{ this->clusterBuffer, this->clusterBuffer.getSize(), 0 }; }
+        BufferInfo getIndexBufferInfo() { return BufferInfo{ this->indexBuffer, this->indexBuffer.getSize(), 0 }; }
+
+        void release();
+
+    private:
+        nugie::Device *device;
+        uint32_t maxLightCount;
+        uint32_t lightCount = 0;
+
+        wgpu::Buffer lightBuffer;
+        wgpu::Buffer clusterBuffer;
+        wgpu::Buffer indexBuffer;
+        wgpu::Buffer counterBuffer;
+
+        wgpu::BindGroupLayout cullBindGroupLayout;
+        wgpu::PipelineLayout cullPipelineLayout;
+        wgpu::ComputePipeline cullPipeline;
+
+        bool released = false;
+
+        void createBuffers();
+
+        void createCullPipeline(nugie::ShaderLibrary *shaderLibrary);
+    };
+}
+
+#endif
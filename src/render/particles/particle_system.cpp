@@ -0,0 +1,442 @@
+#include "particle_system.hpp"
+
+#include <cmath>
+#include <vector>
+#include <numeric>
+#include <algorithm>
+#include <stdexcept>
+
+namespace nugie {
+    ParticleSystem::ParticleSystem(nugie::Device *device, nugie::ShaderLibrary *shaderLibrary, uint32_t maxParticleCount,
+        wgpu::TextureFormat colorFormat, wgpu::TextureFormat depthFormat)
+    : device{device},
+      maxParticleCount{std::max(maxParticleCount, 1u)}
+    {
+        // Emitting or simulating the whole pool must fit in one dispatch
+        if (this->maxParticleCount > MAX_WORKGROUPS * WORKGROUP_SIZE) {
+            throw std::runtime_error("particle pool is larger than one dispatch can cover");
+        }
+
+        this->createBuffers();
+        this->reset();
+
+        this->createComputePipelines(shaderLibrary);
+
+        if (colorFormat != wgpu::TextureFormat::Undefined) {
+            this->createRenderPipeline(shaderLibrary, colorFormat, depthFormat);
+        }
+
+        this->createBindGroups();
+    }
+
+    ParticleSystem::~ParticleSystem() {
+        this->release();
+    }
+
+    void ParticleSystem::reset() {
+        // Every particle starts out dead
+        std::vector<uint32_t> deadList(this->maxParticleCount);
+        std::iota(deadList.begin(), deadList.end(), 0u);
+        this->device->writeBuffer(this->deadListBuffer, 0, deadList.data(), deadList.size() * sizeof(uint32_t));
+
+        uint32_t counters[4] { this->maxParticleCount, 0, 0, 0 };
+        this->device->writeBuffer(this->counterBuffer, 0, counters, sizeof(counters));
+
+        this->emitRemainder = 0.0f;
+        this->pendingBurst = 0;
+        this->frameCount = 0;
+    }
+
+    void ParticleSystem::burst(uint32_t count) {
+        this->pendingBurst = std::min(this->pendingBurst + count, this->maxParticleCount);
+    }
+
+    void ParticleSystem::update(float deltaTime, glm::mat4 viewProjection, glm::vec3 cameraRight, glm::vec3 cameraUp) {
+        float wanted = this->emitter.rate * std::max(deltaTime, 0.0f) + this->emitRemainder;
+        float whole = std::floor(wanted);
+
+        this->emitRemainder = wanted - whole;
+
+        uint32_t emitRequest = static_cast<uint32_t>(std::min(whole, static_cast<float>(this->maxParticleCount))) + this->pendingBurst;
+        this->pendingBurst = 0;
+
+        this->params.viewProjection = viewProjection;
+        this->params.cameraRightSize = glm::vec4{ cameraRight, this->emitter.size };
+        this->params.cameraUp = glm::vec4{ cameraUp, 0.0f };
+        this->params.emitterPositionRadius = glm::vec4{ this->emitter.position, this->emitter.radius };
+        this->params.emitterVelocityJitter = glm::vec4{ this->emitter.velocity, this->emitter.velocityJitter };
+        this->params.gravityDrag = glm::vec4{ this->emitter.gravity, this->emitter.drag };
+        this->params.startColor = this->emitter.startColor;
+        this->params.endColor = this->emitter.endColor;
+        this->params.deltaTime = deltaTime;
+        this->params.lifetimeMin = this->emitter.lifetimeMin;
+        this->params.lifetimeMax = std::max(this->emitter.lifetimeMax, this->emitter.lifetimeMin);
+        this->params.emitRequest = std::min(emitRequest, this->maxParticleCount);
+        this->params.maxParticles = this->maxParticleCount;
+
+        // Last frame's output list is this frame's input
+        this->params.parity = this->frameCount & 1u;
+        this->params.seed = this->frameCount * 2654435761u;
+        this->frameCount++;
+
+        this->device->writeBuffer(this->paramsBuffer, 0, &this->params, sizeof(ParticleParams));
+    }
+
+    void ParticleSystem::dispatch(wgpu::ComputePassEncoder computePassEncoder) {
+        computePassEncoder.setBindGroup(0, this->stateBindGroup, 0, nullptr);
+        computePassEncoder.setBindGroup(1, this->argsBindGroup, 0, nullptr);
+
+        computePassEncoder.setPipeline(this->beginPipeline);
+        computePassEncoder.dispatchWorkgroups(1, 1, 1);
+
+        if (this->params.emitRequest > 0) {
+            computePassEncoder.setPipeline(this->emitPipeline);
+            computePassEncoder.dispatchWorkgroups((this->params.emitRequest + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1, 1);
+        }
+
+        computePassEncoder.setPipeline(this->simulatePipeline);
+        computePassEncoder.dispatchWorkgroupsIndirect(this->dispatchArgsBuffer, 0);
+
+        computePassEncoder.setPipeline(this->finishPipeline);
+        computePassEncoder.dispatchWorkgroups(1, 1, 1);
+    }
+
+    void ParticleSystem::draw(wgpu::RenderPassEncoder renderPassEncoder) {
+        renderPassEncoder.setPipeline(this->renderPipeline);
+        renderPassEncoder.setBindGroup(0, this->renderBindGroup, 0, nullptr);
+        renderPassEncoder.drawIndirect(this->drawArgsBuffer, 0);
+    }
+
+    void ParticleSystem::release() {
+        if (this->released) {
+            return;
+        }
+
+        if (this->renderPipeline) {
+            this->renderBindGroup.release();
+            this->renderPipeline.release();
+            this->renderPipelineLayout.release();
+            this->renderBindGroupLayout.release();
+        }
+
+        this->argsBindGroup.release();
+        this->stateBindGroup.release();
+
+        this->finishPipeline.release();
+        this->simulatePipeline.release();
+        this->emitPipeline.release();
+        this->beginPipeline.release();
+
+        this->statePipelineLayout.release();
+        this->argsPipelineLayout.release();
+        this->argsBindGroupLayout.release();
+        this->stateBindGroupLayout.release();
+
+        this->device->releaseBuffer(this->drawArgsBuffer);
+        this->device->releaseBuffer(this->dispatchArgsBuffer);
+        this->device->releaseBuffer(this->counterBuffer);
+        this->device->releaseBuffer(this->aliveListBuffer);
+        this->device->releaseBuffer(this->deadListBuffer);
+        this->device->releaseBuffer(this->particleBuffer);
+        this->device->releaseBuffer(this->paramsBuffer);
+
+        this->released = true;
+    }
+
+    void ParticleSystem::createBuffers() {
+        wgpu::BufferDescriptor bufferDesc{};
+        bufferDesc.mappedAtCreation = false;
+
+        bufferDesc.label = "Particle Params Buffer";
+        bufferDesc.size = sizeof(ParticleParams);
+        bufferDesc.usage = wgpu::BufferUsage::Uniform | wgpu::BufferUsage::CopyDst;
+        this->paramsBuffer = this->device->createBuffer(bufferDesc);
+
+        bufferDesc.label = "Particle Buffer";
+        bufferDesc.size = this->maxParticleCount * sizeof(Particle);
+        bufferDesc.usage = wgpu::BufferUsage::Storage;
+        this->particleBuffer = this->device->createBuffer(bufferDesc);
+
+        bufferDesc.label = "Particle Dead List Buffer";
+        bufferDesc.size = this->maxParticleCount * sizeof(uint32_t);
+        bufferDesc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst;
+        this->deadListBuffer = this->device->createBuffer(bufferDesc);
+
+        // Two lists, the one read this frame and the one the survivors are compacted into
+        bufferDesc.label = "Particle Alive List Buffer";
+        bufferDesc.size = 2 * this->maxParticleCount * sizeof(uint32_t);
+        bufferDesc.usage = wgpu::BufferUsage::Storage;
+        this->aliveListBuffer = this->device->createBuffer(bufferDesc);
+
+        // Dead count, the two alive counts and the count emitted this frame
+        bufferDesc.label = "Particle Counter Buffer";
+        bufferDesc.size = 4 * sizeof(uint32_t);
+        bufferDesc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst;
+        this->counterBuffer = this->device->createBuffer(bufferDesc);
+
+        bufferDesc.label = "Particle Dispatch Args Buffer";
+        bufferDesc.size = 3 * sizeof(uint32_t);
+        bufferDesc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::Indirect;
+        this->dispatchArgsBuffer = this->device->createBuffer(bufferDesc);
+
+        bufferDesc.label = "Particle Draw Args Buffer";
+        bufferDesc.size = 4 * sizeof(uint32_t);
+        bufferDesc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::Indirect;
+        this->drawArgsBuffer = this->device->createBuffer(bufferDesc);
+    }
+
+    void ParticleSystem::createComputePipelines(nugie::ShaderLibrary *shaderLibrary) {
+        const ShaderReflection &reflection = shaderLibrary->getReflection("particle_simulate.wgsl");
+
+        reflection.validateStruct("ParticleParams", sizeof(ParticleParams), {
+            { "viewProjection", offsetof(ParticleParams, viewProjection) },
+            { "cameraRightSize", offsetof(ParticleParams, cameraRightSize) },
+            { "cameraUp", offsetof(ParticleParams, cameraUp) },
+            { "emitterPositionRadius", offsetof(ParticleParams, emitterPositionRadius) },
+            { "emitterVelocityJitter", offsetof(ParticleParams, emitterVelocityJitter) },
+            { "gravityDrag", offsetof(ParticleParams, gravityDrag) },
+            { "startColor", offsetof(ParticleParams, startColor) },
+            { "endColor", offsetof(ParticleParams, endColor) },
+            { "deltaTime", offsetof(ParticleParams, deltaTime) },
+            { "lifetimeMin", offsetof(ParticleParams, lifetimeMin) },
+            { "lifetimeMax", offsetof(ParticleParams, lifetimeMax) },
+            { "emitRequest", offsetof(ParticleParams, emitRequest) },
+            { "maxParticles", offsetof(ParticleParams, maxParticles) },
+            { "parity", offsetof(ParticleParams, parity) },
+            { "seed", offsetof(ParticleParams, seed) }
+        });
+
+        reflection.validateStruct("Particle", sizeof(Particle), {
+            { "positionAge", offsetof(Particle, positionAge) },
+            { "velocityLifetime", offsetof(Particle, velocityLifetime) }
+        });
+
+        wgpu::BindGroupLayoutEntry stateEntries[5];
+
+        for (uint32_t i = 0; i < 5; i++) {
+            stateEntries[i].nextInChain = nullptr;
+            stateEntries[i].binding = i;
+            stateEntries[i].visibility = wgpu::ShaderStage::Compute;
+            stateEntries[i].buffer.nextInChain = nullptr;
+            stateEntries[i].buffer.hasDynamicOffset = false;
+            stateEntries[i].buffer.type = wgpu::BufferBindingType::Storage;
+        }
+
+        stateEntries[0].buffer.type = wgpu::BufferBindingType::Uniform;
+
+        wgpu::BindGroupLayoutDescriptor bindGroupLayoutDesc{};
+        bindGroupLayoutDesc.label = "Particle State Bind Group Layout";
+        bindGroupLayoutDesc.nextInChain = nullptr;
+        bindGroupLayoutDesc.entryCount = 5;
+        bindGroupLayoutDesc.entries = stateEntries;
+
+        this->stateBindGroupLayout = this->device->createBindGroupLayout(bindGroupLayoutDesc);
+
+        wgpu::BindGroupLayoutEntry argsEntries[2];
+
+        for (uint32_t i = 0; i < 2; i++) {
+            argsEntries[i].nextInChain = nullptr;
+            argsEntries[i].binding = i;
+            argsEntries[i].visibility = wgpu::ShaderStage::Compute;
+            argsEntries[i].buffer.nextInChain = nullptr;
+            argsEntries[i].buffer.hasDynamicOffset = false;
+            argsEntries[i].buffer.type = wgpu::BufferBindingType::Storage;
+        }
+
+        bindGroupLayoutDesc.label = "Particle Args Bind Group Layout";
+        bindGroupLayoutDesc.entryCount = 2;
+        bindGroupLayoutDesc.entries = argsEntries;
+
+        this->argsBindGroupLayout = this->device->createBindGroupLayout(bindGroupLayoutDesc);
+
+        WGPUBindGroupLayout bindGroupLayouts[2] {
+            this->stateBindGroupLayout,
+            this->argsBindGroupLayout
+        };
+
+        wgpu::PipelineLayoutDescriptor pipelineLayoutDesc{};
+        pipelineLayoutDesc.label = "Particle Args Pipeline Layout";
+        pipelineLayoutDesc.bindGroupLayoutCount = 2;
+        pipelineLayoutDesc.bindGroupLayouts = bindGroupLayouts;
+
+        this->argsPipelineLayout = this->device->createPipelineLayout(pipelineLayoutDesc);
+
+        pipelineLayoutDesc.label = "Particle State Pipeline Layout";
+        pipelineLayoutDesc.bindGroupLayoutCount = 1;
+
+        this->statePipelineLayout = this->device->createPipelineLayout(pipelineLayoutDesc);
+
+        wgpu::ShaderModule shaderModule = shaderLibrary->getModule("particle_simulate.wgsl");
+
+        auto createPipeline = [&](const char *label, wgpu::PipelineLayout layout, const char *entryPoint) {
+            wgpu::ComputePipelineDescriptor pipelineDesc{};
+            pipelineDesc.label = label;
+            pipelineDesc.layout = layout;
+            pipelineDesc.compute.nextInChain = nullptr;
+            pipelineDesc.compute.module = shaderModule;
+            pipelineDesc.compute.entryPoint = entryPoint;
+            pipelineDesc.compute.constantCount = 0;
+            pipelineDesc.compute.constants = nullptr;
+
+            return this->device->createComputePipeline(pipelineDesc);
+        };
+
+        this->beginPipeline = createPipeline("Particle Begin Pipeline", this->argsPipelineLayout, "beginMain");
+        this->emitPipeline = createPipeline("Particle Emit Pipeline", this->statePipelineLayout, "emitMain");
+        this->simulatePipeline = createPipeline("Particle Simulate Pipeline", this->statePipelineLayout, "simulateMain");
+        this->finishPipeline = createPipeline("Particle Finish Pipeline", this->argsPipelineLayout, "finishMain");
+    }
+
+    void ParticleSystem::createRenderPipeline(nugie::ShaderLibrary *shaderLibrary, wgpu::TextureFormat colorFormat, wgpu::TextureFormat depthFormat) {
+        wgpu::BindGroupLayoutEntry bindGroupLayoutEntries[3];
+
+        for (uint32_t i = 0; i < 3; i++) {
+            bindGroupLayoutEntries[i].nextInChain = nullptr;
+            bindGroupLayoutEntries[i].binding = i;
+            bindGroupLayoutEntries[i].visibility = wgpu::ShaderStage::Vertex;
+            bindGroupLayoutEntries[i].buffer.nextInChain = nullptr;
+            bindGroupLayoutEntries[i].buffer.hasDynamicOffset = false;
+            bindGroupLayoutEntries[i].buffer.type = wgpu::BufferBindingType::ReadOnlyStorage;
+        }
+
+        bindGroupLayoutEntries[0].buffer.type = wgpu::BufferBindingType::Uniform;
+
+        wgpu::BindGroupLayoutDescriptor bindGroupLayoutDesc{};
+        bindGroupLayoutDesc.label = "Particle Render Bind Group Layout";
+        bindGroupLayoutDesc.nextInChain = nullptr;
+        bindGroupLayoutDesc.entryCount = 3;
+        bindGroupLayoutDesc.entries = bindGroupLayoutEntries;
+
+        this->renderBindGroupLayout = this->device->createBindGroupLayout(bindGroupLayoutDesc);
+
+        WGPUBindGroupLayout bindGroupLayouts[1] {
+            this->renderBindGroupLayout
+        };
+
+        wgpu::PipelineLayoutDescriptor pipelineLayoutDesc{};
+        pipelineLayoutDesc.label = "Particle Render Pipeline Layout";
+        pipelineLayoutDesc.bindGroupLayoutCount = 1;
+        pipelineLayoutDesc.bindGroupLayouts = bindGroupLayouts;
+
+        this->renderPipelineLayout = this->device->createPipelineLayout(pipelineLayoutDesc);
+
+        wgpu::ShaderModule shaderModule = shaderLibrary->getModule("particle_render.wgsl");
+
+        // Additive, so overlapping particles need no sorting
+        wgpu::BlendState blendState{};
+        blendState.color.srcFactor = wgpu::BlendFactor::SrcAlpha;
+        blendState.color.dstFactor = wgpu::BlendFactor::One;
+        blendState.color.operation = wgpu::BlendOperation::Add;
+
+        blendState.alpha.srcFactor = wgpu::BlendFactor::Zero;
+        blendState.alpha.dstFactor = wgpu::BlendFactor::One;
+        blendState.alpha.operation = wgpu::BlendOperation::Add;
+
+        wgpu::ColorTargetState colorTarget{};
+        colorTarget.nextInChain = nullptr;
+        colorTarget.format = colorFormat;
+        colorTarget.blend = &blendState;
+        colorTarget.writeMask = wgpu::ColorWriteMask::All;
+
+        wgpu::FragmentState fragmentState{};
+        fragmentState.nextInChain = nullptr;
+        fragmentState.module = shaderModule;
+        fragmentState.entryPoint = "fragmentMain";
+        fragmentState.constantCount = 0;
+        fragmentState.constants = nullptr;
+        fragmentState.targetCount = 1;
+        fragmentState.targets = &colorTarget;
+
+        // No vertex buffers, the quads come from the vertex and instance indices
+        wgpu::VertexState vertexState{};
+        vertexState.nextInChain = nullptr;
+        vertexState.bufferCount = 0;
+        vertexState.buffers = nullptr;
+        vertexState.module = shaderModule;
+        vertexState.entryPoint = "vertexMain";
+        vertexState.constantCount = 0;
+        vertexState.constants = nullptr;
+
+        wgpu::PrimitiveState primitiveState{};
+        primitiveState.nextInChain = nullptr;
+        primitiveState.topology = wgpu::PrimitiveTopology::TriangleList;
+        primitiveState.stripIndexFormat = wgpu::IndexFormat::Undefined;
+        primitiveState.frontFace = wgpu::FrontFace::CCW;
+        primitiveState.cullMode = wgpu::CullMode::None;
+
+        // Tested against the scene but never written, particles do not hide each other
+        wgpu::DepthStencilState depthStencilState{};
+        depthStencilState.nextInChain = nullptr;
+        depthStencilState.depthWriteEnabled = false;
+        depthStencilState.depthCompare = wgpu::CompareFunction::Less;
+        depthStencilState.format = depthFormat;
+        depthStencilState.stencilReadMask = 0;
+        depthStencilState.stencilWriteMask = 0;
+
+        wgpu::MultisampleState multiSampleState{};
+        multiSampleState.nextInChain = nullptr;
+        multiSampleState.count = 1;
+        multiSampleState.mask = ~0u;
+        multiSampleState.alphaToCoverageEnabled = false;
+
+        wgpu::RenderPipelineDescriptor pipelineDesc{};
+        pipelineDesc.label = "Particle Render Pipeline";
+        pipelineDesc.vertex = vertexState;
+        pipelineDesc.primitive = primitiveState;
+        pipelineDesc.fragment = &fragmentState;
+        pipelineDesc.depthStencil = &depthStencilState;
+        pipelineDesc.multisample = multiSampleState;
+        pipelineDesc.layout = this->renderPipelineLayout;
+
+        this->renderPipeline = this->device->createRenderPipeline(pipelineDesc);
+    }
+
+    void ParticleSystem::createBindGroups() {
+        BufferInfo paramsInfo{ this->paramsBuffer, sizeof(ParticleParams), 0 };
+        BufferInfo particleInfo{ this->particleBuffer, this->maxParticleCount * sizeof(Particle), 0 };
+        BufferInfo aliveListInfo{ this->aliveListBuffer, 2 * this->maxParticleCount * sizeof(uint32_t), 0 };
+
+        BufferInfo stateInfos[5] {
+            paramsInfo,
+            particleInfo,
+            BufferInfo{ this->deadListBuffer, this->maxParticleCount * sizeof(uint32_t), 0 },
+            aliveListInfo,
+            BufferInfo{ this->counterBuffer, 4 * sizeof(uint32_t), 0 }
+        };
+
+        this->stateBindGroup = this->createBindGroup("Particle State Bind Group", this->stateBindGroupLayout, 5, stateInfos);
+
+        BufferInfo argsInfos[2] {
+            BufferInfo{ this->dispatchArgsBuffer, 3 * sizeof(uint32_t), 0 },
+            BufferInfo{ this->drawArgsBuffer, 4 * sizeof(uint32_t), 0 }
+        };
+
+        this->argsBindGroup = this->createBindGroup("Particle Args Bind Group", this->argsBindGroupLayout, 2, argsInfos);
+
+        if (this->renderPipeline) {
+            BufferInfo renderInfos[3] { paramsInfo, particleInfo, aliveListInfo };
+            this->renderBindGroup = this->createBindGroup("Particle Render Bind Group", this->renderBindGroupLayout, 3, renderInfos);
+        }
+    }
+
+    wgpu::BindGroup ParticleSystem::createBindGroup(const char *label, wgpu::BindGroupLayout layout, uint32_t entryCount, const BufferInfo *infos) {
+        std::vector<wgpu::BindGroupEntry> bindGroupEntries(entryCount);
+
+        for (uint32_t i = 0; i < entryCount; i++) {
+            bindGroupEntries[i].nextInChain = nullptr;
+            bindGroupEntries[i].binding = i;
+            bindGroupEntries[i].buffer = infos[i].buffer;
+            bindGroupEntries[i].offset = infos[i].offset;
+            bindGroupEntries[i].size = infos[i].size;
+        }
+
+        wgpu::BindGroupDescriptor bindGroupDesc{};
+        bindGroupDesc.label = label;
+        bindGroupDesc.nextInChain = nullptr;
+        bindGroupDesc.entryCount = entryCount;
+        bindGroupDesc.entries = bindGroupEntries.data();
+        bindGroupDesc.layout = layout;
+
+        return this->device->createBindGroup(bindGroupDesc);
+    }
+}
@@ -0,0 +1,158 @@
+#ifndef NUGIE_PARTICLE_SYSTEM_HPP
+#define NUGIE_PARTICLE_SYSTEM_HPP
+
+#include <glm/glm.hpp>
+
+#include "../../device/device.hpp"
+#include "../../shader/library/shader_library.hpp"
+
+namespace nugie {
+    class Device;
+
+    // Where particles spawn and how they move, in world space
+    struct ParticleEmitter {
+        glm::vec3 position{ 0.0f };
+        float radius = 0.1f;
+
+        glm::vec3 velocity{ 0.0f, 2.0f, 0.0f };
+        float velocityJitter = 0.5f;
+
+        glm::vec3 gravity{ 0.0f, -9.81f, 0.0f };
+        float drag = 0.1f;
+
+        // Particles spawned per second
+        float rate = 1000.0f;
+
+        float lifetimeMin = 1.0f;
+        float lifetimeMax = 2.0f;
+
+        // Half the side of the quad
+        float size = 0.02f;
+
+        // Particles fade from the start to the end color over their lifetime
+        glm::vec4 startColor{ 1.0f, 0.8f, 0.4f, 1.0f };
+        glm::vec4 endColor{ 1.0f, 0.2f, 0.1f, 0.0f };
+    };
+
+    // A pool of particles that lives entirely on the GPU.
+    //
+    // Every frame one compute pass emits new particles from a dead list, integrates the alive ones and
+    // compacts the survivors into the other of two alive lists, then writes the indirect arguments that
+    // draw exactly that list. The CPU only uploads the emitter and camera, it never reads a count back.
+    // Particles are drawn as camera-facing quads built in the vertex shader, blended additively.
+    class ParticleSystem {
+    public:
+        // Without a color format the system only simulates and draw() must not be called
+        ParticleSystem(nugie::Device *device, nugie::ShaderLibrary *shaderLibrary, uint32_t maxParticleCount,
+            wgpu::TextureFormat colorFormat, wgpu::TextureFormat depthFormat);
+
+        ~ParticleSystem();
+
+        void setEmitter(const ParticleEmitter &emitter) { this->emitter = emitter; }
+
+        // Kills every particle and restarts the emission and its random seed, takes effect with the next dispatch()
+        void reset();
+
+        // Spawns this many particles on top of the rate in the next frame, as far as free particles allow
+        void burst(uint32_t count);
+
+        // Uploads the emission and camera of this frame, once per frame before dispatch()
+        void update(float deltaTime, glm::mat4 viewProjection, glm::vec3 cameraRight, glm::vec3 cameraUp);
+
+        void dispatch(wgpu::ComputePassEncoder computePassEncoder);
+
+        // Draws what this frame's dispatch() left alive, the depth attachment is only tested against
+        void draw(wgpu::RenderPassEncoder renderPassEncoder);
+
+        uint32_t getMaxParticleCount() { return this->maxParticleCount; }
+
+        // Particles asked for in the last update, the GPU emits fewer when the pool is full
+        uint32_t getEmitRequest() { return this->params.emitRequest; }
+
+        void release();
+
+    private:
+        static constexpr uint32_t WORKGROUP_SIZE = 64;
+
+        // A dispatch may have at most this many workgroups along one axis
+        static constexpr uint32_t MAX_WORKGROUPS = 65535;
+
+        // Layout matches Particle in common/particles.wgsl
+        struct Particle {
+            glm::vec4 positionAge;
+            glm::vec4 velocityLifetime;
+        };
+
+        // Layout matches ParticleParams in common/particles.wgsl
+        struct ParticleParams {
+            glm::mat4 viewProjection;
+            glm::vec4 cameraRightSize;
+            glm::vec4 cameraUp;
+            glm::vec4 emitterPositionRadius;
+            glm::vec4 emitterVelocityJitter;
+            glm::vec4 gravityDrag;
+            glm::vec4 startColor;
+            glm::vec4 endColor;
+            float deltaTime;
+            float lifetimeMin;
+            float lifetimeMax;
+            uint32_t emitRequest;
+            uint32_t maxParticles;
+            uint32_t parity;
+            uint32_t seed;
+            uint32_t padding;
+        };
+
+        nugie::Device *device;
+        uint32_t maxParticleCount;
+
+        ParticleEmitter emitter;
+        ParticleParams params{};
+
+        // Fractions of a particle the rate asked for and no frame emitted yet
+        float emitRemainder = 0.0f;
+        uint32_t pendingBurst = 0;
+        uint32_t frameCount = 0;
+
+        wgpu::Buffer paramsBuffer;
+        wgpu::Buffer particleBuffer;
+        wgpu::Buffer deadListBuffer;
+        wgpu::Buffer aliveListBuffer;
+        wgpu::Buffer counterBuffer;
+        wgpu::Buffer dispatchArgsBuffer;
+        wgpu::Buffer drawArgsBuffer;
+
+        wgpu::BindGroupLayout stateBindGroupLayout;
+        wgpu::BindGroupLayout argsBindGroupLayout;
+        wgpu::BindGroupLayout renderBindGroupLayout;
+
+        // Emit and simulate leave the argument buffers out, they are read as indirect arguments meanwhile
+        wgpu::PipelineLayout argsPipelineLayout;
+        wgpu::PipelineLayout statePipelineLayout;
+        wgpu::PipelineLayout renderPipelineLayout;
+
+        wgpu::ComputePipeline beginPipeline;
+        wgpu::ComputePipeline emitPipeline;
+        wgpu::ComputePipeline simulatePipeline;
+        wgpu::ComputePipeline finishPipeline;
+        wgpu::RenderPipeline renderPipeline;
+
+        wgpu::BindGroup stateBindGroup;
+        wgpu::BindGroup argsBindGroup;
+        wgpu::BindGroup renderBindGroup;
+
+        bool released = false;
+
+        void createBuffers();
+
+        void createComputePipelines(nugie::ShaderLibrary *shaderLibrary);
+
+        void createRenderPipeline(nugie::ShaderLibrary *shaderLibrary, wgpu::TextureFormat colorFormat, wgpu::TextureFormat depthFormat);
+
+        void createBindGroups();
+
+        wgpu::BindGroup createBindGroup(const char *label, wgpu::BindGroupLayout layout, uint32_t entryCount, const BufferInfo *infos);
+    };
+}
+
+#endif
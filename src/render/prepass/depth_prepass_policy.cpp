@@ -0,0 +1,33 @@
+#include "depth_prepass_policy.hpp"
+
+namespace nugie {
+    DepthPrepassPolicy::DepthPrepassPolicy(DepthPrepassSettings settings)
+    {
+        this->setSettings(settings);
+    }
+
+    void DepthPrepassPolicy::setSettings(DepthPrepassSettings settings) {
+        this->settings = settings;
+        this->enabled = settings.mode == DepthPrepassMode::On;
+        this->agreeingSamples = 0;
+    }
+
+    bool DepthPrepassPolicy::update(double depthComplexity) {
+        if (this->settings.mode != DepthPrepassMode::Auto || depthComplexity < 0.0) {
+            return this->enabled;
+        }
+
+        bool wantsSwitch = this->enabled
+            ? depthComplexity < this->settings.disableDepthComplexity
+            : depthComplexity > this->settings.enableDepthComplexity;
+
+        this->agreeingSamples = wantsSwitch ? this->agreeingSamples + 1 : 0;
+
+        if (this->agreeingSamples >= this->settings.confirmSamples) {
+            this->enabled = !this->enabled;
+            this->agreeingSamples = 0;
+        }
+
+        return this->enabled;
+    }
+}
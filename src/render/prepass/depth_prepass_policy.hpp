@@ -0,0 +1,45 @@
+#ifndef NUGIE_DEPTH_PREPASS_POLICY_HPP
+#define NUGIE_DEPTH_PREPASS_POLICY_HPP
+
+#include <cstdint>
+
+namespace nugie {
+    enum class DepthPrepassMode {
+        Off,
+        On,
+        Auto
+    };
+
+    struct DepthPrepassSettings {
+        DepthPrepassMode mode = DepthPrepassMode::Auto;
+
+        // Auto turns the prepass on above the first depth complexity and back off below the second.
+        // The gap keeps a scene that sits near one threshold from flipping every frame.
+        double enableDepthComplexity = 2.0;
+        double disableDepthComplexity = 1.4;
+
+        // Consecutive measurements that must agree before Auto switches
+        uint32_t confirmSamples = 8;
+    };
+
+    // Decides per scene whether the depth prepass runs. A prepass pays for a second geometry pass
+    // so that the main pass shades each pixel once, which only wins when many fragments overlap.
+    class DepthPrepassPolicy {
+    public:
+        DepthPrepassPolicy(DepthPrepassSettings settings = DepthPrepassSettings{});
+
+        void setSettings(DepthPrepassSettings settings);
+
+        // Feeds one depth complexity measurement, only used in Auto mode
+        bool update(double depthComplexity);
+
+        bool isEnabled() { return this->enabled; }
+
+    private:
+        DepthPrepassSettings settings;
+        bool enabled;
+        uint32_t agreeingSamples = 0;
+    };
+}
+
+#endif
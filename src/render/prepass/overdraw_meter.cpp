@@ -0,0 +1,58 @@
+#include "overdraw_meter.hpp"
+
+#include <algorithm>
+
+namespace nugie {
+    OverdrawMeter::OverdrawMeter(nugie::Device *device, nugie::ReadbackRing *readbackRing, uint32_t framesInFlight)
+    : device{device},
+      readbackRing{readbackRing}
+    {
+        wgpu::QuerySetDescriptor querySetDesc{};
+        querySetDesc.nextInChain = nullptr;
+        querySetDesc.label = "Occlusion Query Set";
+        querySetDesc.type = wgpu::QueryType::Occlusion;
+        querySetDesc.count = framesInFlight * 2;
+
+        this->querySet = this->device->createQuerySet(querySetDesc);
+
+        wgpu::BufferDescriptor bufferDesc{};
+        bufferDesc.label = "Occlusion Resolve Buffer";
+        bufferDesc.size = framesInFlight * SLOT_STRIDE;
+        bufferDesc.usage = wgpu::BufferUsage::QueryResolve | wgpu::BufferUsage::CopySrc;
+        bufferDesc.mappedAtCreation = false;
+
+        this->resolveBuffer = this->device->createBuffer(bufferDesc);
+    }
+
+    OverdrawMeter::~OverdrawMeter() {
+        this->release();
+    }
+
+    void OverdrawMeter::resolve(wgpu::CommandEncoder commandEncoder, uint32_t frameSlot, bool prepassEnabled, uint64_t pixelCount) {
+        commandEncoder.resolveQuerySet(this->querySet, this->getDepthQueryIndex(frameSlot), 2, this->resolveBuffer, frameSlot * SLOT_STRIDE);
+
+        // The callback carries what the frame was counted with, small enough for std::function to hold without allocating
+        uint32_t pixels = static_cast<uint32_t>(std::clamp<uint64_t>(pixelCount, 1, UINT32_MAX));
+
+        this->readbackRing->readBuffer(commandEncoder, this->resolveBuffer, frameSlot * SLOT_STRIDE, 2 * sizeof(uint64_t), 
+            [this, pixels, prepassEnabled](const ReadbackResult &result) {
+                const uint64_t *samples = reinterpret_cast<const uint64_t*>(result.data);
+                uint64_t depthSamples = prepassEnabled ? samples[0] : samples[1];
+
+                this->depthComplexity = static_cast<double>(depthSamples) / pixels;
+                this->shadedOverdraw = static_cast<double>(samples[1]) / pixels;
+                this->sampleCount++;
+            });
+    }
+
+    void OverdrawMeter::release() {
+        if (this->released) {
+            return;
+        }
+
+        this->device->releaseBuffer(this->resolveBuffer);
+        this->querySet.release();
+
+        this->released = true;
+    }
+}
@@ -0,0 +1,55 @@
+#ifndef NUGIE_OVERDRAW_METER_HPP
+#define NUGIE_OVERDRAW_METER_HPP
+
+#include "../../device/device.hpp"
+#include "../readback/readback_ring.hpp"
+
+namespace nugie {
+    class Device;
+    class ReadbackRing;
+
+    // Counts the samples that pass the depth test with occlusion queries, once in the pass that
+    // lays down depth and once in the pass that shades. Divided by the rendered pixel count these
+    // give the depth complexity of the scene and how many times each pixel was actually shaded.
+    //
+    // Fragments that are shaded and then fail a late depth test are not counted, so the shaded
+    // value is a lower bound. Results come back through the readback ring like the GPU timer's.
+    class OverdrawMeter {
+    public:
+        OverdrawMeter(nugie::Device *device, nugie::ReadbackRing *readbackRing, uint32_t framesInFlight);
+        ~OverdrawMeter();
+
+        wgpu::QuerySet getQuerySet() { return this->querySet; }
+
+        uint32_t getDepthQueryIndex(uint32_t frameSlot) { return frameSlot * 2; }
+        uint32_t getShadeQueryIndex(uint32_t frameSlot) { return frameSlot * 2 + 1; }
+
+        // Records the resolve of this slot's queries and their readback. Without a prepass the shading
+        // pass also lays down depth, and the depth query is left unused.
+        void resolve(wgpu::CommandEncoder commandEncoder, uint32_t frameSlot, bool prepassEnabled, uint64_t pixelCount);
+
+        // Samples per rendered pixel, negative before the first result arrived
+        double getDepthComplexity() { return this->depthComplexity; }
+        double getShadedOverdraw() { return this->shadedOverdraw; }
+
+        uint64_t getSampleCount() { return this->sampleCount; }
+
+        void release();
+
+    private:
+        static constexpr uint64_t SLOT_STRIDE = 256;
+
+        nugie::Device *device;
+        nugie::ReadbackRing *readbackRing;
+
+        wgpu::QuerySet querySet;
+        wgpu::Buffer resolveBuffer;
+
+        double depthComplexity = -1.0;
+        double shadedOverdraw = -1.0;
+        uint64_t sampleCount = 0;
+        bool released = false;
+    };
+}
+
+#endif
@@ -0,0 +1,121 @@
+#include "draw_queue.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+namespace nugie {
+    DrawQueue::DrawQueue(LinearArena *arena)
+    : arena{arena},
+      commands{ArenaAllocator<DrawCommand>(arena)},
+      sortedCommands{ArenaAllocator<DrawCommand>(arena)},
+      entries{ArenaAllocator<SortEntry>(arena)},
+      scratch{ArenaAllocator<SortEntry>(arena)}
+    {
+
+    }
+
+    void DrawQueue::clear(size_t expectedDrawCount) {
+        // The old storage belongs to the arena and went away with its reset, it is dropped without being touched
+        this->commands = ArenaVector<DrawCommand>(ArenaAllocator<DrawCommand>(this->arena));
+        this->sortedCommands = ArenaVector<DrawCommand>(ArenaAllocator<DrawCommand>(this->arena));
+        this->entries = ArenaVector<SortEntry>(ArenaAllocator<SortEntry>(this->arena));
+        this->scratch = ArenaVector<SortEntry>(ArenaAllocator<SortEntry>(this->arena));
+
+        this->commands.reserve(expectedDrawCount);
+        this->entries.reserve(expectedDrawCount);
+
+        // Streamed objects come and go, so ids of ones long released would pile up. Once a map has
+        // handed out every id its bits hold it starts over, the ids wrapped around by then anyway.
+        resetIds(this->pipelineIds, PIPELINE_BITS);
+        resetIds(this->materialIds, MATERIAL_BITS);
+        resetIds(this->geometryIds, GEOMETRY_BITS);
+    }
+
+    void DrawQueue::push(const DrawCommand &drawCommand, DrawSortInfo sortInfo) {
+        uint64_t pipeline = getId(this->pipelineIds, drawCommand.pipeline, PIPELINE_BITS);
+        uint64_t material = getId(this->materialIds, drawCommand.objectBindGroup, MATERIAL_BITS);
+        uint64_t geometry = getId(this->geometryIds, drawCommand.positionBuffer.buffer, GEOMETRY_BITS);
+
+        constexpr uint64_t maxDepth = (uint64_t(1) << DEPTH_BITS) - 1;
+        uint64_t depth = static_cast<uint64_t>(std::clamp(sortInfo.depth, 0.0f, 1.0f) * static_cast<float>(maxDepth));
+
+        uint64_t state = (pipeline << (MATERIAL_BITS + GEOMETRY_BITS)) | (material << GEOMETRY_BITS) | geometry;
+        uint64_t key = uint64_t(sortInfo.pass & 0xF) << 60;
+
+        if (sortInfo.blended) {
+            key |= uint64_t(1) << 59;
+            key |= (maxDepth - depth) << (59 - DEPTH_BITS);
+            key |= state;
+        } else {
+            key |= state << DEPTH_BITS;
+            key |= depth;
+        }
+
+        this->entries.push_back(SortEntry{ key, static_cast<uint32_t>(this->commands.size()) });
+        this->commands.push_back(drawCommand);
+    }
+
+    void DrawQueue::sort() {
+        auto startTime = std::chrono::high_resolution_clock::now();
+
+        radixSort(this->entries, this->scratch);
+
+        this->sortedCommands.resize(this->entries.size());
+        for (size_t i = 0; i < this->entries.size(); i++) {
+            this->sortedCommands[i] = this->commands[this->entries[i].index];
+        }
+
+        std::chrono::duration<double, std::milli> sortTime = std::chrono::high_resolution_clock::now() - startTime;
+
+        this->stats.drawCount = static_cast<uint32_t>(this->entries.size());
+        this->stats.sortTimeMs = sortTime.count();
+    }
+
+    uint32_t DrawQueue::getId(std::unordered_map<const void*, uint32_t> &ids, const void* handle, uint32_t bits) {
+        auto found = ids.find(handle);
+        if (found != ids.end()) {
+            return found->second;
+        }
+
+        uint32_t id = static_cast<uint32_t>(ids.size()) & ((1u << bits) - 1);
+        ids.emplace(handle, id);
+
+        return id;
+    }
+
+    void DrawQueue::resetIds(std::unordered_map<const void*, uint32_t> &ids, uint32_t bits) {
+        if (ids.size() > (size_t(1) << bits)) {
+            ids.clear();
+        }
+    }
+
+    void DrawQueue::radixSort(ArenaVector<SortEntry> &entries, ArenaVector<SortEntry> &scratch) {
+        scratch.resize(entries.size());
+
+        // Eight passes of eight bits. Stable passes from the least significant digit up give a full sort,
+        // and a digit every key shares (unused ids, an empty depth range) is skipped entirely.
+        for (uint32_t shift = 0; shift < 64; shift += 8) {
+            size_t counts[256] = {};
+            for (auto &&entry : entries) {
+                counts[(entry.key >> shift) & 0xFF]++;
+            }
+
+            if (entries.empty() || counts[(entries[0].key >> shift) & 0xFF] == entries.size()) {
+                continue;
+            }
+
+            size_t offset = 0;
+            for (auto &&count : counts) {
+                size_t bucketSize = count;
+                count = offset;
+                offset += bucketSize;
+            }
+
+            for (auto &&entry : entries) {
+                scratch[counts[(entry.key >> shift) & 0xFF]++] = entry;
+            }
+
+            entries.swap(scratch);
+        }
+    }
+}
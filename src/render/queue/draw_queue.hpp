@@ -0,0 +1,91 @@
+#ifndef NUGIE_DRAW_QUEUE_HPP
+#define NUGIE_DRAW_QUEUE_HPP
+
+#include <vector>
+#include <unordered_map>
+
+#include "../../struct.hpp"
+#include "../../memory/arena/arena_allocator.hpp"
+
+namespace nugie {
+    // Where a draw goes and how it must be ordered within that place
+    struct DrawSortInfo {
+        // Passes or layers are drawn in increasing order, at most 16 of them
+        uint8_t pass = 0;
+
+        // Blended draws come after the opaque ones of the same pass and are sorted back to front
+        bool blended = false;
+
+        // Normalized view depth, 0 at the camera and 1 at the far plane
+        float depth = 0.0f;
+    };
+
+    struct DrawQueueStats {
+        uint32_t drawCount = 0;
+        double sortTimeMs = 0.0;
+    };
+
+    // Collects draws for one frame, gives each a packed 64-bit key and sorts them with an LSD radix sort.
+    //
+    // Opaque key, most significant first:  pass(4) | 0 | pipeline(10) | material(12) | geometry(12) | depth(24)
+    // Blended key, most significant first: pass(4) | 1 | inverted depth(24) | pipeline(10) | material(12) | geometry(12)
+    //
+    // Opaque draws are grouped by state and go front to back within a group to help early depth rejection,
+    // blended draws must go back to front so their state only groups when the depth is equal.
+    // The material is the object bind group and the geometry is the position buffer.
+    //
+    // Per-frame lists live in a frame arena and are rebuilt by every clear(), so the arena must have
+    // been reset (or be a fresh frame slot) before the queue is cleared again.
+    class DrawQueue {
+    public:
+        DrawQueue(LinearArena *arena);
+
+        // Starts a new frame, reserving room for the expected number of draws up front
+        void clear(size_t expectedDrawCount = 0);
+
+        void push(const DrawCommand &drawCommand, DrawSortInfo sortInfo);
+
+        // Sorts the draws pushed since the last clear(), the result stays valid until the next push()
+        void sort();
+
+        const ArenaVector<DrawCommand>& getSortedCommands() { return this->sortedCommands; }
+
+        size_t getDrawCount() { return this->commands.size(); }
+
+        DrawQueueStats getStats() { return this->stats; }
+
+    private:
+        static constexpr uint32_t PIPELINE_BITS = 10;
+        static constexpr uint32_t MATERIAL_BITS = 12;
+        static constexpr uint32_t GEOMETRY_BITS = 12;
+        static constexpr uint32_t DEPTH_BITS = 24;
+
+        struct SortEntry {
+            uint64_t key;
+            uint32_t index;
+        };
+
+        LinearArena *arena;
+
+        ArenaVector<DrawCommand> commands;
+        ArenaVector<DrawCommand> sortedCommands;
+        ArenaVector<SortEntry> entries;
+        ArenaVector<SortEntry> scratch;
+
+        // Handles are given small ids the first time they are seen, ids wrap once a field runs out of bits,
+        // which only costs some state changes and never correctness
+        std::unordered_map<const void*, uint32_t> pipelineIds;
+        std::unordered_map<const void*, uint32_t> materialIds;
+        std::unordered_map<const void*, uint32_t> geometryIds;
+
+        DrawQueueStats stats;
+
+        static uint32_t getId(std::unordered_map<const void*, uint32_t> &ids, const void* handle, uint32_t bits);
+
+        static void resetIds(std::unordered_map<const void*, uint32_t> &ids, uint32_t bits);
+
+        static void radixSort(ArenaVector<SortEntry> &entries, ArenaVector<SortEntry> &scratch);
+    };
+}
+
+#endif
@@ -0,0 +1,246 @@
+#include "readback_ring.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace nugie {
+    ReadbackRing::ReadbackRing(nugie::Device *device, nugie::FrameSync *frameSync, uint32_t maxInFlight)
+    : device{device},
+      frameSync{frameSync},
+      maxInFlight{std::max(maxInFlight, 1u)}
+    {
+
+    }
+
+    ReadbackRing::~ReadbackRing() {
+        this->release();
+    }
+
+    // ================================ Request Function ================================
+
+    bool ReadbackRing::readTexture(wgpu::CommandEncoder commandEncoder, wgpu::Texture texture, uint32_t mipLevel, uint32_t x, uint32_t y, 
+        uint32_t width, uint32_t height, uint32_t bytesPerPixel, ReadbackCallback callback) 
+    {
+        if (width == 0 || height == 0) {
+            return false;
+        }
+
+        uint32_t bytesPerRow = width * bytesPerPixel;
+        uint32_t paddedBytesPerRow = (bytesPerRow + ROW_PITCH_ALIGNMENT - 1) / ROW_PITCH_ALIGNMENT * ROW_PITCH_ALIGNMENT;
+
+        Slot *slot = this->acquire(uint64_t(paddedBytesPerRow) * height);
+        if (slot == nullptr) {
+            return false;
+        }
+
+        slot->size = uint64_t(paddedBytesPerRow) * height;
+        slot->width = width;
+        slot->height = height;
+        slot->bytesPerRow = bytesPerRow;
+        slot->paddedBytesPerRow = paddedBytesPerRow;
+        slot->callback = std::move(callback);
+
+        wgpu::ImageCopyTexture source{};
+        source.texture = texture;
+        source.mipLevel = mipLevel;
+        source.origin = { x, y, 0 };
+        source.aspect = wgpu::TextureAspect::All;
+
+        wgpu::ImageCopyBuffer destination{};
+        destination.buffer = slot->buffer;
+        destination.layout.offset = 0;
+        destination.layout.bytesPerRow = paddedBytesPerRow;
+        destination.layout.rowsPerImage = height;
+
+        commandEncoder.copyTextureToBuffer(source, destination, { width, height, 1 });
+        return true;
+    }
+
+    bool ReadbackRing::readBuffer(wgpu::CommandEncoder commandEncoder, wgpu::Buffer buffer, uint64_t offset, uint64_t size, ReadbackCallback callback) {
+        if (size == 0) {
+            return false;
+        }
+
+        Slot *slot = this->acquire(size);
+        if (slot == nullptr) {
+            return false;
+        }
+
+        slot->size = size;
+        slot->width = 0;
+        slot->height = 0;
+        slot->bytesPerRow = 0;
+        slot->paddedBytesPerRow = 0;
+        slot->callback = std::move(callback);
+
+        commandEncoder.copyBufferToBuffer(buffer, offset, slot->buffer, 0, size);
+        return true;
+    }
+
+    // ================================ Lifecycle Function ================================
+
+    void ReadbackRing::mapPending() {
+        for (auto &&slot : this->slots) {
+            if (slot->state.load(std::memory_order_acquire) != SlotState::Recorded) {
+                continue;
+            }
+
+            slot->state.store(SlotState::Mapping, std::memory_order_release);
+            wgpuBufferMapAsync(slot->buffer, WGPUMapMode_Read, 0, slot->size, &ReadbackRing::onMapped, slot.get());
+        }
+    }
+
+    void ReadbackRing::deliver() {
+        this->device->processGpuEvents();
+
+        uint64_t frameIndex = this->frameSync->getFrameIndex();
+
+        for (auto &&slot : this->slots) {
+            SlotState state = slot->state.load(std::memory_order_acquire);
+            if (state != SlotState::Mapped && state != SlotState::Failed) {
+                continue;
+            }
+
+            if (state == SlotState::Mapped) {
+                const uint8_t *mapped = static_cast<const uint8_t*>(slot->buffer.getConstMappedRange(0, slot->size));
+
+                ReadbackResult result{};
+                result.width = slot->width;
+                result.height = slot->height;
+                result.bytesPerRow = slot->bytesPerRow;
+                result.requestFrameIndex = slot->requestFrameIndex;
+                result.latencyFrames = frameIndex - slot->requestFrameIndex;
+
+                if (slot->paddedBytesPerRow != slot->bytesPerRow) {
+                    // Drop the row padding the copy needed
+                    this->packed.resize(uint64_t(slot->bytesPerRow) * slot->height);
+
+                    for (uint32_t row = 0; row < slot->height; row++) {
+                        std::memcpy(this->packed.data() + uint64_t(row) * slot->bytesPerRow, mapped + uint64_t(row) * slot->paddedBytesPerRow, slot->bytesPerRow);
+                    }
+
+                    result.data = this->packed.data();
+                    result.size = this->packed.size();
+                } else {
+                    result.data = mapped;
+                    result.size = slot->width > 0 ? uint64_t(slot->bytesPerRow) * slot->height : slot->size;
+                }
+
+                slot->callback(result);
+
+                this->statsDelivered++;
+                this->statsLatencySum += result.latencyFrames;
+                this->statsLatencyMax = std::max(this->statsLatencyMax, result.latencyFrames);
+                this->statsBytes += result.size;
+            }
+
+            slot->buffer.unmap();
+            slot->callback = nullptr;
+            slot->state.store(SlotState::Free, std::memory_order_release);
+        }
+    }
+
+    bool ReadbackRing::collectStats(double interval, ReadbackStats &stats) {
+        double elapsed = std::chrono::duration<double>(Clock::now() - this->statsStart).count();
+        if (elapsed < interval) {
+            return false;
+        }
+
+        stats.deliveredCount = this->statsDelivered;
+        stats.averageLatencyFrames = this->statsDelivered > 0 ? static_cast<double>(this->statsLatencySum) / this->statsDelivered : 0.0;
+        stats.maxLatencyFrames = this->statsLatencyMax;
+        stats.throughputMBps = static_cast<double>(this->statsBytes) / (1024.0 * 1024.0) / elapsed;
+
+        this->statsStart = Clock::now();
+        this->statsDelivered = 0;
+        this->statsLatencySum = 0;
+        this->statsLatencyMax = 0;
+        this->statsBytes = 0;
+
+        return true;
+    }
+
+    uint32_t ReadbackRing::getInFlightCount() {
+        uint32_t count = 0;
+        for (auto &&slot : this->slots) {
+            if (slot->state.load(std::memory_order_acquire) != SlotState::Free) {
+                count++;
+            }
+        }
+
+        return count;
+    }
+
+    void ReadbackRing::release() {
+        if (this->released) {
+            return;
+        }
+
+        for (auto &&slot : this->slots) {
+            this->device->releaseBuffer(slot->buffer);
+        }
+
+        this->slots.clear();
+        this->released = true;
+    }
+
+    ReadbackRing::Slot* ReadbackRing::acquire(uint64_t size) {
+        uint64_t capacity = (size + BUFFER_GRANULARITY - 1) / BUFFER_GRANULARITY * BUFFER_GRANULARITY;
+        Slot *smallFree = nullptr;
+        Slot *bestFit = nullptr;
+
+        // The smallest free buffer that fits, so per-frame stats readbacks leave the large ones to images
+        for (auto &&slot : this->slots) {
+            if (slot->state.load(std::memory_order_acquire) != SlotState::Free) {
+                continue;
+            }
+
+            if (slot->capacity >= size) {
+                if (bestFit == nullptr || slot->capacity < bestFit->capacity) {
+                    bestFit = slot.get();
+                }
+            } else {
+                smallFree = slot.get();
+            }
+        }
+
+        if (bestFit != nullptr) {
+            bestFit->state.store(SlotState::Recorded, std::memory_order_release);
+            bestFit->requestFrameIndex = this->frameSync->getFrameIndex();
+
+            return bestFit;
+        }
+
+        Slot *slot = smallFree;
+        if (slot == nullptr) {
+            if (this->slots.size() >= this->maxInFlight) {
+                return nullptr;
+            }
+
+            this->slots.emplace_back(std::make_unique<Slot>());
+            slot = this->slots.back().get();
+        } else {
+            // Free and unmapped, so the GPU is done with it and it can be replaced right away
+            this->device->releaseBuffer(slot->buffer);
+        }
+
+        wgpu::BufferDescriptor bufferDesc{};
+        bufferDesc.label = "Readback Ring Buffer";
+        bufferDesc.size = capacity;
+        bufferDesc.usage = wgpu::BufferUsage::MapRead | wgpu::BufferUsage::CopyDst;
+        bufferDesc.mappedAtCreation = false;
+
+        slot->buffer = this->device->createBuffer(bufferDesc);
+        slot->capacity = capacity;
+        slot->state.store(SlotState::Recorded, std::memory_order_release);
+        slot->requestFrameIndex = this->frameSync->getFrameIndex();
+
+        return slot;
+    }
+
+    void ReadbackRing::onMapped(WGPUBufferMapAsyncStatus status, void *userdata) {
+        // May run on another thread, it only publishes the state for deliver()
+        Slot *slot = static_cast<Slot*>(userdata);
+        slot->state.store(status == WGPUBufferMapAsyncStatus_Success ? SlotState::Mapped : SlotState::Failed, std::memory_order_release);
+    }
+}
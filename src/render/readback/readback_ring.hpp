@@ -0,0 +1,129 @@
+#ifndef NUGIE_READBACK_RING_HPP
+#define NUGIE_READBACK_RING_HPP
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <functional>
+
+#include "../../device/device.hpp"
+#include "../../frame/sync/frame_sync.hpp"
+
+namespace nugie {
+    class Device;
+    class FrameSync;
+
+    struct ReadbackResult {
+        // Tightly packed, only valid during the callback
+        const uint8_t *data;
+        uint64_t size;
+
+        // Zero for buffer readbacks
+        uint32_t width;
+        uint32_t height;
+        uint32_t bytesPerRow;
+
+        uint64_t requestFrameIndex;
+        uint64_t latencyFrames;
+    };
+
+    struct ReadbackStats {
+        uint32_t deliveredCount = 0;
+        double averageLatencyFrames = 0.0;
+        uint64_t maxLatencyFrames = 0;
+        double throughputMBps = 0.0;
+    };
+
+    using ReadbackCallback = std::function<void(const ReadbackResult &result)>;
+
+    // Copies GPU data into a ring of MapRead buffers and hands it to a callback some frames later,
+    // without ever waiting on the GPU.
+    //
+    // Copies are recorded into the frame's command encoder. After the submit, mapPending() starts
+    // mapping them, and deliver() calls back the ones whose mapping finished, on the calling thread.
+    class ReadbackRing {
+    public:
+        ReadbackRing(nugie::Device *device, nugie::FrameSync *frameSync, uint32_t maxInFlight);
+        ~ReadbackRing();
+
+        // ================================ Request Function ================================
+
+        // The texture needs CopySrc usage. Rows are padded to the 256-byte pitch the copy requires
+        // and packed again before the callback. Returns false when every ring buffer is in use.
+        bool readTexture(wgpu::CommandEncoder commandEncoder, wgpu::Texture texture, uint32_t mipLevel, uint32_t x, uint32_t y, 
+            uint32_t width, uint32_t height, uint32_t bytesPerPixel, ReadbackCallback callback);
+
+        // The source needs CopySrc usage, offset and size must be multiples of 4
+        bool readBuffer(wgpu::CommandEncoder commandEncoder, wgpu::Buffer buffer, uint64_t offset, uint64_t size, ReadbackCallback callback);
+
+        // ================================ Lifecycle Function ================================
+
+        // Starts mapping every copy recorded since the last call, must be called after the frame was submitted
+        void mapPending();
+
+        // Calls back every readback whose mapping finished and returns its buffer to the ring
+        void deliver();
+
+        // Fills stats and returns true once every interval seconds
+        bool collectStats(double interval, ReadbackStats &stats);
+
+        uint32_t getInFlightCount();
+
+        uint32_t getMaxInFlight() { return this->maxInFlight; }
+
+        void release();
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        static constexpr uint32_t ROW_PITCH_ALIGNMENT = 256;
+
+        // Ring buffers are rounded up to this, so similar requests can share them
+        static constexpr uint64_t BUFFER_GRANULARITY = 64 * 1024;
+
+        enum class SlotState : uint32_t {
+            Free,
+            Recorded,
+            Mapping,
+            Mapped,
+            Failed
+        };
+
+        struct Slot {
+            wgpu::Buffer buffer;
+            uint64_t capacity = 0;
+            std::atomic<SlotState> state{SlotState::Free};
+
+            uint64_t size = 0;
+            uint32_t width = 0;
+            uint32_t height = 0;
+            uint32_t paddedBytesPerRow = 0;
+            uint32_t bytesPerRow = 0;
+            uint64_t requestFrameIndex = 0;
+            ReadbackCallback callback;
+        };
+
+        nugie::Device *device;
+        nugie::FrameSync *frameSync;
+        uint32_t maxInFlight;
+
+        std::vector<std::unique_ptr<Slot>> slots;
+        std::vector<uint8_t> packed;
+
+        Clock::time_point statsStart = Clock::now();
+        uint32_t statsDelivered = 0;
+        uint64_t statsLatencySum = 0;
+        uint64_t statsLatencyMax = 0;
+        uint64_t statsBytes = 0;
+
+        bool released = false;
+
+        Slot* acquire(uint64_t size);
+
+        // The map callback of a slot, through the C API so mapping does not allocate a callback object every frame
+        static void onMapped(WGPUBufferMapAsyncStatus status, void *userdata);
+    };
+}
+
+#endif
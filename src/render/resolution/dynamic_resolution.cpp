@@ -0,0 +1,38 @@
+#include "dynamic_resolution.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace nugie {
+    DynamicResolution::DynamicResolution(DynamicResolutionSettings settings)
+    : settings{settings},
+      scale{settings.maxScale}
+    {
+
+    }
+
+    float DynamicResolution::update(double gpuFrameMs) {
+        if (gpuFrameMs <= 0.0) {
+            return this->scale;
+        }
+
+        double error = (gpuFrameMs - this->settings.targetFrameMs) / this->settings.targetFrameMs;
+        if (std::abs(error) < this->settings.deadZone) {
+            return this->scale;
+        }
+
+        float idealScale = this->scale * static_cast<float>(std::sqrt(this->settings.targetFrameMs / gpuFrameMs));
+        float newScale = this->scale + (idealScale - this->scale) * this->settings.smoothing;
+
+        this->scale = std::clamp(newScale, this->settings.minScale, this->settings.maxScale);
+        return this->scale;
+    }
+
+    uint32_t DynamicResolution::getRenderWidth(uint32_t outputWidth) {
+        return std::clamp(static_cast<uint32_t>(std::lround(outputWidth * this->scale)), 1u, outputWidth);
+    }
+
+    uint32_t DynamicResolution::getRenderHeight(uint32_t outputHeight) {
+        return std::clamp(static_cast<uint32_t>(std::lround(outputHeight * this->scale)), 1u, outputHeight);
+    }
+}
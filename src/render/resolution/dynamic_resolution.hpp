@@ -0,0 +1,44 @@
+#ifndef NUGIE_DYNAMIC_RESOLUTION_HPP
+#define NUGIE_DYNAMIC_RESOLUTION_HPP
+
+#include <cstdint>
+
+namespace nugie {
+    struct DynamicResolutionSettings {
+        double targetFrameMs = 16.0;
+        float minScale = 0.5f;
+        float maxScale = 1.0f;
+
+        // Errors smaller than this fraction of the target leave the scale untouched
+        double deadZone = 0.05;
+
+        // How much of the correction is applied per update, lower is smoother
+        float smoothing = 0.25f;
+    };
+
+    // Chooses the fraction of the output resolution to render at, from measured GPU frame times.
+    // Fill cost grows with the pixel count, which is the square of the scale, so the correction
+    // is the square root of the time ratio.
+    class DynamicResolution {
+    public:
+        DynamicResolution(DynamicResolutionSettings settings = DynamicResolutionSettings{});
+
+        void setSettings(DynamicResolutionSettings settings) { this->settings = settings; }
+
+        // Feeds one GPU time measured at the current scale and returns the new scale
+        float update(double gpuFrameMs);
+
+        float getScale() { return this->scale; }
+
+        // Render size for an output size, never larger than the output nor smaller than one pixel
+        uint32_t getRenderWidth(uint32_t outputWidth);
+
+        uint32_t getRenderHeight(uint32_t outputHeight);
+
+    private:
+        DynamicResolutionSettings settings;
+        float scale;
+    };
+}
+
+#endif
@@ -0,0 +1,64 @@
+#include "gpu_timer.hpp"
+
+namespace nugie {
+    GpuTimer::GpuTimer(nugie::Device *device, nugie::ReadbackRing *readbackRing, uint32_t framesInFlight)
+    : device{device},
+      readbackRing{readbackRing},
+      supported{device->isTimestampQuerySupported()}
+    {
+        if (!this->supported) {
+            return;
+        }
+
+        wgpu::QuerySetDescriptor querySetDesc{};
+        querySetDesc.nextInChain = nullptr;
+        querySetDesc.label = "Timestamp Query Set";
+        querySetDesc.type = wgpu::QueryType::Timestamp;
+        querySetDesc.count = framesInFlight * 2;
+
+        this->querySet = this->device->createQuerySet(querySetDesc);
+
+        wgpu::BufferDescriptor bufferDesc{};
+        bufferDesc.label = "Timestamp Resolve Buffer";
+        bufferDesc.size = framesInFlight * SLOT_STRIDE;
+        bufferDesc.usage = wgpu::BufferUsage::QueryResolve | wgpu::BufferUsage::CopySrc;
+        bufferDesc.mappedAtCreation = false;
+
+        this->resolveBuffer = this->device->createBuffer(bufferDesc);
+    }
+
+    GpuTimer::~GpuTimer() {
+        this->release();
+    }
+
+    void GpuTimer::resolve(wgpu::CommandEncoder commandEncoder, uint32_t frameSlot) {
+        if (!this->supported) {
+            return;
+        }
+
+        commandEncoder.resolveQuerySet(this->querySet, this->getBeginIndex(frameSlot), 2, this->resolveBuffer, frameSlot * SLOT_STRIDE);
+
+        // Delivered on the thread that calls the ring's deliver(), which is the only one reading the results
+        this->readbackRing->readBuffer(commandEncoder, this->resolveBuffer, frameSlot * SLOT_STRIDE, 2 * sizeof(uint64_t), [this](const ReadbackResult &result) {
+            const uint64_t *timestamps = reinterpret_cast<const uint64_t*>(result.data);
+
+            // Timestamps are in nanoseconds, a reset counter can make the end smaller than the begin
+            if (timestamps[1] > timestamps[0]) {
+                this->lastTimeMs = static_cast<double>(timestamps[1] - timestamps[0]) / 1000000.0;
+                this->totalTimeMs += this->lastTimeMs;
+                this->sampleCount++;
+            }
+        });
+    }
+
+    void GpuTimer::release() {
+        if (!this->supported) {
+            return;
+        }
+
+        this->device->releaseBuffer(this->resolveBuffer);
+        this->querySet.release();
+
+        this->supported = false;
+    }
+}
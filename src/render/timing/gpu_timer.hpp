@@ -0,0 +1,59 @@
+#ifndef NUGIE_GPU_TIMER_HPP
+#define NUGIE_GPU_TIMER_HPP
+
+#include "../../device/device.hpp"
+#include "../readback/readback_ring.hpp"
+
+namespace nugie {
+    class Device;
+    class ReadbackRing;
+
+    // Measures the GPU time between two timestamps per frame slot. Results come back through the
+    // readback ring, so the value returned lags a few frames behind and the CPU never stalls.
+    class GpuTimer {
+    public:
+        GpuTimer(nugie::Device *device, nugie::ReadbackRing *readbackRing, uint32_t framesInFlight);
+        ~GpuTimer();
+
+        // False when the adapter has no timestamp queries, every other call is then a no-op
+        bool isSupported() { return this->supported; }
+
+        wgpu::QuerySet getQuerySet() { return this->querySet; }
+
+        uint32_t getBeginIndex(uint32_t frameSlot) { return frameSlot * 2; }
+
+        uint32_t getEndIndex(uint32_t frameSlot) { return frameSlot * 2 + 1; }
+
+        // Records the resolve of this slot's timestamps and their readback, after every timed pass of the frame.
+        // The frame is not timed when every ring buffer is in use.
+        void resolve(wgpu::CommandEncoder commandEncoder, uint32_t frameSlot);
+
+        // Most recent measured GPU time, or a negative value before the first result arrived
+        double getLastTimeMs() { return this->lastTimeMs; }
+
+        // Increases every time a new measurement arrives, so stale results are not fed twice
+        uint64_t getSampleCount() { return this->sampleCount; }
+
+        // Of every measurement so far, the difference between two calls over that of the sample count is their average
+        double getTotalTimeMs() { return this->totalTimeMs; }
+
+        void release();
+
+    private:
+        // Query resolve offsets must be 256-byte aligned
+        static constexpr uint64_t SLOT_STRIDE = 256;
+
+        nugie::Device *device;
+        nugie::ReadbackRing *readbackRing;
+        bool supported;
+
+        wgpu::QuerySet querySet;
+        wgpu::Buffer resolveBuffer;
+
+        double lastTimeMs = -1.0;
+        double totalTimeMs = 0.0;
+        uint64_t sampleCount = 0;
+    };
+}
+
+#endif
@@ -0,0 +1,132 @@
+#include "shader_library.hpp"
+
+#include <algorithm>
+
+namespace nugie {
+    void ShaderConstants::set(const std::string& key, double value) {
+        for (size_t i = 0; i < this->keys.size(); i++) {
+            if (this->keys[i] == key) {
+                this->entries[i].value = value;
+                return;
+            }
+        }
+
+        wgpu::ConstantEntry entry{};
+        entry.nextInChain = nullptr;
+        entry.value = value;
+
+        this->keys.push_back(key);
+        this->entries.push_back(entry);
+    }
+
+    const wgpu::ConstantEntry* ShaderConstants::getEntries() {
+        // Keys can move while the vectors grow, so the pointers are refreshed on every read
+        for (size_t i = 0; i < this->keys.size(); i++) {
+            this->entries[i].key = this->keys[i].c_str();
+        }
+
+        return this->entries.empty() ? nullptr : this->entries.data();
+    }
+
+    ShaderLibrary::ShaderLibrary(nugie::Device *device, std::string rootDirectory)
+    : device{device},
+      preprocessor{rootDirectory}
+    {
+
+    }
+
+    ShaderLibrary::~ShaderLibrary() {
+        this->release();
+    }
+
+    wgpu::ShaderModule ShaderLibrary::getModule(const std::string& path, const std::vector<ShaderDefine>& defines) {
+        std::string variantKey = getVariantKey(path, defines);
+
+        auto variant = this->variants.find(variantKey);
+        if (variant != this->variants.end()) {
+            return variant->second;
+        }
+
+        std::string source = this->preprocessor.process(path, defines);
+        std::vector<CompiledShader> &bucket = this->modules[hashSource(source)];
+
+        for (auto &&compiled : bucket) {
+            if (compiled.source == source) {
+                this->variants[variantKey] = compiled.module;
+                return compiled.module;
+            }
+        }
+
+        wgpu::ShaderModuleWGSLDescriptor shaderCodeDesc{};
+        shaderCodeDesc.chain.next = nullptr;
+        shaderCodeDesc.chain.sType = wgpu::SType::ShaderModuleWGSLDescriptor;
+        shaderCodeDesc.code = source.c_str();
+
+        wgpu::ShaderModuleDescriptor shaderDesc{};
+        shaderDesc.nextInChain = &shaderCodeDesc.chain;
+        shaderDesc.label = path.c_str();
+
+        wgpu::ShaderModule shaderModule = this->device->createShaderModule(shaderDesc);
+
+        bucket.push_back(CompiledShader{ std::move(source), shaderModule });
+        this->variants[variantKey] = shaderModule;
+
+        return shaderModule;
+    }
+
+    const ShaderReflection& ShaderLibrary::getReflection(const std::string& path, const std::vector<ShaderDefine>& defines) {
+        std::string variantKey = getVariantKey(path, defines);
+
+        auto reflection = this->reflections.find(variantKey);
+        if (reflection != this->reflections.end()) {
+            return reflection->second;
+        }
+
+        return this->reflections[variantKey] = ShaderReflection{ this->preprocessor.process(path, defines) };
+    }
+
+    size_t ShaderLibrary::getModuleCount() {
+        size_t count = 0;
+        for (auto &&[hash, bucket] : this->modules) {
+            count += bucket.size();
+        }
+
+        return count;
+    }
+
+    void ShaderLibrary::release() {
+        for (auto &&[hash, bucket] : this->modules) {
+            for (auto &&compiled : bucket) {
+                compiled.module.release();
+            }
+        }
+
+        this->modules.clear();
+        this->variants.clear();
+        this->reflections.clear();
+    }
+
+    uint64_t ShaderLibrary::hashSource(const std::string& source) {
+        // 64-bit FNV-1a
+        uint64_t hash = 14695981039346656037ull;
+        for (char c : source) {
+            hash ^= static_cast<uint8_t>(c);
+            hash *= 1099511628211ull;
+        }
+
+        return hash;
+    }
+
+    std::string ShaderLibrary::getVariantKey(const std::string& path, std::vector<ShaderDefine> defines) {
+        std::sort(defines.begin(), defines.end(), [](const ShaderDefine& a, const ShaderDefine& b) {
+            return a.name < b.name;
+        });
+
+        std::string key = path;
+        for (auto &&define : defines) {
+            key += '|' + define.name + '=' + define.value;
+        }
+
+        return key;
+    }
+}
@@ -0,0 +1,64 @@
+#ifndef NUGIE_SHADER_LIBRARY_HPP
+#define NUGIE_SHADER_LIBRARY_HPP
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "../../device/device.hpp"
+#include "../preprocessor/shader_preprocessor.hpp"
+#include "../reflection/shader_reflection.hpp"
+
+namespace nugie {
+    class Device;
+
+    // Values for WGSL `override` declarations, passed as the constants of a pipeline stage
+    class ShaderConstants {
+    public:
+        void set(const std::string& key, double value);
+
+        size_t getCount() { return this->entries.size(); }
+
+        const wgpu::ConstantEntry* getEntries();
+
+    private:
+        std::vector<std::string> keys;
+        std::vector<wgpu::ConstantEntry> entries;
+    };
+
+    class ShaderLibrary {
+    public:
+        ShaderLibrary(nugie::Device *device, std::string rootDirectory);
+        ~ShaderLibrary();
+
+        // Returns the module for a file preprocessed with the given defines.
+        // Variants that expand to the same WGSL share one compiled module.
+        wgpu::ShaderModule getModule(const std::string& path, const std::vector<ShaderDefine>& defines = {});
+
+        // Bindings and struct layouts of the same preprocessed source getModule() compiles, reflected once per variant
+        const ShaderReflection& getReflection(const std::string& path, const std::vector<ShaderDefine>& defines = {});
+
+        size_t getModuleCount();
+
+        void release();
+
+    private:
+        struct CompiledShader {
+            std::string source;
+            wgpu::ShaderModule module;
+        };
+
+        nugie::Device *device;
+        ShaderPreprocessor preprocessor;
+
+        std::unordered_map<uint64_t, std::vector<CompiledShader>> modules;
+        std::unordered_map<std::string, wgpu::ShaderModule> variants;
+        std::unordered_map<std::string, ShaderReflection> reflections;
+
+        static uint64_t hashSource(const std::string& source);
+
+        static std::string getVariantKey(const std::string& path, std::vector<ShaderDefine> defines);
+    };
+}
+
+#endif
@@ -0,0 +1,150 @@
+#include "shader_preprocessor.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <cctype>
+
+namespace nugie {
+    static std::string trim(const std::string& text) {
+        size_t begin = text.find_first_not_of(" \t\r");
+        if (begin == std::string::npos) {
+            return "";
+        }
+
+        size_t end = text.find_last_not_of(" \t\r");
+        return text.substr(begin, end - begin + 1);
+    }
+
+    static std::string directoryOf(const std::string& path) {
+        size_t slash = path.find_last_of("/\\");
+        return slash == std::string::npos ? "" : path.substr(0, slash + 1);
+    }
+
+    static bool isIdentifierChar(char c) {
+        return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+    }
+
+    std::string ShaderPreprocessor::process(const std::string& path, const std::vector<ShaderDefine>& defines) {
+        this->macros.clear();
+        this->includedFiles.clear();
+
+        for (auto &&define : defines) {
+            this->macros[define.name] = define.value;
+        }
+
+        std::string output;
+        this->expandFile(path, output);
+
+        return output;
+    }
+
+    std::string ShaderPreprocessor::readFile(const std::string& path) {
+        std::ifstream file(this->rootDirectory + path);
+        if (!file.is_open()) {
+            throw std::runtime_error("failed to open shader file: " + path);
+        }
+
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+
+        return buffer.str();
+    }
+
+    void ShaderPreprocessor::expandFile(const std::string& path, std::string& output) {
+        if (!this->includedFiles.insert(path).second) {
+            return;
+        }
+
+        std::istringstream source(this->readFile(path));
+        std::string line;
+
+        // Each entry tells whether the enclosing #ifdef block is currently emitting code
+        std::vector<bool> activeStack;
+        bool active = true;
+
+        while (std::getline(source, line)) {
+            std::string directive = trim(line);
+
+            if (directive.rfind('#', 0) != 0) {
+                if (active) {
+                    output += this->substituteMacros(line);
+                    output += '\n';
+                }
+
+                continue;
+            }
+
+            std::istringstream tokens(directive.substr(1));
+            std::string keyword, name;
+            tokens >> keyword >> name;
+
+            if (keyword == "ifdef" || keyword == "ifndef") {
+                activeStack.push_back(active);
+                bool defined = this->macros.find(name) != this->macros.end();
+                active = active && (keyword == "ifdef" ? defined : !defined);
+            } else if (keyword == "else") {
+                if (activeStack.empty()) {
+                    throw std::runtime_error("#else without #ifdef in shader file: " + path);
+                }
+
+                active = activeStack.back() && !active;
+            } else if (keyword == "endif") {
+                if (activeStack.empty()) {
+                    throw std::runtime_error("#endif without #ifdef in shader file: " + path);
+                }
+
+                active = activeStack.back();
+                activeStack.pop_back();
+            } else if (!active) {
+                continue;
+            } else if (keyword == "include") {
+                size_t open = directive.find('"');
+                size_t close = directive.find('"', open + 1);
+
+                if (open == std::string::npos || close == std::string::npos) {
+                    throw std::runtime_error("malformed #include in shader file: " + path);
+                }
+
+                this->expandFile(directoryOf(path) + directive.substr(open + 1, close - open - 1), output);
+            } else if (keyword == "define") {
+                std::string value;
+                std::getline(tokens, value);
+                this->macros[name] = trim(value);
+            } else if (keyword == "undef") {
+                this->macros.erase(name);
+            } else {
+                throw std::runtime_error("unknown directive #" + keyword + " in shader file: " + path);
+            }
+        }
+
+        if (!activeStack.empty()) {
+            throw std::runtime_error("unterminated #ifdef in shader file: " + path);
+        }
+    }
+
+    std::string ShaderPreprocessor::substituteMacros(const std::string& line) {
+        std::string result;
+        result.reserve(line.size());
+
+        size_t i = 0;
+        while (i < line.size()) {
+            if (!isIdentifierChar(line[i])) {
+                result += line[i++];
+                continue;
+            }
+
+            size_t begin = i;
+            while (i < line.size() && isIdentifierChar(line[i])) {
+                i++;
+            }
+
+            std::string identifier = line.substr(begin, i - begin);
+            auto macro = this->macros.find(identifier);
+
+            result += (macro != this->macros.end() && !macro->second.empty()) ? macro->second : identifier;
+        }
+
+        return result;
+    }
+}
@@ -0,0 +1,37 @@
+#ifndef NUGIE_SHADER_PREPROCESSOR_HPP
+#define NUGIE_SHADER_PREPROCESSOR_HPP
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace nugie {
+    struct ShaderDefine {
+        std::string name;
+        std::string value;
+    };
+
+    // Expands #include, #define, #undef, #ifdef, #ifndef, #else and #endif in WGSL source.
+    // Every included file is only pasted once per expansion, so shared headers need no guard.
+    class ShaderPreprocessor {
+    public:
+        ShaderPreprocessor(std::string rootDirectory) : rootDirectory{rootDirectory} {}
+
+        std::string process(const std::string& path, const std::vector<ShaderDefine>& defines);
+
+        std::string readFile(const std::string& path);
+
+    private:
+        std::string rootDirectory;
+
+        std::unordered_map<std::string, std::string> macros;
+        std::unordered_set<std::string> includedFiles;
+
+        void expandFile(const std::string& path, std::string& output);
+
+        std::string substituteMacros(const std::string& line);
+    };
+}
+
+#endif
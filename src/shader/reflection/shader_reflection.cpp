@@ -0,0 +1,834 @@
+#include "shader_reflection.hpp"
+
+#include <cctype>
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace nugie {
+    namespace {
+        struct Token {
+            std::string text;
+            bool identifier;
+        };
+
+        struct Attribute {
+            std::string name;
+            std::string argument;
+        };
+
+        struct RawMember {
+            std::string name;
+            std::string type;
+            std::string align;
+            std::string size;
+        };
+
+        struct Function {
+            WGPUShaderStageFlags stage = WGPUShaderStage_None;
+            std::unordered_set<std::string> identifiers;
+        };
+
+        struct Variable {
+            std::string name;
+            std::string addressSpace;
+            std::string access;
+            std::string type;
+            uint32_t group;
+            uint32_t binding;
+        };
+
+        struct TypeLayout {
+            uint32_t align;
+            uint32_t size;
+        };
+
+        uint32_t roundUp(uint32_t alignment, uint32_t value) {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+
+        std::vector<Token> tokenize(const std::string &source) {
+            std::vector<Token> tokens;
+            size_t i = 0;
+
+            while (i < source.size()) {
+                char c = source[i];
+
+                if (std::isspace(static_cast<unsigned char>(c))) {
+                    i++;
+                } else if (source.compare(i, 2, "//") == 0) {
+                    i = source.find('\n', i);
+                    i = i == std::string::npos ? source.size() : i;
+                } else if (source.compare(i, 2, "/*") == 0) {
+                    // Block comments nest in WGSL
+                    uint32_t depth = 0;
+
+                    do {
+                        if (source.compare(i, 2, "/*") == 0) {
+                            depth++;
+                            i += 2;
+                        } else if (source.compare(i, 2, "*/") == 0) {
+                            depth--;
+                            i += 2;
+                        } else {
+                            i++;
+                        }
+                    } while (depth > 0 && i < source.size());
+                } else if (std::isalpha(static_cast<unsigned char>(c)) || c == '_') {
+                    size_t start = i;
+                    while (i < source.size() && (std::isalnum(static_cast<unsigned char>(source[i])) || source[i] == '_')) {
+                        i++;
+                    }
+
+                    tokens.push_back(Token{ source.substr(start, i - start), true });
+                } else if (std::isdigit(static_cast<unsigned char>(c)) || (c == '.' && i + 1 < source.size() && std::isdigit(static_cast<unsigned char>(source[i + 1])))) {
+                    size_t start = i;
+                    while (i < source.size() && (std::isalnum(static_cast<unsigned char>(source[i])) || source[i] == '.'
+                        || ((source[i] == '+' || source[i] == '-') && (source[i - 1] == 'e' || source[i - 1] == 'E'))))
+                    {
+                        i++;
+                    }
+
+                    tokens.push_back(Token{ source.substr(start, i - start), false });
+                } else {
+                    tokens.push_back(Token{ std::string(1, c), false });
+                    i++;
+                }
+            }
+
+            return tokens;
+        }
+
+        // Splits "array<vec4f,4>" into "array" and { "vec4f", "4" }, nested arguments stay whole
+        std::string splitType(const std::string &type, std::vector<std::string> &arguments) {
+            size_t open = type.find('<');
+            if (open == std::string::npos) {
+                return type;
+            }
+
+            uint32_t depth = 0;
+            size_t start = open + 1;
+
+            for (size_t i = open + 1; i < type.size(); i++) {
+                if (type[i] == '<') {
+                    depth++;
+                } else if (type[i] == '>' && depth > 0) {
+                    depth--;
+                } else if ((type[i] == ',' && depth == 0) || (type[i] == '>' && depth == 0)) {
+                    if (i > start) {
+                        arguments.push_back(type.substr(start, i - start));
+                    }
+
+                    start = i + 1;
+                }
+            }
+
+            return type.substr(0, open);
+        }
+
+        wgpu::TextureViewDimension getViewDimension(const std::string &dimension) {
+            if (dimension == "1d") return wgpu::TextureViewDimension::_1D;
+            if (dimension == "2d") return wgpu::TextureViewDimension::_2D;
+            if (dimension == "2d_array") return wgpu::TextureViewDimension::_2DArray;
+            if (dimension == "3d") return wgpu::TextureViewDimension::_3D;
+            if (dimension == "cube") return wgpu::TextureViewDimension::Cube;
+            if (dimension == "cube_array") return wgpu::TextureViewDimension::CubeArray;
+
+            throw std::runtime_error("Unknown WGSL texture dimension " + dimension);
+        }
+
+        wgpu::TextureFormat getStorageFormat(const std::string &format) {
+            if (format == "r32float") return wgpu::TextureFormat::R32Float;
+            if (format == "r32uint") return wgpu::TextureFormat::R32Uint;
+            if (format == "r32sint") return wgpu::TextureFormat::R32Sint;
+            if (format == "rg32float") return wgpu::TextureFormat::RG32Float;
+            if (format == "rg32uint") return wgpu::TextureFormat::RG32Uint;
+            if (format == "rgba8unorm") return wgpu::TextureFormat::RGBA8Unorm;
+            if (format == "rgba8snorm") return wgpu::TextureFormat::RGBA8Snorm;
+            if (format == "rgba8uint") return wgpu::TextureFormat::RGBA8Uint;
+            if (format == "rgba16float") return wgpu::TextureFormat::RGBA16Float;
+            if (format == "rgba16uint") return wgpu::TextureFormat::RGBA16Uint;
+            if (format == "rgba32float") return wgpu::TextureFormat::RGBA32Float;
+            if (format == "rgba32uint") return wgpu::TextureFormat::RGBA32Uint;
+            if (format == "bgra8unorm") return wgpu::TextureFormat::BGRA8Unorm;
+
+            throw std::runtime_error("Unsupported WGSL storage texture format " + format);
+        }
+
+        // Walks the module scope once. Function bodies are only scanned for the identifiers they name,
+        // which is enough to tell which variables and functions an entry point reaches.
+        class ModuleParser {
+        public:
+            std::vector<Variable> variables;
+            std::unordered_map<std::string, Function> functions;
+            std::unordered_map<std::string, std::vector<RawMember>> rawStructs;
+            std::vector<std::string> structOrder;
+            std::unordered_map<std::string, std::string> aliases;
+            std::unordered_map<std::string, std::string> constants;
+
+            explicit ModuleParser(const std::string &source)
+            : tokens{tokenize(source)}
+            {
+
+            }
+
+            void parse() {
+                while (this->position < this->tokens.size()) {
+                    std::vector<Attribute> attributes = this->parseAttributes();
+                    if (this->position >= this->tokens.size()) {
+                        break;
+                    }
+
+                    std::string keyword = this->next();
+
+                    if (keyword == "struct") {
+                        this->parseStruct();
+                    } else if (keyword == "var") {
+                        this->parseVariable(attributes);
+                    } else if (keyword == "fn") {
+                        this->parseFunction(attributes);
+                    } else if (keyword == "const" || keyword == "override") {
+                        this->parseConstant();
+                    } else if (keyword == "alias") {
+                        std::string name = this->next();
+                        this->expect("=");
+                        this->aliases[name] = this->parseType();
+                        this->expect(";");
+                    } else if (keyword == "enable" || keyword == "requires" || keyword == "diagnostic" || keyword == "const_assert") {
+                        this->skipPast(";");
+                    } else if (keyword != ";") {
+                        throw std::runtime_error("Unexpected '" + keyword + "' at the module scope of WGSL");
+                    }
+                }
+            }
+
+            uint32_t parseInteger(const std::string &text) {
+                auto constant = this->constants.find(text);
+                if (constant != this->constants.end()) {
+                    return this->parseInteger(constant->second);
+                }
+
+                std::string digits = text;
+                while (!digits.empty() && (digits.back() == 'u' || digits.back() == 'i')) {
+                    digits.pop_back();
+                }
+
+                try {
+                    return static_cast<uint32_t>(std::stoul(digits, nullptr, 0));
+                } catch (const std::exception&) {
+                    throw std::runtime_error("Expected an integer in WGSL, got " + text);
+                }
+            }
+
+        private:
+            std::vector<Token> tokens;
+            size_t position = 0;
+
+            const std::string& peek() {
+                static const std::string end;
+                return this->position < this->tokens.size() ? this->tokens[this->position].text : end;
+            }
+
+            std::string next() {
+                if (this->position >= this->tokens.size()) {
+                    throw std::runtime_error("Unexpected end of WGSL source");
+                }
+
+                return this->tokens[this->position++].text;
+            }
+
+            void expect(const std::string &text) {
+                std::string found = this->next();
+                if (found != text) {
+                    throw std::runtime_error("Expected '" + text + "' in WGSL, got '" + found + "'");
+                }
+            }
+
+            void skipPast(const std::string &text) {
+                while (this->next() != text) {}
+            }
+
+            // The tokens up to the parenthesis closing the one just read, joined without spaces
+            std::string readParenthesized() {
+                std::string text;
+                uint32_t depth = 1;
+
+                while (true) {
+                    std::string token = this->next();
+
+                    if (token == "(") {
+                        depth++;
+                    } else if (token == ")" && --depth == 0) {
+                        return text;
+                    }
+
+                    text += token;
+                }
+            }
+
+            std::vector<Attribute> parseAttributes() {
+                std::vector<Attribute> attributes;
+
+                while (this->peek() == "@") {
+                    this->next();
+
+                    Attribute attribute{ this->next(), "" };
+                    if (this->peek() == "(") {
+                        this->next();
+                        attribute.argument = this->readParenthesized();
+                    }
+
+                    attributes.push_back(attribute);
+                }
+
+                return attributes;
+            }
+
+            std::string parseType() {
+                std::string type = this->next();
+                if (this->peek() != "<") {
+                    return type;
+                }
+
+                uint32_t depth = 0;
+                do {
+                    std::string token = this->next();
+
+                    if (token == "<") {
+                        depth++;
+                    } else if (token == ">") {
+                        depth--;
+                    }
+
+                    type += token;
+                } while (depth > 0);
+
+                return type;
+            }
+
+            void parseStruct() {
+                std::string name = this->next();
+                std::vector<RawMember> members;
+
+                this->expect("{");
+
+                while (this->peek() != "}") {
+                    RawMember member{};
+
+                    for (auto &&attribute : this->parseAttributes()) {
+                        if (attribute.name == "align") {
+                            member.align = attribute.argument;
+                        } else if (attribute.name == "size") {
+                            member.size = attribute.argument;
+                        }
+                    }
+
+                    member.name = this->next();
+                    this->expect(":");
+                    member.type = this->parseType();
+
+                    members.push_back(member);
+
+                    if (this->peek() == ",") {
+                        this->next();
+                    }
+                }
+
+                this->expect("}");
+
+                this->rawStructs[name] = members;
+                this->structOrder.push_back(name);
+            }
+
+            void parseVariable(const std::vector<Attribute> &attributes) {
+                Variable variable{};
+
+                if (this->peek() == "<") {
+                    this->next();
+                    variable.addressSpace = this->next();
+
+                    if (this->peek() == ",") {
+                        this->next();
+                        variable.access = this->next();
+                    }
+
+                    this->expect(">");
+                }
+
+                variable.name = this->next();
+
+                if (this->peek() == ":") {
+                    this->next();
+                    variable.type = this->parseType();
+                }
+
+                this->skipPast(";");
+
+                bool hasGroup = false;
+                bool hasBinding = false;
+
+                for (auto &&attribute : attributes) {
+                    if (attribute.name == "group") {
+                        variable.group = this->parseInteger(attribute.argument);
+                        hasGroup = true;
+                    } else if (attribute.name == "binding") {
+                        variable.binding = this->parseInteger(attribute.argument);
+                        hasBinding = true;
+                    }
+                }
+
+                // Private and workgroup variables take no part in the layout
+                if (hasGroup && hasBinding) {
+                    this->variables.push_back(variable);
+                }
+            }
+
+            void parseFunction(const std::vector<Attribute> &attributes) {
+                std::string name = this->next();
+                Function function{};
+
+                for (auto &&attribute : attributes) {
+                    if (attribute.name == "vertex") {
+                        function.stage = WGPUShaderStage_Vertex;
+                    } else if (attribute.name == "fragment") {
+                        function.stage = WGPUShaderStage_Fragment;
+                    } else if (attribute.name == "compute") {
+                        function.stage = WGPUShaderStage_Compute;
+                    }
+                }
+
+                while (this->peek() != "{") {
+                    this->next();
+                }
+
+                uint32_t depth = 0;
+                do {
+                    const Token &token = this->tokens[this->position];
+
+                    if (token.text == "{") {
+                        depth++;
+                    } else if (token.text == "}") {
+                        depth--;
+                    } else if (token.identifier) {
+                        function.identifiers.insert(token.text);
+                    }
+
+                    this->next();
+                } while (depth > 0);
+
+                this->functions[name] = std::move(function);
+            }
+
+            // Only constants whose initializer is a single literal are kept, they may size arrays
+            void parseConstant() {
+                std::string name = this->next();
+                std::vector<std::string> initializer;
+                bool assigned = false;
+
+                for (std::string token = this->next(); token != ";"; token = this->next()) {
+                    if (assigned) {
+                        initializer.push_back(token);
+                    } else if (token == "=") {
+                        assigned = true;
+                    }
+                }
+
+                if (initializer.size() == 1) {
+                    this->constants[name] = initializer[0];
+                }
+            }
+        };
+
+        class LayoutBuilder {
+        public:
+            explicit LayoutBuilder(ModuleParser &parser)
+            : parser{parser}
+            {
+
+            }
+
+            TypeLayout getLayout(const std::string &type) {
+                std::vector<std::string> arguments;
+                std::string base = splitType(type, arguments);
+
+                auto alias = this->parser.aliases.find(base);
+                if (alias != this->parser.aliases.end() && arguments.empty()) {
+                    return this->getLayout(alias->second);
+                }
+
+                if (base == "f32" || base == "i32" || base == "u32" || base == "bool") {
+                    return TypeLayout{ 4, 4 };
+                }
+
+                if (base == "f16") {
+                    return TypeLayout{ 2, 2 };
+                }
+
+                if (base == "atomic" && arguments.size() == 1) {
+                    return this->getLayout(arguments[0]);
+                }
+
+                // vec3f, vec3<f32>, mat4x4f, mat4x4<f32> and their i, u and h forms
+                if (base.size() >= 4 && base.compare(0, 3, "vec") == 0 && std::isdigit(static_cast<unsigned char>(base[3]))) {
+                    return getVectorLayout(base[3] - '0', this->getComponentSize(base.substr(4), arguments));
+                }
+
+                if (base.size() >= 6 && base.compare(0, 3, "mat") == 0 && base[4] == 'x') {
+                    uint32_t columns = base[3] - '0';
+                    TypeLayout column = getVectorLayout(base[5] - '0', this->getComponentSize(base.substr(6), arguments));
+
+                    return TypeLayout{ column.align, columns * roundUp(column.align, column.size) };
+                }
+
+                if (base == "array" && !arguments.empty()) {
+                    TypeLayout element = this->getLayout(arguments[0]);
+                    uint32_t stride = roundUp(element.align, element.size);
+
+                    // A runtime sized array counts as one element, the least a binding must hold
+                    uint32_t count = arguments.size() > 1 ? this->parser.parseInteger(arguments[1]) : 1;
+
+                    return TypeLayout{ element.align, count * stride };
+                }
+
+                const StructLayout &layout = this->getStruct(base);
+                return TypeLayout{ layout.align, layout.size };
+            }
+
+            const StructLayout& getStruct(const std::string &name) {
+                auto laidOut = this->structs.find(name);
+                if (laidOut != this->structs.end()) {
+                    return laidOut->second;
+                }
+
+                auto raw = this->parser.rawStructs.find(name);
+                if (raw == this->parser.rawStructs.end()) {
+                    throw std::runtime_error("Unknown WGSL type " + name);
+                }
+
+                StructLayout layout{};
+                layout.name = name;
+
+                uint32_t end = 0;
+                for (auto &&rawMember : raw->second) {
+                    TypeLayout memberLayout = this->getLayout(rawMember.type);
+
+                    uint32_t align = rawMember.align.empty() ? memberLayout.align : this->parser.parseInteger(rawMember.align);
+                    uint32_t size = rawMember.size.empty() ? memberLayout.size : this->parser.parseInteger(rawMember.size);
+                    uint32_t offset = roundUp(align, end);
+
+                    layout.members.push_back(StructMember{ rawMember.name, rawMember.type, offset, size, align });
+                    layout.align = std::max(layout.align, align);
+
+                    end = offset + size;
+                }
+
+                layout.size = roundUp(layout.align, end);
+
+                return this->structs[name] = layout;
+            }
+
+            std::unordered_map<std::string, StructLayout> structs;
+
+        private:
+            ModuleParser &parser;
+
+            static TypeLayout getVectorLayout(uint32_t count, uint32_t componentSize) {
+                uint32_t align = (count == 3 ? 4 : count) * componentSize;
+                return TypeLayout{ align, count * componentSize };
+            }
+
+            uint32_t getComponentSize(const std::string &suffix, const std::vector<std::string> &arguments) {
+                if (suffix == "h") {
+                    return 2;
+                }
+
+                if (suffix.empty() && arguments.size() == 1) {
+                    return this->getLayout(arguments[0]).size;
+                }
+
+                return 4;
+            }
+        };
+
+        bool isSameLayout(const StructLayout &a, const StructLayout &b) {
+            if (a.size != b.size || a.members.size() != b.members.size()) {
+                return false;
+            }
+
+            for (size_t i = 0; i < a.members.size(); i++) {
+                if (a.members[i].name != b.members[i].name || a.members[i].offset != b.members[i].offset) {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+    }
+
+    ShaderReflection::ShaderReflection(const std::string &source) {
+        ModuleParser parser{ source };
+        parser.parse();
+
+        LayoutBuilder layoutBuilder{ parser };
+        for (auto &&name : parser.structOrder) {
+            layoutBuilder.getStruct(name);
+        }
+
+        // The functions each stage reaches, following calls from its entry points
+        std::vector<std::pair<WGPUShaderStageFlags, std::unordered_set<std::string>>> reached;
+
+        for (auto &&[name, function] : parser.functions) {
+            if (function.stage == WGPUShaderStage_None) {
+                continue;
+            }
+
+            std::unordered_set<std::string> visited{ name };
+            std::vector<std::string> pending{ name };
+
+            while (!pending.empty()) {
+                const Function &current = parser.functions[pending.back()];
+                pending.pop_back();
+
+                for (auto &&identifier : current.identifiers) {
+                    if (parser.functions.count(identifier) > 0 && visited.insert(identifier).second) {
+                        pending.push_back(identifier);
+                    }
+                }
+            }
+
+            reached.push_back({ function.stage, std::move(visited) });
+        }
+
+        for (auto &&variable : parser.variables) {
+            ReflectedBinding binding{};
+            binding.group = variable.group;
+            binding.binding = variable.binding;
+            binding.name = variable.name;
+            binding.type = variable.type;
+
+            for (auto &&[stage, functionNames] : reached) {
+                for (auto &&functionName : functionNames) {
+                    if (parser.functions[functionName].identifiers.count(variable.name) > 0) {
+                        binding.visibility |= stage;
+                        break;
+                    }
+                }
+            }
+
+            std::vector<std::string> arguments;
+            std::string base = splitType(variable.type, arguments);
+
+            if (variable.addressSpace == "uniform" || variable.addressSpace == "storage") {
+                if (variable.addressSpace == "uniform") {
+                    binding.kind = BindingKind::UniformBuffer;
+                } else {
+                    binding.kind = variable.access == "read_write" ? BindingKind::StorageBuffer : BindingKind::ReadOnlyStorageBuffer;
+                }
+
+                binding.minBindingSize = layoutBuilder.getLayout(variable.type).size;
+            } else if (base == "sampler") {
+                binding.kind = BindingKind::Sampler;
+            } else if (base == "sampler_comparison") {
+                binding.kind = BindingKind::ComparisonSampler;
+            } else if (base.compare(0, 16, "texture_storage_") == 0 && arguments.size() == 2) {
+                binding.kind = BindingKind::StorageTexture;
+                binding.viewDimension = getViewDimension(base.substr(16));
+                binding.storageFormat = getStorageFormat(arguments[0]);
+
+                if (arguments[1] == "read") {
+                    binding.storageAccess = wgpu::StorageTextureAccess::ReadOnly;
+                } else if (arguments[1] == "read_write") {
+                    binding.storageAccess = wgpu::StorageTextureAccess::ReadWrite;
+                } else {
+                    binding.storageAccess = wgpu::StorageTextureAccess::WriteOnly;
+                }
+            } else if (base.compare(0, 14, "texture_depth_") == 0) {
+                std::string dimension = base.substr(14);
+
+                binding.kind = BindingKind::Texture;
+                binding.sampleType = wgpu::TextureSampleType::Depth;
+                binding.multisampled = dimension.compare(0, 13, "multisampled_") == 0;
+                binding.viewDimension = getViewDimension(binding.multisampled ? dimension.substr(13) : dimension);
+            } else if (base.compare(0, 8, "texture_") == 0 && arguments.size() == 1) {
+                std::string dimension = base.substr(8);
+
+                binding.kind = BindingKind::Texture;
+                binding.multisampled = dimension.compare(0, 13, "multisampled_") == 0;
+                binding.viewDimension = getViewDimension(binding.multisampled ? dimension.substr(13) : dimension);
+
+                if (arguments[0] == "i32") {
+                    binding.sampleType = wgpu::TextureSampleType::Sint;
+                } else if (arguments[0] == "u32") {
+                    binding.sampleType = wgpu::TextureSampleType::Uint;
+                } else {
+                    // Multisampled textures cannot be filtered
+                    binding.sampleType = binding.multisampled ? wgpu::TextureSampleType::UnfilterableFloat : wgpu::TextureSampleType::Float;
+                }
+            } else {
+                throw std::runtime_error("Binding " + variable.name + " has a type WGSL reflection does not know, " + variable.type);
+            }
+
+            this->bindings.push_back(binding);
+        }
+
+        std::sort(this->bindings.begin(), this->bindings.end(), [](const ReflectedBinding &a, const ReflectedBinding &b) {
+            return a.group != b.group ? a.group < b.group : a.binding < b.binding;
+        });
+
+        this->structs = std::move(layoutBuilder.structs);
+    }
+
+    void ShaderReflection::merge(const ShaderReflection &other) {
+        for (auto &&binding : other.bindings) {
+            auto existing = std::find_if(this->bindings.begin(), this->bindings.end(), [&](const ReflectedBinding &candidate) {
+                return candidate.group == binding.group && candidate.binding == binding.binding;
+            });
+
+            if (existing == this->bindings.end()) {
+                this->bindings.push_back(binding);
+                continue;
+            }
+
+            if (existing->kind != binding.kind || existing->type != binding.type) {
+                throw std::runtime_error("Binding " + std::to_string(binding.group) + ":" + std::to_string(binding.binding) + " is declared as "
+                    + existing->type + " and as " + binding.type);
+            }
+
+            existing->visibility |= binding.visibility;
+        }
+
+        std::sort(this->bindings.begin(), this->bindings.end(), [](const ReflectedBinding &a, const ReflectedBinding &b) {
+            return a.group != b.group ? a.group < b.group : a.binding < b.binding;
+        });
+
+        for (auto &&[name, layout] : other.structs) {
+            auto existing = this->structs.find(name);
+
+            if (existing == this->structs.end()) {
+                this->structs[name] = layout;
+            } else if (!isSameLayout(existing->second, layout)) {
+                throw std::runtime_error("WGSL struct " + name + " is declared with two different layouts");
+            }
+        }
+    }
+
+    const ReflectedBinding* ShaderReflection::findBinding(uint32_t group, uint32_t binding) const {
+        for (auto &&candidate : this->bindings) {
+            if (candidate.group == group && candidate.binding == binding) {
+                return &candidate;
+            }
+        }
+
+        return nullptr;
+    }
+
+    const StructLayout* ShaderReflection::findStruct(const std::string &name) const {
+        auto layout = this->structs.find(name);
+        return layout != this->structs.end() ? &layout->second : nullptr;
+    }
+
+    std::vector<wgpu::BindGroupLayoutEntry> ShaderReflection::getBindGroupLayoutEntries(uint32_t group) const {
+        std::vector<wgpu::BindGroupLayoutEntry> entries;
+
+        for (auto &&binding : this->bindings) {
+            if (binding.group != group) {
+                continue;
+            }
+
+            wgpu::BindGroupLayoutEntry entry{};
+            entry.nextInChain = nullptr;
+            entry.binding = binding.binding;
+            entry.visibility = binding.visibility;
+
+            switch (binding.kind) {
+                case BindingKind::UniformBuffer:
+                case BindingKind::StorageBuffer:
+                case BindingKind::ReadOnlyStorageBuffer:
+                    entry.buffer.nextInChain = nullptr;
+                    entry.buffer.hasDynamicOffset = false;
+                    entry.buffer.minBindingSize = binding.minBindingSize;
+
+                    if (binding.kind == BindingKind::UniformBuffer) {
+                        entry.buffer.type = wgpu::BufferBindingType::Uniform;
+                    } else if (binding.kind == BindingKind::StorageBuffer) {
+                        entry.buffer.type = wgpu::BufferBindingType::Storage;
+                    } else {
+                        entry.buffer.type = wgpu::BufferBindingType::ReadOnlyStorage;
+                    }
+                    break;
+                case BindingKind::Texture:
+                    entry.texture.nextInChain = nullptr;
+                    entry.texture.sampleType = binding.sampleType;
+                    entry.texture.viewDimension = binding.viewDimension;
+                    entry.texture.multisampled = binding.multisampled;
+                    break;
+                case BindingKind::StorageTexture:
+                    entry.storageTexture.nextInChain = nullptr;
+                    entry.storageTexture.access = binding.storageAccess;
+                    entry.storageTexture.format = binding.storageFormat;
+                    entry.storageTexture.viewDimension = binding.viewDimension;
+                    break;
+                case BindingKind::Sampler:
+                case BindingKind::ComparisonSampler:
+                    entry.sampler.nextInChain = nullptr;
+                    entry.sampler.type = binding.kind == BindingKind::Sampler ? wgpu::SamplerBindingType::Filtering : wgpu::SamplerBindingType::Comparison;
+                    break;
+            }
+
+            entries.push_back(entry);
+        }
+
+        return entries;
+    }
+
+    wgpu::BindGroupLayout ShaderReflection::createBindGroupLayout(nugie::Device *device, const char *label, uint32_t group) const {
+        std::vector<wgpu::BindGroupLayoutEntry> entries = this->getBindGroupLayoutEntries(group);
+
+        wgpu::BindGroupLayoutDescriptor bindGroupLayoutDesc{};
+        bindGroupLayoutDesc.label = label;
+        bindGroupLayoutDesc.nextInChain = nullptr;
+        bindGroupLayoutDesc.entryCount = entries.size();
+        bindGroupLayoutDesc.entries = entries.data();
+
+        return device->createBindGroupLayout(bindGroupLayoutDesc);
+    }
+
+    void ShaderReflection::validateStruct(const std::string &name, size_t hostSize, std::initializer_list<HostMember> hostMembers) const {
+        const StructLayout *layout = this->findStruct(name);
+        if (layout == nullptr) {
+            throw std::runtime_error("WGSL struct " + name + " not found");
+        }
+
+        std::string errors;
+
+        if (layout->size != hostSize) {
+            errors += "\n    size is " + std::to_string(layout->size) + " in WGSL but " + std::to_string(hostSize) + " in C++";
+        }
+
+        for (auto &&member : layout->members) {
+            auto hostMember = std::find_if(hostMembers.begin(), hostMembers.end(), [&](const HostMember &candidate) {
+                return member.name == candidate.name;
+            });
+
+            if (hostMember == hostMembers.end()) {
+                errors += "\n    " + member.name + " has no C++ counterpart";
+            } else if (hostMember->offset != member.offset) {
+                errors += "\n    " + member.name + " is at " + std::to_string(member.offset) + " in WGSL but at " + std::to_string(hostMember->offset) + " in C++";
+            }
+        }
+
+        for (auto &&hostMember : hostMembers) {
+            bool found = std::any_of(layout->members.begin(), layout->members.end(), [&](const StructMember &member) {
+                return member.name == hostMember.name;
+            });
+
+            if (!found) {
+                errors += "\n    " + std::string(hostMember.name) + " is not a member in WGSL";
+            }
+        }
+
+        if (!errors.empty()) {
+            throw std::runtime_error("Layout of " + name + " does not match its WGSL struct:" + errors);
+        }
+    }
+}
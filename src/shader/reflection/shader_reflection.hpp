@@ -0,0 +1,107 @@
+#ifndef NUGIE_SHADER_REFLECTION_HPP
+#define NUGIE_SHADER_REFLECTION_HPP
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <initializer_list>
+#include <unordered_map>
+
+#include "../../device/device.hpp"
+
+namespace nugie {
+    class Device;
+
+    // One member of a host-shareable struct, placed by the WGSL alignment rules
+    struct StructMember {
+        std::string name;
+        std::string type;
+        uint32_t offset;
+        uint32_t size;
+        uint32_t align;
+    };
+
+    struct StructLayout {
+        std::string name;
+        std::vector<StructMember> members;
+        uint32_t size = 0;
+        uint32_t align = 1;
+    };
+
+    enum class BindingKind {
+        UniformBuffer,
+        StorageBuffer,
+        ReadOnlyStorageBuffer,
+        Texture,
+        StorageTexture,
+        Sampler,
+        ComparisonSampler
+    };
+
+    struct ReflectedBinding {
+        uint32_t group;
+        uint32_t binding;
+        std::string name;
+        std::string type;
+        BindingKind kind;
+
+        // Stages whose entry points reach the variable, through any function they call
+        WGPUShaderStageFlags visibility = WGPUShaderStage_None;
+
+        // Size of the buffer's type, of the fixed part and one element for runtime sized arrays
+        uint64_t minBindingSize = 0;
+
+        wgpu::TextureSampleType sampleType = wgpu::TextureSampleType::Undefined;
+        wgpu::TextureViewDimension viewDimension = wgpu::TextureViewDimension::Undefined;
+        bool multisampled = false;
+
+        wgpu::TextureFormat storageFormat = wgpu::TextureFormat::Undefined;
+        wgpu::StorageTextureAccess storageAccess = wgpu::StorageTextureAccess::Undefined;
+    };
+
+    // A C++ member checked against its WGSL counterpart, by name
+    struct HostMember {
+        const char *name;
+        size_t offset;
+    };
+
+    // What a preprocessed WGSL source declares: its structs laid out as the GPU reads them, and its
+    // resource bindings with the stages that use them. It only understands the module scope of WGSL
+    // (structs, aliases, constants, variables and functions), which is all the layouts depend on.
+    //
+    // Bind group layouts are built from it instead of by hand, and C++ structs that mirror WGSL ones
+    // are checked against it at startup, so a member added on one side only fails loudly instead of
+    // shifting everything after it.
+    class ShaderReflection {
+    public:
+        ShaderReflection() = default;
+
+        // Throws std::runtime_error for a source it cannot parse
+        explicit ShaderReflection(const std::string &source);
+
+        // Adds the bindings and structs of another module, for layouts shared by several pipelines.
+        // The visibility of a binding both declare is the union, differing declarations throw.
+        void merge(const ShaderReflection &other);
+
+        const std::vector<ReflectedBinding>& getBindings() const { return this->bindings; }
+
+        const ReflectedBinding* findBinding(uint32_t group, uint32_t binding) const;
+
+        const StructLayout* findStruct(const std::string &name) const;
+
+        // Entries sorted by binding. Textures of f32 reflect as filterable, samplers as filtering.
+        std::vector<wgpu::BindGroupLayoutEntry> getBindGroupLayoutEntries(uint32_t group) const;
+
+        wgpu::BindGroupLayout createBindGroupLayout(nugie::Device *device, const char *label, uint32_t group) const;
+
+        // Throws std::runtime_error unless the C++ struct has the WGSL struct's size and every one of its
+        // members at the same offset. Host members WGSL does not have, like explicit padding, may be left out.
+        void validateStruct(const std::string &name, size_t hostSize, std::initializer_list<HostMember> hostMembers) const;
+
+    private:
+        std::vector<ReflectedBinding> bindings;
+        std::unordered_map<std::string, StructLayout> structs;
+    };
+}
+
+#endif
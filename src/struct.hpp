@@ -16,4 +16,34 @@ namespace nugie {
         ChildBuffer indexBuffer;
         uint32_t indexCount;
     };
-}
\ No newline at end of file
+
+    // Everything needed to record one indexed draw into a pass or a render bundle
+    struct DrawCommand {
+        wgpu::RenderPipeline pipeline;
+        wgpu::BindGroup sceneBindGroup;
+        wgpu::BindGroup objectBindGroup;
+
+        BufferInfo positionBuffer;
+        BufferInfo textCoordBuffer;
+        BufferInfo indexBuffer;
+
+        uint32_t indexCount;
+        uint32_t instanceCount = 1;
+
+        // When set, the draw arguments are read from this buffer on the GPU instead
+        BufferInfo indirectBuffer{};
+    };
+
+    enum class LightType : uint32_t {
+        Point = 0,
+        Spot = 1
+    };
+
+    // Layout matches `Light` in common/lights.wgsl
+    struct Light {
+        glm::vec4 positionRange;    // world position, range
+        glm::vec4 colorIntensity;   // linear color, intensity
+        glm::vec4 directionType;    // spot direction, LightType as a float
+        glm::vec4 spotAngles;       // cosine of the inner cone, cosine of the outer cone
+    };
+}
@@ -0,0 +1,363 @@
+#include "world_streamer.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+namespace nugie {
+    uint64_t CellPayload::getByteSize() const {
+        return this->positions.size() * sizeof(glm::vec3)
+            + this->textCoords.size() * sizeof(glm::vec2)
+            + this->indices.size() * sizeof(uint32_t)
+            + this->texturePixels.size()
+            + this->instanceData.size();
+    }
+
+    WorldStreamer::WorldStreamer(nugie::Device *device, nugie::JobSystem *jobSystem, nugie::DeletionQueue *deletionQueue, StreamingSettings settings, CellLoader loader)
+    : device{device},
+      jobSystem{jobSystem},
+      deletionQueue{deletionQueue},
+      settings{settings},
+      loader{loader},
+      memoryBudgetBytes{settings.memoryBudgetBytes}
+    {
+        this->settings.cellSize = std::max(this->settings.cellSize, 0.001f);
+        this->settings.unloadRadius = std::max(this->settings.unloadRadius, this->settings.loadRadius);
+        this->settings.maxLoadsInFlight = std::max(this->settings.maxLoadsInFlight, 1u);
+        this->settings.minMemoryBudgetBytes = std::min(this->settings.minMemoryBudgetBytes, this->settings.memoryBudgetBytes);
+    }
+
+    WorldStreamer::~WorldStreamer() {
+        this->release();
+    }
+
+    void WorldStreamer::setResidencyCallbacks(CellCallback onResident, CellCallback onEvict) {
+        this->onResident = onResident;
+        this->onEvict = onEvict;
+    }
+
+    void WorldStreamer::update(nugie::Camera *camera) {
+        // Pressure may come from any of the device's memory, so it only caps the budget while it lasts
+        if (this->memoryPressure.exchange(false)) {
+            uint64_t cappedBytes = std::min(this->memoryBudgetBytes, this->residentBytes / 4 * 3);
+            this->memoryBudgetBytes = std::max(cappedBytes, this->settings.minMemoryBudgetBytes);
+        } else if (this->memoryBudgetBytes < this->settings.memoryBudgetBytes && !this->device->getMemoryTracker()->isOverBudget()) {
+            this->memoryBudgetBytes = std::min(this->memoryBudgetBytes + this->settings.uploadBytesPerFrame, this->settings.memoryBudgetBytes);
+        }
+
+        this->stats.uploadedBytes = 0;
+        this->stats.evictedCells = 0;
+
+        // Every cell in the load radius gets an entry, so it is ranked with the ones already known
+        int32_t radiusCells = static_cast<int32_t>(std::ceil(this->settings.loadRadius / this->settings.cellSize));
+        int32_t centerX = static_cast<int32_t>(std::floor(camera->position.x / this->settings.cellSize));
+        int32_t centerZ = static_cast<int32_t>(std::floor(camera->position.z / this->settings.cellSize));
+
+        for (int32_t z = centerZ - radiusCells; z <= centerZ + radiusCells; z++) {
+            for (int32_t x = centerX - radiusCells; x <= centerX + radiusCells; x++) {
+                this->getCell(CellCoord{ x, z });
+            }
+        }
+
+        this->rankCells(camera->position, camera->front);
+
+        // Whatever left the unload radius goes, finished loads included
+        this->loadsInFlight = 0;
+        for (Cell *cell : this->rankedCells) {
+            CellState state = cell->state.load(std::memory_order_acquire);
+
+            if (state == CellState::Loading) {
+                this->loadsInFlight++;
+            } else if (cell->distance > this->settings.unloadRadius) {
+                if (state == CellState::Resident) {
+                    this->evict(cell);
+                } else if (state == CellState::Loaded) {
+                    cell->payload = CellPayload{};
+                    cell->state.store(CellState::Unloaded, std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // A lowered budget takes effect even when nothing new is waiting
+        this->evictToBudget();
+
+        // Finished loads go up best ranked first, as far as the upload and memory budgets allow
+        uint64_t uploadedBytes = 0;
+        for (Cell *cell : this->rankedCells) {
+            if (cell->state.load(std::memory_order_acquire) != CellState::Loaded) {
+                continue;
+            }
+
+            uint64_t byteSize = cell->payload.getByteSize();
+            if (uploadedBytes > 0 && uploadedBytes + byteSize > this->settings.uploadBytesPerFrame) {
+                break;
+            }
+
+            if (!this->makeRoom(byteSize, cell->priority)) {
+                continue;
+            }
+
+            this->upload(cell);
+            uploadedBytes += byteSize;
+        }
+
+        for (Cell *cell : this->rankedCells) {
+            if (this->loadsInFlight >= this->settings.maxLoadsInFlight) {
+                break;
+            }
+
+            if (cell->distance <= this->settings.loadRadius && cell->state.load(std::memory_order_acquire) == CellState::Unloaded) {
+                this->startLoad(cell);
+            }
+        }
+
+        // Cells that are far away and hold nothing are forgotten, so the table only covers the neighbourhood
+        for (auto entry = this->cells.begin(); entry != this->cells.end();) {
+            Cell &cell = *entry->second;
+
+            if (cell.distance > this->settings.unloadRadius && cell.state.load(std::memory_order_acquire) == CellState::Unloaded) {
+                entry = this->cells.erase(entry);
+            } else {
+                entry++;
+            }
+        }
+
+        this->stats.residentCells = 0;
+        this->stats.loadingCells = 0;
+        this->stats.pendingUploads = 0;
+
+        for (auto &&entry : this->cells) {
+            CellState state = entry.second->state.load(std::memory_order_acquire);
+
+            this->stats.residentCells += state == CellState::Resident ? 1 : 0;
+            this->stats.loadingCells += state == CellState::Loading ? 1 : 0;
+            this->stats.pendingUploads += state == CellState::Loaded ? 1 : 0;
+        }
+
+        this->stats.residentBytes = this->residentBytes;
+        this->stats.uploadedBytes = uploadedBytes;
+    }
+
+    void WorldStreamer::onMemoryPressure() {
+        this->memoryPressure.store(true);
+    }
+
+    void WorldStreamer::release() {
+        if (this->released) {
+            return;
+        }
+
+        this->jobSystem->wait(this->loadCounter);
+
+        for (auto &&entry : this->cells) {
+            if (entry.second->state.load(std::memory_order_acquire) == CellState::Resident) {
+                this->evict(entry.second.get());
+            }
+        }
+
+        this->cells.clear();
+        this->rankedCells.clear();
+
+        this->released = true;
+    }
+
+    uint64_t WorldStreamer::getKey(CellCoord coord) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(coord.x)) << 32) | static_cast<uint32_t>(coord.z);
+    }
+
+    WorldStreamer::Cell* WorldStreamer::getCell(CellCoord coord) {
+        std::unique_ptr<Cell> &cell = this->cells[getKey(coord)];
+
+        if (!cell) {
+            cell = std::make_unique<Cell>();
+            cell->coord = coord;
+        }
+
+        return cell.get();
+    }
+
+    void WorldStreamer::rankCells(glm::vec3 position, glm::vec3 front) {
+        glm::vec2 viewDirection{ front.x, front.z };
+        float viewLength = glm::length(viewDirection);
+
+        this->rankedCells.clear();
+
+        for (auto &&entry : this->cells) {
+            Cell *cell = entry.second.get();
+
+            glm::vec2 center{ (cell->coord.x + 0.5f) * this->settings.cellSize, (cell->coord.z + 0.5f) * this->settings.cellSize };
+            glm::vec2 toCell = center - glm::vec2{ position.x, position.z };
+
+            cell->distance = glm::length(toCell);
+
+            // Straight down or standing in the cell, there is no direction to prefer
+            float facing = 1.0f;
+            if (viewLength > 0.0001f && cell->distance > 0.0001f) {
+                facing = glm::dot(viewDirection / viewLength, toCell / cell->distance);
+            }
+
+            cell->priority = cell->distance * (1.0f + this->settings.directionWeight * (1.0f - facing) * 0.5f);
+
+            this->rankedCells.push_back(cell);
+        }
+
+        std::sort(this->rankedCells.begin(), this->rankedCells.end(), [](const Cell *a, const Cell *b) {
+            return a->priority < b->priority;
+        });
+    }
+
+    void WorldStreamer::startLoad(Cell *cell) {
+        cell->state.store(CellState::Loading, std::memory_order_relaxed);
+        this->loadsInFlight++;
+
+        // Loads may take long, so they stay off the workers a frame's wait() helps out on
+        this->jobSystem->runBackground(this->loadCounter, [this, cell] {
+            this->loader(cell->coord, cell->payload);
+            cell->state.store(CellState::Loaded, std::memory_order_release);
+        });
+    }
+
+    void WorldStreamer::upload(Cell *cell) {
+        CellPayload &payload = cell->payload;
+        CellResources &resources = cell->resources;
+
+        auto createBuffer = [this](const char *label, WGPUBufferUsageFlags usage, const void *data, uint64_t size) {
+            wgpu::BufferDescriptor bufferDesc{};
+            bufferDesc.label = label;
+            bufferDesc.size = size;
+            bufferDesc.usage = usage | WGPUBufferUsage_CopyDst;
+            bufferDesc.mappedAtCreation = false;
+
+            wgpu::Buffer buffer = this->device->createBuffer(bufferDesc);
+            this->device->writeBuffer(buffer, 0, data, size);
+
+            return BufferHandle{ buffer, this->deletionQueue };
+        };
+
+        if (!payload.positions.empty()) {
+            resources.positionBuffer = createBuffer("Cell Position Buffer", WGPUBufferUsage_Vertex, payload.positions.data(), payload.positions.size() * sizeof(glm::vec3));
+        }
+
+        if (!payload.textCoords.empty()) {
+            resources.textCoordBuffer = createBuffer("Cell Texture Coordinate Buffer", WGPUBufferUsage_Vertex, payload.textCoords.data(), payload.textCoords.size() * sizeof(glm::vec2));
+        }
+
+        if (!payload.indices.empty()) {
+            resources.indexBuffer = createBuffer("Cell Index Buffer", WGPUBufferUsage_Index, payload.indices.data(), payload.indices.size() * sizeof(uint32_t));
+        }
+
+        // Queue writes must be a multiple of four bytes
+        if (!payload.instanceData.empty()) {
+            payload.instanceData.resize((payload.instanceData.size() + 3) & ~size_t(3), 0);
+            resources.instanceBuffer = createBuffer("Cell Instance Buffer", WGPUBufferUsage_Vertex | WGPUBufferUsage_Storage, payload.instanceData.data(), payload.instanceData.size());
+        }
+
+        if (!payload.texturePixels.empty()) {
+            wgpu::TextureDescriptor textureDesc{};
+            textureDesc.nextInChain = nullptr;
+            textureDesc.label = "Cell Texture";
+            textureDesc.dimension = wgpu::TextureDimension::_2D;
+            textureDesc.size = { payload.textureWidth, payload.textureHeight, 1 };
+            textureDesc.mipLevelCount = 1;
+            textureDesc.sampleCount = 1;
+            textureDesc.format = wgpu::TextureFormat::RGBA8Unorm;
+            textureDesc.usage = wgpu::TextureUsage::CopyDst | wgpu::TextureUsage::TextureBinding;
+
+            resources.texture = TextureHandle{ this->device->createTexture(textureDesc), this->deletionQueue };
+
+            wgpu::ImageCopyTexture destination{};
+            destination.texture = resources.texture.get();
+            destination.aspect = wgpu::TextureAspect::All;
+            destination.mipLevel = 0;
+            destination.origin = { 0, 0, 0 };
+
+            wgpu::TextureDataLayout source;
+            source.offset = 0;
+            source.bytesPerRow = 4 * payload.textureWidth;
+            source.rowsPerImage = payload.textureHeight;
+
+            this->device->writeTexture(destination, payload.texturePixels.data(), payload.texturePixels.size(), source, textureDesc.size);
+
+            wgpu::TextureViewDescriptor textureViewDesc{};
+            textureViewDesc.nextInChain = nullptr;
+            textureViewDesc.aspect = wgpu::TextureAspect::All;
+            textureViewDesc.dimension = wgpu::TextureViewDimension::_2D;
+            textureViewDesc.arrayLayerCount = 1;
+            textureViewDesc.baseArrayLayer = 0;
+            textureViewDesc.mipLevelCount = 1;
+            textureViewDesc.baseMipLevel = 0;
+            textureViewDesc.format = textureDesc.format;
+
+            resources.textureView = TextureViewHandle{ resources.texture->createView(textureViewDesc), this->deletionQueue };
+        }
+
+        resources.indexCount = static_cast<uint32_t>(payload.indices.size());
+        resources.instanceCount = payload.instanceCount;
+        resources.byteSize = payload.getByteSize();
+        resources.center = glm::vec3{ (cell->coord.x + 0.5f) * this->settings.cellSize, 0.0f, (cell->coord.z + 0.5f) * this->settings.cellSize };
+
+        // The GPU has its copy, the CPU one is not kept
+        cell->payload = CellPayload{};
+
+        this->residentBytes += resources.byteSize;
+        cell->state.store(CellState::Resident, std::memory_order_relaxed);
+
+        if (this->onResident) {
+            this->onResident(cell->coord, resources);
+        }
+    }
+
+    void WorldStreamer::evict(Cell *cell) {
+        if (this->onEvict) {
+            this->onEvict(cell->coord, cell->resources);
+        }
+
+        this->residentBytes -= cell->resources.byteSize;
+        this->stats.evictedCells++;
+
+        // The handles hand their objects to the deletion queue as they are replaced
+        cell->resources = CellResources{};
+        cell->state.store(CellState::Unloaded, std::memory_order_relaxed);
+    }
+
+    void WorldStreamer::evictToBudget() {
+        for (auto cell = this->rankedCells.rbegin(); cell != this->rankedCells.rend(); cell++) {
+            if (this->residentBytes <= this->memoryBudgetBytes) {
+                break;
+            }
+
+            if ((*cell)->state.load(std::memory_order_acquire) == CellState::Resident) {
+                this->evict(*cell);
+            }
+        }
+    }
+
+    bool WorldStreamer::makeRoom(uint64_t byteSize, float priority) {
+        if (this->residentBytes + byteSize <= this->memoryBudgetBytes) {
+            return true;
+        }
+
+        uint64_t evictableBytes = 0;
+        for (Cell *cell : this->rankedCells) {
+            if (cell->priority > priority && cell->state.load(std::memory_order_acquire) == CellState::Resident) {
+                evictableBytes += cell->resources.byteSize;
+            }
+        }
+
+        // Evicting would not be enough, so nothing is evicted for nothing
+        if (this->residentBytes - evictableBytes + byteSize > this->memoryBudgetBytes) {
+            return false;
+        }
+
+        for (auto cell = this->rankedCells.rbegin(); cell != this->rankedCells.rend(); cell++) {
+            if (this->residentBytes + byteSize <= this->memoryBudgetBytes) {
+                break;
+            }
+
+            if ((*cell)->priority > priority && (*cell)->state.load(std::memory_order_acquire) == CellState::Resident) {
+                this->evict(*cell);
+            }
+        }
+
+        return true;
+    }
+}
@@ -0,0 +1,215 @@
+#ifndef NUGIE_WORLD_STREAMER_HPP
+#define NUGIE_WORLD_STREAMER_HPP
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <functional>
+#include <unordered_map>
+#include <glm/glm.hpp>
+
+#include "../../device/device.hpp"
+#include "../../camera/camera.hpp"
+#include "../../job/system/job_system.hpp"
+#include "../../frame/deletion/gpu_handle.hpp"
+
+namespace nugie {
+    class Device;
+
+    // A square of the world on the XZ plane, cell (x, z) covers [x, x + 1) * cellSize by [z, z + 1) * cellSize
+    struct CellCoord {
+        int32_t x;
+        int32_t z;
+    };
+
+    // What a cell's loader produces, all of it on the CPU. Vertices are in world space.
+    struct CellPayload {
+        std::vector<glm::vec3> positions;
+        std::vector<glm::vec2> textCoords;
+        std::vector<uint32_t> indices;
+
+        // RGBA8, left empty for cells without a texture of their own
+        std::vector<uint8_t> texturePixels;
+        uint32_t textureWidth = 0;
+        uint32_t textureHeight = 0;
+
+        // Opaque per-instance data such as transforms, uploaded as a storage and vertex buffer
+        std::vector<uint8_t> instanceData;
+        uint32_t instanceCount = 0;
+
+        uint64_t getByteSize() const;
+    };
+
+    // The GPU copy of a resident cell. Everything is released through the deletion queue when the
+    // cell is evicted, so frames still in flight may keep drawing it.
+    struct CellResources {
+        BufferHandle positionBuffer;
+        BufferHandle textCoordBuffer;
+        BufferHandle indexBuffer;
+        BufferHandle instanceBuffer;
+
+        TextureHandle texture;
+        TextureViewHandle textureView;
+
+        // Filled by the application's residency callback, for instance with per-frame material bind groups
+        std::vector<BindGroupHandle> bindGroups;
+
+        uint32_t indexCount = 0;
+        uint32_t instanceCount = 0;
+
+        // What the cell counts against the memory budget
+        uint64_t byteSize = 0;
+
+        // World space center, for sorting draws
+        glm::vec3 center{ 0.0f };
+    };
+
+    struct StreamingSettings {
+        float cellSize = 16.0f;
+
+        // Cells whose center is nearer than this are loaded, resident ones are only evicted past the unload
+        // radius. The gap between the two keeps a camera on a cell boundary from loading and dropping it every frame.
+        float loadRadius = 48.0f;
+        float unloadRadius = 64.0f;
+
+        // Cells behind the camera count as up to 1 + directionWeight times as far, so what it looks at comes first
+        float directionWeight = 1.0f;
+
+        // Bytes uploaded per frame, a cell larger than this still goes up alone when nothing else did
+        uint64_t uploadBytesPerFrame = 4 * 1024 * 1024;
+
+        // Bytes all resident cells may hold together
+        uint64_t memoryBudgetBytes = 256 * 1024 * 1024;
+
+        // Memory pressure never lowers the budget below this, so a few cells can always stream in
+        uint64_t minMemoryBudgetBytes = 32 * 1024 * 1024;
+
+        uint32_t maxLoadsInFlight = 4;
+    };
+
+    struct StreamingStats {
+        uint32_t residentCells = 0;
+        uint32_t loadingCells = 0;
+        uint32_t pendingUploads = 0;
+        uint64_t residentBytes = 0;
+
+        // Of the last update
+        uint64_t uploadedBytes = 0;
+        uint32_t evictedCells = 0;
+    };
+
+    // Streams a grid of cells in and out around the camera.
+    //
+    // Every update() ranks the cells by distance, weighted by how far they are off the view direction.
+    // The best ranked cells in the load radius are loaded on the job system's background thread, loads
+    // that finished are uploaded in rank order within the per-frame upload budget, and cells past the
+    // unload radius are evicted. When a new cell would go over the memory budget, resident cells ranked
+    // below it are evicted first, and if that is not enough it waits. A budget lowered under memory
+    // pressure evicts the worst ranked resident cells until what is left fits. Once the device is back
+    // within its memory budget, the streaming budget grows back by a frame's uploads per update.
+    class WorldStreamer {
+    public:
+        // Runs on the job system's background thread, so it must only touch the payload it is given
+        using CellLoader = std::function<void(CellCoord coord, CellPayload &payload)>;
+
+        using CellCallback = std::function<void(CellCoord coord, CellResources &resources)>;
+
+        WorldStreamer(nugie::Device *device, nugie::JobSystem *jobSystem, nugie::DeletionQueue *deletionQueue, StreamingSettings settings, CellLoader loader);
+        ~WorldStreamer();
+
+        // onResident runs once a cell's resources are uploaded, onEvict just before they are dropped
+        void setResidencyCallbacks(CellCallback onResident, CellCallback onEvict);
+
+        // Once per frame on the thread that owns the job system, before anything draws the resident cells
+        void update(nugie::Camera *camera);
+
+        // Lowers the budget to three quarters of what is resident now, but not under the minimum, and the
+        // next update() evicts down to it. Safe to call from any thread, meant for the GPU memory tracker's
+        // budget callback.
+        void onMemoryPressure();
+
+        // Calls function(coord, resources) for every resident cell, the set only changes in update()
+        template<typename F>
+        void forEachResident(F &&function) {
+            for (auto &&entry : this->cells) {
+                Cell &cell = *entry.second;
+
+                if (cell.state.load(std::memory_order_acquire) == CellState::Resident) {
+                    function(cell.coord, cell.resources);
+                }
+            }
+        }
+
+        StreamingStats getStats() { return this->stats; }
+
+        uint64_t getMemoryBudget() { return this->memoryBudgetBytes; }
+
+        // Waits for the loads in flight and evicts every cell
+        void release();
+
+    private:
+        enum class CellState : uint32_t {
+            Unloaded,
+            Loading,
+            Loaded,
+            Resident
+        };
+
+        struct Cell {
+            CellCoord coord;
+            std::atomic<CellState> state{CellState::Unloaded};
+
+            // Lower is sooner, the distance on the XZ plane weighted by the view direction
+            float priority = 0.0f;
+            float distance = 0.0f;
+
+            // Written by the loader job, read once the state says Loaded
+            CellPayload payload;
+            CellResources resources;
+        };
+
+        nugie::Device *device;
+        nugie::JobSystem *jobSystem;
+        nugie::DeletionQueue *deletionQueue;
+
+        StreamingSettings settings;
+        CellLoader loader;
+        CellCallback onResident;
+        CellCallback onEvict;
+
+        std::unordered_map<uint64_t, std::unique_ptr<Cell>> cells;
+
+        // Reused by every update, so ranking does not allocate once it has grown
+        std::vector<Cell*> rankedCells;
+
+        JobCounter loadCounter;
+        uint32_t loadsInFlight = 0;
+
+        uint64_t memoryBudgetBytes;
+        uint64_t residentBytes = 0;
+        std::atomic<bool> memoryPressure{false};
+
+        StreamingStats stats;
+        bool released = false;
+
+        static uint64_t getKey(CellCoord coord);
+
+        Cell* getCell(CellCoord coord);
+
+        void rankCells(glm::vec3 position, glm::vec3 front);
+
+        void startLoad(Cell *cell);
+
+        void upload(Cell *cell);
+
+        void evict(Cell *cell);
+
+        // Evicts resident cells, worst ranked first, until they fit the memory budget
+        void evictToBudget();
+
+        // Evicts resident cells ranked below the given priority, worst first, until the bytes fit
+        bool makeRoom(uint64_t byteSize, float priority);
+    };
+}
+
+#endif